@@ -39,6 +39,7 @@
 #include <errno.h>
 #include <fcntl.h>
 #include <inttypes.h>
+#include <poll.h>
 #include <stdint.h>
 #include <sys/errno.h>
 #include <sys/socket.h>
@@ -47,6 +48,7 @@
 #include <sys/un.h>
 #include <unistd.h>
 
+#include <algorithm>
 #include <mutex>
 
 #include <hardware/audio.h>
@@ -57,6 +59,7 @@
 #include "osi/include/log.h"
 #include "osi/include/osi.h"
 #include "osi/include/socket_utils/sockets.h"
+#include "osi/include/time.h"
 
 #include "audio_a2dp_hw.h"
 
@@ -376,7 +379,9 @@ static int skt_write(int fd, const void* p, size_t len) {
   }
 
   // use non-blocking send, poll
-  int ms_timeout = SOCK_SEND_TIMEOUT_MS;
+  // The timeout bounds the whole write. A reader draining a little at a time
+  // wakes every poll, so it must not restart the countdown.
+  uint32_t deadline_ms = time_get_os_boottime_ms() + SOCK_SEND_TIMEOUT_MS;
   size_t count = 0;
   while (count < len) {
     OSI_NO_INTR(sent = send(fd, p, len - count, MSG_NOSIGNAL | MSG_DONTWAIT));
@@ -385,9 +390,12 @@ static int skt_write(int fd, const void* p, size_t len) {
         ERROR("write failed with error(%s)", strerror(errno));
         return -1;
       }
-      if (ms_timeout >= WRITE_POLL_MS) {
-        usleep(WRITE_POLL_MS * 1000);
-        ms_timeout -= WRITE_POLL_MS;
+      int32_t ms_left = (int32_t)(deadline_ms - time_get_os_boottime_ms());
+      if (ms_left > 0) {
+        // Wait for room in the socket buffer instead of sleeping a whole
+        // poll period, so the write resumes as soon as the stack has read.
+        struct pollfd pfd = {.fd = fd, .events = POLLOUT};
+        OSI_NO_INTR(poll(&pfd, 1, std::min<int32_t>(ms_left, WRITE_POLL_MS)));
         continue;
       }
       WARN("write timeout exceeded, sent %zu bytes", count);
@@ -586,6 +586,7 @@ void bta_ag_rfc_open(tBTA_AG_SCB* p_scb, tBTA_AG_DATA* p_data) {
   VLOG(1) << __func__ << " p_scb addr:" << p_scb->peer_addr;
   /* set up AT command interpreter */
   p_scb->at_cb.p_at_tbl = (tBTA_AG_AT_CMD*)bta_ag_at_tbl[p_scb->conn_service];
+  p_scb->at_cb.p_at_index = bta_ag_at_index_tbl[p_scb->conn_service];
   p_scb->at_cb.p_cmd_cback =
       (tBTA_AG_AT_CMD_CBACK*)bta_ag_at_cback_tbl[p_scb->conn_service];
   p_scb->at_cb.p_err_cback = (tBTA_AG_AT_ERR_CBACK*)bta_ag_at_err_cback;
@@ -22,6 +22,7 @@
  *
  ******************************************************************************/
 
+#include <ctype.h>
 #include <string.h>
 
 #include "bt_common.h"
@@ -33,6 +34,29 @@
  *  Constants
  ****************************************************************************/
 
+/******************************************************************************
+ *
+ * Function         bta_ag_at_cmd_len
+ *
+ * Description      Finds the length of the command name at the start of
+ *                  |p_cmd|, without the "AT" prefix: an extended command is
+ *                  '+' and/or '%' followed by letters, a basic command a
+ *                  single letter. Whatever follows is the argument.
+ *
+ *
+ * Returns          Length of the name, 0 if |p_cmd| doesn't start with one.
+ *
+ *****************************************************************************/
+static size_t bta_ag_at_cmd_len(const char* p_cmd) {
+  const char* p = p_cmd;
+
+  while (*p == '+' || *p == '%') p++;
+  if (p == p_cmd) return isalpha((unsigned char)*p) ? 1 : 0;
+
+  while (isalpha((unsigned char)*p)) p++;
+  return p - p_cmd;
+}
+
 /******************************************************************************
  *
  * Function         bta_ag_at_init
@@ -78,19 +102,17 @@ void bta_ag_at_reinit(tBTA_AG_AT_CB* p_cb) {
  *
  *****************************************************************************/
 void bta_ag_process_at(tBTA_AG_AT_CB* p_cb, char* p_end) {
-  uint16_t idx;
+  int idx;
   uint8_t arg_type;
   char* p_arg;
   int16_t int_arg = 0;
-  /* loop through at command table looking for match */
-  for (idx = 0; p_cb->p_at_tbl[idx].p_cmd[0] != 0; idx++) {
-    if (!utl_strucmp(p_cb->p_at_tbl[idx].p_cmd, p_cb->p_cmd_buf)) {
-      break;
-    }
-  }
+  /* look the command name up in the index of the at command table */
+  idx = utl_at_index_find(p_cb->p_at_index, p_cb->p_at_tbl,
+                          &tBTA_AG_AT_CMD::p_cmd, p_cb->p_cmd_buf,
+                          bta_ag_at_cmd_len(p_cb->p_cmd_buf), true);
 
   /* if there is a match; verify argument type */
-  if (p_cb->p_at_tbl[idx].p_cmd[0] != 0) {
+  if (idx >= 0) {
     /* start of argument is p + strlen matching command */
     p_arg = p_cb->p_cmd_buf + strlen(p_cb->p_at_tbl[idx].p_cmd);
     if (p_arg > p_end) {
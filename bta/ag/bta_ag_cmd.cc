@@ -109,7 +109,7 @@ enum {
 };
 
 /* AT command interpreter table for HSP */
-const tBTA_AG_AT_CMD bta_ag_hsp_cmd[] = {
+constexpr tBTA_AG_AT_CMD bta_ag_hsp_cmd[] = {
     {"+CKPD", BTA_AG_AT_CKPD_EVT, BTA_AG_AT_SET, BTA_AG_AT_INT, 200, 200},
     {"+VGS", BTA_AG_SPK_EVT, BTA_AG_AT_SET, BTA_AG_AT_INT, 0, 15},
     {"+VGM", BTA_AG_MIC_EVT, BTA_AG_AT_SET, BTA_AG_AT_INT, 0, 15},
@@ -117,7 +117,7 @@ const tBTA_AG_AT_CMD bta_ag_hsp_cmd[] = {
     {"", 0, 0, 0, 0, 0}};
 
 /* AT command interpreter table for HFP */
-const tBTA_AG_AT_CMD bta_ag_hfp_cmd[] = {
+constexpr tBTA_AG_AT_CMD bta_ag_hfp_cmd[] = {
     {"A", BTA_AG_AT_A_EVT, BTA_AG_AT_NONE, BTA_AG_AT_STR, 0, 0},
     {"D", BTA_AG_AT_D_EVT, BTA_AG_AT_NONE | BTA_AG_AT_FREE, BTA_AG_AT_STR, 0,
      0},
@@ -172,6 +172,19 @@ const tBTA_AG_AT_CMD bta_ag_hfp_cmd[] = {
     /* End-of-table marker used to stop lookup iteration */
     {"", 0, 0, 0, 0, 0}};
 
+/* Perfect hash indexes of the AT command tables */
+constexpr tUTL_AT_INDEX bta_ag_hsp_index =
+    utl_at_build_index(bta_ag_hsp_cmd, &tBTA_AG_AT_CMD::p_cmd);
+static_assert(utl_at_index_ok(bta_ag_hsp_index, bta_ag_hsp_cmd,
+                              &tBTA_AG_AT_CMD::p_cmd),
+              "no perfect hash found for the HSP AT command table");
+
+constexpr tUTL_AT_INDEX bta_ag_hfp_index =
+    utl_at_build_index(bta_ag_hfp_cmd, &tBTA_AG_AT_CMD::p_cmd);
+static_assert(utl_at_index_ok(bta_ag_hfp_index, bta_ag_hfp_cmd,
+                              &tBTA_AG_AT_CMD::p_cmd),
+              "no perfect hash found for the HFP AT command table");
+
 /* AT result code table element */
 typedef struct {
   const char* result_string; /* AT result string */
@@ -244,6 +257,9 @@ static const tBTA_AG_RESULT* bta_ag_result_by_code(size_t code) {
 const tBTA_AG_AT_CMD* bta_ag_at_tbl[BTA_AG_NUM_IDX] = {bta_ag_hsp_cmd,
                                                        bta_ag_hfp_cmd};
 
+const tUTL_AT_INDEX* bta_ag_at_index_tbl[BTA_AG_NUM_IDX] = {
+    &bta_ag_hsp_index, &bta_ag_hfp_index};
+
 typedef struct {
   size_t result_code;
   size_t indicator;
@@ -388,6 +388,7 @@ typedef struct {
 extern const uint16_t bta_ag_uuid[BTA_AG_NUM_IDX];
 extern const uint8_t bta_ag_sec_id[BTA_AG_NUM_IDX];
 extern const tBTA_AG_AT_CMD* bta_ag_at_tbl[BTA_AG_NUM_IDX];
+extern const tUTL_AT_INDEX* bta_ag_at_index_tbl[BTA_AG_NUM_IDX];
 
 /* control block declaration */
 extern tBTA_AG_CB bta_ag_cb;
@@ -0,0 +1,245 @@
+/*
+ * Copyright 2019 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+#include <string.h>
+
+#include <random>
+#include <string>
+#include <vector>
+
+#include "bta/ag/bta_ag_int.h"
+#include "bta/hf_client/bta_hf_client_int.h"
+
+using ::benchmark::State;
+
+// Size of the AT command buffer of a gateway connection, as set up by
+// bta_ag_rfc_open()
+#define AG_CMD_BUF_LEN 512
+
+// Mutated copies of the traffic fed to the parsers by the fuzz benchmarks
+#define NUM_FUZZ_INPUTS 1024
+
+// Commands a hands-free unit sends through a service level connection setup,
+// a call and a few vendor extensions the gateway doesn't support.
+static const char* kAgCommands[] = {
+    "AT+BRSF=959\r",
+    "AT+BAC=1,2\r",
+    "AT+CIND=?\r",
+    "AT+CIND?\r",
+    "AT+CMER=3,0,0,1\r",
+    "AT+CHLD=?\r",
+    "AT+BIND=1,2\r",
+    "AT+BIND?\r",
+    "AT+CLIP=1\r",
+    "AT+CCWA=1\r",
+    "AT+CMEE=1\r",
+    "AT+VGS=9\r",
+    "AT+VGM=12\r",
+    "AT+XAPL=ABCD-1234-0100,10\r",
+    "AT+IPHONEACCEV=2,1,5,2,0\r",
+    "ATD5551234567;\r",
+    "AT+CLCC\r",
+    "AT+COPS=3,0\r",
+    "AT+COPS?\r",
+    "AT+BCS=2\r",
+    "AT+BIEV=2,70\r",
+    "AT+NREC=0\r",
+    "ATA\r",
+    "AT+CHUP\r",
+};
+
+// Results and unsolicited events a gateway sends to a hands-free unit.
+static const char* kHfEvents[] = {
+    "\r\n+BRSF: 871\r\n\r\nOK\r\n",
+    "\r\n+CIND: (\"call\",(0,1)),(\"callsetup\",(0-3)),(\"service\",(0-1)),"
+    "(\"signal\",(0-5)),(\"roam\",(0,1)),(\"battchg\",(0-5)),"
+    "(\"callheld\",(0-2))\r\n\r\nOK\r\n",
+    "\r\n+CIND: 0,0,1,4,0,3,0\r\n\r\nOK\r\n",
+    "\r\n+CHLD: (0,1,1x,2,2x,3,4)\r\n\r\nOK\r\n",
+    "\r\n+CIEV: 2,1\r\n",
+    "\r\nRING\r\n",
+    "\r\n+CLIP: \"5551234567\",129\r\n",
+    "\r\n+CIEV: 1,1\r\n",
+    "\r\n+CIEV: 2,0\r\n",
+    "\r\n+VGS: 9\r\n",
+    "\r\n+VGM=12\r\n",
+    "\r\n+BCS: 2\r\n",
+    "\r\n+CLCC: 1,1,0,0,0,\"5551234567\",129\r\n\r\nOK\r\n",
+    "\r\n+COPS: 0,0,\"Carrier\"\r\n\r\nOK\r\n",
+    "\r\n+XAPL=iPhone,6\r\n",
+    "\r\n+CME ERROR: 30\r\n",
+    "\r\nNO CARRIER\r\n",
+    "\r\nERROR\r\n",
+};
+
+static void ag_cmd_cback(tBTA_AG_SCB* p_user, uint16_t command_id,
+                         uint8_t arg_type, char* p_arg, char* p_end,
+                         int16_t int_arg) {
+  benchmark::DoNotOptimize(command_id);
+}
+
+static void ag_err_cback(tBTA_AG_SCB* p_user, bool unknown, char* p_arg) {
+  benchmark::DoNotOptimize(unknown);
+}
+
+// Randomly flips, drops and duplicates bytes of the inputs, with a fixed seed
+// so that every run parses the same traffic.
+static std::vector<std::string> fuzz_inputs(const char** inputs, size_t count) {
+  std::mt19937 rng(0x4154);
+  std::vector<std::string> fuzzed;
+  for (size_t i = 0; i < NUM_FUZZ_INPUTS; i++) {
+    std::string s = inputs[i % count];
+    int mutations = 1 + rng() % 4;
+    for (int m = 0; m < mutations && !s.empty(); m++) {
+      size_t pos = rng() % s.size();
+      switch (rng() % 4) {
+        case 0:
+          s[pos] = (char)rng();
+          break;
+        case 1:
+          s.erase(pos, 1);
+          break;
+        case 2:
+          s.insert(pos, 1, s[pos]);
+          break;
+        case 3:
+          s[pos] = "\r\n:=,?+%\" "[rng() % 10];
+          break;
+      }
+    }
+    fuzzed.push_back(s);
+  }
+  return fuzzed;
+}
+
+class BM_AgAtParse : public ::benchmark::Fixture {
+ protected:
+  void SetUp(State& st) override {
+    ::benchmark::Fixture::SetUp(st);
+    memset(&at_cb_, 0, sizeof(at_cb_));
+    at_cb_.p_at_tbl = (tBTA_AG_AT_CMD*)bta_ag_at_tbl[BTA_AG_HFP];
+    at_cb_.p_at_index = bta_ag_at_index_tbl[BTA_AG_HFP];
+    at_cb_.p_cmd_cback = ag_cmd_cback;
+    at_cb_.p_err_cback = ag_err_cback;
+    at_cb_.cmd_max_len = AG_CMD_BUF_LEN;
+    bta_ag_at_init(&at_cb_);
+  }
+
+  void TearDown(State& st) override {
+    bta_ag_at_reinit(&at_cb_);
+    ::benchmark::Fixture::TearDown(st);
+  }
+
+  void Parse(const std::string& at) {
+    buf_.assign(at.begin(), at.end());
+    bta_ag_at_parse(&at_cb_, buf_.data(), buf_.size());
+  }
+
+  tBTA_AG_AT_CB at_cb_;
+  std::vector<char> buf_;
+};
+
+BENCHMARK_DEFINE_F(BM_AgAtParse, commands)(State& state) {
+  std::vector<std::string> inputs(std::begin(kAgCommands),
+                                  std::end(kAgCommands));
+  size_t bytes = 0;
+  for (auto _ : state) {
+    for (const std::string& at : inputs) {
+      Parse(at);
+      bytes += at.size();
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * inputs.size());
+  state.SetBytesProcessed(bytes);
+}
+
+BENCHMARK_DEFINE_F(BM_AgAtParse, fuzz)(State& state) {
+  std::vector<std::string> inputs =
+      fuzz_inputs(kAgCommands, sizeof(kAgCommands) / sizeof(kAgCommands[0]));
+  size_t bytes = 0;
+  for (auto _ : state) {
+    for (const std::string& at : inputs) {
+      Parse(at);
+      bytes += at.size();
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * inputs.size());
+  state.SetBytesProcessed(bytes);
+}
+
+BENCHMARK_REGISTER_F(BM_AgAtParse, commands);
+BENCHMARK_REGISTER_F(BM_AgAtParse, fuzz);
+
+// Parses on a connected control block that isn't registered, so that the
+// events go no further than the callbacks of the application, which isn't
+// there either.
+class BM_HfClientAtParse : public ::benchmark::Fixture {
+ protected:
+  void SetUp(State& st) override {
+    ::benchmark::Fixture::SetUp(st);
+    memset(&client_cb_, 0, sizeof(client_cb_));
+    bta_hf_client_at_init(&client_cb_);
+    client_cb_.svc_conn = true;
+  }
+
+  void TearDown(State& st) override {
+    bta_hf_client_at_reset(&client_cb_);
+    alarm_free(client_cb_.at_cb.resp_timer);
+    alarm_free(client_cb_.at_cb.hold_timer);
+    ::benchmark::Fixture::TearDown(st);
+  }
+
+  void Parse(const std::string& events) {
+    buf_.assign(events.begin(), events.end());
+    bta_hf_client_at_parse(&client_cb_, buf_.data(), buf_.size());
+  }
+
+  tBTA_HF_CLIENT_CB client_cb_;
+  std::vector<char> buf_;
+};
+
+BENCHMARK_DEFINE_F(BM_HfClientAtParse, events)(State& state) {
+  std::vector<std::string> inputs(std::begin(kHfEvents), std::end(kHfEvents));
+  size_t bytes = 0;
+  for (auto _ : state) {
+    for (const std::string& events : inputs) {
+      Parse(events);
+      bytes += events.size();
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * inputs.size());
+  state.SetBytesProcessed(bytes);
+}
+
+BENCHMARK_DEFINE_F(BM_HfClientAtParse, fuzz)(State& state) {
+  std::vector<std::string> inputs =
+      fuzz_inputs(kHfEvents, sizeof(kHfEvents) / sizeof(kHfEvents[0]));
+  size_t bytes = 0;
+  for (auto _ : state) {
+    for (const std::string& events : inputs) {
+      Parse(events);
+      bytes += events.size();
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * inputs.size());
+  state.SetBytesProcessed(bytes);
+}
+
+BENCHMARK_REGISTER_F(BM_HfClientAtParse, events);
+BENCHMARK_REGISTER_F(BM_HfClientAtParse, fuzz);
+
+BENCHMARK_MAIN();
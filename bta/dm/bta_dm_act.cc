@@ -207,6 +207,7 @@ static void bta_dm_remove_sec_dev_entry(const RawAddress& remote_bd_addr);
 static void bta_dm_observe_results_cb(tBTM_INQ_RESULTS* p_inq, uint8_t* p_eir,
                                       uint16_t eir_len);
 static void bta_dm_observe_cmpl_cb(void* p_result);
+static void bta_dm_observe_batch_end_cb(void);
 static void bta_dm_delay_role_switch_cback(void* data);
 static void bta_dm_disable_timer_cback(void* data);
 static void bta_dm_vnd_info_report_cback(uint8_t evt_len, uint8_t *p_data);
@@ -4927,6 +4928,22 @@ static void bta_dm_observe_results_cb(tBTM_INQ_RESULTS* p_inq, uint8_t* p_eir,
   }
 }
 
+/*******************************************************************************
+ *
+ * Function         bta_dm_observe_batch_end_cb
+ *
+ * Description      Callback for the end of the BLE Observe results of one
+ *                  advertising report event
+ *
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+static void bta_dm_observe_batch_end_cb(void) {
+  if (bta_dm_search_cb.p_scan_cback)
+    bta_dm_search_cb.p_scan_cback(BTA_DM_INQ_RES_BATCH_END_EVT, NULL);
+}
+
 /*******************************************************************************
  *
  * Function         bta_dm_observe_cmpl_cb
@@ -5323,7 +5340,8 @@ void bta_dm_ble_observe(tBTA_DM_MSG* p_data) {
     /*Save the  callback to be called when a scan results are available */
     bta_dm_search_cb.p_scan_cback = p_data->ble_observe.p_cback;
     status = BTM_BleObserve(true, p_data->ble_observe.duration,
-                            bta_dm_observe_results_cb, bta_dm_observe_cmpl_cb);
+                            bta_dm_observe_results_cb, bta_dm_observe_cmpl_cb,
+                            bta_dm_observe_batch_end_cb);
     if (status != BTM_CMD_STARTED) {
       tBTA_DM_SEARCH data;
       APPL_TRACE_WARNING(" %s BTM_BleObserve  failed. status %d", __func__,
@@ -5334,8 +5352,11 @@ void bta_dm_ble_observe(tBTA_DM_MSG* p_data) {
       }
     }
   } else {
+    /* Hand on the results still held for a batch that was not ended, as no
+     * callback is made once the observer is stopped */
+    bta_dm_observe_batch_end_cb();
     bta_dm_search_cb.p_scan_cback = NULL;
-    BTM_BleObserve(false, 0, NULL, NULL);
+    BTM_BleObserve(false, 0, NULL, NULL, NULL);
   }
 }
 
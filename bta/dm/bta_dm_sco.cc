@@ -650,7 +650,7 @@ int32_t BTA_DmPcmResample(void* p_src, uint32_t in_bytes, void* p_dst) {
 #endif
   if (bta_dm_pcm_cb.can_be_filtered) {
     out_sample = (*bta_dm_pcm_cb.filter)(
-        p_src, p_dst, (in_bytes / bta_dm_pcm_cb.divisor), bta_dm_pcm_cb.src_sps,
+        (uint8_t*)p_src, p_dst, (in_bytes / bta_dm_pcm_cb.divisor), bta_dm_pcm_cb.src_sps,
         (int32_t*)&bta_dm_pcm_cb.cur_pos, bta_dm_pcm_cb.overlap_area);
   } else {
     out_sample = (*bta_dm_pcm_cb.nofilter)(p_src, p_dst,
@@ -35,6 +35,7 @@
 #include "bta_sys.h"
 #include "btif/include/btif_debug_conn.h"
 #include "l2c_api.h"
+#include "sdp_api.h"
 #include "osi/include/log.h"
 #include "osi/include/osi.h"
 #include "stack/l2cap/l2c_int.h"
@@ -1347,6 +1348,8 @@ bool bta_gattc_process_srvc_chg_ind(uint16_t conn_id, tBTA_GATTC_RCB* p_clrcb,
 
   /* mark service handle change pending */
   p_srcb->srvc_hdl_chg = true;
+  /* the BR/EDR services of a dual mode device may have changed as well */
+  SDP_InvalidateDiscoveryCache(p_srcb->server_bda);
   /* clear up all notification/indication registration */
   bta_gattc_clear_notif_registration(p_srcb, conn_id, s_handle, e_handle);
   /* service change indication all received, do discovery update */
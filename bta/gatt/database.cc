@@ -21,6 +21,7 @@
 #include "stack/include/gattdefs.h"
 
 #include <base/logging.h>
+#include <algorithm>
 #include <memory>
 #include <sstream>
 
@@ -37,17 +38,103 @@ const Uuid CHARACTERISTIC = Uuid::From16Bit(GATT_UUID_CHAR_DECLARE);
 bool HandleInRange(const Service& svc, uint16_t handle) {
   return handle >= svc.handle && handle <= svc.end_handle;
 }
+
+/* Services are kept sorted by handle, so the only candidate is the last one
+ * that starts at or before |handle| */
+template <typename ServiceVector>
+auto FindServiceInSorted(ServiceVector& services, uint16_t handle)
+    -> decltype(&services.front()) {
+  auto it = std::upper_bound(
+      services.begin(), services.end(), handle,
+      [](uint16_t handle, const Service& s) { return handle < s.handle; });
+  if (it == services.begin()) return nullptr;
+
+  auto& service = *std::prev(it);
+  if (!HandleInRange(service, handle)) return nullptr;
+  return &service;
+}
 }  // namespace
 
 Service* FindService(std::vector<Service>& services, uint16_t handle) {
-  for (Service& service : services) {
-    if (handle >= service.handle && handle <= service.end_handle)
-      return &service;
+  return FindServiceInSorted(services, handle);
+}
+
+const Service* Database::FindService(uint16_t handle) const {
+  return FindServiceInSorted(services, handle);
+}
+
+void Database::BuildIndex() {
+  handle_index.clear();
+
+  for (size_t s = 0; s < services.size(); s++) {
+    const Service& service = services[s];
+    for (size_t c = 0; c < service.characteristics.size(); c++) {
+      const Characteristic& charac = service.characteristics[c];
+      handle_index.push_back(HandleIndexEntry{
+          .handle = charac.value_handle,
+          .service_idx = static_cast<uint16_t>(s),
+          .characteristic_idx = static_cast<uint16_t>(c),
+          .descriptor_idx = DESCRIPTOR_NONE});
+
+      for (size_t d = 0; d < charac.descriptors.size(); d++) {
+        handle_index.push_back(HandleIndexEntry{
+            .handle = charac.descriptors[d].handle,
+            .service_idx = static_cast<uint16_t>(s),
+            .characteristic_idx = static_cast<uint16_t>(c),
+            .descriptor_idx = static_cast<uint16_t>(d)});
+      }
+    }
+  }
+
+  // Attributes are usually already in order, stable sort keeps first
+  // occurrence first if remote device reports duplicate handles.
+  std::stable_sort(handle_index.begin(), handle_index.end(),
+                   [](const HandleIndexEntry& a, const HandleIndexEntry& b) {
+                     return a.handle < b.handle;
+                   });
+  handle_index.shrink_to_fit();
+}
+
+const Database::HandleIndexEntry* Database::FindIndexEntry(
+    uint16_t handle, bool is_descriptor) const {
+  auto it = std::lower_bound(
+      handle_index.begin(), handle_index.end(), handle,
+      [](const HandleIndexEntry& e, uint16_t handle) {
+        return e.handle < handle;
+      });
+
+  for (; it != handle_index.end() && it->handle == handle; it++) {
+    if ((it->descriptor_idx != DESCRIPTOR_NONE) == is_descriptor) return &(*it);
   }
 
   return nullptr;
 }
 
+const Characteristic* Database::FindCharacteristic(
+    uint16_t value_handle) const {
+  const HandleIndexEntry* e = FindIndexEntry(value_handle, false);
+  if (!e) return nullptr;
+
+  return &services[e->service_idx].characteristics[e->characteristic_idx];
+}
+
+const Descriptor* Database::FindDescriptor(uint16_t handle) const {
+  const HandleIndexEntry* e = FindIndexEntry(handle, true);
+  if (!e) return nullptr;
+
+  return &services[e->service_idx]
+              .characteristics[e->characteristic_idx]
+              .descriptors[e->descriptor_idx];
+}
+
+const Characteristic* Database::FindOwningCharacteristic(
+    uint16_t handle) const {
+  const HandleIndexEntry* e = FindIndexEntry(handle, true);
+  if (!e) return nullptr;
+
+  return &services[e->service_idx].characteristics[e->characteristic_idx];
+}
+
 std::string Database::ToString() const {
   std::stringstream tmp;
 
@@ -148,15 +235,17 @@ Database Database::Deserialize(const std::vector<StoredAttribute>& nv_attr,
         !HandleInRange(*current_service_it, attr.handle)) {
       LOG(ERROR) << "Can't find service for attribute with handle: "
                  << loghex(attr.handle);
+      result.BuildIndex();
       *success = false;
       return result;
     }
 
     if (attr.type == INCLUDE) {
-      Service* included_service =
-          FindService(result.services, attr.value.included_service.handle);
+      Service* included_service = gatt::FindService(
+          result.services, attr.value.included_service.handle);
       if (!included_service) {
         LOG(ERROR) << __func__ << ": Non-existing included service!";
+        result.BuildIndex();
         *success = false;
         return result;
       }
@@ -178,6 +267,7 @@ Database Database::Deserialize(const std::vector<StoredAttribute>& nv_attr,
           Descriptor{.handle = attr.handle, .uuid = attr.type});
     }
   }
+  result.BuildIndex();
   *success = true;
   return result;
 }
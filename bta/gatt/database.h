@@ -101,7 +101,10 @@ class Database {
 
   /* Clear the GATT database. This method forces relocation to ensure no extra
    * space is used unnecesarly */
-  void Clear() { std::vector<Service>().swap(services); }
+  void Clear() {
+    std::vector<Service>().swap(services);
+    std::vector<HandleIndexEntry>().swap(handle_index);
+  }
 
   /* Return list of services available in this database */
   const std::vector<Service>& Services() const { return services; }
@@ -113,14 +116,50 @@ class Database {
   static Database Deserialize(const std::vector<gatt::StoredAttribute>& nv_attr,
                               bool* success);
 
+  /* Return service that contains |handle|, or nullptr if there is none. */
+  const Service* FindService(uint16_t handle) const;
+
+  /* Return characteristic with value handle equal to |value_handle|, or
+   * nullptr if there is none. */
+  const Characteristic* FindCharacteristic(uint16_t value_handle) const;
+
+  /* Return descriptor with given |handle|, or nullptr if there is none. */
+  const Descriptor* FindDescriptor(uint16_t handle) const;
+
+  /* Return characteristic owning descriptor with given |handle|, or nullptr if
+   * there is no such descriptor. */
+  const Characteristic* FindOwningCharacteristic(uint16_t handle) const;
+
   friend class DatabaseBuilder;
 
  private:
+  /* Entry of the handle index: position of a characteristic value or a
+   * descriptor inside |services|. Positions are used instead of pointers, so
+   * that the index stays valid when the Database is copied. */
+  struct HandleIndexEntry {
+    uint16_t handle;
+    uint16_t service_idx;
+    uint16_t characteristic_idx;
+    /* DESCRIPTOR_NONE for characteristic value entries */
+    uint16_t descriptor_idx;
+  };
+  static constexpr uint16_t DESCRIPTOR_NONE = 0xffff;
+
+  /* Rebuild |handle_index| from |services|. Must be called every time
+   * |services| content is changed. */
+  void BuildIndex();
+
+  const HandleIndexEntry* FindIndexEntry(uint16_t handle,
+                                         bool is_descriptor) const;
+
   std::vector<Service> services;
+
+  /* characteristic value and descriptor handles, sorted by handle */
+  std::vector<HandleIndexEntry> handle_index;
 };
 
-/* Find a service that should contain handle. Helper method for internal use
- * inside gatt namespace.*/
+/* Find a service that should contain handle. |services| must be sorted by
+ * handle. Helper method for internal use inside gatt namespace.*/
 Service* FindService(std::vector<Service>& services, uint16_t handle);
 
 }  // namespace gatt
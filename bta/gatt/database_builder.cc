@@ -22,6 +22,7 @@
 
 #include <base/logging.h>
 #include <algorithm>
+#include <iterator>
 
 using bluetooth::Uuid;
 
@@ -29,28 +30,34 @@ namespace gatt {
 
 void DatabaseBuilder::AddService(uint16_t handle, uint16_t end_handle,
                                  const Uuid& uuid, bool is_primary) {
-  // general case optimization - we add services in order
-  if (database.services.empty() ||
-      database.services.back().end_handle < handle) {
-    database.services.emplace_back(Service{.handle = handle,
-                                           .end_handle = end_handle,
-                                           .is_primary = is_primary,
-                                           .uuid = uuid});
-  } else {
-    auto& vec = database.services;
+  auto& vec = database.services;
 
+  // Services are kept sorted by start handle, which FindService() relies on.
+  // General case optimization - we add services in order
+  auto it = vec.end();
+  if (!vec.empty() && vec.back().handle >= handle) {
     // Find first service whose start handle is bigger than new service handle
-    auto it = std::lower_bound(
+    it = std::upper_bound(
         vec.begin(), vec.end(), handle,
-        [](Service s, uint16_t handle) { return s.end_handle < handle; });
+        [](uint16_t handle, const Service& s) { return handle < s.handle; });
+  }
 
-    // Insert new service just before it
-    vec.emplace(it, Service{.handle = handle,
-                            .end_handle = end_handle,
-                            .is_primary = is_primary,
-                            .uuid = uuid});
+  // A service overlapping another one would break the order by handle
+  if (end_handle < handle ||
+      (it != vec.begin() && std::prev(it)->end_handle >= handle) ||
+      (it != vec.end() && it->handle <= end_handle)) {
+    LOG(ERROR) << "Remote device violates spec: service "
+               << loghex(handle) << "-" << loghex(end_handle)
+               << " overlaps another service, ignored";
+    return;
   }
 
+  // Insert new service just before it
+  vec.emplace(it, Service{.handle = handle,
+                          .end_handle = end_handle,
+                          .is_primary = is_primary,
+                          .uuid = uuid});
+
   services_to_discover.insert({handle, end_handle});
 }
 
@@ -179,6 +186,7 @@ bool DatabaseBuilder::InProgress() const { return !database.services.empty(); }
 
 Database DatabaseBuilder::Build() {
   Database tmp = database;
+  tmp.BuildIndex();
   database.Clear();
   return tmp;
 }
@@ -28,6 +28,7 @@
 #include "osi/include/log.h"
 #include "osi/include/osi.h"
 #include "port_api.h"
+#include "utl_at_index.h"
 
 /* Uncomment to enable AT traffic dumping */
 /* #define BTA_HF_CLIENT_AT_DUMP 1 */
@@ -1491,25 +1492,78 @@ static char* bta_hf_client_process_unknown(tBTA_HF_CLIENT_CB* client_cb,
  */
 typedef char* (*tBTA_HF_CLIENT_PARSER_CALLBACK)(tBTA_HF_CLIENT_CB*, char*);
 
-static const tBTA_HF_CLIENT_PARSER_CALLBACK bta_hf_client_parser_cb[] = {
-    bta_hf_client_parse_ok,          bta_hf_client_parse_error,
-    bta_hf_client_parse_ring,        bta_hf_client_parse_brsf,
-    bta_hf_client_parse_cind,        bta_hf_client_parse_ciev,
-    bta_hf_client_parse_chld,        bta_hf_client_parse_bcs,
-    bta_hf_client_parse_bsir,        bta_hf_client_parse_cmeerror,
-    bta_hf_client_parse_vgm,         bta_hf_client_parse_vgme,
-    bta_hf_client_parse_vgs,         bta_hf_client_parse_vgse,
-    bta_hf_client_parse_bvra,        bta_hf_client_parse_clip,
-    bta_hf_client_parse_ccwa,        bta_hf_client_parse_cops,
-    bta_hf_client_parse_binp,        bta_hf_client_parse_clcc,
-    bta_hf_client_parse_cnum,        bta_hf_client_parse_btrh,
-    bta_hf_client_parse_busy,        bta_hf_client_parse_delayed,
-    bta_hf_client_parse_no_carrier,  bta_hf_client_parse_no_answer,
-    bta_hf_client_parse_blacklisted, bta_hf_client_process_unknown};
-
-/* calculate supported event list length */
-static const uint16_t bta_hf_client_parser_cb_count =
-    sizeof(bta_hf_client_parser_cb) / sizeof(bta_hf_client_parser_cb[0]);
+typedef struct {
+  const char* p_event; /* event name, up to and including ':' or '=' */
+  tBTA_HF_CLIENT_PARSER_CALLBACK p_parser;
+} tBTA_HF_CLIENT_PARSER;
+
+static constexpr tBTA_HF_CLIENT_PARSER bta_hf_client_parser_tbl[] = {
+    {"OK", bta_hf_client_parse_ok},
+    {"ERROR", bta_hf_client_parse_error},
+    {"RING", bta_hf_client_parse_ring},
+    {"+BRSF:", bta_hf_client_parse_brsf},
+    {"+CIND:", bta_hf_client_parse_cind},
+    {"+CIEV:", bta_hf_client_parse_ciev},
+    {"+CHLD:", bta_hf_client_parse_chld},
+    {"+BCS:", bta_hf_client_parse_bcs},
+    {"+BSIR:", bta_hf_client_parse_bsir},
+    {"+CME ERROR:", bta_hf_client_parse_cmeerror},
+    {"+VGM:", bta_hf_client_parse_vgm},
+    {"+VGM=", bta_hf_client_parse_vgme},
+    {"+VGS:", bta_hf_client_parse_vgs},
+    {"+VGS=", bta_hf_client_parse_vgse},
+    {"+BVRA:", bta_hf_client_parse_bvra},
+    {"+CLIP:", bta_hf_client_parse_clip},
+    {"+CCWA:", bta_hf_client_parse_ccwa},
+    {"+COPS:", bta_hf_client_parse_cops},
+    {"+BINP:", bta_hf_client_parse_binp},
+    {"+CLCC:", bta_hf_client_parse_clcc},
+    {"+CNUM:", bta_hf_client_parse_cnum},
+    {"+BTRH:", bta_hf_client_parse_btrh},
+    {"BUSY", bta_hf_client_parse_busy},
+    {"DELAYED", bta_hf_client_parse_delayed},
+    {"NO CARRIER", bta_hf_client_parse_no_carrier},
+    {"NO ANSWER", bta_hf_client_parse_no_answer},
+    {"BLACKLISTED", bta_hf_client_parse_blacklisted}};
+
+/* perfect hash index of the supported events */
+static constexpr tUTL_AT_INDEX bta_hf_client_parser_index =
+    utl_at_build_index(bta_hf_client_parser_tbl,
+                       &tBTA_HF_CLIENT_PARSER::p_event);
+static_assert(utl_at_index_ok(bta_hf_client_parser_index,
+                              bta_hf_client_parser_tbl,
+                              &tBTA_HF_CLIENT_PARSER::p_event),
+              "no perfect hash found for the AT event table");
+
+/* Finds the length of the event name at |buffer|, which starts after the
+ * leading <cr><lf>: up to and including the first ':' or '=', else up to the
+ * ending <cr> without the spaces before it. */
+static size_t bta_hf_client_event_len(const char* buffer) {
+  const char* p = buffer;
+
+  while (*p != ':' && *p != '=' && *p != '\r' && *p != '\0') p++;
+  if (*p == ':' || *p == '=') return p - buffer + 1;
+
+  while (p > buffer && *(p - 1) == ' ') p--;
+  return p - buffer;
+}
+
+/* Returns the parser of the event at |buffer|, the one forwarding unknown
+ * events to the application if the event isn't supported. */
+static tBTA_HF_CLIENT_PARSER_CALLBACK bta_hf_client_find_parser(
+    const char* buffer) {
+  if (strncmp("\r\n", buffer, sizeof("\r\n") - 1) != 0)
+    return bta_hf_client_process_unknown;
+
+  buffer += sizeof("\r\n") - 1;
+  int idx = utl_at_index_find(
+      &bta_hf_client_parser_index, bta_hf_client_parser_tbl,
+      &tBTA_HF_CLIENT_PARSER::p_event, buffer,
+      bta_hf_client_event_len(buffer), false);
+  if (idx < 0) return bta_hf_client_process_unknown;
+
+  return bta_hf_client_parser_tbl[idx].p_parser;
+}
 
 #ifdef BTA_HF_CLIENT_AT_DUMP
 static void bta_hf_client_dump_at(tBTA_HF_CLIENT_CB* client_cb) {
@@ -1549,23 +1603,10 @@ static void bta_hf_client_at_parse_start(tBTA_HF_CLIENT_CB* client_cb) {
 #endif
 
   while (*buf != '\0') {
-    int i;
-    char* tmp = NULL;
-
-    for (i = 0; i < bta_hf_client_parser_cb_count; i++) {
-      tmp = bta_hf_client_parser_cb[i](client_cb, buf);
-      if (tmp == NULL) {
-        APPL_TRACE_ERROR("HFPCient: AT event/reply parsing failed, skipping");
-        tmp = bta_hf_client_skip_unknown(client_cb, buf);
-        break;
-      }
-
-      /* matched or unknown skipped, if unknown failed tmp is NULL so
-         this is also handled */
-      if (tmp != buf) {
-        buf = tmp;
-        break;
-      }
+    char* tmp = bta_hf_client_find_parser(buf)(client_cb, buf);
+    if (tmp == NULL || tmp == buf) {
+      APPL_TRACE_ERROR("HFPCient: AT event/reply parsing failed, skipping");
+      tmp = bta_hf_client_skip_unknown(client_cb, buf);
     }
 
     /* could not skip unknown (received garbage?)... disconnect */
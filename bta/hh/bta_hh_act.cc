@@ -1164,6 +1164,21 @@ static void bta_hh_cback(uint8_t dev_handle, const RawAddress& addr,
       sm_event = BTA_HH_INT_CLOSE_EVT;
       break;
     case HID_HDEV_EVT_INTR_DATA:
+      /* Input reports of a connected device skip the BTA message queue: we
+       * already run on the BTU thread, so the report goes to uhid without
+       * waiting behind whatever else is queued. */
+      xx = bta_hh_dev_handle_to_cb_idx(dev_handle);
+      if (xx < BTA_HH_MAX_DEVICE &&
+          bta_hh_cb.kdev[xx].state == BTA_HH_CONN_ST) {
+        tBTA_HH_DEV_CB* p_cb = &bta_hh_cb.kdev[xx];
+        uint8_t* p_rpt = (uint8_t*)(pdata + 1) + pdata->offset;
+
+        bta_hh_co_data(dev_handle, p_rpt, pdata->len, p_cb->mode,
+                       p_cb->sub_class, p_cb->dscp_info.ctry_code, p_cb->addr,
+                       p_cb->app_id);
+        osi_free(pdata);
+        return;
+      }
       sm_event = BTA_HH_INT_DATA_EVT;
       break;
     case HID_HDEV_EVT_HANDSHAKE:
@@ -768,6 +768,8 @@ typedef tBTM_RAW_CMPL_CB tBTA_RAW_CMPL_CBACK;
 #define BTA_DM_DISC_CMPL_EVT 4          /* Discovery complete. */
 #define BTA_DM_DI_DISC_CMPL_EVT 5       /* Discovery complete. */
 #define BTA_DM_SEARCH_CANCEL_CMPL_EVT 6 /* Search cancelled */
+#define BTA_DM_INQ_RES_BATCH_END_EVT \
+  7 /* End of the BLE observe results of one advertising report event. */
 
 typedef uint8_t tBTA_DM_SEARCH_EVT;
 
@@ -1807,7 +1809,9 @@ extern void BTA_DmSetEncryption(const RawAddress& bd_addr,
  * Parameters       start: start or stop observe.
  *                  duration : Duration of the scan. Continuous scan if 0 is
  *                             passed
- *                  p_results_cb: Callback to be called with scan results
+ *                  p_results_cb: Callback to be called with scan results,
+ *                             and with BTA_DM_INQ_RES_BATCH_END_EVT after
+ *                             the results of each advertising report event
  *
  * Returns          void
  *
@@ -0,0 +1,164 @@
+/******************************************************************************
+ *
+ *  Copyright 2019 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+/******************************************************************************
+ *
+ *  Perfect hash indexes over the names of AT command and result tables.
+ *
+ *  An index is built at compile time from a constexpr table: a seed is
+ *  searched for which every name of the table hashes to a slot of its own,
+ *  so a lookup costs one hash of the token and one comparison with the
+ *  single candidate, whatever the size of the table. Names hash case
+ *  insensitively; whether the comparison does is up to the caller.
+ *
+ ******************************************************************************/
+#ifndef UTL_AT_INDEX_H
+#define UTL_AT_INDEX_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*****************************************************************************
+ *  Constants
+ ****************************************************************************/
+
+/* Number of slots of an index, a power of two at least twice the number of
+ * names so that a collision free seed is found in a few tries */
+#define UTL_AT_INDEX_SLOTS 128
+
+/* Seeds tried before giving up on a table */
+#define UTL_AT_INDEX_MAX_TRIES 4096
+
+/*****************************************************************************
+ *  Type Definitions
+ ****************************************************************************/
+
+typedef struct {
+  uint32_t seed;
+  uint8_t count;                     /* names indexed, 0 if none could be */
+  uint8_t slot[UTL_AT_INDEX_SLOTS];  /* table entry + 1, 0 for empty */
+} tUTL_AT_INDEX;
+
+/*****************************************************************************
+ *  Functions
+ ****************************************************************************/
+
+constexpr char utl_at_upper(char c) {
+  return (c >= 'a' && c <= 'z') ? (char)(c - 0x20) : c;
+}
+
+constexpr size_t utl_at_slot(const char* p_name, size_t len, uint32_t seed) {
+  uint32_t hash = seed;
+  for (size_t i = 0; i < len; i++) {
+    hash = (hash ^ (uint8_t)utl_at_upper(p_name[i])) * 16777619u;
+  }
+  return (hash ^ (hash >> 16)) & (UTL_AT_INDEX_SLOTS - 1);
+}
+
+constexpr size_t utl_at_strlen(const char* p) {
+  size_t len = 0;
+  while (p[len] != 0) len++;
+  return len;
+}
+
+/*******************************************************************************
+ *
+ * Function         utl_at_build_index
+ *
+ * Description      Builds the index of the names of |tbl|, read through the
+ *                  |p_name| member. Entries with an empty name, such as end
+ *                  of table markers, are left out. Meant to initialize a
+ *                  constexpr index, with utl_at_index_ok() checked by a
+ *                  static_assert.
+ *
+ * Returns          The index.
+ *
+ ******************************************************************************/
+template <typename T, size_t N>
+constexpr tUTL_AT_INDEX utl_at_build_index(const T (&tbl)[N],
+                                           const char* T::*p_name) {
+  static_assert(N < 256, "AT table too large to be indexed");
+  tUTL_AT_INDEX index = {};
+  uint32_t seed = 2166136261u;
+  for (int tries = 0; tries < UTL_AT_INDEX_MAX_TRIES; tries++) {
+    bool collision = false;
+    for (size_t i = 0; i < UTL_AT_INDEX_SLOTS; i++) index.slot[i] = 0;
+    index.count = 0;
+    for (size_t i = 0; i < N && !collision; i++) {
+      const char* p = tbl[i].*p_name;
+      if (p[0] == 0) continue;
+      size_t s = utl_at_slot(p, utl_at_strlen(p), seed);
+      if (index.slot[s] != 0) {
+        collision = true;
+      } else {
+        index.slot[s] = (uint8_t)(i + 1);
+        index.count++;
+      }
+    }
+    if (!collision) {
+      index.seed = seed;
+      return index;
+    }
+    seed += 0x9e3779b9u;
+  }
+  index.count = 0;
+  return index;
+}
+
+/* Checks that |index| covers every named entry of |tbl| */
+template <typename T, size_t N>
+constexpr bool utl_at_index_ok(const tUTL_AT_INDEX& index, const T (&tbl)[N],
+                               const char* T::*p_name) {
+  size_t named = 0;
+  for (size_t i = 0; i < N; i++) {
+    if ((tbl[i].*p_name)[0] != 0) named++;
+  }
+  return named != 0 && index.count == named;
+}
+
+/*******************************************************************************
+ *
+ * Function         utl_at_index_find
+ *
+ * Description      Looks up the |len| characters at |p_token| in |index|,
+ *                  built over |p_tbl|. The token does not have to be null
+ *                  terminated. Upper and lower case letters of the token
+ *                  match the same name when |ignore_case| is set, the names
+ *                  of the table then have to be in upper case.
+ *
+ * Returns          Position of the matching entry in |p_tbl|, -1 if none.
+ *
+ ******************************************************************************/
+template <typename T>
+inline int utl_at_index_find(const tUTL_AT_INDEX* index, const T* p_tbl,
+                             const char* T::*p_name, const char* p_token,
+                             size_t len, bool ignore_case) {
+  if (len == 0) return -1;
+  uint8_t entry = index->slot[utl_at_slot(p_token, len, index->seed)];
+  if (entry == 0) return -1;
+
+  const char* p = p_tbl[entry - 1].*p_name;
+  for (size_t i = 0; i < len; i++) {
+    char c = ignore_case ? utl_at_upper(p_token[i]) : p_token[i];
+    if (p[i] != c) return -1;
+  }
+  if (p[len] != 0) return -1;
+  return entry - 1;
+}
+
+#endif /* UTL_AT_INDEX_H */
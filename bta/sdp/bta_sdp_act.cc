@@ -566,6 +566,8 @@ void bta_sdp_search(tBTA_SDP_MSG* p_data) {
                    uuid.ToString().c_str());
   SDP_InitDiscoveryDb(p_bta_sdp_cfg->p_sdp_db, p_bta_sdp_cfg->sdp_db_size, 1,
                       &uuid, 0, NULL);
+  /* an app asking for the records wants what the remote has now */
+  p_bta_sdp_cfg->p_sdp_db->bypass_cache = true;
 
   Uuid* bta_sdp_search_uuid = (Uuid*)osi_malloc(sizeof(Uuid));
   *bta_sdp_search_uuid = uuid;
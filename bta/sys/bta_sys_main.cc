@@ -539,7 +539,10 @@ void bta_sys_sendmsg(void* p_msg) {
   }
 
   bta_message_loop->task_runner()->PostTask(
-      FROM_HERE, base::Bind(&bta_sys_event, static_cast<BT_HDR*>(p_msg)));
+      FROM_HERE,
+      task_stats_wrap(
+          get_message_loop_task_stats(), FROM_HERE,
+          base::Bind(&bta_sys_event, static_cast<BT_HDR*>(p_msg))));
 }
 
 /*******************************************************************************
@@ -560,7 +563,9 @@ void do_in_bta_thread(const base::Location& from_here,
     return;
   }
 
-  bta_message_loop->task_runner()->PostTask(from_here, task);
+  bta_message_loop->task_runner()->PostTask(
+      from_here,
+      task_stats_wrap(get_message_loop_task_stats(), from_here, task));
 }
 
 /*******************************************************************************
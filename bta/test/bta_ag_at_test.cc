@@ -0,0 +1,176 @@
+/******************************************************************************
+ *
+ *  Copyright 2019 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#include <gtest/gtest.h>
+#include <string.h>
+
+#include <string>
+
+#include "bta/ag/bta_ag_at.h"
+
+namespace {
+
+enum {
+  TEST_CMD_A = 1,
+  TEST_CMD_D,
+  TEST_CMD_VGS,
+  TEST_CMD_CIND,
+  TEST_CMD_QAC,
+};
+
+constexpr tBTA_AG_AT_CMD test_cmd_tbl[] = {
+    {"A", TEST_CMD_A, BTA_AG_AT_NONE, BTA_AG_AT_STR, 0, 0},
+    {"D", TEST_CMD_D, BTA_AG_AT_NONE | BTA_AG_AT_FREE, BTA_AG_AT_STR, 0, 0},
+    {"+VGS", TEST_CMD_VGS, BTA_AG_AT_SET, BTA_AG_AT_INT, 0, 15},
+    {"+CIND", TEST_CMD_CIND, BTA_AG_AT_READ | BTA_AG_AT_TEST, BTA_AG_AT_STR, 0,
+     0},
+    {"+%QAC", TEST_CMD_QAC, BTA_AG_AT_SET, BTA_AG_AT_STR, 0, 0},
+    {"", 0, 0, 0, 0, 0}};
+
+constexpr tUTL_AT_INDEX test_cmd_index =
+    utl_at_build_index(test_cmd_tbl, &tBTA_AG_AT_CMD::p_cmd);
+static_assert(utl_at_index_ok(test_cmd_index, test_cmd_tbl,
+                              &tBTA_AG_AT_CMD::p_cmd),
+              "no perfect hash found for the test table");
+
+struct {
+  int commands;
+  uint16_t command_id;
+  uint8_t arg_type;
+  std::string arg;
+  int16_t int_arg;
+  int errors;
+  bool unknown;
+  std::string unknown_cmd;
+} result;
+
+void cmd_cback(tBTA_AG_SCB* p_user, uint16_t command_id, uint8_t arg_type,
+               char* p_arg, char* p_end, int16_t int_arg) {
+  result.commands++;
+  result.command_id = command_id;
+  result.arg_type = arg_type;
+  result.arg = p_arg;
+  result.int_arg = int_arg;
+}
+
+void err_cback(tBTA_AG_SCB* p_user, bool unknown, char* p_arg) {
+  result.errors++;
+  result.unknown = unknown;
+  result.unknown_cmd = p_arg != NULL ? p_arg : "";
+}
+
+}  // namespace
+
+class BtaAgAtTest : public testing::Test {
+ protected:
+  void SetUp() override {
+    result = {};
+    memset(&at_cb_, 0, sizeof(at_cb_));
+    at_cb_.p_at_tbl = (tBTA_AG_AT_CMD*)test_cmd_tbl;
+    at_cb_.p_at_index = &test_cmd_index;
+    at_cb_.p_cmd_cback = cmd_cback;
+    at_cb_.p_err_cback = err_cback;
+    at_cb_.cmd_max_len = 64;
+    bta_ag_at_init(&at_cb_);
+  }
+
+  void TearDown() override { bta_ag_at_reinit(&at_cb_); }
+
+  void Parse(const char* at) {
+    std::string buf(at);
+    bta_ag_at_parse(&at_cb_, &buf[0], buf.size());
+  }
+
+  tBTA_AG_AT_CB at_cb_;
+};
+
+TEST_F(BtaAgAtTest, test_set_ignores_case) {
+  Parse("at+vgs=7\r");
+
+  EXPECT_EQ(1, result.commands);
+  EXPECT_EQ(TEST_CMD_VGS, result.command_id);
+  EXPECT_EQ(BTA_AG_AT_SET, result.arg_type);
+  EXPECT_EQ(7, result.int_arg);
+  EXPECT_EQ(0, result.errors);
+}
+
+TEST_F(BtaAgAtTest, test_read_and_test) {
+  Parse("AT+CIND?\r");
+  EXPECT_EQ(TEST_CMD_CIND, result.command_id);
+  EXPECT_EQ(BTA_AG_AT_READ, result.arg_type);
+
+  Parse("AT+CIND=?\r");
+  EXPECT_EQ(TEST_CMD_CIND, result.command_id);
+  EXPECT_EQ(BTA_AG_AT_TEST, result.arg_type);
+  EXPECT_EQ(2, result.commands);
+}
+
+TEST_F(BtaAgAtTest, test_basic_command_takes_rest_as_argument) {
+  Parse("ATD1234567;\r");
+
+  EXPECT_EQ(1, result.commands);
+  EXPECT_EQ(TEST_CMD_D, result.command_id);
+  EXPECT_EQ(BTA_AG_AT_FREE, result.arg_type);
+  EXPECT_EQ("1234567;", result.arg);
+}
+
+TEST_F(BtaAgAtTest, test_vendor_prefix) {
+  Parse("AT+%QAC=1,2\r");
+
+  EXPECT_EQ(1, result.commands);
+  EXPECT_EQ(TEST_CMD_QAC, result.command_id);
+  EXPECT_EQ("1,2", result.arg);
+}
+
+TEST_F(BtaAgAtTest, test_unknown_command) {
+  Parse("AT+XAPL=ABCD-1234-0100,10\r");
+
+  EXPECT_EQ(0, result.commands);
+  EXPECT_EQ(1, result.errors);
+  EXPECT_TRUE(result.unknown);
+  EXPECT_EQ("+XAPL=ABCD-1234-0100,10", result.unknown_cmd);
+}
+
+TEST_F(BtaAgAtTest, test_longer_name_is_unknown) {
+  Parse("AT+VGSX=1\r");
+  Parse("AT+VG=1\r");
+
+  EXPECT_EQ(0, result.commands);
+  EXPECT_EQ(2, result.errors);
+  EXPECT_TRUE(result.unknown);
+}
+
+TEST_F(BtaAgAtTest, test_bad_argument) {
+  Parse("AT+VGS=16\r");
+  EXPECT_FALSE(result.unknown);
+
+  Parse("AT+VGS?\r");
+  EXPECT_FALSE(result.unknown);
+
+  EXPECT_EQ(0, result.commands);
+  EXPECT_EQ(2, result.errors);
+}
+
+TEST_F(BtaAgAtTest, test_command_split_across_packets) {
+  Parse("AT+V");
+  Parse("GS=3\rATA\r");
+
+  EXPECT_EQ(2, result.commands);
+  EXPECT_EQ(TEST_CMD_A, result.command_id);
+  EXPECT_EQ(BTA_AG_AT_NONE, result.arg_type);
+}
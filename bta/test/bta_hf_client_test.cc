@@ -25,7 +25,10 @@ namespace base {
 class MessageLoop;
 }  // namespace base
 
+typedef struct task_stats_t task_stats_t;
+
 base::MessageLoop* get_message_loop() { return NULL; }
+task_stats_t* get_message_loop_task_stats() { return NULL; }
 
 namespace {
 const RawAddress bdaddr1({0x11, 0x22, 0x33, 0x44, 0x55, 0x66});
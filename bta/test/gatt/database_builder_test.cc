@@ -162,4 +162,47 @@ TEST(DatabaseBuilderTest, SecondaryServiceOutOfOrderTest) {
   EXPECT_EQ(result.Services()[4].is_primary, true);
 }
 
+/* Verify that services reported out of order by the peer are kept sorted by
+ * start handle, so that every one of them can be found, and that a service
+ * overlapping another one is ignored */
+TEST(DatabaseBuilderTest, OutOfOrderPeerDatabaseTest) {
+  DatabaseBuilder builder;
+
+  builder.AddService(0x0030, 0x003f, SERVICE_3_UUID, true);
+  builder.AddService(0x0001, 0x000f, SERVICE_1_UUID, true);
+  builder.AddService(0x0050, 0x005f, SERVICE_5_UUID, true);
+  builder.AddService(0x0020, 0x002f, SERVICE_2_UUID, true);
+  // Overlaps 0x0020-0x002f and 0x0030-0x003f
+  builder.AddService(0x0028, 0x0034, SERVICE_4_UUID, true);
+  // Starts inside 0x0001-0x000f
+  builder.AddService(0x0008, 0x0018, SERVICE_4_UUID, true);
+
+  builder.AddCharacteristic(0x0021, 0x0022, SERVICE_1_CHAR_1_UUID, 0x02);
+  builder.AddCharacteristic(0x0031, 0x0032, SERVICE_1_CHAR_1_UUID, 0x02);
+  builder.AddCharacteristic(0x0051, 0x0052, SERVICE_1_CHAR_1_UUID, 0x02);
+
+  Database result = builder.Build();
+
+  ASSERT_EQ(4u, result.Services().size());
+  EXPECT_EQ(result.Services()[0].handle, 0x0001);
+  EXPECT_EQ(result.Services()[1].handle, 0x0020);
+  EXPECT_EQ(result.Services()[2].handle, 0x0030);
+  EXPECT_EQ(result.Services()[3].handle, 0x0050);
+
+  for (uint16_t handle : {0x0001, 0x000f, 0x0020, 0x002f, 0x0030, 0x003f,
+                          0x0050, 0x005f}) {
+    const Service* service = result.FindService(handle);
+    ASSERT_NE(nullptr, service) << "handle " << handle;
+    EXPECT_LE(service->handle, handle);
+    EXPECT_GE(service->end_handle, handle);
+  }
+  EXPECT_EQ(nullptr, result.FindService(0x0018));
+
+  EXPECT_EQ(1u, result.Services()[1].characteristics.size());
+  EXPECT_EQ(1u, result.Services()[2].characteristics.size());
+  EXPECT_EQ(1u, result.Services()[3].characteristics.size());
+  EXPECT_NE(nullptr, result.FindCharacteristic(0x0022));
+  EXPECT_NE(nullptr, result.FindCharacteristic(0x0052));
+}
+
 }  // namespace gatt
\ No newline at end of file
@@ -204,4 +204,47 @@ TEST(GattCacheTest, stored_attribute_to_binary_descriptor_test) {
   // LOG(ERROR) << " " << base::HexEncode(&attr, len);
   EXPECT_EQ(memcmp(binary_form, &attr, len), 0);
 }
-}  // namespace gatt
\ No newline at end of file
+
+/* This test makes sure that attributes can be looked up by handle, both in
+ * freshly built and in deserialized database */
+TEST(GattDatabaseTest, find_by_handle_test) {
+  DatabaseBuilder builder;
+  builder.AddService(0x0001, 0x000f, SERVICE_1_UUID, true);
+  builder.AddService(0x0020, 0x002f, SERVICE_2_UUID, true);
+  builder.AddCharacteristic(0x0003, 0x0004, SERVICE_1_CHAR_1_UUID, 0x02);
+  builder.AddDescriptor(0x0005, SERVICE_1_CHAR_1_DESC_1_UUID);
+  builder.AddCharacteristic(0x0021, 0x0022, SERVICE_1_CHAR_1_UUID, 0x10);
+  builder.AddDescriptor(0x0023, SERVICE_1_CHAR_1_DESC_1_UUID);
+
+  Database built = builder.Build();
+  bool success = false;
+  Database deserialized = Database::Deserialize(built.Serialize(), &success);
+  EXPECT_TRUE(success);
+
+  for (const Database* db : {&built, &deserialized}) {
+    EXPECT_EQ(db->FindService(0x0000), nullptr);
+    EXPECT_EQ(db->FindService(0x0001)->handle, 0x0001);
+    EXPECT_EQ(db->FindService(0x000f)->handle, 0x0001);
+    EXPECT_EQ(db->FindService(0x0010), nullptr);
+    EXPECT_EQ(db->FindService(0x0025)->handle, 0x0020);
+    EXPECT_EQ(db->FindService(0x0030), nullptr);
+
+    EXPECT_EQ(db->FindCharacteristic(0x0004)->declaration_handle, 0x0003);
+    EXPECT_EQ(db->FindCharacteristic(0x0022)->declaration_handle, 0x0021);
+    EXPECT_EQ(db->FindCharacteristic(0x0003), nullptr);
+    EXPECT_EQ(db->FindCharacteristic(0x0005), nullptr);
+
+    EXPECT_EQ(db->FindDescriptor(0x0005)->handle, 0x0005);
+    EXPECT_EQ(db->FindDescriptor(0x0023)->handle, 0x0023);
+    EXPECT_EQ(db->FindDescriptor(0x0004), nullptr);
+
+    EXPECT_EQ(db->FindOwningCharacteristic(0x0005)->value_handle, 0x0004);
+    EXPECT_EQ(db->FindOwningCharacteristic(0x0023)->value_handle, 0x0022);
+    EXPECT_EQ(db->FindOwningCharacteristic(0x0022), nullptr);
+  }
+
+  built.Clear();
+  EXPECT_EQ(built.FindService(0x0001), nullptr);
+  EXPECT_EQ(built.FindCharacteristic(0x0004), nullptr);
+}
+}  // namespace gatt
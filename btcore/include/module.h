@@ -19,6 +19,7 @@
 #pragma once
 
 #include <stdbool.h>
+#include <stddef.h>
 
 #include "osi/include/future.h"
 #include "osi/include/thread.h"
@@ -57,6 +58,15 @@ void module_shut_down(const module_t* module);
 // If not initialized, does nothing.
 void module_clean_up(const module_t* module);
 
+// Initialize or start up all of |modules|. Modules that do not depend on each
+// other through their |dependencies| run concurrently, each on a thread of its
+// own. Returns true only if every module succeeded.
+bool module_init_parallel(const module_t* const modules[], size_t count);
+bool module_start_up_parallel(const module_t* const modules[], size_t count);
+
+// Dumps the wall clock time spent in recent module init and start up calls.
+void module_debug_dump(int fd);
+
 // Temporary callbacked wrapper for module start up, so real modules can be
 // spliced into the current janky startup sequence. Runs on a separate thread,
 // which terminates when the module start up has finished. When module startup
@@ -20,15 +20,19 @@
 
 #include <base/logging.h>
 #include <dlfcn.h>
+#include <stdio.h>
 #include <string.h>
 
+#include <deque>
 #include <mutex>
 #include <unordered_map>
+#include <vector>
 
 #include "btcore/include/module.h"
 #include "osi/include/allocator.h"
 #include "osi/include/log.h"
 #include "osi/include/osi.h"
+#include "osi/include/time.h"
 
 typedef enum {
   MODULE_STATE_NONE = 0,
@@ -44,7 +48,22 @@ static std::unordered_map<const module_t*, module_state_t> metadata;
 // TODO(jamuraa): remove this lock after the startup sequence is clean
 static std::mutex metadata_mutex;
 
+// Wall clock time spent in each init and start up call, oldest first
+#define MODULE_TIMELINE_MAX_ENTRIES 64
+typedef struct {
+  const char* module_name;
+  const char* phase;
+  uint64_t begin_us;
+  uint64_t end_us;
+  bool success;
+} timeline_entry_t;
+static std::deque<timeline_entry_t> timeline;
+static std::mutex timeline_mutex;
+
 static bool call_lifecycle_function(module_lifecycle_fn function);
+static bool call_timed_lifecycle_function(const module_t* module,
+                                          const char* phase,
+                                          module_lifecycle_fn function);
 static module_state_t get_module_state(const module_t* module);
 static void set_module_state(const module_t* module, module_state_t state);
 
@@ -64,7 +83,7 @@ bool module_init(const module_t* module) {
   CHECK(module != NULL);
   CHECK(get_module_state(module) == MODULE_STATE_NONE);
 
-  if (!call_lifecycle_function(module->init)) {
+  if (!call_timed_lifecycle_function(module, "init", module->init)) {
     LOG_ERROR(LOG_TAG, "%s Failed to initialize module \"%s\"", __func__,
               module->name);
     return false;
@@ -86,7 +105,7 @@ bool module_start_up(const module_t* module) {
 
   LOG_INFO(LOG_TAG, "%s Starting module \"%s\"", __func__, module->name);
   set_module_state(module, MODULE_STATE_STARTING);
-  if (!call_lifecycle_function(module->start_up)) {
+  if (!call_timed_lifecycle_function(module, "start_up", module->start_up)) {
     LOG_ERROR(LOG_TAG, "%s Failed to start up module \"%s\"", __func__,
               module->name);
     set_module_state(module, MODULE_STATE_STARTUP_ERROR);
@@ -152,6 +171,22 @@ static bool call_lifecycle_function(module_lifecycle_fn function) {
   return future_await(future);
 }
 
+static bool call_timed_lifecycle_function(const module_t* module,
+                                          const char* phase,
+                                          module_lifecycle_fn function) {
+  timeline_entry_t entry;
+  entry.module_name = module->name;
+  entry.phase = phase;
+  entry.begin_us = time_get_os_boottime_us();
+  entry.success = call_lifecycle_function(function);
+  entry.end_us = time_get_os_boottime_us();
+
+  std::lock_guard<std::mutex> lock(timeline_mutex);
+  if (timeline.size() == MODULE_TIMELINE_MAX_ENTRIES) timeline.pop_front();
+  timeline.push_back(entry);
+  return entry.success;
+}
+
 static module_state_t get_module_state(const module_t* module) {
   std::lock_guard<std::mutex> lock(metadata_mutex);
   auto map_ptr = metadata.find(module);
@@ -218,3 +253,103 @@ static void post_result_to_callback(void* context) {
 
   callback(result);
 }
+
+// Parallel lifecycle execution
+
+typedef struct {
+  const module_t* module;
+  bool (*lifecycle)(const module_t* module);
+  future_t* done;
+} parallel_step_t;
+
+static void run_parallel_step(void* context) {
+  parallel_step_t* step = (parallel_step_t*)context;
+  bool success = step->lifecycle(step->module);
+  future_ready(step->done, success ? FUTURE_SUCCESS : FUTURE_FAIL);
+}
+
+static bool depends_on(const module_t* module, const module_t* other) {
+  for (int i = 0; i < BTCORE_MAX_MODULE_DEPENDENCIES; i++) {
+    if (module->dependencies[i] == NULL) break;
+    if (strcmp(module->dependencies[i], other->name) == 0) return true;
+  }
+  return false;
+}
+
+// Runs |lifecycle| on every module in |modules|, in waves. Each wave holds the
+// modules whose dependencies within the set have completed, and runs them on
+// threads of their own. Dependencies outside the set must already be satisfied.
+static bool run_parallel(const module_t* const modules[], size_t count,
+                         bool (*lifecycle)(const module_t* module)) {
+  std::vector<const module_t*> remaining(modules, modules + count);
+  bool success = true;
+
+  while (!remaining.empty()) {
+    std::vector<const module_t*> wave;
+    for (const module_t* module : remaining) {
+      bool ready = true;
+      for (const module_t* other : remaining) {
+        if (other != module && depends_on(module, other)) {
+          ready = false;
+          break;
+        }
+      }
+      if (ready) wave.push_back(module);
+    }
+    CHECK(!wave.empty()) << __func__ << ": dependency cycle";
+
+    if (wave.size() == 1) {
+      success &= lifecycle(wave[0]);
+    } else {
+      std::vector<thread_t*> threads;
+      std::vector<parallel_step_t> steps(wave.size());
+      for (size_t i = 0; i < wave.size(); i++) {
+        steps[i].module = wave[i];
+        steps[i].lifecycle = lifecycle;
+        steps[i].done = future_new();
+        thread_t* thread = thread_new(wave[i]->name);
+        CHECK(thread != NULL);
+        thread_post(thread, run_parallel_step, &steps[i]);
+        threads.push_back(thread);
+      }
+      for (size_t i = 0; i < wave.size(); i++) {
+        success &= (future_await(steps[i].done) == FUTURE_SUCCESS);
+        thread_free(threads[i]);
+      }
+    }
+
+    for (const module_t* module : wave) {
+      for (auto it = remaining.begin(); it != remaining.end(); ++it) {
+        if (*it == module) {
+          remaining.erase(it);
+          break;
+        }
+      }
+    }
+  }
+  return success;
+}
+
+bool module_init_parallel(const module_t* const modules[], size_t count) {
+  return run_parallel(modules, count, module_init);
+}
+
+bool module_start_up_parallel(const module_t* const modules[], size_t count) {
+  return run_parallel(modules, count, module_start_up);
+}
+
+void module_debug_dump(int fd) {
+  std::lock_guard<std::mutex> lock(timeline_mutex);
+
+  dprintf(fd, "\nModule lifecycle timeline:\n");
+  if (timeline.empty()) return;
+
+  uint64_t origin_us = timeline.front().begin_us;
+  for (const timeline_entry_t& entry : timeline) {
+    dprintf(fd, "  %-24s %-9s +%8llu ms %8llu us%s\n", entry.module_name,
+            entry.phase,
+            (unsigned long long)((entry.begin_us - origin_us) / 1000),
+            (unsigned long long)(entry.end_us - entry.begin_us),
+            entry.success ? "" : " (failed)");
+  }
+}
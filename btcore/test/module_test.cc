@@ -0,0 +1,139 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2019 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+
+#include "osi/test/AllocationTestHarness.h"
+
+#include "btcore/include/module.h"
+
+// Modules meeting at a rendezvous wait there for each other, so they only
+// both get past it if they run at the same time. The timeout keeps modules
+// run one after the other from blocking the test.
+static std::mutex rendezvous_mutex;
+static std::condition_variable rendezvous_cv;
+static int rendezvous_arrived;
+static int rendezvous_met;
+
+static bool first_done;
+static bool dependency_done_before_start;
+
+static void rendezvous() {
+  std::unique_lock<std::mutex> lock(rendezvous_mutex);
+  rendezvous_arrived++;
+  rendezvous_cv.notify_all();
+  if (rendezvous_cv.wait_for(lock, std::chrono::seconds(5),
+                             [] { return rendezvous_arrived == 2; }))
+    rendezvous_met++;
+}
+
+static future_t* left_start_up() {
+  rendezvous();
+  return NULL;
+}
+
+static future_t* right_start_up() {
+  rendezvous();
+  return NULL;
+}
+
+static future_t* first_start_up() {
+  first_done = true;
+  return NULL;
+}
+
+static future_t* dependent_start_up() {
+  dependency_done_before_start = first_done;
+  return NULL;
+}
+
+static future_t* failing_start_up() { return future_new_immediate(FUTURE_FAIL); }
+
+static const module_t left_module = {.name = "left_module",
+                                     .init = NULL,
+                                     .start_up = left_start_up,
+                                     .shut_down = NULL,
+                                     .clean_up = NULL,
+                                     .dependencies = {NULL}};
+
+static const module_t right_module = {.name = "right_module",
+                                      .init = NULL,
+                                      .start_up = right_start_up,
+                                      .shut_down = NULL,
+                                      .clean_up = NULL,
+                                      .dependencies = {NULL}};
+
+static const module_t first_module = {.name = "first_module",
+                                      .init = NULL,
+                                      .start_up = first_start_up,
+                                      .shut_down = NULL,
+                                      .clean_up = NULL,
+                                      .dependencies = {NULL}};
+
+static const module_t dependent_module = {
+    .name = "dependent_module",
+    .init = NULL,
+    .start_up = dependent_start_up,
+    .shut_down = NULL,
+    .clean_up = NULL,
+    .dependencies = {"first_module", NULL}};
+
+static const module_t failing_module = {.name = "failing_module",
+                                        .init = NULL,
+                                        .start_up = failing_start_up,
+                                        .shut_down = NULL,
+                                        .clean_up = NULL,
+                                        .dependencies = {NULL}};
+
+class ModuleTest : public AllocationTestHarness {
+ protected:
+  void SetUp() override {
+    AllocationTestHarness::SetUp();
+    module_management_start();
+    rendezvous_arrived = 0;
+    rendezvous_met = 0;
+    first_done = false;
+    dependency_done_before_start = false;
+  }
+
+  void TearDown() override {
+    module_management_stop();
+    AllocationTestHarness::TearDown();
+  }
+};
+
+TEST_F(ModuleTest, test_independent_modules_start_concurrently) {
+  const module_t* modules[] = {&left_module, &right_module};
+  EXPECT_TRUE(module_start_up_parallel(modules, 2));
+  EXPECT_EQ(2, rendezvous_met);
+}
+
+TEST_F(ModuleTest, test_dependencies_start_first) {
+  const module_t* modules[] = {&dependent_module, &first_module};
+  EXPECT_TRUE(module_start_up_parallel(modules, 2));
+  EXPECT_TRUE(dependency_done_before_start);
+}
+
+TEST_F(ModuleTest, test_failure_is_reported) {
+  const module_t* modules[] = {&first_module, &failing_module};
+  EXPECT_FALSE(module_start_up_parallel(modules, 2));
+}
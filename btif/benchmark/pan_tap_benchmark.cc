@@ -0,0 +1,84 @@
+/*
+ * Copyright 2019 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+#include <linux/if_ether.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <thread>
+#include <vector>
+
+#include "bt_target.h"
+#include "btif_pan_internal.h"
+
+using ::benchmark::State;
+
+// Bytes queued in the socket before the writer has to wait for the reader
+#define SOCKET_BUFFER_SIZE (256 * 1024)
+
+// Pushes frames through btpan_tap_send() into a packet socket that keeps frame
+// boundaries like the tap device does, with a reader thread draining the
+// other end like the network stack would. Opening a real tap interface needs
+// privileges that benchmarks don't have.
+class BM_PanTapSend : public ::benchmark::Fixture {
+ protected:
+  void SetUp(State& st) override {
+    ::benchmark::Fixture::SetUp(st);
+    int fds[2];
+    socketpair(AF_UNIX, SOCK_SEQPACKET, 0, fds);
+    int size = SOCKET_BUFFER_SIZE;
+    setsockopt(fds[0], SOL_SOCKET, SO_SNDBUF, &size, sizeof(size));
+    setsockopt(fds[1], SOL_SOCKET, SO_RCVBUF, &size, sizeof(size));
+    tap_fd_ = fds[0];
+    peer_fd_ = fds[1];
+
+    reader_ = std::thread([this] {
+      std::vector<uint8_t> frame(TAP_MAX_PKT_WRITE_LEN + sizeof(tETH_HDR));
+      while (read(peer_fd_, frame.data(), frame.size()) > 0) {
+      }
+    });
+  }
+
+  void TearDown(State& st) override {
+    shutdown(tap_fd_, SHUT_RDWR);
+    reader_.join();
+    close(tap_fd_);
+    close(peer_fd_);
+    ::benchmark::Fixture::TearDown(st);
+  }
+
+  int tap_fd_ = -1;
+  int peer_fd_ = -1;
+  std::thread reader_;
+};
+
+BENCHMARK_DEFINE_F(BM_PanTapSend, frames)(State& state) {
+  const RawAddress src = {{0x00, 0x11, 0x22, 0x33, 0x44, 0x55}};
+  const RawAddress dst = {{0x00, 0x66, 0x77, 0x88, 0x99, 0xaa}};
+  std::vector<char> payload(state.range(0), 0x5a);
+
+  for (auto _ : state) {
+    btpan_tap_send(tap_fd_, src, dst, ETH_P_IP, payload.data(),
+                   payload.size(), false, false);
+  }
+  state.SetBytesProcessed(state.iterations() * payload.size());
+}
+
+// Small frames are TCP acks, large ones full MTU segments
+BENCHMARK_REGISTER_F(BM_PanTapSend, frames)->Arg(64)->Arg(576)->Arg(1500);
+
+BENCHMARK_MAIN();
@@ -77,43 +77,21 @@ void bta_dm_co_lk_upgrade(UNUSED_ATTR const RawAddress& bd_addr,
 
 #if (BTM_SCO_HCI_INCLUDED == TRUE) && (BTM_SCO_INCLUDED == TRUE)
 
-/*******************************************************************************
- *
- * Function         btui_sco_codec_callback
- *
- * Description      Callback for btui codec.
- *
- *
- * Returns          void
- *
- ******************************************************************************/
-static void btui_sco_codec_callback(uint16_t event, uint16_t sco_handle) {
-  bta_dm_sco_ci_data_ready(event, sco_handle);
-}
-
 /*******************************************************************************
  *
  * Function         bta_dm_sco_co_open
  *
  * Description      This function is executed when a SCO connection is open.
- *
+ *                  SCO audio over HCI is served by the SCO sockets, see
+ *                  btif_sock_sco.cc, so there is no codec to open here.
  *
  * Returns          void
  *
  ******************************************************************************/
-void bta_dm_sco_co_open(uint16_t handle, uint8_t pkt_size, uint16_t event) {
-  tBTUI_SCO_CODEC_CFG cfg;
-
-  if (btui_cb.sco_hci) {
-    BTIF_TRACE_DEBUG("bta_dm_sco_co_open handle:%d pkt_size:%d", handle,
-                     pkt_size);
-    cfg.p_cback = btui_sco_codec_callback;
-    cfg.pkt_size = pkt_size;
-    cfg.cb_event = event;
-    /* open and start the codec */
-    btui_sco_codec_open(&cfg);
-    btui_sco_codec_start(handle);
-  }
+void bta_dm_sco_co_open(uint16_t handle, uint8_t pkt_size,
+                        UNUSED_ATTR uint16_t event) {
+  BTIF_TRACE_DEBUG("bta_dm_sco_co_open handle:%d pkt_size:%d", handle,
+                   pkt_size);
 }
 
 /*******************************************************************************
@@ -127,13 +105,7 @@ void bta_dm_sco_co_open(uint16_t handle, uint8_t pkt_size, uint16_t event) {
  *
  ******************************************************************************/
 void bta_dm_sco_co_close(void) {
-  if (btui_cb.sco_hci) {
-    BTIF_TRACE_DEBUG("bta_dm_sco_co_close close codec");
-    /* close sco codec */
-    btui_sco_codec_close();
-
-    btui_cb.sco_hci = false;
-  }
+  BTIF_TRACE_DEBUG("bta_dm_sco_co_close");
 }
 
 /*******************************************************************************
@@ -146,11 +118,9 @@ void bta_dm_sco_co_close(void) {
  * Returns          void
  *
  ******************************************************************************/
-void bta_dm_sco_co_in_data(BT_HDR* p_buf) {
-  if (btui_cfg.sco_use_mic)
-    btui_sco_codec_inqdata(p_buf);
-  else
-    osi_free(p_buf);
+void bta_dm_sco_co_in_data(BT_HDR* p_buf,
+                           UNUSED_ATTR tBTM_SCO_DATA_FLAG status) {
+  osi_free(p_buf);
 }
 
 /*******************************************************************************
@@ -162,7 +132,7 @@ void bta_dm_sco_co_in_data(BT_HDR* p_buf) {
  * Returns          void
  *
  ******************************************************************************/
-void bta_dm_sco_co_out_data(BT_HDR** p_buf) { btui_sco_codec_readbuf(p_buf); }
+void bta_dm_sco_co_out_data(BT_HDR** p_buf) { *p_buf = NULL; }
 
 #endif /* (BTM_SCO_HCI_INCLUDED == TRUE) && (BTM_SCO_INCLUDED == TRUE)*/
 
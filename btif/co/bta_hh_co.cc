@@ -22,13 +22,13 @@
 #include <fcntl.h>
 #include <linux/uhid.h>
 #include <linux/version.h>
-#include <pthread.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <string.h>
-#include <sys/poll.h>
 #include <unistd.h>
 
+#include <atomic>
+
 #include "bta_api.h"
 #include "bta_hh_api.h"
 #include "bta_hh_co.h"
@@ -36,8 +36,11 @@
 #include "btif_util.h"
 #include "device/include/interop.h"
 #include "osi/include/osi.h"
+#include "osi/include/packet_trace.h"
+#include "osi/include/reactor.h"
 #include "osi/include/socket_utils/sockets.h"
 #include "osi/include/properties.h"
+#include "osi/include/thread.h"
 
 const char* dev_path = "/dev/uhid";
 const char* hid_3d_audio_path = "/dev/socket/spatialaudio";
@@ -49,6 +52,11 @@ static tBTA_HH_RPT_CACHE_ENTRY sReportCache[BTA_HH_NV_LOAD_MAX];
 #endif
 #define BT_HID_RPT_OFFSET 9
 
+/* All uhid devices are watched from a single thread, which is started with the
+ * first device and stopped by bta_hh_co_cleanup(). */
+static thread_t* uhid_thread;
+static std::atomic<reactor_object_t*> uhid_objects[BTIF_HH_MAX_HID];
+
 #define REPORT_DESC_REPORT_ID 0x05
 #define REPORT_DESC_DIGITIZER_PAGE 0x0D
 #define REPORT_DESC_START_COLLECTION 0xA1
@@ -182,6 +190,8 @@ static int uhid_read_event(btif_hh_device_t* p_dev) {
   if (ret == 0) {
     APPL_TRACE_ERROR("%s: Read HUP on uhid-cdev %s", __func__, strerror(errno));
     return -EFAULT;
+  } else if (ret < 0 && errno == EAGAIN) {
+    return 0;
   } else if (ret < 0) {
     APPL_TRACE_ERROR("%s: Cannot read uhid-cdev: %s", __func__,
                      strerror(errno));
@@ -319,86 +329,74 @@ static int uhid_read_event(btif_hh_device_t* p_dev) {
   return 0;
 }
 
+/* Runs on the uhid thread. */
+static void btif_hh_uhid_read_ready(void* context) {
+  btif_hh_device_t* p_dev = (btif_hh_device_t*)context;
+
+  if (uhid_read_event(p_dev) != 0) {
+    APPL_TRACE_ERROR("%s: stop watching uhid fd %d", __func__, p_dev->fd);
+    reactor_object_t* object =
+        uhid_objects[p_dev - btif_hh_cb.devices].exchange(NULL);
+    if (object != NULL) reactor_unregister(object);
+  }
+}
+
 /*******************************************************************************
  *
- * Function create_thread
+ * Function btif_hh_stop_uhid_watch
  *
- * Description creat a select loop
+ * Description Stops reading events from the uhid fd of |p_dev|. When this
+ *             returns, no event of |p_dev| is being handled.
  *
- * Returns pthread_t
+ * Returns void
  *
  ******************************************************************************/
-static inline pthread_t create_thread(void* (*start_routine)(void*),
-                                      void* arg) {
-  APPL_TRACE_DEBUG("create_thread: entered");
-  pthread_attr_t thread_attr;
-
-  pthread_attr_init(&thread_attr);
-  pthread_attr_setdetachstate(&thread_attr, PTHREAD_CREATE_JOINABLE);
-  pthread_t thread_id = -1;
-  if (pthread_create(&thread_id, &thread_attr, start_routine, arg) != 0) {
-    APPL_TRACE_ERROR("pthread_create : %s", strerror(errno));
-    return -1;
-  }
-  APPL_TRACE_DEBUG("create_thread: thread created successfully");
-  return thread_id;
+static void btif_hh_stop_uhid_watch(btif_hh_device_t* p_dev) {
+  reactor_object_t* object =
+      uhid_objects[p_dev - btif_hh_cb.devices].exchange(NULL);
+  if (object != NULL) reactor_unregister(object);
 }
 
 /*******************************************************************************
  *
- * Function btif_hh_poll_event_thread
+ * Function btif_hh_start_uhid_watch
  *
- * Description the polling thread which polls for event from UHID driver
+ * Description Adds the uhid fd of |p_dev| to the set watched by the uhid
+ *             thread, starting the thread if needed.
  *
  * Returns void
  *
  ******************************************************************************/
-static void* btif_hh_poll_event_thread(void* arg) {
-  btif_hh_device_t* p_dev = (btif_hh_device_t*)arg;
-  APPL_TRACE_DEBUG("%s: Thread created fd = %d", __func__, p_dev->fd);
-  struct pollfd pfds[1];
+static void btif_hh_start_uhid_watch(btif_hh_device_t* p_dev) {
+  btif_hh_stop_uhid_watch(p_dev);
 
-  pfds[0].fd = p_dev->fd;
-  pfds[0].events = POLLIN;
-
-  // Set the uhid fd as non-blocking to ensure we never block the BTU thread
-  uhid_set_non_blocking(p_dev->fd);
-
-  while (p_dev->hh_keep_polling) {
-    int ret;
-    OSI_NO_INTR(ret = poll(pfds, 1, 50));
-    if (ret < 0) {
-      APPL_TRACE_ERROR("%s: Cannot poll for fds: %s\n", __func__,
-                       strerror(errno));
-      break;
-    }
-    if (p_dev->fd == -1) {
-      APPL_TRACE_ERROR("%s: fd is closed, stop the poll thread", __func__);
-      p_dev->hh_keep_polling = 0;
-      break;
-    }
-    if (pfds[0].revents & POLLIN) {
-      APPL_TRACE_DEBUG("%s: POLLIN", __func__);
-      ret = uhid_read_event(p_dev);
-      if (ret != 0) break;
+  if (uhid_thread == NULL) {
+    uhid_thread = thread_new("bt_hh_uhid");
+    if (uhid_thread == NULL) {
+      APPL_TRACE_ERROR("%s: unable to start the uhid thread", __func__);
+      return;
     }
   }
 
-  p_dev->hh_poll_thread_id = -1;
-  APPL_TRACE_DEBUG("%s: Thread destroyed", __func__);
-  return 0;
-}
-
-static inline void btif_hh_close_poll_thread(btif_hh_device_t* p_dev) {
-  APPL_TRACE_DEBUG("%s", __func__);
-  p_dev->hh_keep_polling = 0;
-  if (p_dev->hh_poll_thread_id > 0)
-    pthread_join(p_dev->hh_poll_thread_id, NULL);
+  // Set the uhid fd as non-blocking to ensure we never block the uhid thread
+  uhid_set_non_blocking(p_dev->fd);
 
-  return;
+  reactor_object_t* object =
+      reactor_register(thread_get_reactor(uhid_thread), p_dev->fd, p_dev,
+                       btif_hh_uhid_read_ready, NULL);
+  if (object == NULL) {
+    APPL_TRACE_ERROR("%s: unable to watch uhid fd %d", __func__, p_dev->fd);
+    return;
+  }
+  uhid_objects[p_dev - btif_hh_cb.devices].store(object);
 }
 
 void bta_hh_co_destroy(int fd) {
+  for (uint32_t i = 0; i < BTIF_HH_MAX_HID; i++) {
+    if (btif_hh_cb.devices[i].fd == fd)
+      btif_hh_stop_uhid_watch(&btif_hh_cb.devices[i]);
+  }
+
   struct uhid_event ev;
   memset(&ev, 0, sizeof(ev));
   ev.type = UHID_DESTROY;
@@ -407,6 +405,24 @@ void bta_hh_co_destroy(int fd) {
   close(fd);
 }
 
+/*******************************************************************************
+ *
+ * Function bta_hh_co_cleanup
+ *
+ * Description Stops watching all uhid fds and stops the uhid thread, waiting
+ *             for it to exit.
+ *
+ * Returns void
+ *
+ ******************************************************************************/
+void bta_hh_co_cleanup(void) {
+  for (uint32_t i = 0; i < BTIF_HH_MAX_HID; i++)
+    btif_hh_stop_uhid_watch(&btif_hh_cb.devices[i]);
+
+  thread_free(uhid_thread);
+  uhid_thread = NULL;
+}
+
 int bta_hh_co_write(int fd, uint8_t* rpt, uint16_t len) {
   APPL_TRACE_VERBOSE("%s: UHID write %d", __func__, len);
 
@@ -470,9 +486,7 @@ void bta_hh_co_open(uint8_t dev_handle, uint8_t sub_class,
           APPL_TRACE_DEBUG("%s: uhid fd = %d", __func__, p_dev->fd);
       }
 
-      p_dev->hh_keep_polling = 1;
-      p_dev->hh_poll_thread_id =
-          create_thread(btif_hh_poll_event_thread, p_dev);
+      btif_hh_start_uhid_watch(p_dev);
       break;
     }
     p_dev = NULL;
@@ -500,9 +514,7 @@ void bta_hh_co_open(uint8_t dev_handle, uint8_t sub_class,
           return;
         } else {
           APPL_TRACE_DEBUG("%s: uhid fd = %d", __func__, p_dev->fd);
-          p_dev->hh_keep_polling = 1;
-          p_dev->hh_poll_thread_id =
-              create_thread(btif_hh_poll_event_thread, p_dev);
+          btif_hh_start_uhid_watch(p_dev);
         }
 
         break;
@@ -572,7 +584,7 @@ void bta_hh_co_close(uint8_t dev_handle, uint8_t app_id) {
         close(p_dev->fd_3d_audio);
       p_dev->fd_3d_audio = -1;
       p_dev->fd_3d_audio_connected = false;
-      btif_hh_close_poll_thread(p_dev);
+      btif_hh_stop_uhid_watch(p_dev);
       break;
     }
   }
@@ -628,7 +640,8 @@ void bta_hh_co_data(uint8_t dev_handle, uint8_t* p_rpt, uint16_t len,
 
   // Send the HID data to the kernel.
   if ((p_dev->fd >= 0) && p_dev->ready_for_data) {
-    bta_hh_co_write(p_dev->fd, p_rpt, len);
+    if (bta_hh_co_write(p_dev->fd, p_rpt, len) == 0)
+      PACKET_TRACE_LAST_RX(PACKET_TRACE_UHID_WRITE, dev_handle, len);
     if ((btif_hh_cb.hid_3d_audio == true) && (p_dev->attr_mask & HID_3D_AUDIO)) {
       if (p_dev->fd_3d_audio < 0) {
         p_dev->fd_3d_audio = socket(AF_LOCAL, SOCK_SEQPACKET, 0);
@@ -98,6 +98,14 @@ typedef struct {
   uint64_t total_scheduling_time_us;
 } scheduling_stats_t;
 
+// Number of buckets of the TX queue latency histogram, see
+// |btif_media_stats_t.tx_queue_latency_histogram|.
+#define BTIF_A2DP_SOURCE_LATENCY_HISTOGRAM_SIZE 8
+
+// Number of buckets of the PCM read underflow histogram, see
+// |btif_media_stats_t.media_read_underflow_histogram|.
+#define BTIF_A2DP_SOURCE_UNDERFLOW_HISTOGRAM_SIZE 4
+
 typedef struct {
   uint64_t session_start_us;
   uint64_t session_end_us;
@@ -110,6 +118,8 @@ typedef struct {
 
   uint64_t tx_queue_total_queueing_time_us;
   uint64_t tx_queue_max_queueing_time_us;
+  // Time spent by the packets in the TX queue before being read by the link
+  size_t tx_queue_latency_histogram[BTIF_A2DP_SOURCE_LATENCY_HISTOGRAM_SIZE];
 
   size_t tx_queue_total_readbuf_calls;
   uint64_t tx_queue_last_readbuf_us;
@@ -124,6 +134,9 @@ typedef struct {
   size_t media_read_total_underflow_bytes;
   size_t media_read_total_underflow_count;
   uint64_t media_read_last_underflow_us;
+  // Share of the requested PCM missing on underflow, in quarters
+  size_t
+      media_read_underflow_histogram[BTIF_A2DP_SOURCE_UNDERFLOW_HISTOGRAM_SIZE];
 } btif_media_stats_t;
 
 typedef struct {
@@ -75,8 +75,6 @@ typedef struct {
   int fd_3d_audio;
   bool fd_3d_audio_connected;
   bool ready_for_data;
-  pthread_t hh_poll_thread_id;
-  uint8_t hh_keep_polling;
   alarm_t* vup_timer;
 #if (OFF_TARGET_TEST_ENABLED == FALSE)
   #if (LINUX_VERSION_CODE > KERNEL_VERSION(3, 18, 00))
@@ -0,0 +1,151 @@
+/******************************************************************************
+ *
+ *  Copyright 2019 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+/*******************************************************************************
+ *
+ *  Filename:      btif_rc_rsp_cache.h
+ *
+ *  Description:   Cache of the AVRCP target responses to polled commands
+ *
+ *  Responses to the commands CTs poll for (GetElementAttributes,
+ *  GetFolderItems and GetPlayStatus) are kept per device and replayed to
+ *  repeated commands without asking the application again. An entry is only
+ *  used while the CT is registered for the notification that reports its
+ *  change, and is dropped when that notification is sent as CHANGED.
+ *
+ *  Commands are looked up on the btif thread while the application's
+ *  responses and notifications are stored from the JNI thread, so every
+ *  function below takes the lock of the caches.
+ *
+ ******************************************************************************/
+
+#ifndef BTIF_RC_RSP_CACHE_H
+#define BTIF_RC_RSP_CACHE_H
+
+#include <stdint.h>
+
+#include "avrc_defs.h"
+#include "bt_types.h"
+
+#define BTIF_RC_RSP_CACHE_SIZE 8
+#define BTIF_RC_RSP_CACHE_KEY_LEN 64
+/* Play status is extrapolated from the last response for at most this long */
+#define BTIF_RC_PLAY_STATUS_CACHE_MS 1000
+
+typedef struct {
+  uint8_t key[BTIF_RC_RSP_CACHE_KEY_LEN]; /* raw command, starting at the PDU */
+  uint16_t key_len;
+  uint8_t event_id; /* notification event the entry depends on */
+  BT_HDR* p_rsp;    /* encoded response, before the AV/C header is added */
+  uint32_t last_used_ms;
+} btif_rc_rsp_cache_entry_t;
+
+typedef struct {
+  btif_rc_rsp_cache_entry_t entries[BTIF_RC_RSP_CACHE_SIZE];
+  /* The last command missed for GetElementAttributes and GetFolderItems */
+  btif_rc_rsp_cache_entry_t pending_elem_attr;
+  btif_rc_rsp_cache_entry_t pending_folder_items;
+  bool play_status_valid;
+  tAVRC_GET_PLAY_STATUS_RSP play_status;
+  uint32_t play_status_ms;
+  uint32_t hits;
+  uint32_t misses;
+} btif_rc_rsp_cache_t;
+
+/*******************************************************************************
+ *
+ * Function         btif_rc_rsp_cache_lookup
+ *
+ * Description      Looks up the |len| bytes of command |p_data|, a |pdu|
+ *                  whose response changes with |event_id|. Entries are only
+ *                  used if the CT is |registered| for |event_id|. On a miss,
+ *                  the command is remembered so that the response stored
+ *                  next for |pdu| is cached, unless the application is
+ *                  still preparing a response to an earlier one
+ *                  (|rsp_pending|).
+ *
+ * Returns          A copy of the cached response, to be sent and freed by
+ *                  the caller, or NULL on a miss.
+ *
+ ******************************************************************************/
+BT_HDR* btif_rc_rsp_cache_lookup(btif_rc_rsp_cache_t* p_cache, uint8_t pdu,
+                                 uint8_t event_id, const uint8_t* p_data,
+                                 uint16_t len, bool registered,
+                                 bool rsp_pending);
+
+/*******************************************************************************
+ *
+ * Function         btif_rc_rsp_cache_store
+ *
+ * Description      Keeps a copy of the encoded response |p_msg| to the last
+ *                  command missed for |pdu|, replacing the least recently
+ *                  used entry.
+ *
+ ******************************************************************************/
+void btif_rc_rsp_cache_store(btif_rc_rsp_cache_t* p_cache, uint8_t pdu,
+                             const BT_HDR* p_msg);
+
+/*******************************************************************************
+ *
+ * Function         btif_rc_rsp_cache_store_play_status
+ *
+ * Description      Keeps the play status the application just reported.
+ *
+ ******************************************************************************/
+void btif_rc_rsp_cache_store_play_status(
+    btif_rc_rsp_cache_t* p_cache, const tAVRC_GET_PLAY_STATUS_RSP* p_rsp);
+
+/*******************************************************************************
+ *
+ * Function         btif_rc_rsp_cache_get_play_status
+ *
+ * Description      Fills |p_rsp| with the last play status, the song
+ *                  position moved on by the time elapsed while playing. Not
+ *                  used unless the CT is |registered| for play status
+ *                  changes, and not while playing if the stream was
+ *                  |remote_suspended|, to let the application restart it.
+ *
+ * Returns          true if |p_rsp| was filled.
+ *
+ ******************************************************************************/
+bool btif_rc_rsp_cache_get_play_status(btif_rc_rsp_cache_t* p_cache,
+                                       bool registered, bool remote_suspended,
+                                       tAVRC_GET_PLAY_STATUS_RSP* p_rsp);
+
+/*******************************************************************************
+ *
+ * Function         btif_rc_rsp_cache_invalidate
+ *
+ * Description      Drops the cached responses notification |event_id|
+ *                  reports a change of. A change of addressed player drops
+ *                  all of them.
+ *
+ ******************************************************************************/
+void btif_rc_rsp_cache_invalidate(btif_rc_rsp_cache_t* p_cache,
+                                  uint8_t event_id);
+
+/*******************************************************************************
+ *
+ * Function         btif_rc_rsp_cache_clear
+ *
+ * Description      Drops all the cached responses of a device.
+ *
+ ******************************************************************************/
+void btif_rc_rsp_cache_clear(btif_rc_rsp_cache_t* p_cache);
+
+#endif /* BTIF_RC_RSP_CACHE_H */
@@ -59,6 +59,7 @@
 #include "bta/include/bta_hf_client_api.h"
 #include "btif/include/btif_debug_btsnoop.h"
 #include "btif/include/btif_debug_conn.h"
+#include "btcore/include/module.h"
 #include "btif_a2dp.h"
 #include "btif_hf.h"
 #include "btif_api.h"
@@ -71,6 +72,7 @@
 #include "device/include/device_iot_config.h"
 #include "btsnoop.h"
 #include "btsnoop_mem.h"
+#include "hci_layer.h"
 #include "common/address_obfuscator.h"
 #include "common/os_utils.h"
 #include "device/include/interop.h"
@@ -79,11 +81,15 @@
 #include "osi/include/log.h"
 #include "osi/include/metrics.h"
 #include "osi/include/osi.h"
+#include "osi/include/packet_trace.h"
+#include "osi/include/properties.h"
+#include "osi/include/task_stats.h"
 #include "osi/include/wakelock.h"
 #include "stack/gatt/connection_manager.h"
 #include "stack_manager.h"
 #include "stack_interface.h"
 #include "stack/include/btm_api.h"
+#include "stack/include/sdp_api.h"
 
 using base::Bind;
 using bluetooth::hearing_aid::HearingAidInterface;
@@ -178,6 +184,8 @@ static int init(bt_callbacks_t* callbacks, bool start_restricted,
   common_criteria_mode = is_common_criteria_mode;
   common_criteria_config_compare_result = config_compare_result;
   is_local_device_atv = is_atv;
+  task_stats_set_enabled(
+      osi_property_get_int32("persist.bluetooth.task_stats", 0) != 0);
   init_external_interfaces();
 
   stack_manager_get_interface()->init_stack();
@@ -371,6 +379,10 @@ static void dump(int fd, const char** arguments) {
                                                                         true);
       return;
     }
+    if (strncmp(arguments[0], "--packet-trace", 14) == 0) {
+      packet_trace_dump_json(fd);
+      return;
+    }
   }
   btif_debug_conn_dump(fd);
   btif_debug_bond_event_dump(fd);
@@ -385,7 +397,12 @@ static void dump(int fd, const char** arguments) {
   alarm_debug_dump(fd);
   HearingAid::DebugDump(fd);
   connection_manager::dump(fd);
+  SDP_DumpDiscoveryCache(fd);
   bluetooth::bqr::DebugDump(fd);
+  hci_layer_debug_dump(fd);
+  module_debug_dump(fd);
+  packet_trace_debug_dump(fd);
+  task_stats_debug_dump(fd);
 #if (BTSNOOP_MEM == TRUE)
   btif_debug_btsnoop_dump(fd);
 #endif
@@ -33,6 +33,8 @@
 #include <limits.h>
 #include <string.h>
 #include <algorithm>
+#include <deque>
+#include <mutex>
 
 #if (OFF_TARGET_TEST_ENABLED == FALSE)
 #include "audio_hal_interface/a2dp_encoding.h"
@@ -131,6 +133,18 @@ static void btif_a2dp_source_shutdown_delayed(void* context);
 static uint8_t btif_a2dp_source_dynamic_audio_buffer_size =
     MAX_OUTPUT_A2DP_FRAME_QUEUE_SZ;
 
+/* Upper bounds (in ms) of the TX queue latency histogram buckets. The last
+ * bucket collects everything above the previous bound. */
+static const uint64_t btif_a2dp_source_latency_bounds_ms
+    [BTIF_A2DP_SOURCE_LATENCY_HISTOGRAM_SIZE] = {10, 20,  40,  60,
+                                                 80, 100, 200, UINT64_MAX};
+
+/* Enqueue timestamps of the packets in |tx_audio_queue|, in queue order. The
+ * queue is filled on the media thread and drained by BTA, so both are only
+ * touched together under |tx_queue_mutex|. */
+static std::mutex tx_queue_mutex;
+static std::deque<uint64_t> tx_queue_enqueue_us;
+
 static void btif_a2dp_source_audio_tx_start_event(void);
 static void btif_a2dp_source_audio_tx_stop_event(void);
 static void btif_a2dp_source_audio_tx_flush_event(BT_HDR* p_msg);
@@ -232,6 +246,13 @@ void btif_a2dp_source_accumulate_stats(btif_media_stats_t* src,
   dst->media_read_total_underflow_count +=
       src->media_read_total_underflow_count;
   dst->media_read_last_underflow_us = src->media_read_last_underflow_us;
+  for (size_t i = 0; i < BTIF_A2DP_SOURCE_LATENCY_HISTOGRAM_SIZE; i++) {
+    dst->tx_queue_latency_histogram[i] += src->tx_queue_latency_histogram[i];
+  }
+  for (size_t i = 0; i < BTIF_A2DP_SOURCE_UNDERFLOW_HISTOGRAM_SIZE; i++) {
+    dst->media_read_underflow_histogram[i] +=
+        src->media_read_underflow_histogram[i];
+  }
   btif_a2dp_source_accumulate_scheduling_stats(&src->tx_queue_enqueue_stats,
                                                &dst->tx_queue_enqueue_stats);
   btif_a2dp_source_accumulate_scheduling_stats(&src->tx_queue_dequeue_stats,
@@ -336,8 +357,12 @@ static void btif_a2dp_source_shutdown_delayed(UNUSED_ATTR void* context) {
   } else {
     btif_a2dp_control_cleanup();
   }
-  fixed_queue_free(btif_a2dp_source_cb.tx_audio_queue, NULL);
-  btif_a2dp_source_cb.tx_audio_queue = NULL;
+  {
+    std::lock_guard<std::mutex> lock(tx_queue_mutex);
+    fixed_queue_free(btif_a2dp_source_cb.tx_audio_queue, NULL);
+    btif_a2dp_source_cb.tx_audio_queue = NULL;
+    tx_queue_enqueue_us.clear();
+  }
 
   btif_a2dp_source_state = BTIF_A2DP_SOURCE_STATE_OFF;
   APPL_TRACE_EVENT("%s: enc_update_in_progress = %d", __func__, enc_update_in_progress);
@@ -1052,6 +1077,45 @@ static void btif_a2dp_source_audio_tx_stop_event(void) {
     btif_a2dp_source_cb.encoder_interface->feeding_reset();
 }
 
+static void btif_a2dp_source_tx_queue_enqueue(BT_HDR* p_buf,
+                                              uint64_t now_us) {
+  std::lock_guard<std::mutex> lock(tx_queue_mutex);
+  tx_queue_enqueue_us.push_back(now_us);
+  fixed_queue_enqueue(btif_a2dp_source_cb.tx_audio_queue, p_buf);
+}
+
+static BT_HDR* btif_a2dp_source_tx_queue_dequeue(uint64_t now_us) {
+  std::lock_guard<std::mutex> lock(tx_queue_mutex);
+  BT_HDR* p_buf =
+      (BT_HDR*)fixed_queue_try_dequeue(btif_a2dp_source_cb.tx_audio_queue);
+  if (p_buf == NULL || tx_queue_enqueue_us.empty()) return p_buf;
+
+  uint64_t queueing_time_us = now_us - tx_queue_enqueue_us.front();
+  tx_queue_enqueue_us.pop_front();
+
+  btif_media_stats_t* stats = &btif_a2dp_source_cb.stats;
+  stats->tx_queue_total_queueing_time_us += queueing_time_us;
+  stats->tx_queue_max_queueing_time_us =
+      std::max(stats->tx_queue_max_queueing_time_us, queueing_time_us);
+  size_t i = 0;
+  while (i < BTIF_A2DP_SOURCE_LATENCY_HISTOGRAM_SIZE - 1 &&
+         queueing_time_us / 1000 >= btif_a2dp_source_latency_bounds_ms[i]) {
+    i++;
+  }
+  stats->tx_queue_latency_histogram[i]++;
+
+  return p_buf;
+}
+
+// Flushes the TX queue and returns the number of dropped packets.
+static size_t btif_a2dp_source_tx_queue_flush(void) {
+  std::lock_guard<std::mutex> lock(tx_queue_mutex);
+  size_t drop_n = fixed_queue_length(btif_a2dp_source_cb.tx_audio_queue);
+  fixed_queue_flush(btif_a2dp_source_cb.tx_audio_queue, osi_free);
+  tx_queue_enqueue_us.clear();
+  return drop_n;
+}
+
 static void btif_a2dp_source_alarm_cb(UNUSED_ATTR void* context) {
   APPL_TRACE_DEBUG("%s:", __func__);
   thread_post(btif_a2dp_source_cb.worker_thread,
@@ -1109,6 +1173,9 @@ static uint32_t btif_a2dp_source_read_callback(uint8_t* p_buf, uint32_t len) {
     btif_a2dp_source_cb.stats.media_read_total_underflow_count++;
     btif_a2dp_source_cb.stats.media_read_last_underflow_us =
         time_get_os_boottime_us();
+    size_t quarter = (size_t)(len - bytes_read) * 4 / len;
+    btif_a2dp_source_cb.stats.media_read_underflow_histogram[std::min<size_t>(
+        quarter, BTIF_A2DP_SOURCE_UNDERFLOW_HISTOGRAM_SIZE - 1)]++;
   }
 
   return bytes_read;
@@ -1133,9 +1200,8 @@ static bool btif_a2dp_source_enqueue_callback(BT_HDR* p_buf, size_t frames_n,
     LOG_DEBUG(LOG_TAG, "%s: tx suspended %d or remote suspended, discarded frame", __func__, btif_a2dp_source_cb.tx_flush);
 
     btif_a2dp_source_cb.stats.tx_queue_total_flushed_messages +=
-        fixed_queue_length(btif_a2dp_source_cb.tx_audio_queue);
+        btif_a2dp_source_tx_queue_flush();
     btif_a2dp_source_cb.stats.tx_queue_last_flushed_us = now_us;
-    fixed_queue_flush(btif_a2dp_source_cb.tx_audio_queue, osi_free);
 
     osi_free(p_buf);
     return false;
@@ -1154,13 +1220,10 @@ static bool btif_a2dp_source_enqueue_callback(BT_HDR* p_buf, size_t frames_n,
     btif_a2dp_source_cb.stats.tx_queue_last_dropouts_us = now_us;
 
     // Flush all queued buffers
-    size_t drop_n = fixed_queue_length(btif_a2dp_source_cb.tx_audio_queue);
+    size_t drop_n = btif_a2dp_source_tx_queue_flush();
     btif_a2dp_source_cb.stats.tx_queue_max_dropped_messages = std::max(
         drop_n, btif_a2dp_source_cb.stats.tx_queue_max_dropped_messages);
-    while (fixed_queue_length(btif_a2dp_source_cb.tx_audio_queue)) {
-      btif_a2dp_source_cb.stats.tx_queue_total_dropped_messages++;
-      osi_free(fixed_queue_try_dequeue(btif_a2dp_source_cb.tx_audio_queue));
-    }
+    btif_a2dp_source_cb.stats.tx_queue_total_dropped_messages += drop_n;
 
     // Request RSSI and Failed Contact Counter for log purposes if we had to
     // flush buffers.
@@ -1197,7 +1260,7 @@ static bool btif_a2dp_source_enqueue_callback(BT_HDR* p_buf, size_t frames_n,
       frames_n, btif_a2dp_source_cb.stats.tx_queue_max_frames_per_packet);
   CHECK(btif_a2dp_source_cb.encoder_interface != NULL);
 
-  fixed_queue_enqueue(btif_a2dp_source_cb.tx_audio_queue, p_buf);
+  btif_a2dp_source_tx_queue_enqueue(p_buf, now_us);
 
   return true;
 }
@@ -1210,10 +1273,9 @@ static void btif_a2dp_source_audio_tx_flush_event(UNUSED_ATTR BT_HDR* p_msg) {
     btif_a2dp_source_cb.encoder_interface->feeding_flush();
 
   btif_a2dp_source_cb.stats.tx_queue_total_flushed_messages +=
-      fixed_queue_length(btif_a2dp_source_cb.tx_audio_queue);
+      btif_a2dp_source_tx_queue_flush();
   btif_a2dp_source_cb.stats.tx_queue_last_flushed_us =
       time_get_os_boottime_us();
-  fixed_queue_flush(btif_a2dp_source_cb.tx_audio_queue, osi_free);
 
   if (!btif_a2dp_source_is_hal_v2_supported()) {
     UIPC_Ioctl(UIPC_CH_ID_AV_AUDIO, UIPC_REQ_RX_FLUSH, NULL);
@@ -1243,8 +1305,7 @@ static bool btif_a2dp_source_audio_tx_flush_req(void) {
 
 BT_HDR* btif_a2dp_source_audio_readbuf(void) {
   uint64_t now_us = time_get_os_boottime_us();
-  BT_HDR* p_buf =
-      (BT_HDR*)fixed_queue_try_dequeue(btif_a2dp_source_cb.tx_audio_queue);
+  BT_HDR* p_buf = btif_a2dp_source_tx_queue_dequeue(now_us);
   APPL_TRACE_DEBUG("%s:", __func__);
   btif_a2dp_source_cb.stats.tx_queue_total_readbuf_calls++;
   btif_a2dp_source_cb.stats.tx_queue_last_readbuf_us = now_us;
@@ -1397,6 +1458,42 @@ void btif_a2dp_source_debug_dump(int fd) {
                     1000
               : 0);
 
+  dprintf(fd,
+          "  Underflow histogram (missing <25%%/<50%%/<75%%/<=100%%)   : %zu / "
+          "%zu / %zu / %zu\n",
+          accumulated_stats->media_read_underflow_histogram[0],
+          accumulated_stats->media_read_underflow_histogram[1],
+          accumulated_stats->media_read_underflow_histogram[2],
+          accumulated_stats->media_read_underflow_histogram[3]);
+
+  ave_time_us = 0;
+  if (dequeue_stats->total_updates != 0) {
+    ave_time_us = accumulated_stats->tx_queue_total_queueing_time_us /
+                  dequeue_stats->total_updates;
+  }
+  dprintf(
+      fd,
+      "  Queueing time in ms (total/max/ave)                     : %llu / %llu "
+      "/ %llu\n",
+      (unsigned long long)accumulated_stats->tx_queue_total_queueing_time_us /
+          1000,
+      (unsigned long long)accumulated_stats->tx_queue_max_queueing_time_us /
+          1000,
+      (unsigned long long)ave_time_us / 1000);
+
+  dprintf(fd, "  Queueing time histogram in ms                           :");
+  for (size_t i = 0; i < BTIF_A2DP_SOURCE_LATENCY_HISTOGRAM_SIZE; i++) {
+    if (i < BTIF_A2DP_SOURCE_LATENCY_HISTOGRAM_SIZE - 1) {
+      dprintf(fd, " <%llu: %zu",
+              (unsigned long long)btif_a2dp_source_latency_bounds_ms[i],
+              accumulated_stats->tx_queue_latency_histogram[i]);
+    } else {
+      dprintf(fd, " >=%llu: %zu\n",
+              (unsigned long long)btif_a2dp_source_latency_bounds_ms[i - 1],
+              accumulated_stats->tx_queue_latency_histogram[i]);
+    }
+  }
+
   //
   // TxQueue enqueue stats
   //
@@ -1652,7 +1749,7 @@ bool btif_a2dp_source_start_session(const RawAddress& peer_address) {
 #endif
        SessionType::A2DP_SOFTWARE_ENCODING_DATAPATH) {
       APPL_TRACE_EVENT("%s Freeing queue from previous session", __func__);
-      fixed_queue_flush(btif_a2dp_source_cb.tx_audio_queue, osi_free);
+      btif_a2dp_source_tx_queue_flush();
     }
   }
   btif_a2dp_update_sink_latency_change();
@@ -25,6 +25,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <iterator>
 #include <unordered_set>
 #include "device/include/controller.h"
 
@@ -158,12 +159,62 @@ void bta_scan_results_cb_impl(RawAddress bd_addr, tBT_DEVICE_TYPE device_type,
             ble_tx_power, rssi, ble_periodic_adv_int, std::move(value), &original_bda);
 }
 
+// A scan result, as received from BTA
+struct ScanResult {
+  RawAddress bd_addr;
+  tBT_DEVICE_TYPE device_type;
+  int8_t rssi;
+  uint8_t addr_type;
+  uint16_t ble_evt_type;
+  uint8_t ble_primary_phy;
+  uint8_t ble_secondary_phy;
+  uint8_t ble_advertising_sid;
+  int8_t ble_tx_power;
+  uint16_t ble_periodic_adv_int;
+  vector<uint8_t> value;
+  RawAddress original_bda;
+};
+
+// Results of the advertising report event being processed, all access to this
+// variable should be done on the bta thread
+vector<ScanResult> pending_scan_results;
+
+void bta_scan_results_batch_cb_impl(vector<ScanResult>* results) {
+  for (ScanResult& r : *results) {
+    bta_scan_results_cb_impl(r.bd_addr, r.device_type, r.rssi, r.addr_type,
+                             r.ble_evt_type, r.ble_primary_phy,
+                             r.ble_secondary_phy, r.ble_advertising_sid,
+                             r.ble_tx_power, r.ble_periodic_adv_int,
+                             std::move(r.value), r.original_bda);
+  }
+}
+
+// Hands the pending results to the jni thread, in a single task rather than
+// one per result.
+void bta_scan_results_flush() {
+  if (pending_scan_results.empty()) return;
+
+  // Moved element by element, so that the storage of the pending results is
+  // reused for the next event
+  vector<ScanResult>* results = new vector<ScanResult>(
+      std::make_move_iterator(pending_scan_results.begin()),
+      std::make_move_iterator(pending_scan_results.end()));
+  pending_scan_results.clear();
+  do_in_jni_thread(Bind(bta_scan_results_batch_cb_impl, Owned(results)));
+}
+
 void bta_scan_results_cb(tBTA_DM_SEARCH_EVT event, tBTA_DM_SEARCH* p_data) {
   uint8_t len;
 
+  if (event == BTA_DM_INQ_RES_BATCH_END_EVT) {
+    bta_scan_results_flush();
+    return;
+  }
+
   if (event == BTA_DM_INQ_CMPL_EVT) {
     BTIF_TRACE_DEBUG("%s  BLE observe complete. Num Resp %d", __func__,
                      p_data->inq_cmpl.num_resps);
+    bta_scan_results_flush();
     return;
   }
 
@@ -183,12 +234,13 @@ void bta_scan_results_cb(tBTA_DM_SEARCH_EVT event, tBTA_DM_SEARCH* p_data) {
     }
   }
 
+  // Passed on at the end of the advertising report event
   tBTA_DM_INQ_RES* r = &p_data->inq_res;
-  do_in_jni_thread(Bind(bta_scan_results_cb_impl, r->bd_addr, r->device_type,
-                        r->rssi, r->ble_addr_type, r->ble_evt_type,
-                        r->ble_primary_phy, r->ble_secondary_phy,
-                        r->ble_advertising_sid, r->ble_tx_power,
-                        r->ble_periodic_adv_int, std::move(value), r->original_bda));
+  pending_scan_results.push_back(
+      {r->bd_addr, r->device_type, r->rssi, r->ble_addr_type, r->ble_evt_type,
+       r->ble_primary_phy, r->ble_secondary_phy, r->ble_advertising_sid,
+       r->ble_tx_power, r->ble_periodic_adv_int, std::move(value),
+       r->original_bda});
 }
 
 void bta_track_adv_event_cb(tBTM_BLE_TRACK_ADV_DATA* p_track_adv_data) {
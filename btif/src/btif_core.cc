@@ -864,10 +864,9 @@ static void execute_storage_request(uint16_t event, char* p_param) {
         local_le_features.local_privacy_enabled = BTM_BleLocalPrivacyEnabled();
 
         prop.len = sizeof(bt_local_le_features_t);
-        if (cmn_vsc_cb.filter_support == 1)
-          local_le_features.max_adv_filter_supported = cmn_vsc_cb.max_filter;
-        else
-          local_le_features.max_adv_filter_supported = 0;
+        /* Without APCF in the controller the host applies the filters */
+        local_le_features.max_adv_filter_supported =
+            BTM_BleMaxAdvFilterSupported();
         local_le_features.max_adv_instance = cmn_vsc_cb.adv_inst_max;
         local_le_features.max_irk_list_size = cmn_vsc_cb.max_irk_list_sz;
         local_le_features.rpa_offload_supported = cmn_vsc_cb.rpa_offloading;
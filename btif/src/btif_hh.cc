@@ -137,6 +137,7 @@ static tHID_KB_LIST hid_kb_numlock_on_list[] = {{LOGITECH_KB_MX5500_PRODUCT_ID,
  *  Externs
  ******************************************************************************/
 extern void bta_hh_co_destroy(int fd);
+extern void bta_hh_co_cleanup(void);
 extern void bta_hh_co_write(int fd, uint8_t* rpt, uint16_t len);
 extern bt_status_t btif_dm_remove_bond(const RawAddress* bd_addr);
 extern int bta_hh_co_send_hid_info(btif_hh_device_t* p_dev,
@@ -500,8 +501,6 @@ void btif_hh_remove_device(RawAddress bd_addr) {
     BTIF_TRACE_WARNING("%s: device_num = 0", __func__);
   }
 
-  p_dev->hh_keep_polling = 0;
-  p_dev->hh_poll_thread_id = -1;
   BTIF_TRACE_DEBUG("%s: uhid fd = %d", __func__, p_dev->fd);
   if (p_dev->fd >= 0) {
     bta_hh_co_destroy(p_dev->fd);
@@ -780,6 +779,8 @@ static void btif_hh_upstreams_evt(uint16_t event, char* p_param) {
       }
       if (p_data->status == BTA_HH_OK) {
         int i;
+        // The uhid thread holds pointers to the devices
+        bta_hh_co_cleanup();
         // Clear the control block
         for (i = 0; i < BTIF_HH_MAX_HID; i++) {
           alarm_free(btif_hh_cb.devices[i].vup_timer);
@@ -1754,8 +1755,6 @@ static void cleanup(void) {
   for (i = 0; i < BTIF_HH_MAX_HID; i++) {
     p_dev = &btif_hh_cb.devices[i];
     if (p_dev->dev_status != BTHH_CONN_STATE_UNKNOWN && p_dev->fd >= 0) {
-      p_dev->hh_keep_polling = 0;
-      p_dev->hh_poll_thread_id = -1;
       BTIF_TRACE_DEBUG("%s: Closing uhid fd = %d", __func__, p_dev->fd);
       if (p_dev->fd >= 0) {
         bta_hh_co_destroy(p_dev->fd);
@@ -1763,7 +1762,7 @@ static void cleanup(void) {
       }
     }
   }
-
+  bta_hh_co_cleanup();
 }
 
 static const bthh_interface_t bthhInterface = {
@@ -41,10 +41,10 @@
 #include <stdio.h>
 #include <string.h>
 #include <sys/ioctl.h>
-#include <sys/poll.h>
 #include <sys/prctl.h>
 #include <sys/select.h>
 #include <sys/socket.h>
+#include <sys/uio.h>
 #include <sys/wait.h>
 #include <unistd.h>
 
@@ -86,8 +86,6 @@
                        __func__, #s, __LINE__)                           \
   } while (0)
 
-#define MIN(x, y) (((x) < (y)) ? (x) : (y))
-
 btpan_cb_t btpan_cb;
 
 static bool jni_initialized;
@@ -424,18 +422,23 @@ int btpan_tap_send(int tap_fd, const RawAddress& src, const RawAddress& dst,
     eth_hdr.h_dest = dst;
     eth_hdr.h_src = src;
     eth_hdr.h_proto = htons(proto);
-    char packet[TAP_MAX_PKT_WRITE_LEN + sizeof(tETH_HDR)];
-    memcpy(packet, &eth_hdr, sizeof(tETH_HDR));
     if (len > TAP_MAX_PKT_WRITE_LEN) {
       LOG_ERROR(LOG_TAG, "btpan_tap_send eth packet size:%d is exceeded limit!",
                 len);
       return -1;
     }
-    memcpy(packet + sizeof(tETH_HDR), buf, len);
 
-    /* Send data to network interface */
+    /* Send data to network interface. The tap driver takes the frame from
+     * both vectors in one write, so the payload is not copied behind the
+     * header first. */
+    struct iovec iov[2];
+    iov[0].iov_base = &eth_hdr;
+    iov[0].iov_len = sizeof(tETH_HDR);
+    iov[1].iov_base = (void*)buf;
+    iov[1].iov_len = len;
+
     ssize_t ret;
-    OSI_NO_INTR(ret = write(tap_fd, packet, len + sizeof(tETH_HDR)));
+    OSI_NO_INTR(ret = writev(tap_fd, iov, 2));
     BTIF_TRACE_DEBUG("ret:%d", ret);
     return (int)ret;
   }
@@ -676,10 +679,10 @@ static void bta_pan_callback(tBTA_PAN_EVT event, tBTA_PAN* p_data) {
                         sizeof(tBTA_PAN), NULL);
 }
 
-#define IS_EXCEPTION(e) ((e) & (POLLHUP | POLLRDHUP | POLLERR | POLLNVAL))
 static void btu_exec_tap_fd_read(void* p_param) {
-  struct pollfd ufd;
   int fd = PTR_TO_INT(p_param);
+  BT_HDR* buffer = NULL;
+  bool failed = false;
 
   if (fd == INVALID_FD || fd != btpan_cb.tap_fd) return;
 
@@ -687,79 +690,55 @@ static void btu_exec_tap_fd_read(void* p_param) {
   // give other profiles a chance to run by limiting the amount of memory
   // PAN can use.
   for (int i = 0; i < PAN_BUF_MAX && btif_is_enabled() && btpan_cb.flow; i++) {
-    BT_HDR* buffer = (BT_HDR*)osi_malloc(PAN_BUF_SIZE);
+    // A buffer whose frame was dropped is reused for the next one.
+    if (buffer == NULL) buffer = (BT_HDR*)osi_malloc(PAN_BUF_SIZE);
     buffer->offset = PAN_MINIMUM_OFFSET;
-    buffer->len = PAN_BUF_SIZE - sizeof(BT_HDR) - buffer->offset;
-
-    uint8_t* packet = (uint8_t*)buffer + sizeof(BT_HDR) + buffer->offset;
-
-    // If we don't have an undelivered packet left over, pull one from the TAP
-    // driver.
-    // We save it in the congest_packet right away in case we can't deliver it
-    // in this
-    // attempt.
-    if (!btpan_cb.congest_packet_size) {
-      ssize_t ret;
-      OSI_NO_INTR(ret = read(fd, btpan_cb.congest_packet,
-                             sizeof(btpan_cb.congest_packet)));
-      switch (ret) {
-        case -1:
-          BTIF_TRACE_ERROR("%s unable to read from driver: %s", __func__,
-                           strerror(errno));
-          osi_free(buffer);
-          // add fd back to monitor thread to try it again later
-          btsock_thread_add_fd(pan_pth, fd, 0, SOCK_THREAD_FD_RD, 0);
-          return;
-        case 0:
-          BTIF_TRACE_WARNING("%s end of file reached.", __func__);
-          osi_free(buffer);
-          // add fd back to monitor thread to process the exception
-          btsock_thread_add_fd(pan_pth, fd, 0, SOCK_THREAD_FD_RD, 0);
-          return;
-        default:
-          btpan_cb.congest_packet_size = ret;
-          break;
-      }
-    }
 
-    memcpy(packet, btpan_cb.congest_packet,
-           MIN(btpan_cb.congest_packet_size, buffer->len));
-    buffer->len = MIN(btpan_cb.congest_packet_size, buffer->len);
-
-    if (buffer->len > sizeof(tETH_HDR) && should_forward((tETH_HDR*)packet)) {
-      // Extract the ethernet header from the buffer since the PAN_WriteBuf
-      // inside
-      // forward_bnep can't handle two pointers that point inside the same GKI
-      // buffer.
-      tETH_HDR hdr;
-      memcpy(&hdr, packet, sizeof(tETH_HDR));
-
-      // Skip the ethernet header.
-      buffer->len -= sizeof(tETH_HDR);
-      buffer->offset += sizeof(tETH_HDR);
-      if (forward_bnep(&hdr, buffer) != FORWARD_CONGEST)
-        btpan_cb.congest_packet_size = 0;
-    } else {
-      BTIF_TRACE_WARNING("%s dropping packet of length %d", __func__,
-                         buffer->len);
-      btpan_cb.congest_packet_size = 0;
-      osi_free(buffer);
+    // Read the ethernet header aside and the payload straight into the
+    // buffer, where BNEP will prepend its own header.
+    tETH_HDR hdr;
+    struct iovec iov[2];
+    iov[0].iov_base = &hdr;
+    iov[0].iov_len = sizeof(tETH_HDR);
+    iov[1].iov_base = (uint8_t*)(buffer + 1) + buffer->offset;
+    iov[1].iov_len = PAN_BUF_SIZE - sizeof(BT_HDR) - buffer->offset;
+
+    // The fd is non-blocking, so running out of frames ends the loop
+    // without polling the driver before each read.
+    ssize_t ret;
+    OSI_NO_INTR(ret = readv(fd, iov, 2));
+    if (ret == -1 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+    if (ret == -1) {
+      BTIF_TRACE_ERROR("%s unable to read from driver: %s", __func__,
+                       strerror(errno));
+      failed = true;
+      break;
+    }
+    if (ret == 0) {
+      BTIF_TRACE_WARNING("%s end of file reached.", __func__);
+      failed = true;
+      break;
     }
 
-    // Bail out of the loop if reading from the TAP fd would block.
-    ufd.fd = fd;
-    ufd.events = POLLIN;
-    ufd.revents = 0;
+    if ((size_t)ret <= sizeof(tETH_HDR) || !should_forward(&hdr)) {
+      BTIF_TRACE_WARNING("%s dropping packet of length %zd", __func__, ret);
+      continue;
+    }
 
-    int ret;
-    OSI_NO_INTR(ret = poll(&ufd, 1, 0));
-    if (ret <= 0 || IS_EXCEPTION(ufd.revents)) break;
+    buffer->len = ret - sizeof(tETH_HDR);
+    // BNEP owns the buffer from here on, whatever the result. Flow control
+    // is turned off synchronously when L2CAP congests, so a frame rejected
+    // for a full transmit queue is rare and is dropped like a NIC would.
+    if (forward_bnep(&hdr, buffer) == FORWARD_CONGEST)
+      BTIF_TRACE_WARNING("%s transmit queue full, frame dropped", __func__);
+    buffer = NULL;
   }
+  osi_free(buffer);
 
-  if (btpan_cb.flow) {
-    // add fd back to monitor thread when the flow is on
+  // Add fd back to monitor thread when the flow is on, or after a failed read
+  // to try again later or process the exception.
+  if (btpan_cb.flow || failed)
     btsock_thread_add_fd(pan_pth, fd, 0, SOCK_THREAD_FD_RD, 0);
-  }
 }
 
 static void btif_pan_close_all_conns() {
@@ -77,6 +77,7 @@
 #include "bta_av_api.h"
 #include "btif_av.h"
 #include "btif_hf.h"
+#include "btif_rc_rsp_cache.h"
 #include "btif_common.h"
 #include "btif_util.h"
 #include "btu.h"
@@ -289,6 +290,7 @@ typedef struct {
   uint8_t tws_earbud_state;
 #endif
   bool rc_element_attr_app_req;  /* flag to track get_element_attr req */
+  btif_rc_rsp_cache_t rc_rsp_cache;
 
 } btif_rc_device_cb_t;
 
@@ -367,6 +369,9 @@ static uint8_t opcode_from_pdu(uint8_t pdu);
 static void send_metamsg_rsp(btif_rc_device_cb_t* p_dev, int index,
                              uint8_t label, tBTA_AV_CODE code,
                              tAVRC_RESPONSE* pmetamsg_resp);
+static bool rc_rsp_cache_serve(btif_rc_device_cb_t* p_dev,
+                               tBTA_AV_META_MSG* pmeta_msg,
+                               tAVRC_COMMAND* pavrc_cmd);
 static void register_volumechange(uint8_t label, btif_rc_device_cb_t* p_dev);
 static void lbl_init();
 static void init_all_transactions(int index);
@@ -978,6 +983,7 @@ void handle_rc_disconnect(tBTA_AV_RC_CLOSE* p_rc_close) {
  
   /* Clean up AVRCP procedure flags */
   memset(&p_dev->rc_app_settings, 0, sizeof(btif_rc_player_app_settings_t));
+  btif_rc_rsp_cache_clear(&p_dev->rc_rsp_cache);
   p_dev->rc_features_processed = false;
   p_dev->rc_procedure_complete = false;
   rc_stop_play_status_timer(p_dev);
@@ -1471,6 +1477,8 @@ void handle_rc_metamsg_cmd(tBTA_AV_META_MSG* pmeta_msg) {
     BTIF_TRACE_EVENT("%s: Passing received metamsg command to app. pdu: %s",
                      __func__, dump_rc_pdu(avrc_command.cmd.pdu));
 
+    if (rc_rsp_cache_serve(p_dev, pmeta_msg, &avrc_command)) return;
+
     /* Since handle_rc_metamsg_cmd() itself is called from
         *btif context, no context switching is required. Invoke
         * btif_rc_upstreams_evt directly from here. */
@@ -1497,6 +1505,9 @@ void btif_rc_handler(tBTA_AV_EVT event, tBTA_AV* p_data) {
       }
 
       if (btif_rc_cb.rc_multi_cb != NULL) {
+        for (int idx = 0; idx < btif_max_rc_clients; idx++)
+          btif_rc_rsp_cache_clear(
+              &btif_rc_cb.rc_multi_cb[idx].rc_rsp_cache);
         osi_free(btif_rc_cb.rc_multi_cb);
         btif_rc_cb.rc_multi_cb = NULL;
       }
@@ -1852,6 +1863,8 @@ static void send_metamsg_rsp(btif_rc_device_cb_t* p_dev, int index,
 
     /* de-register this notification for a CHANGED response */
     p_dev->rc_notif[event_id - 1].bNotify = false;
+    if (code == AVRC_RSP_CHANGED)
+      btif_rc_rsp_cache_invalidate(&p_dev->rc_rsp_cache, event_id);
     BTIF_TRACE_DEBUG("%s: rc_handle: %d. event_id: 0x%02d bNotify: %u",
                      __func__, p_dev->rc_handle, event_id, bNotify);
     if (bNotify) {
@@ -1888,6 +1901,14 @@ static void send_metamsg_rsp(btif_rc_device_cb_t* p_dev, int index,
     status = AVRC_BldResponse(p_dev->rc_handle, pmetamsg_resp, &p_msg);
 
     if (status == AVRC_STS_NO_ERROR) {
+      if (pmetamsg_resp->rsp.status == AVRC_STS_NO_ERROR) {
+        if (index == IDX_GET_ELEMENT_ATTR_RSP)
+          btif_rc_rsp_cache_store(&p_dev->rc_rsp_cache,
+                                  AVRC_PDU_GET_ELEMENT_ATTR, p_msg);
+        else if (index == IDX_GET_PLAY_STATUS_RSP)
+          btif_rc_rsp_cache_store_play_status(
+              &p_dev->rc_rsp_cache, &pmetamsg_resp->get_play_status);
+      }
       BTA_AvMetaRsp(p_dev->rc_handle, label, ctype, p_msg);
     } else {
       BTIF_TRACE_ERROR("%s: failed to build metamsg response. status: 0x%02x",
@@ -1896,6 +1917,86 @@ static void send_metamsg_rsp(btif_rc_device_cb_t* p_dev, int index,
   }
 }
 
+/***************************************************************************
+ *  Function       rc_rsp_cache_serve
+ *
+ *  - Argument:    p_dev      Dev pointer
+ *                 pmeta_msg  Received command
+ *                 pavrc_cmd  Parsed command
+ *
+ *  - Description: Answers a command from the response cache. On a miss,
+ *                 the cache remembers the command so that the
+ *                 application's response can be cached.
+ *
+ *  - Returns:     true if the command was answered.
+ *
+ ***************************************************************************/
+static bool rc_rsp_cache_serve(btif_rc_device_cb_t* p_dev,
+                               tBTA_AV_META_MSG* pmeta_msg,
+                               tAVRC_COMMAND* pavrc_cmd) {
+  const uint8_t* p_data;
+  uint16_t len;
+  uint8_t event_id;
+  int index;
+
+  switch (pavrc_cmd->pdu) {
+    case AVRC_PDU_GET_PLAY_STATUS: {
+      tAVRC_RESPONSE avrc_rsp;
+      if (!btif_rc_rsp_cache_get_play_status(
+              &p_dev->rc_rsp_cache,
+              p_dev->rc_notif[AVRC_EVT_PLAY_STATUS_CHANGE - 1].bNotify,
+              btif_av_check_flag_remote_suspend(
+                  btif_av_idx_by_bdaddr(&p_dev->rc_addr)),
+              &avrc_rsp.get_play_status))
+        return false;
+      send_metamsg_rsp(p_dev, -1, pmeta_msg->label, pmeta_msg->code,
+                       &avrc_rsp);
+      return true;
+    }
+
+    case AVRC_PDU_GET_ELEMENT_ATTR:
+      if (pmeta_msg->p_msg->hdr.opcode != AVRC_OP_VENDOR) return false;
+      p_data = pmeta_msg->p_msg->vendor.p_vendor_data;
+      len = pmeta_msg->p_msg->vendor.vendor_len;
+      event_id = AVRC_EVT_TRACK_CHANGE;
+      index = IDX_GET_ELEMENT_ATTR_RSP;
+      break;
+
+    case AVRC_PDU_GET_FOLDER_ITEMS:
+      if (pmeta_msg->p_msg->hdr.opcode != AVRC_OP_BROWSE) return false;
+      p_data = pmeta_msg->p_msg->browse.p_browse_data;
+      len = pmeta_msg->p_msg->browse.browse_len;
+      switch (pavrc_cmd->get_items.scope) {
+        case AVRC_SCOPE_PLAYER_LIST:
+          event_id = AVRC_EVT_AVAL_PLAYERS_CHANGE;
+          break;
+        case AVRC_SCOPE_NOW_PLAYING:
+          event_id = AVRC_EVT_NOW_PLAYING_CHANGE;
+          break;
+        default:
+          event_id = AVRC_EVT_UIDS_CHANGE;
+          break;
+      }
+      index = IDX_GET_FOLDER_ITEMS_RSP;
+      break;
+
+    default:
+      return false;
+  }
+
+  BT_HDR* p_rsp = btif_rc_rsp_cache_lookup(
+      &p_dev->rc_rsp_cache, pavrc_cmd->pdu, event_id, p_data, len,
+      p_dev->rc_notif[event_id - 1].bNotify,
+      p_dev->rc_pdu_info[index].is_rsp_pending);
+  if (p_rsp == NULL) return false;
+
+  BTIF_TRACE_DEBUG("%s: %s answered from cache", __func__,
+                   dump_rc_pdu(pavrc_cmd->pdu));
+  BTA_AvMetaRsp(p_dev->rc_handle, pmeta_msg->label,
+                get_rsp_type_code(AVRC_STS_NO_ERROR, pmeta_msg->code), p_rsp);
+  return true;
+}
+
 static uint8_t opcode_from_pdu(uint8_t pdu) {
   uint8_t opcode = 0;
 
@@ -3393,6 +3494,8 @@ static bt_status_t get_folder_items_list_rsp(RawAddress* bd_addr,
   if (status == AVRC_STS_NO_ERROR) {
     code = p_dev->rc_pdu_info[rsp_index].ctype[front_index];
     ctype = get_rsp_type_code(avrc_rsp.get_items.status, code);
+    btif_rc_rsp_cache_store(&p_dev->rc_rsp_cache, AVRC_PDU_GET_FOLDER_ITEMS,
+                            p_msg);
     BTA_AvMetaRsp(p_dev->rc_handle, p_dev->rc_pdu_info[rsp_index].label[front_index],
                   ctype, p_msg);
   } else /* Error occured, send reject response */
@@ -3438,6 +3541,9 @@ static bt_status_t set_addressed_player_rsp(RawAddress* bd_addr,
 
   BTIF_TRACE_DEBUG("%s", __func__);
   CHECK_RC_CONNECTED(p_dev);
+  /* Cached responses describe the previously addressed player */
+  btif_rc_rsp_cache_invalidate(&p_dev->rc_rsp_cache,
+                               AVRC_EVT_ADDR_PLAYER_CHANGE);
 
   avrc_rsp.addr_player.pdu = AVRC_PDU_SET_ADDRESSED_PLAYER;
   avrc_rsp.addr_player.opcode = opcode_from_pdu(AVRC_PDU_SET_ADDRESSED_PLAYER);
@@ -3488,6 +3594,8 @@ static bt_status_t set_browsed_player_rsp(RawAddress* bd_addr,
 
   int front_index = p_dev->rc_pdu_info[rsp_index].front;
   CHECK_RC_CONNECTED(p_dev);
+  /* Cached folder listings are relative to the browsed folder */
+  btif_rc_rsp_cache_invalidate(&p_dev->rc_rsp_cache, AVRC_EVT_UIDS_CHANGE);
 
   memset(&avrc_rsp, 0, sizeof(tAVRC_RESPONSE));
   memset(&item, 0, sizeof(tAVRC_NAME));
@@ -3604,6 +3712,8 @@ static bt_status_t change_path_rsp(RawAddress* bd_addr,
 
   BTIF_TRACE_DEBUG("%s", __func__);
   CHECK_RC_CONNECTED(p_dev);
+  /* Cached folder listings are relative to the browsed folder */
+  btif_rc_rsp_cache_invalidate(&p_dev->rc_rsp_cache, AVRC_EVT_UIDS_CHANGE);
 
   avrc_rsp.chg_path.pdu = AVRC_PDU_CHANGE_PATH;
   avrc_rsp.chg_path.opcode = opcode_from_pdu(AVRC_PDU_CHANGE_PATH);
@@ -3639,6 +3749,8 @@ static bt_status_t search_rsp(RawAddress* bd_addr, btrc_status_t rsp_status,
 
   BTIF_TRACE_DEBUG("%s", __func__);
   CHECK_RC_CONNECTED(p_dev);
+  /* Cached folder listings are relative to the browsed folder */
+  btif_rc_rsp_cache_invalidate(&p_dev->rc_rsp_cache, AVRC_EVT_UIDS_CHANGE);
 
   avrc_rsp.search.pdu = AVRC_PDU_SEARCH;
   avrc_rsp.search.opcode = opcode_from_pdu(AVRC_PDU_SEARCH);
@@ -5905,6 +6017,7 @@ static void cleanup_ctrl() {
   if (btif_rc_cb.rc_multi_cb != NULL) {
     for (int idx = 0; idx < btif_max_rc_clients; idx++) {
       alarm_free(btif_rc_cb.rc_multi_cb[idx].rc_play_status_timer);
+      btif_rc_rsp_cache_clear(&btif_rc_cb.rc_multi_cb[idx].rc_rsp_cache);
     }
     osi_free(btif_rc_cb.rc_multi_cb);
     btif_rc_cb.rc_multi_cb = NULL;
@@ -0,0 +1,188 @@
+/******************************************************************************
+ *
+ *  Copyright 2019 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+/*******************************************************************************
+ *
+ *  Filename:      btif_rc_rsp_cache.cc
+ *
+ *  Description:   Cache of the AVRCP target responses to polled commands
+ *
+ ******************************************************************************/
+
+#define LOG_TAG "bt_btif_rc_rsp_cache"
+
+#include "btif_rc_rsp_cache.h"
+
+#include <string.h>
+
+#include <mutex>
+
+#include "osi/include/allocator.h"
+#include "osi/include/log.h"
+#include "osi/include/time.h"
+
+/* Guards the caches of all the devices. Never held while calling out. */
+static std::mutex rsp_cache_lock;
+
+/* Copies an encoded response, keeping its offset so that AVRC can still
+ * prepend its headers. */
+static BT_HDR* rsp_cache_copy_pkt(const BT_HDR* p_msg) {
+  BT_HDR* p_copy =
+      (BT_HDR*)osi_malloc(BT_HDR_SIZE + p_msg->offset + p_msg->len);
+  memcpy(p_copy, p_msg, BT_HDR_SIZE + p_msg->offset + p_msg->len);
+  return p_copy;
+}
+
+static void rsp_cache_free_entry(btif_rc_rsp_cache_entry_t* p_entry) {
+  osi_free_and_reset((void**)&p_entry->p_rsp);
+  p_entry->key_len = 0;
+}
+
+static btif_rc_rsp_cache_entry_t* rsp_cache_pending(
+    btif_rc_rsp_cache_t* p_cache, uint8_t pdu) {
+  switch (pdu) {
+    case AVRC_PDU_GET_ELEMENT_ATTR:
+      return &p_cache->pending_elem_attr;
+    case AVRC_PDU_GET_FOLDER_ITEMS:
+      return &p_cache->pending_folder_items;
+    default:
+      return NULL;
+  }
+}
+
+BT_HDR* btif_rc_rsp_cache_lookup(btif_rc_rsp_cache_t* p_cache, uint8_t pdu,
+                                 uint8_t event_id, const uint8_t* p_data,
+                                 uint16_t len, bool registered,
+                                 bool rsp_pending) {
+  std::lock_guard<std::mutex> lock(rsp_cache_lock);
+  btif_rc_rsp_cache_entry_t* p_pending = rsp_cache_pending(p_cache, pdu);
+
+  if (p_pending == NULL || len == 0 || len > BTIF_RC_RSP_CACHE_KEY_LEN)
+    return NULL;
+
+  if (registered) {
+    for (int i = 0; i < BTIF_RC_RSP_CACHE_SIZE; i++) {
+      btif_rc_rsp_cache_entry_t* p_entry = &p_cache->entries[i];
+      if (p_entry->p_rsp == NULL || p_entry->key_len != len ||
+          memcmp(p_entry->key, p_data, len) != 0)
+        continue;
+
+      p_entry->last_used_ms = time_get_os_boottime_ms();
+      p_cache->hits++;
+      return rsp_cache_copy_pkt(p_entry->p_rsp);
+    }
+  }
+
+  /* Only cache a response that cannot be mistaken for another command's */
+  p_cache->misses++;
+  p_pending->key_len = 0;
+  if (!rsp_pending) {
+    memcpy(p_pending->key, p_data, len);
+    p_pending->key_len = len;
+    p_pending->event_id = event_id;
+  }
+  return NULL;
+}
+
+void btif_rc_rsp_cache_store(btif_rc_rsp_cache_t* p_cache, uint8_t pdu,
+                             const BT_HDR* p_msg) {
+  std::lock_guard<std::mutex> lock(rsp_cache_lock);
+  btif_rc_rsp_cache_entry_t* p_pending = rsp_cache_pending(p_cache, pdu);
+
+  if (p_pending == NULL || p_pending->key_len == 0) return;
+
+  btif_rc_rsp_cache_entry_t* p_entry = &p_cache->entries[0];
+  for (int i = 1; i < BTIF_RC_RSP_CACHE_SIZE; i++) {
+    if (p_cache->entries[i].last_used_ms < p_entry->last_used_ms)
+      p_entry = &p_cache->entries[i];
+  }
+  rsp_cache_free_entry(p_entry);
+
+  memcpy(p_entry->key, p_pending->key, p_pending->key_len);
+  p_entry->key_len = p_pending->key_len;
+  p_entry->event_id = p_pending->event_id;
+  p_entry->p_rsp = rsp_cache_copy_pkt(p_msg);
+  p_entry->last_used_ms = time_get_os_boottime_ms();
+  p_pending->key_len = 0;
+}
+
+void btif_rc_rsp_cache_store_play_status(
+    btif_rc_rsp_cache_t* p_cache, const tAVRC_GET_PLAY_STATUS_RSP* p_rsp) {
+  std::lock_guard<std::mutex> lock(rsp_cache_lock);
+  p_cache->play_status = *p_rsp;
+  p_cache->play_status_ms = time_get_os_boottime_ms();
+  p_cache->play_status_valid = true;
+}
+
+bool btif_rc_rsp_cache_get_play_status(btif_rc_rsp_cache_t* p_cache,
+                                       bool registered, bool remote_suspended,
+                                       tAVRC_GET_PLAY_STATUS_RSP* p_rsp) {
+  std::lock_guard<std::mutex> lock(rsp_cache_lock);
+  uint32_t now_ms = time_get_os_boottime_ms();
+  uint32_t elapsed_ms = now_ms - p_cache->play_status_ms;
+
+  if (!p_cache->play_status_valid || !registered ||
+      elapsed_ms >= BTIF_RC_PLAY_STATUS_CACHE_MS)
+    return false;
+
+  bool playing = p_cache->play_status.play_status == AVRC_PLAYSTATE_PLAYING;
+  if (playing && remote_suspended) return false;
+
+  *p_rsp = p_cache->play_status;
+  if (playing) {
+    uint64_t pos = (uint64_t)p_rsp->song_pos + elapsed_ms;
+    if (p_rsp->song_len != 0 && p_rsp->song_len != 0xFFFFFFFF &&
+        pos > p_rsp->song_len)
+      pos = p_rsp->song_len;
+    p_rsp->song_pos = (uint32_t)pos;
+  }
+  p_cache->hits++;
+  return true;
+}
+
+void btif_rc_rsp_cache_invalidate(btif_rc_rsp_cache_t* p_cache,
+                                  uint8_t event_id) {
+  std::lock_guard<std::mutex> lock(rsp_cache_lock);
+  bool all = (event_id == AVRC_EVT_ADDR_PLAYER_CHANGE);
+
+  for (int i = 0; i < BTIF_RC_RSP_CACHE_SIZE; i++) {
+    if (all || p_cache->entries[i].event_id == event_id)
+      rsp_cache_free_entry(&p_cache->entries[i]);
+  }
+  /* A response the application is preparing may predate the change */
+  if (all || p_cache->pending_elem_attr.event_id == event_id)
+    p_cache->pending_elem_attr.key_len = 0;
+  if (all || p_cache->pending_folder_items.event_id == event_id)
+    p_cache->pending_folder_items.key_len = 0;
+
+  if (all || event_id == AVRC_EVT_PLAY_STATUS_CHANGE ||
+      event_id == AVRC_EVT_TRACK_CHANGE ||
+      event_id == AVRC_EVT_PLAY_POS_CHANGED)
+    p_cache->play_status_valid = false;
+}
+
+void btif_rc_rsp_cache_clear(btif_rc_rsp_cache_t* p_cache) {
+  std::lock_guard<std::mutex> lock(rsp_cache_lock);
+
+  if (p_cache->hits || p_cache->misses)
+    LOG_DEBUG(LOG_TAG, "%s: hits: %u, misses: %u", __func__, p_cache->hits,
+              p_cache->misses);
+  for (int i = 0; i < BTIF_RC_RSP_CACHE_SIZE; i++)
+    rsp_cache_free_entry(&p_cache->entries[i]);
+  memset(p_cache, 0, sizeof(*p_cache));
+}
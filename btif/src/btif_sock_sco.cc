@@ -26,19 +26,23 @@
 #include <sys/types.h>
 #include <unistd.h>
 
+#include <algorithm>
 #include <mutex>
 
 #include <hardware/bluetooth.h>
 #include <hardware/bt_sock.h>
 
 #include "btif_common.h"
+#include "btm_sco_voice.h"
 #include "device/include/esco_parameters.h"
 #include "osi/include/allocator.h"
 #include "osi/include/list.h"
 #include "osi/include/log.h"
 #include "osi/include/osi.h"
+#include "osi/include/properties.h"
 #include "osi/include/socket.h"
 #include "osi/include/thread.h"
+#include "osi/include/time.h"
 
 // This module provides a socket abstraction for SCO connections to a higher
 // layer. It returns file descriptors representing two types of sockets:
@@ -46,6 +50,13 @@
 // transferred across these sockets; instead, they are used to manage SCO
 // connection lifecycles while the data routing takes place over the I2S bus.
 //
+// When the stack is built with BTM_SCO_HCI_INCLUDED, the SCO data is routed
+// over HCI instead and carried on the connected sockets as 16-bit little
+// endian mono PCM: 8 kHz for CVSD, 16 kHz for mSBC, selected with the
+// persist.bluetooth.sco_hci_codec property. Every frame of microphone audio
+// written to the socket is sent to the remote, and answered with a frame of
+// speaker audio from the voice pipeline (see stack/include/btm_sco_voice.h).
+//
 // This code bridges the gap between the BTM layer, which implements SCO
 // connections, and the Android HAL. It adapts the BTM representation of SCO
 // connections (integer handles) to a file descriptor representation usable by
@@ -62,6 +73,11 @@ typedef struct {
   uint16_t sco_handle;
   socket_t* socket;
   bool connect_completed;
+#if (BTM_SCO_HCI_INCLUDED == TRUE)
+  tBTM_SCO_VOICE* voice;  // Created once the connection completes.
+  int16_t mic_pcm[BTM_SCO_VOICE_MAX_FRAME_SAMPLES];
+  size_t mic_bytes;  // Bytes of |mic_pcm| read so far.
+#endif
 } sco_socket_t;
 
 static sco_socket_t* sco_socket_establish_locked(bool is_listening,
@@ -75,6 +91,11 @@ static void connection_request_cb(tBTM_ESCO_EVT event,
 static void connect_completed_cb(uint16_t sco_handle);
 static void disconnect_completed_cb(uint16_t sco_handle);
 static void socket_read_ready_cb(socket_t* socket, void* context);
+#if (BTM_SCO_HCI_INCLUDED == TRUE)
+static void sco_data_cb(uint16_t sco_inx, BT_HDR* p_msg,
+                        tBTM_SCO_DATA_FLAG status);
+static bool sco_socket_read_pcm_locked(sco_socket_t* sco_socket);
+#endif
 
 // |sco_lock| protects all of the static variables below and
 // calls into the BTM layer.
@@ -82,6 +103,7 @@ static std::mutex sco_lock;
 static list_t* sco_sockets;  // Owns a collection of sco_socket_t objects.
 static sco_socket_t* listen_sco_socket;  // Not owned, do not free.
 static thread_t* thread;                 // Not owned, do not free.
+static esco_codec_t sco_codec = ESCO_CODEC_CVSD;
 
 bt_status_t btsock_sco_init(thread_t* thread_) {
   CHECK(thread_ != NULL);
@@ -90,7 +112,12 @@ bt_status_t btsock_sco_init(thread_t* thread_) {
   if (!sco_sockets) return BT_STATUS_FAIL;
 
   thread = thread_;
-  enh_esco_params_t params = esco_parameters_for_codec(ESCO_CODEC_CVSD);
+#if (BTM_SCO_HCI_INCLUDED == TRUE)
+  char codec[PROPERTY_VALUE_MAX] = {0};
+  osi_property_get("persist.bluetooth.sco_hci_codec", codec, "cvsd");
+  sco_codec = strcmp(codec, "msbc") ? ESCO_CODEC_CVSD : ESCO_CODEC_MSBC_T2;
+#endif
+  enh_esco_params_t params = esco_parameters_for_codec(sco_codec);
   BTM_SetEScoMode(&params);
 
   return BT_STATUS_SUCCESS;
@@ -154,10 +181,18 @@ static sco_socket_t* sco_socket_establish_locked(bool is_listening,
     goto error;
   }
 
-  params = esco_parameters_for_codec(ESCO_CODEC_CVSD);
+  params = esco_parameters_for_codec(sco_codec);
+#if (BTM_SCO_HCI_INCLUDED == TRUE)
+  // The link keeps its own data callback, an HFP call configuring the SCO
+  // path of its links does not take the data away from the socket.
+  status = BTM_CreateScoOverHci(bd_addr, !is_listening, params.packet_types,
+                                &sco_socket->sco_handle, connect_completed_cb,
+                                disconnect_completed_cb, sco_data_cb);
+#else
   status = BTM_CreateSco(bd_addr, !is_listening, params.packet_types,
                          &sco_socket->sco_handle, connect_completed_cb,
                          disconnect_completed_cb);
+#endif
   if (status != BTM_CMD_STARTED) {
     LOG_ERROR(LOG_TAG, "%s unable to create SCO socket: %d", __func__, status);
     goto error;
@@ -201,6 +236,9 @@ static void sco_socket_free_locked(sco_socket_t* sco_socket) {
   if (sco_socket->sco_handle != BTM_INVALID_SCO_INDEX)
     BTM_RemoveSco(sco_socket->sco_handle);
   socket_free(sco_socket->socket);
+#if (BTM_SCO_HCI_INCLUDED == TRUE)
+  BTM_ScoVoiceFree(sco_socket->voice);
+#endif
   osi_free(sco_socket);
 }
 
@@ -304,6 +342,14 @@ static void connect_completed_cb(uint16_t sco_handle) {
   }
 
   sco_socket->connect_completed = true;
+#if (BTM_SCO_HCI_INCLUDED == TRUE)
+  sco_socket->voice =
+      BTM_ScoVoiceNew(sco_codec == ESCO_CODEC_CVSD ? BTM_SCO_VOICE_CODEC_CVSD
+                                                   : BTM_SCO_VOICE_CODEC_MSBC);
+  if (!sco_socket->voice)
+    LOG_ERROR(LOG_TAG, "%s unable to set up voice for handle: %hu", __func__,
+              sco_handle);
+#endif
 }
 
 static void disconnect_completed_cb(uint16_t sco_handle) {
@@ -323,6 +369,9 @@ static void socket_read_ready_cb(UNUSED_ATTR socket_t* socket, void* context) {
   std::unique_lock<std::mutex> lock(sco_lock);
 
   sco_socket_t* sco_socket = (sco_socket_t*)context;
+#if (BTM_SCO_HCI_INCLUDED == TRUE)
+  if (sco_socket->voice && sco_socket_read_pcm_locked(sco_socket)) return;
+#endif
   socket_free(sco_socket->socket);
   sco_socket->socket = NULL;
 
@@ -338,3 +387,65 @@ static void socket_read_ready_cb(UNUSED_ATTR socket_t* socket, void* context) {
     if (sco_socket == listen_sco_socket) listen_sco_socket = NULL;
   }
 }
+
+#if (BTM_SCO_HCI_INCLUDED == TRUE)
+// Called on the BTU thread with each SCO packet received over HCI.
+static void sco_data_cb(uint16_t sco_inx, BT_HDR* p_msg,
+                        tBTM_SCO_DATA_FLAG status) {
+  std::unique_lock<std::mutex> lock(sco_lock);
+
+  sco_socket_t* sco_socket = sco_socket_find_locked(sco_inx);
+  if (sco_socket && sco_socket->voice &&
+      p_msg->len >= HCI_SCO_PREAMBLE_SIZE) {
+    const uint8_t* p = (uint8_t*)(p_msg + 1) + p_msg->offset;
+    uint16_t len = std::min<uint16_t>(p_msg->len - HCI_SCO_PREAMBLE_SIZE,
+                                      p[HCI_SCO_PREAMBLE_SIZE - 1]);
+    BTM_ScoVoiceReceive(sco_socket->voice, p + HCI_SCO_PREAMBLE_SIZE, len,
+                        status, time_get_os_boottime_us());
+  }
+  osi_free(p_msg);
+}
+
+// Reads the microphone audio available on the socket of |sco_socket|, sends
+// every complete frame and writes back a frame of speaker audio for it.
+// Returns false if the socket was closed by the local host.
+static bool sco_socket_read_pcm_locked(sco_socket_t* sco_socket) {
+  tBTM_SCO_VOICE* voice = sco_socket->voice;
+  size_t frame_bytes = BTM_ScoVoiceFrameSamples(voice) * sizeof(int16_t);
+
+  for (;;) {
+    ssize_t ret =
+        socket_read(sco_socket->socket,
+                    (uint8_t*)sco_socket->mic_pcm + sco_socket->mic_bytes,
+                    frame_bytes - sco_socket->mic_bytes);
+    if (ret == 0) return false;
+    if (ret < 0) return errno == EAGAIN || errno == EWOULDBLOCK;
+
+    sco_socket->mic_bytes += ret;
+    if (sco_socket->mic_bytes < frame_bytes) continue;
+    sco_socket->mic_bytes = 0;
+
+    BTM_ScoVoiceWritePcm(voice, sco_socket->mic_pcm);
+    for (;;) {
+      BT_HDR* p_buf = (BT_HDR*)osi_malloc(sizeof(BT_HDR) +
+                                          HCI_SCO_PREAMBLE_SIZE +
+                                          BTM_SCO_DATA_SIZE_MAX);
+      p_buf->offset = HCI_SCO_PREAMBLE_SIZE;
+      p_buf->len = BTM_ScoVoiceGetTxPacket(
+          voice, (uint8_t*)(p_buf + 1) + p_buf->offset);
+      if (p_buf->len == 0) {
+        osi_free(p_buf);
+        break;
+      }
+      BTM_WriteScoData(sco_socket->sco_handle, p_buf);
+    }
+
+    int16_t ear_pcm[BTM_SCO_VOICE_MAX_FRAME_SAMPLES];
+    BTM_ScoVoiceReadPcm(voice, ear_pcm);
+    if (socket_write(sco_socket->socket, ear_pcm, frame_bytes) !=
+        (ssize_t)frame_bytes)
+      LOG_WARN(LOG_TAG, "%s speaker frame dropped for handle: %hu", __func__,
+               sco_socket->sco_handle);
+  }
+}
+#endif
@@ -123,6 +123,7 @@ const char* dump_dm_search_event(uint16_t event) {
     CASE_RETURN_STR(BTA_DM_DISC_CMPL_EVT)
     CASE_RETURN_STR(BTA_DM_DI_DISC_CMPL_EVT)
     CASE_RETURN_STR(BTA_DM_SEARCH_CANCEL_CMPL_EVT)
+    CASE_RETURN_STR(BTA_DM_INQ_RES_BATCH_END_EVT)
 
     default:
       return "UNKNOWN MSG ID";
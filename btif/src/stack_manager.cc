@@ -116,10 +116,15 @@ static void event_init_stack(void* context) {
 
     module_init(get_module(OSI_MODULE));
     module_init(get_module(BT_UTILS_MODULE));
+
+    // The config files are independent of each other, parse them in parallel
+    const module_t* config_modules[] = {
 #if (BT_IOT_LOGGING_ENABLED == TRUE)
-    module_init(get_module(DEVICE_IOT_CONFIG_MODULE));
+        get_module(DEVICE_IOT_CONFIG_MODULE),
 #endif
-    module_init(get_module(BTIF_CONFIG_MODULE));
+        get_module(BTIF_CONFIG_MODULE),
+    };
+    module_init_parallel(config_modules, ARRAY_SIZE(config_modules));
 
     btif_stack_state(StackState::INITIALIZING);
 
@@ -162,12 +167,15 @@ static void event_start_up_stack(UNUSED_ATTR void* context) {
   hack_future = local_hack_future;
 
   // Include this for now to put btif config into a shutdown-able state
-  module_start_up(get_module(BTIF_CONFIG_MODULE));
-
-  btif_stack_state(StackState::TURNING_ON);
+  const module_t* config_modules[] = {
 #if (BT_IOT_LOGGING_ENABLED == TRUE)
-  module_start_up(get_module(DEVICE_IOT_CONFIG_MODULE));
+      get_module(DEVICE_IOT_CONFIG_MODULE),
 #endif
+      get_module(BTIF_CONFIG_MODULE),
+  };
+  module_start_up_parallel(config_modules, ARRAY_SIZE(config_modules));
+
+  btif_stack_state(StackState::TURNING_ON);
   bte_main_enable();
 
   if (future_await(local_hack_future) != FUTURE_SUCCESS) {
@@ -0,0 +1,201 @@
+/******************************************************************************
+ *
+ *  Copyright 2019 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+#include <gtest/gtest.h>
+
+#include <string.h>
+
+#include <vector>
+
+#include "btif/include/btif_rc_rsp_cache.h"
+#include "osi/include/allocator.h"
+
+namespace {
+
+const std::vector<uint8_t> kElementAttrCmd = {0x20, 0x00, 0x00, 0x09, 0x00,
+                                              0x00, 0x00, 0x00, 0x00, 0x00,
+                                              0x00, 0x00, 0x00};
+const std::vector<uint8_t> kFolderItemsCmd = {0x71, 0x00, 0x0a, 0x01, 0x00,
+                                              0x00, 0x00, 0x00, 0x00, 0x00,
+                                              0x00, 0x09, 0x00};
+
+class BtifRcRspCacheTest : public ::testing::Test {
+ protected:
+  void SetUp() override { memset(&cache_, 0, sizeof(cache_)); }
+  void TearDown() override { btif_rc_rsp_cache_clear(&cache_); }
+
+  // Looks up |cmd|, returns whether it was answered from the cache.
+  bool Lookup(uint8_t pdu, uint8_t event_id, const std::vector<uint8_t>& cmd,
+              bool registered = true, bool rsp_pending = false) {
+    BT_HDR* p_rsp =
+        btif_rc_rsp_cache_lookup(&cache_, pdu, event_id, cmd.data(),
+                                 cmd.size(), registered, rsp_pending);
+    if (p_rsp == NULL) return false;
+    last_rsp_.assign(p_rsp->data + p_rsp->offset,
+                     p_rsp->data + p_rsp->offset + p_rsp->len);
+    osi_free(p_rsp);
+    return true;
+  }
+
+  // Misses |cmd| and stores the response |rsp| to it.
+  void MissAndStore(uint8_t pdu, uint8_t event_id,
+                    const std::vector<uint8_t>& cmd,
+                    const std::vector<uint8_t>& rsp) {
+    EXPECT_FALSE(Lookup(pdu, event_id, cmd));
+    Store(pdu, rsp);
+  }
+
+  void Store(uint8_t pdu, const std::vector<uint8_t>& rsp) {
+    const uint16_t offset = 4;
+    BT_HDR* p_msg = (BT_HDR*)osi_calloc(BT_HDR_SIZE + offset + rsp.size());
+    p_msg->offset = offset;
+    p_msg->len = rsp.size();
+    memcpy(p_msg->data + offset, rsp.data(), rsp.size());
+    btif_rc_rsp_cache_store(&cache_, pdu, p_msg);
+    osi_free(p_msg);
+  }
+
+  btif_rc_rsp_cache_t cache_;
+  std::vector<uint8_t> last_rsp_;
+};
+
+}  // namespace
+
+TEST_F(BtifRcRspCacheTest, serves_stored_response) {
+  MissAndStore(AVRC_PDU_GET_ELEMENT_ATTR, AVRC_EVT_TRACK_CHANGE,
+               kElementAttrCmd, {0x01, 0x02, 0x03});
+
+  EXPECT_TRUE(Lookup(AVRC_PDU_GET_ELEMENT_ATTR, AVRC_EVT_TRACK_CHANGE,
+                     kElementAttrCmd));
+  EXPECT_EQ(std::vector<uint8_t>({0x01, 0x02, 0x03}), last_rsp_);
+  EXPECT_EQ(1u, cache_.hits);
+  EXPECT_EQ(1u, cache_.misses);
+}
+
+TEST_F(BtifRcRspCacheTest, different_command_misses) {
+  MissAndStore(AVRC_PDU_GET_ELEMENT_ATTR, AVRC_EVT_TRACK_CHANGE,
+               kElementAttrCmd, {0x01});
+
+  std::vector<uint8_t> other = kElementAttrCmd;
+  other.back() = 0x01;
+  EXPECT_FALSE(
+      Lookup(AVRC_PDU_GET_ELEMENT_ATTR, AVRC_EVT_TRACK_CHANGE, other));
+}
+
+TEST_F(BtifRcRspCacheTest, not_served_unless_registered) {
+  MissAndStore(AVRC_PDU_GET_ELEMENT_ATTR, AVRC_EVT_TRACK_CHANGE,
+               kElementAttrCmd, {0x01});
+
+  EXPECT_FALSE(Lookup(AVRC_PDU_GET_ELEMENT_ATTR, AVRC_EVT_TRACK_CHANGE,
+                      kElementAttrCmd, false));
+}
+
+TEST_F(BtifRcRspCacheTest, response_to_earlier_command_not_stored) {
+  // The application still owes the response to an earlier command, the one
+  // stored next can't be told apart.
+  EXPECT_FALSE(Lookup(AVRC_PDU_GET_ELEMENT_ATTR, AVRC_EVT_TRACK_CHANGE,
+                      kElementAttrCmd, true, true));
+  Store(AVRC_PDU_GET_ELEMENT_ATTR, {0x01});
+
+  EXPECT_FALSE(Lookup(AVRC_PDU_GET_ELEMENT_ATTR, AVRC_EVT_TRACK_CHANGE,
+                      kElementAttrCmd));
+}
+
+TEST_F(BtifRcRspCacheTest, changed_notification_invalidates) {
+  MissAndStore(AVRC_PDU_GET_ELEMENT_ATTR, AVRC_EVT_TRACK_CHANGE,
+               kElementAttrCmd, {0x01});
+
+  btif_rc_rsp_cache_invalidate(&cache_, AVRC_EVT_TRACK_CHANGE);
+  EXPECT_FALSE(Lookup(AVRC_PDU_GET_ELEMENT_ATTR, AVRC_EVT_TRACK_CHANGE,
+                      kElementAttrCmd));
+}
+
+TEST_F(BtifRcRspCacheTest, change_drops_response_being_prepared) {
+  EXPECT_FALSE(Lookup(AVRC_PDU_GET_ELEMENT_ATTR, AVRC_EVT_TRACK_CHANGE,
+                      kElementAttrCmd));
+  btif_rc_rsp_cache_invalidate(&cache_, AVRC_EVT_TRACK_CHANGE);
+  Store(AVRC_PDU_GET_ELEMENT_ATTR, {0x01});
+
+  EXPECT_FALSE(Lookup(AVRC_PDU_GET_ELEMENT_ATTR, AVRC_EVT_TRACK_CHANGE,
+                      kElementAttrCmd));
+}
+
+TEST_F(BtifRcRspCacheTest, uids_change_only_drops_folder_items) {
+  MissAndStore(AVRC_PDU_GET_ELEMENT_ATTR, AVRC_EVT_TRACK_CHANGE,
+               kElementAttrCmd, {0x01});
+  MissAndStore(AVRC_PDU_GET_FOLDER_ITEMS, AVRC_EVT_UIDS_CHANGE,
+               kFolderItemsCmd, {0x02});
+
+  btif_rc_rsp_cache_invalidate(&cache_, AVRC_EVT_UIDS_CHANGE);
+  EXPECT_FALSE(Lookup(AVRC_PDU_GET_FOLDER_ITEMS, AVRC_EVT_UIDS_CHANGE,
+                      kFolderItemsCmd));
+  EXPECT_TRUE(Lookup(AVRC_PDU_GET_ELEMENT_ATTR, AVRC_EVT_TRACK_CHANGE,
+                     kElementAttrCmd));
+}
+
+TEST_F(BtifRcRspCacheTest, addressed_player_change_drops_everything) {
+  MissAndStore(AVRC_PDU_GET_ELEMENT_ATTR, AVRC_EVT_TRACK_CHANGE,
+               kElementAttrCmd, {0x01});
+  MissAndStore(AVRC_PDU_GET_FOLDER_ITEMS, AVRC_EVT_NOW_PLAYING_CHANGE,
+               kFolderItemsCmd, {0x02});
+  tAVRC_GET_PLAY_STATUS_RSP play_status = {};
+  btif_rc_rsp_cache_store_play_status(&cache_, &play_status);
+
+  btif_rc_rsp_cache_invalidate(&cache_, AVRC_EVT_ADDR_PLAYER_CHANGE);
+  EXPECT_FALSE(Lookup(AVRC_PDU_GET_ELEMENT_ATTR, AVRC_EVT_TRACK_CHANGE,
+                      kElementAttrCmd));
+  EXPECT_FALSE(Lookup(AVRC_PDU_GET_FOLDER_ITEMS, AVRC_EVT_NOW_PLAYING_CHANGE,
+                      kFolderItemsCmd));
+  EXPECT_FALSE(btif_rc_rsp_cache_get_play_status(&cache_, true, false,
+                                                 &play_status));
+}
+
+TEST_F(BtifRcRspCacheTest, least_recently_used_entry_replaced) {
+  std::vector<uint8_t> cmd = kElementAttrCmd;
+  for (int i = 0; i <= BTIF_RC_RSP_CACHE_SIZE; i++) {
+    cmd.back() = i;
+    MissAndStore(AVRC_PDU_GET_ELEMENT_ATTR, AVRC_EVT_TRACK_CHANGE, cmd,
+                 {(uint8_t)i});
+  }
+
+  int cached = 0;
+  for (int i = 0; i <= BTIF_RC_RSP_CACHE_SIZE; i++) {
+    cmd.back() = i;
+    if (Lookup(AVRC_PDU_GET_ELEMENT_ATTR, AVRC_EVT_TRACK_CHANGE, cmd))
+      cached++;
+  }
+  EXPECT_EQ(BTIF_RC_RSP_CACHE_SIZE, cached);
+}
+
+TEST_F(BtifRcRspCacheTest, play_status) {
+  tAVRC_GET_PLAY_STATUS_RSP play_status = {};
+  play_status.play_status = AVRC_PLAYSTATE_PLAYING;
+  play_status.song_len = 200000;
+  play_status.song_pos = 1000;
+  btif_rc_rsp_cache_store_play_status(&cache_, &play_status);
+
+  tAVRC_GET_PLAY_STATUS_RSP rsp;
+  EXPECT_FALSE(btif_rc_rsp_cache_get_play_status(&cache_, false, false, &rsp));
+  EXPECT_FALSE(btif_rc_rsp_cache_get_play_status(&cache_, true, true, &rsp));
+  ASSERT_TRUE(btif_rc_rsp_cache_get_play_status(&cache_, true, false, &rsp));
+  EXPECT_EQ(AVRC_PLAYSTATE_PLAYING, rsp.play_status);
+  EXPECT_LE(1000u, rsp.song_pos);
+  EXPECT_GT(1000u + BTIF_RC_PLAY_STATUS_CACHE_MS, rsp.song_pos);
+
+  btif_rc_rsp_cache_invalidate(&cache_, AVRC_EVT_PLAY_POS_CHANGED);
+  EXPECT_FALSE(btif_rc_rsp_cache_get_play_status(&cache_, true, false, &rsp));
+}
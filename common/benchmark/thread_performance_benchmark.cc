@@ -25,6 +25,7 @@
 #include "common/execution_barrier.h"
 #include "common/message_loop_thread.h"
 #include "osi/include/fixed_queue.h"
+#include "osi/include/task_stats.h"
 #include "osi/include/thread.h"
 
 using ::benchmark::State;
@@ -281,6 +282,24 @@ BENCHMARK_F(BM_OsiReactorThread, sequential_execution_using_thread_post)
   }
 };
 
+// Same as batch_enque_dequeue_using_thread_post, with per-task timing on, to
+// measure the overhead of task stats.
+BENCHMARK_F(BM_OsiReactorThread,
+            batch_enque_dequeue_using_thread_post_with_task_stats)
+(State& state) {
+  task_stats_set_enabled(true);
+  for (auto _ : state) {
+    g_counter = 0;
+    g_counter_barrier = std::make_unique<ExecutionBarrier>();
+    for (int i = 0; i < NUM_MESSAGES_TO_SEND; i++) {
+      fixed_queue_enqueue(bt_msg_queue_, (void*)&g_counter);
+      thread_post(thread_, pthread_callback_batch, bt_msg_queue_);
+    }
+    g_counter_barrier->WaitForExecution();
+  }
+  task_stats_set_enabled(false);
+};
+
 BENCHMARK_F(BM_OsiReactorThread, batch_enque_dequeue_using_reactor)
 (State& state) {
   fixed_queue_register_dequeue(bt_msg_queue_, thread_get_reactor(thread_),
@@ -344,6 +363,24 @@ BENCHMARK_F(BM_MessageLooopThread, batch_enque_dequeue)(State& state) {
   }
 };
 
+// Same as batch_enque_dequeue, with per-task timing on, to measure the
+// overhead of task stats.
+BENCHMARK_F(BM_MessageLooopThread, batch_enque_dequeue_with_task_stats)
+(State& state) {
+  task_stats_set_enabled(true);
+  for (auto _ : state) {
+    g_counter = 0;
+    g_counter_barrier = std::make_unique<ExecutionBarrier>();
+    for (int i = 0; i < NUM_MESSAGES_TO_SEND; i++) {
+      fixed_queue_enqueue(bt_msg_queue_, (void*)&g_counter);
+      message_loop_thread_->DoInThread(
+          FROM_HERE, base::BindOnce(&callback_batch, bt_msg_queue_, nullptr));
+    }
+    g_counter_barrier->WaitForExecution();
+  }
+  task_stats_set_enabled(false);
+};
+
 BENCHMARK_F(BM_MessageLooopThread, sequential_execution)(State& state) {
   for (auto _ : state) {
     for (int i = 0; i < NUM_MESSAGES_TO_SEND; i++) {
@@ -34,13 +34,15 @@ MessageLoopThread::MessageLoopThread(const std::string& thread_name)
       run_loop_(nullptr),
       thread_(nullptr),
       thread_id_(-1),
-      linux_tid_(-1) {}
+      linux_tid_(-1),
+      task_stats_(task_stats_new(thread_name.c_str())) {}
 
 MessageLoopThread::~MessageLoopThread() {
   std::lock_guard<std::recursive_mutex> api_lock(api_mutex_);
   if (thread_ != nullptr) {
     ShutDown();
   }
+  task_stats_free(task_stats_);
 }
 
 void MessageLoopThread::StartUp() {
@@ -64,7 +66,9 @@ bool MessageLoopThread::DoInThread(const tracked_objects::Location& from_here,
                << ", from " << from_here.ToString();
     return false;
   }
-  if (!message_loop_->task_runner()->PostTask(from_here, std::move(task))) {
+  if (!message_loop_->task_runner()->PostTask(
+          from_here,
+          task_stats_wrap(task_stats_, from_here, std::move(task)))) {
     LOG(ERROR) << __func__
                << ": failed to post task to message loop for thread " << *this
                << ", from " << from_here.ToString();
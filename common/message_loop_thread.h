@@ -28,6 +28,7 @@
 #include <base/tracked_objects.h>
 
 #include "common/execution_barrier.h"
+#include "osi/include/task_stats.h"
 
 namespace bluetooth {
 
@@ -160,6 +161,7 @@ class MessageLoopThread final {
   base::PlatformThreadId thread_id_;
   // Linux specific abstractions
   pid_t linux_tid_;
+  task_stats_t* task_stats_;
 
   DISALLOW_COPY_AND_ASSIGN(MessageLoopThread);
 };
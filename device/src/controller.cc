@@ -29,6 +29,7 @@
 #include "hcimsgs.h"
 #include "osi/include/future.h"
 #include "osi/include/properties.h"
+#include "osi/include/time.h"
 #include "stack/include/btm_ble_api.h"
 #include "osi/include/log.h"
 #include "utils/include/bt_utils.h"
@@ -154,8 +155,39 @@ uint8_t g_adv_audio_prop = 0;
 
 void update_soc_codec_transport();
 
-#define AWAIT_COMMAND(command) \
-  static_cast<BT_HDR*>(future_await(hci->transmit_command_futured(command)))
+// A command handed to the HCI layer during start up. Independent commands
+// are issued back to back and awaited later, so that the HCI layer can keep
+// as many in flight as the controller grants command credits for.
+typedef struct {
+  future_t* future;
+  const char* name;
+  uint64_t issued_us;
+} startup_command_t;
+
+// Time start_up() has spent blocked on command responses
+static uint64_t startup_blocked_us;
+
+static startup_command_t issue_command(BT_HDR* command, const char* name) {
+  startup_command_t issued;
+  issued.issued_us = time_get_os_boottime_us();
+  issued.future = hci->transmit_command_futured(command);
+  issued.name = name;
+  return issued;
+}
+
+static BT_HDR* await_command(startup_command_t issued) {
+  uint64_t await_us = time_get_os_boottime_us();
+  BT_HDR* response = static_cast<BT_HDR*>(future_await(issued.future));
+  uint64_t now_us = time_get_os_boottime_us();
+  startup_blocked_us += now_us - await_us;
+  LOG_DEBUG(LOG_TAG, "%s %s: %llu us after issue, blocked %llu us", __func__,
+            issued.name, (unsigned long long)(now_us - issued.issued_us),
+            (unsigned long long)(now_us - await_us));
+  return response;
+}
+
+#define ISSUE_COMMAND(command) issue_command((command), #command)
+#define AWAIT_COMMAND(command) await_command(ISSUE_COMMAND(command))
 
 // Module lifecycle functions
 
@@ -228,6 +260,7 @@ bool is_soc_lpa_enh_pwr_enabled() {
 
 static future_t* start_up(void) {
   BT_HDR* response;
+  uint64_t start_up_us = time_get_os_boottime_us();
   uint8_t adv_audio_support_mask = 0;
   char adv_audio_property[2] = {};
 
@@ -236,6 +269,7 @@ static future_t* start_up(void) {
 
   //initialize number_of_scrambling_supported_freqs to 0 during start_up
   number_of_scrambling_supported_freqs = 0;
+  startup_blocked_us = 0;
   soc_add_on_features_length = 0;
   host_add_on_features_length = 0;
   char qhs_value[2] = {};
@@ -342,17 +376,33 @@ static future_t* start_up(void) {
   response = AWAIT_COMMAND(packet_factory->make_reset());
   packet_parser->parse_generic_command_complete(response);
 
-  // Request the classic buffer size next
-  response = AWAIT_COMMAND(packet_factory->make_read_buffer_size());
-  packet_parser->parse_read_buffer_size_response(
-      response, &acl_data_size_classic, &acl_buffer_count_classic);
-
-  // Tell the controller about our buffer sizes and buffer counts next
+  // Nothing below depends on the answers to these, so issue them together
+  // and let the HCI layer pace them against the controller's credits:
+  // the classic buffer size, our own buffer sizes and counts, the local
+  // version info (manufacturer and supported HCI version), the bluetooth
+  // address, the supported commands and page 0 of the controller features.
   // TODO(zachoverflow): factor this out. eww l2cap contamination. And why just
   // a hardcoded 10?
-  response = AWAIT_COMMAND(packet_factory->make_host_buffer_size(
-      L2CAP_MTU_SIZE, SCO_HOST_BUFFER_SIZE, L2CAP_HOST_FC_ACL_BUFS, 10));
+  startup_command_t read_buffer_size =
+      ISSUE_COMMAND(packet_factory->make_read_buffer_size());
+  startup_command_t host_buffer_size =
+      ISSUE_COMMAND(packet_factory->make_host_buffer_size(
+          L2CAP_MTU_SIZE, SCO_HOST_BUFFER_SIZE, L2CAP_HOST_FC_ACL_BUFS, 10));
+  startup_command_t read_local_version_info =
+      ISSUE_COMMAND(packet_factory->make_read_local_version_info());
+  startup_command_t read_bd_addr =
+      ISSUE_COMMAND(packet_factory->make_read_bd_addr());
+  startup_command_t read_local_supported_commands =
+      ISSUE_COMMAND(packet_factory->make_read_local_supported_commands());
+  uint8_t page_number = 0;
+  startup_command_t read_local_extended_features = ISSUE_COMMAND(
+      packet_factory->make_read_local_extended_features(page_number));
+
+  response = await_command(read_buffer_size);
+  packet_parser->parse_read_buffer_size_response(
+      response, &acl_data_size_classic, &acl_buffer_count_classic);
 
+  response = await_command(host_buffer_size);
   packet_parser->parse_generic_command_complete(response);
 
   if (is_soc_logging_enabled()) {
@@ -372,25 +422,17 @@ static future_t* start_up(void) {
     btm_enable_link_lpa_enh_pwr_ctrl((uint16_t)HCI_INVALID_HANDLE, true);
   }
 
-  // Read the local version info off the controller next, including
-  // information such as manufacturer and supported HCI version
-  response = AWAIT_COMMAND(packet_factory->make_read_local_version_info());
+  response = await_command(read_local_version_info);
   packet_parser->parse_read_local_version_info_response(response, &bt_version);
 
-  // Read the bluetooth address off the controller next
-  response = AWAIT_COMMAND(packet_factory->make_read_bd_addr());
+  response = await_command(read_bd_addr);
   packet_parser->parse_read_bd_addr_response(response, &address);
 
-  // Request the controller's supported commands next
-  response =
-      AWAIT_COMMAND(packet_factory->make_read_local_supported_commands());
+  response = await_command(read_local_supported_commands);
   packet_parser->parse_read_local_supported_commands_response(
       response, supported_commands, HCI_SUPPORTED_COMMANDS_ARRAY_SIZE);
 
-  // Read page 0 of the controller features next
-  uint8_t page_number = 0;
-  response = AWAIT_COMMAND(
-      packet_factory->make_read_local_extended_features(page_number));
+  response = await_command(read_local_extended_features);
   packet_parser->parse_read_local_extended_features_response(
       response, &page_number, &last_features_classic_page_index,
       features_classic, MAX_FEATURES_CLASSIC_PAGE_COUNT);
@@ -463,19 +505,31 @@ static future_t* start_up(void) {
   ble_supported = last_features_classic_page_index >= 1 &&
                   HCI_LE_HOST_SUPPORTED(features_classic[1].as_array);
   if (ble_supported) {
-    // Request the ble white list size next
-    response = AWAIT_COMMAND(packet_factory->make_ble_read_white_list_size());
+    // The ble white list size, buffer size, supported states and supported
+    // features are independent of each other, so request them together
+    bool read_buffer_size_v2 =
+        HCI_LE_READ_BUFFER_SIZE_V2_SUPPORTED(supported_commands);
+    startup_command_t ble_read_white_list_size =
+        ISSUE_COMMAND(packet_factory->make_ble_read_white_list_size());
+    startup_command_t ble_read_buffer_size =
+        read_buffer_size_v2
+            ? ISSUE_COMMAND(packet_factory->make_ble_read_buffer_size_v2())
+            : ISSUE_COMMAND(packet_factory->make_ble_read_buffer_size());
+    startup_command_t ble_read_supported_states =
+        ISSUE_COMMAND(packet_factory->make_ble_read_supported_states());
+    startup_command_t ble_read_local_supported_features =
+        ISSUE_COMMAND(packet_factory->make_ble_read_local_supported_features());
+
+    response = await_command(ble_read_white_list_size);
     packet_parser->parse_ble_read_white_list_size_response(
         response, &ble_white_list_size);
 
-    // Request the ble buffer size next
-    if (HCI_LE_READ_BUFFER_SIZE_V2_SUPPORTED(supported_commands)) {
-      response = AWAIT_COMMAND(packet_factory->make_ble_read_buffer_size_v2());
+    response = await_command(ble_read_buffer_size);
+    if (read_buffer_size_v2) {
       packet_parser->parse_ble_read_buffer_size_response(
           response, &acl_data_size_ble, &acl_buffer_count_ble,
           &iso_data_packet_len, &total_num_iso_data_packets);
     } else {
-      response = AWAIT_COMMAND(packet_factory->make_ble_read_buffer_size());
       packet_parser->parse_ble_read_buffer_size_response(
           response, &acl_data_size_ble, &acl_buffer_count_ble, NULL, NULL);
     }
@@ -483,14 +537,11 @@ static future_t* start_up(void) {
     // Response of 0 indicates ble has the same buffer size as classic
     if (acl_data_size_ble == 0) acl_data_size_ble = acl_data_size_classic;
 
-    // Request the ble supported states next
-    response = AWAIT_COMMAND(packet_factory->make_ble_read_supported_states());
+    response = await_command(ble_read_supported_states);
     packet_parser->parse_ble_read_supported_states_response(
         response, ble_supported_states, sizeof(ble_supported_states));
 
-    // Request the ble supported features next
-    response =
-        AWAIT_COMMAND(packet_factory->make_ble_read_local_supported_features());
+    response = await_command(ble_read_local_supported_features);
     packet_parser->parse_ble_read_local_supported_features_response(
         response, &features_ble);
 
@@ -503,28 +554,53 @@ static future_t* start_up(void) {
       HCI_LE_SET_CIS_HOST_SUPPORT(features_ble.as_array);
     }
 
-    if (HCI_LE_ENHANCED_PRIVACY_SUPPORTED(features_ble.as_array)) {
-      response =
-          AWAIT_COMMAND(packet_factory->make_ble_read_resolving_list_size());
+    // The remaining ble reads only depend on the features read above, so
+    // they go out together with the ble event mask
+    bool enhanced_privacy =
+        HCI_LE_ENHANCED_PRIVACY_SUPPORTED(features_ble.as_array);
+    bool data_len_ext = HCI_LE_DATA_LEN_EXT_SUPPORTED(features_ble.as_array);
+    bool extended_advertising =
+        HCI_LE_EXTENDED_ADVERTISING_SUPPORTED(features_ble.as_array);
+    startup_command_t ble_read_resolving_list_size = {};
+    startup_command_t ble_read_suggested_default_data_length = {};
+    startup_command_t ble_read_maximum_advertising_data_length = {};
+    startup_command_t ble_read_number_of_supported_advertising_sets = {};
+
+    if (enhanced_privacy) {
+      ble_read_resolving_list_size =
+          ISSUE_COMMAND(packet_factory->make_ble_read_resolving_list_size());
+    }
+    if (data_len_ext) {
+      ble_read_suggested_default_data_length = ISSUE_COMMAND(
+          packet_factory->make_ble_read_suggested_default_data_length());
+    }
+    if (extended_advertising) {
+      ble_read_maximum_advertising_data_length = ISSUE_COMMAND(
+          packet_factory->make_ble_read_maximum_advertising_data_length());
+      ble_read_number_of_supported_advertising_sets = ISSUE_COMMAND(
+          packet_factory->make_ble_read_number_of_supported_advertising_sets());
+    }
+    startup_command_t ble_set_event_mask =
+        ISSUE_COMMAND(packet_factory->make_ble_set_event_mask(&BLE_EVENT_MASK));
+
+    if (enhanced_privacy) {
+      response = await_command(ble_read_resolving_list_size);
       packet_parser->parse_ble_read_resolving_list_size_response(
           response, &ble_resolving_list_max_size);
     }
 
-    if (HCI_LE_DATA_LEN_EXT_SUPPORTED(features_ble.as_array)) {
-      response = AWAIT_COMMAND(
-          packet_factory->make_ble_read_suggested_default_data_length());
+    if (data_len_ext) {
+      response = await_command(ble_read_suggested_default_data_length);
       packet_parser->parse_ble_read_suggested_default_data_length_response(
           response, &ble_suggested_default_data_length);
     }
 
-    if (HCI_LE_EXTENDED_ADVERTISING_SUPPORTED(features_ble.as_array)) {
-      response = AWAIT_COMMAND(
-          packet_factory->make_ble_read_maximum_advertising_data_length());
+    if (extended_advertising) {
+      response = await_command(ble_read_maximum_advertising_data_length);
       packet_parser->parse_ble_read_maximum_advertising_data_length(
           response, &ble_maxium_advertising_data_length);
 
-      response = AWAIT_COMMAND(
-          packet_factory->make_ble_read_number_of_supported_advertising_sets());
+      response = await_command(ble_read_number_of_supported_advertising_sets);
       packet_parser->parse_ble_read_number_of_supported_advertising_sets(
           response, &ble_number_of_supported_advertising_sets);
     } else {
@@ -532,9 +608,7 @@ static future_t* start_up(void) {
       ble_maxium_advertising_data_length = 31;
     }
 
-    // Set the ble event mask next
-    response =
-        AWAIT_COMMAND(packet_factory->make_ble_set_event_mask(&BLE_EVENT_MASK));
+    response = await_command(ble_set_event_mask);
     packet_parser->parse_generic_command_complete(response);
   }
 
@@ -735,6 +809,11 @@ static future_t* start_up(void) {
 
   g_adv_audio_prop = adv_audio_support_mask;
   readable = true;
+  LOG_INFO(LOG_TAG,
+           "%s took %llu us, %llu us of which blocked on the controller",
+           __func__,
+           (unsigned long long)(time_get_os_boottime_us() - start_up_us),
+           (unsigned long long)startup_blocked_us);
   return future_new_immediate(FUTURE_SUCCESS);
 }
 
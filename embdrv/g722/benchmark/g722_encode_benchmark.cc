@@ -0,0 +1,69 @@
+/*
+ * Copyright 2019 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+#include <cstdlib>
+#include <vector>
+
+#include "embdrv/g722/g722_enc_dec.h"
+
+using ::benchmark::State;
+
+// 10ms of 16kHz audio, matching a hearing aid G.722 frame
+#define SAMPLES_PER_FRAME 160
+
+class BM_G722Encode : public ::benchmark::Fixture {
+ protected:
+  void SetUp(State& st) override {
+    ::benchmark::Fixture::SetUp(st);
+    encoder_left_ = g722_encode_init(nullptr, 64000, G722_PACKED);
+    encoder_right_ = g722_encode_init(nullptr, 64000, G722_PACKED);
+    srand(0);
+    for (int i = 0; i < SAMPLES_PER_FRAME; i++) {
+      int16_t left = (int16_t)(rand() & 0xffff) >> 1;
+      int16_t right = (int16_t)(rand() & 0xffff) >> 1;
+      chan_left_.push_back(left);
+      chan_right_.push_back(right);
+    }
+    encoded_left_.resize(SAMPLES_PER_FRAME);
+    encoded_right_.resize(SAMPLES_PER_FRAME);
+  }
+
+  void TearDown(State& st) override {
+    g722_encode_release(encoder_left_);
+    g722_encode_release(encoder_right_);
+    ::benchmark::Fixture::TearDown(st);
+  }
+
+  g722_encode_state_t* encoder_left_ = nullptr;
+  g722_encode_state_t* encoder_right_ = nullptr;
+  std::vector<int16_t> chan_left_;
+  std::vector<int16_t> chan_right_;
+  std::vector<uint8_t> encoded_left_;
+  std::vector<uint8_t> encoded_right_;
+};
+
+BENCHMARK_F(BM_G722Encode, two_mono_channels)(State& state) {
+  for (auto _ : state) {
+    g722_encode(encoder_left_, encoded_left_.data(), chan_left_.data(),
+                SAMPLES_PER_FRAME);
+    g722_encode(encoder_right_, encoded_right_.data(), chan_right_.data(),
+                SAMPLES_PER_FRAME);
+  }
+  state.SetItemsProcessed(state.iterations() * SAMPLES_PER_FRAME * 2);
+};
+
+BENCHMARK_MAIN();
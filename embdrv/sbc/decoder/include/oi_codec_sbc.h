@@ -79,6 +79,7 @@ Declarations of codec functions, data types, and macros.
 
 #define OI_SBC_SYNCWORD 0x9c
 #define OI_SBC_ENHANCED_SYNCWORD 0x9d
+#define OI_mSBC_SYNCWORD 0xad
 
 /**@name Sampling frequencies */
 /**@{*/
@@ -238,6 +239,8 @@ typedef struct {
   uint8_t restrictSubbands;
   uint8_t enhancedEnabled;
   uint8_t bufferedBlocks;
+  /* Boolean, set by OI_CODEC_mSBC_DecoderReset() */
+  uint8_t mSBCEnabled;
 } OI_CODEC_SBC_DECODER_CONTEXT;
 
 typedef struct {
@@ -275,6 +278,18 @@ OI_STATUS OI_CODEC_SBC_DecoderReset(OI_CODEC_SBC_DECODER_CONTEXT* context,
                                     uint8_t maxChannels, uint8_t pcmStride,
                                     OI_BOOL enhanced);
 
+/**
+ * This function resets the decoder for an mSBC (HFP wideband speech) stream.
+ * Only frames starting with the mSBC syncword are decoded, and their
+ * parameters are taken from the mSBC specification rather than from the
+ * frame header. Each decoded frame yields 120 mono samples.
+ *
+ * @param context   Pointer to the decoder context structure to be reset.
+ */
+OI_STATUS OI_CODEC_mSBC_DecoderReset(OI_CODEC_SBC_DECODER_CONTEXT* context,
+                                     uint32_t* decoderData,
+                                     uint32_t decoderDataBytes);
+
 /**
  * This function restricts the kind of SBC frames that the Decoder will
  * process.  Its use is optional.  If used, it must be called after
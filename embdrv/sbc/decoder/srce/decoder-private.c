@@ -90,7 +90,24 @@ INLINE void OI_SBC_ReadHeader(OI_CODEC_SBC_COMMON_CONTEXT* common,
   OI_CODEC_SBC_FRAME_INFO* frame = &common->frameInfo;
   uint8_t d1;
 
-  OI_ASSERT(data[0] == OI_SBC_SYNCWORD || data[0] == OI_SBC_ENHANCED_SYNCWORD);
+  OI_ASSERT(data[0] == OI_SBC_SYNCWORD || data[0] == OI_SBC_ENHANCED_SYNCWORD ||
+            data[0] == OI_mSBC_SYNCWORD);
+
+  /* mSBC frames carry no parameters in their header, they are fixed by the
+   * HFP specification */
+  if (data[0] == OI_mSBC_SYNCWORD) {
+    frame->freqIndex = SBC_FREQ_16000;
+    frame->frequency = freq_values[frame->freqIndex];
+    frame->nrof_blocks = 15;
+    frame->mode = SBC_MONO;
+    frame->nrof_channels = channel_values[frame->mode];
+    frame->alloc = SBC_LOUDNESS;
+    frame->subbands = SBC_SUBBANDS_8;
+    frame->nrof_subbands = band_values[frame->subbands];
+    frame->bitpool = 26;
+    frame->crc = data[3];
+    return;
+  }
 
   /* Avoid filling out all these strucutures if we already remember the values
    * from last time. Just in case we get a stream corresponding to data[1] ==
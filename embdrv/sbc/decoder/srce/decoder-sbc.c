@@ -50,6 +50,18 @@ PRIVATE OI_STATUS FindSyncword(OI_CODEC_SBC_DECODER_CONTEXT* context,
     return OI_CODEC_SBC_NOT_ENOUGH_HEADER_DATA;
   }
 
+  if (context->mSBCEnabled) {
+    while (*frameBytes && (**frameData != OI_mSBC_SYNCWORD)) {
+      (*frameBytes)--;
+      (*frameData)++;
+    }
+    if (*frameBytes) {
+      context->common.frameInfo.enhanced = FALSE;
+      return OI_OK;
+    }
+    return OI_CODEC_SBC_NO_SYNCWORD;
+  }
+
 #ifdef SBC_ENHANCED
   if (context->limitFrameFormat && context->enhancedEnabled) {
     /* If the context is restricted, only search for specified SYNCWORD */
@@ -234,6 +246,15 @@ OI_STATUS OI_CODEC_SBC_DecoderReset(OI_CODEC_SBC_DECODER_CONTEXT* context,
                                maxChannels, pcmStride, enhanced);
 }
 
+OI_STATUS OI_CODEC_mSBC_DecoderReset(OI_CODEC_SBC_DECODER_CONTEXT* context,
+                                     uint32_t* decoderData,
+                                     uint32_t decoderDataBytes) {
+  OI_STATUS status = internal_DecoderReset(context, decoderData,
+                                           decoderDataBytes, 1, 1, FALSE);
+  if (OI_SUCCESS(status)) context->mSBCEnabled = TRUE;
+  return status;
+}
+
 OI_STATUS OI_CODEC_SBC_DecodeFrame(OI_CODEC_SBC_DECODER_CONTEXT* context,
                                    const OI_BYTE** frameData,
                                    uint32_t* frameBytes, int16_t* pcmData,
@@ -58,6 +58,17 @@
 #define SBC_STEREO 2
 #define SBC_JOINT_STEREO 3
 
+#define SBC_FORMAT_GENERAL 0
+#define SBC_FORMAT_MSBC 1
+
+/* mSBC (HFP wideband speech) frames always carry 120 samples of 16 kHz mono
+ * audio, coded with 8 subbands, 15 blocks, loudness allocation and a bitpool
+ * of 26, which gives 57 bytes per frame. */
+#define SBC_MSBC_BLOCKS 15
+#define SBC_MSBC_BITPOOL 26
+#define SBC_MSBC_SAMPLES 120
+#define SBC_MSBC_FRAME_LEN 57
+
 #define SBC_BLOCK_0 4
 #define SBC_BLOCK_1 8
 #define SBC_BLOCK_2 12
@@ -188,6 +199,14 @@ typedef struct SBC_ENC_PARAMS_TAG {
   int16_t as16Bits[SBC_MAX_NUM_OF_CHANNELS * SBC_MAX_NUM_OF_SUBBANDS];
 
   uint16_t FrameHeader;
+  uint8_t Format; /* SBC_FORMAT_GENERAL or SBC_FORMAT_MSBC */
+
+  /* Analysis filter history. Kept per instance so that several encoders can
+   * be used at the same time. s32X must be 32 bits aligned, it is also
+   * accessed as int16_t, cf SHIFTUP_X8_2 */
+  int32_t s32X[ENC_VX_BUFFER_SIZE / 2];
+  int16_t s16ShiftCounter;
+  int16_t s16MaxShiftCounter;
 
 } SBC_ENC_PARAMS;
 
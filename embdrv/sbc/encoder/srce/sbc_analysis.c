@@ -197,17 +197,6 @@
 #define WIND_8_SUBBANDS_8_2 (int16_t)0x12CF /* 40 = 0x12CF6C75 */
 #endif
 
-#if (SBC_USE_ARM_PRAGMA == TRUE)
-#pragma arm section zidata = "sbc_s32_analysis_section"
-#endif
-static int32_t s32DCTY[16] = {0};
-static int32_t s32X[ENC_VX_BUFFER_SIZE / 2];
-static int16_t* s16X =
-    (int16_t*)s32X; /* s16X must be 32 bits aligned cf  SHIFTUP_X8_2*/
-#if (SBC_USE_ARM_PRAGMA == TRUE)
-#pragma arm section zidata
-#endif
-
 /* This macro is for 4 subbands */
 #define SHIFTUP_X4                                      \
   {                                                     \
@@ -1185,8 +1174,6 @@ static int16_t* s16X =
 #endif
 #endif
 
-static int16_t ShiftCounter = 0;
-extern int16_t EncMaxShiftCounter;
 /****************************************************************************
 * SbcAnalysisFilter - performs Analysis of the input audio stream
 *
@@ -1199,6 +1186,7 @@ void SbcAnalysisFilter4(SBC_ENC_PARAMS* pstrEncParams, int16_t* input) {
   int32_t s32NumOfChannels, s32NumOfBlocks;
   int32_t i, *ps32X, *ps32X2;
   int32_t Offset, Offset2, ChOffset;
+  int32_t s32DCTY[16]; /* on the stack, so that encoders can run in parallel */
 #if (SBC_ARM_ASM_OPT == TRUE)
   register int32_t s32Hi, s32Hi2;
 #else
@@ -1217,6 +1205,12 @@ void SbcAnalysisFilter4(SBC_ENC_PARAMS* pstrEncParams, int16_t* input) {
 #endif
 #endif
 
+  /* The filter history is kept per encoder instance, so that several
+   * encoders can run side by side */
+  int16_t* s16X = (int16_t*)pstrEncParams->s32X;
+  int16_t ShiftCounter = pstrEncParams->s16ShiftCounter;
+  const int16_t EncMaxShiftCounter = pstrEncParams->s16MaxShiftCounter;
+
   s32NumOfChannels = pstrEncParams->s16NumOfChannels;
   s32NumOfBlocks = pstrEncParams->s16NumOfBlocks;
 
@@ -1279,6 +1273,7 @@ void SbcAnalysisFilter4(SBC_ENC_PARAMS* pstrEncParams, int16_t* input) {
       }
     }
   }
+  pstrEncParams->s16ShiftCounter = ShiftCounter;
 }
 
 /* ////////////////////////////////////////////////////////////////////////// */
@@ -1290,6 +1285,7 @@ void SbcAnalysisFilter8(SBC_ENC_PARAMS* pstrEncParams, int16_t* input) {
   int32_t s32NumOfChannels, s32NumOfBlocks;
   int32_t i, *ps32X, *ps32X2;
   int32_t ChOffset;
+  int32_t s32DCTY[16]; /* on the stack, so that encoders can run in parallel */
 #if (SBC_ARM_ASM_OPT == TRUE)
   register int32_t s32Hi, s32Hi2;
 #else
@@ -1306,6 +1302,12 @@ void SbcAnalysisFilter8(SBC_ENC_PARAMS* pstrEncParams, int16_t* input) {
 #endif
 #endif
 
+  /* The filter history is kept per encoder instance, so that several
+   * encoders can run side by side */
+  int16_t* s16X = (int16_t*)pstrEncParams->s32X;
+  int16_t ShiftCounter = pstrEncParams->s16ShiftCounter;
+  const int16_t EncMaxShiftCounter = pstrEncParams->s16MaxShiftCounter;
+
   s32NumOfChannels = pstrEncParams->s16NumOfChannels;
   s32NumOfBlocks = pstrEncParams->s16NumOfBlocks;
 
@@ -1392,9 +1394,10 @@ void SbcAnalysisFilter8(SBC_ENC_PARAMS* pstrEncParams, int16_t* input) {
       }
     }
   }
+  pstrEncParams->s16ShiftCounter = ShiftCounter;
 }
 
-void SbcAnalysisInit(void) {
-  memset(s16X, 0, ENC_VX_BUFFER_SIZE * sizeof(int16_t));
-  ShiftCounter = 0;
+void SbcAnalysisInit(SBC_ENC_PARAMS* pstrEncParams) {
+  memset(pstrEncParams->s32X, 0, sizeof(pstrEncParams->s32X));
+  pstrEncParams->s16ShiftCounter = 0;
 }
@@ -0,0 +1,76 @@
+/******************************************************************************
+ *
+ *  Copyright 2019 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#pragma once
+
+#include <base/callback.h>
+
+#include <queue>
+#include <vector>
+
+#include "hci_layer.h"
+
+// Decides when the commands of the HCI layer are sent to the controller,
+// within the command credits it grants.
+//
+// Latency sensitive commands (disconnects, SCO set up, link key and LTK
+// replies) are queued separately so that a burst of other commands cannot
+// hold them back. While other commands are in flight, the last credit is kept
+// back for them.
+//
+// Commands which must stay ordered after an earlier command, such as a
+// connection cancel after the Create Connection it cancels, are never
+// prioritized.
+//
+// Not thread safe, the HCI layer calls it under its command credits lock.
+class CommandScheduler {
+ public:
+  // Credits kept back for the high priority queue while other commands are in
+  // flight.
+  static constexpr int kHighPriorityReservedCredits = 1;
+
+  // Returns true if |opcode| is sent ahead of the other queued commands.
+  static bool IsHighPriority(command_opcode_t opcode);
+
+  // Drops the queued commands and goes back to the single credit the host
+  // starts with (Core spec, Volume 2, Part E, 4.4 Command Flow Control).
+  void Reset();
+
+  // Queues |send|, which sends a command with |opcode|, while
+  // |num_waiting_commands| commands are awaiting a response. The commands to
+  // send now are appended to |ready|.
+  void Enqueue(command_opcode_t opcode, base::Closure send,
+               int num_waiting_commands, std::vector<base::Closure>* ready);
+
+  // The controller now grants |credits| with |num_waiting_commands| commands
+  // awaiting a response. The commands to send now are appended to |ready|.
+  void UpdateCredits(int credits, int num_waiting_commands,
+                     std::vector<base::Closure>* ready);
+
+  int credits() const { return credits_; }
+  size_t queued() const {
+    return high_priority_queue_.size() + queue_.size();
+  }
+
+ private:
+  void Dequeue(int num_waiting_commands, std::vector<base::Closure>* ready);
+
+  int credits_ = 1;
+  std::queue<base::Closure> high_priority_queue_;
+  std::queue<base::Closure> queue_;
+};
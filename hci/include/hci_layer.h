@@ -102,3 +102,6 @@ void post_to_hci_message_loop(const base::Location& from_here,
                               BT_HDR* p_msg);
 
 void hci_layer_cleanup_interface();
+
+// Dumps per-opcode command round trip latency to |fd|
+void hci_layer_debug_dump(int fd);
@@ -0,0 +1,93 @@
+/******************************************************************************
+ *
+ *  Copyright 2019 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#include "command_scheduler.h"
+
+#include <utility>
+
+#include "hcidefs.h"
+
+bool CommandScheduler::IsHighPriority(command_opcode_t opcode) {
+  switch (opcode) {
+    case HCI_DISCONNECT:
+    case HCI_SETUP_ESCO_CONNECTION:
+    case HCI_ACCEPT_ESCO_CONNECTION:
+    case HCI_REJECT_ESCO_CONNECTION:
+    case HCI_ENH_SETUP_ESCO_CONNECTION:
+    case HCI_ENH_ACCEPT_ESCO_CONNECTION:
+    case HCI_LINK_KEY_REQUEST_REPLY:
+    case HCI_BLE_START_ENC:
+    case HCI_BLE_LTK_REQ_REPLY:
+    case HCI_BLE_LTK_REQ_NEG_REPLY:
+      return true;
+    // Not prioritized, although latency sensitive: connection cancels could
+    // reach the controller before the queued Create Connection they cancel,
+    // and Set Connection Encryption before a queued Authentication Requested
+    // on the same link.
+    case HCI_CREATE_CONNECTION_CANCEL:
+    case HCI_BLE_CREATE_CONN_CANCEL:
+    case HCI_SET_CONN_ENCRYPTION:
+    default:
+      return false;
+  }
+}
+
+void CommandScheduler::Reset() {
+  credits_ = 1;
+  std::queue<base::Closure>().swap(high_priority_queue_);
+  std::queue<base::Closure>().swap(queue_);
+}
+
+void CommandScheduler::Enqueue(command_opcode_t opcode, base::Closure send,
+                               int num_waiting_commands,
+                               std::vector<base::Closure>* ready) {
+  if (IsHighPriority(opcode))
+    high_priority_queue_.push(std::move(send));
+  else
+    queue_.push(std::move(send));
+
+  Dequeue(num_waiting_commands, ready);
+}
+
+void CommandScheduler::UpdateCredits(int credits, int num_waiting_commands,
+                                     std::vector<base::Closure>* ready) {
+  // Subtract commands in flight.
+  credits_ = credits - num_waiting_commands;
+  Dequeue(num_waiting_commands, ready);
+}
+
+void CommandScheduler::Dequeue(int num_waiting_commands,
+                               std::vector<base::Closure>* ready) {
+  while (credits_ > 0 && !high_priority_queue_.empty()) {
+    ready->push_back(std::move(high_priority_queue_.front()));
+    high_priority_queue_.pop();
+    credits_--;
+    num_waiting_commands++;
+  }
+
+  // The last credits are only handed to other commands when nothing else is
+  // in flight, so that the queue always makes progress.
+  while (!queue_.empty() &&
+         (credits_ > kHighPriorityReservedCredits ||
+          (credits_ > 0 && num_waiting_commands == 0))) {
+    ready->push_back(std::move(queue_.front()));
+    queue_.pop();
+    credits_--;
+    num_waiting_commands++;
+  }
+}
@@ -32,10 +32,15 @@
 #include <unistd.h>
 
 #include <chrono>
+#include <deque>
+#include <list>
 #include <mutex>
+#include <unordered_map>
+#include <vector>
 
 #include "btcore/include/module.h"
 #include "btsnoop.h"
+#include "command_scheduler.h"
 #include "buffer_allocator.h"
 #include "hci_inject.h"
 #include "hci_internals.h"
@@ -45,8 +50,10 @@
 #include "osi/include/alarm.h"
 #include "osi/include/list.h"
 #include "osi/include/log.h"
+#include "osi/include/packet_trace.h"
 #include "osi/include/properties.h"
 #include "osi/include/reactor.h"
+#include "osi/include/task_stats.h"
 #include "packet_fragmenter.h"
 #include "controller.h"
 
@@ -114,15 +121,34 @@ static alarm_t* startup_timer;
 static alarm_t *hci_timeout_abort_timer;
 
 // Outbound-related
-static int command_credits = 1;
 static std::mutex command_credits_mutex;
-static std::queue<base::Closure> command_queue;
+static CommandScheduler command_scheduler;
 
 // Inbound-related
 static alarm_t* command_response_timer;
-static list_t* commands_pending_response;
+// Commands awaiting a response in the order they were sent, and an index into
+// it by opcode. Several commands with the same opcode may be outstanding, they
+// are answered in the order they were sent.
+typedef std::list<waiting_command_t*> pending_command_list_t;
+static pending_command_list_t commands_pending_response;
+static std::unordered_map<command_opcode_t,
+                          std::deque<pending_command_list_t::iterator>>
+    commands_pending_by_opcode;
 static std::recursive_mutex commands_pending_response_mutex;
 
+// Command round trip latency, per opcode
+#define COMMAND_LATENCY_BUCKETS 8
+static const uint32_t command_latency_bucket_ms[COMMAND_LATENCY_BUCKETS - 1] = {
+    1, 2, 5, 10, 20, 50, 100};
+typedef struct {
+  uint32_t count;
+  uint64_t total_us;
+  uint64_t max_us;
+  uint32_t buckets[COMMAND_LATENCY_BUCKETS];
+} command_latency_stats_t;
+static std::unordered_map<command_opcode_t, command_latency_stats_t>
+    command_latency_stats;
+
 static std::mutex monitor_cmd_stats;
 struct monitor_command {
   period_ms_t lapsed_timeout;
@@ -138,6 +164,7 @@ static base::Callback<void(const base::Location&, BT_HDR*)>
     send_data_upwards;
 
 static bool filter_incoming_event(BT_HDR* packet);
+static uint16_t acl_packet_handle(const BT_HDR* packet);
 static waiting_command_t* get_waiting_command(command_opcode_t opcode);
 static int get_num_waiting_commands();
 
@@ -172,7 +199,9 @@ static const packet_fragmenter_callbacks_t packet_fragmenter_callbacks = {
 void initialization_complete() {
   std::lock_guard<std::mutex> lock(message_loop_mutex);
   message_loop_->task_runner()->PostTask(
-      FROM_HERE, base::Bind(&event_finish_startup, nullptr));
+      FROM_HERE,
+      task_stats_wrap(thread_get_task_stats(thread), FROM_HERE,
+                      base::Bind(&event_finish_startup, nullptr)));
 }
 
 void hci_event_received(const base::Location& from_here,
@@ -189,6 +218,8 @@ void hci_event_received(const base::Location& from_here,
 void acl_event_received(BT_HDR* packet) {
   inc_rx_packet_counter();
   btsnoop->capture(packet, true);
+  PACKET_TRACE(PACKET_TRACE_HCI_RX, packet, acl_packet_handle(packet),
+               packet->len);
   packet_fragmenter->reassemble_and_dispatch(packet);
 }
 
@@ -228,7 +259,13 @@ static future_t* hci_module_start_up(void) {
   // as per the Bluetooth spec, Volume 2, Part E, 4.4 (Command Flow Control)
   // This value can change when you get a command complete or command status
   // event.
-  command_credits = 1;
+  {
+    std::lock_guard<std::mutex> lock(command_credits_mutex);
+    command_scheduler.Reset();
+  }
+
+  packet_trace_set_enabled(
+      osi_property_get_int32("persist.bluetooth.packet_trace", 0) != 0);
 
   // For now, always use the default timeout on non-Android builds.
   period_ms_t startup_timeout_ms = DEFAULT_STARTUP_TIMEOUT_MS;
@@ -271,12 +308,11 @@ static future_t* hci_module_start_up(void) {
     LOG_ERROR(LOG_TAG, "%s unable to make thread RT.", __func__);
   }
 
-  commands_pending_response = list_new(NULL);
-  if (!commands_pending_response) {
-    LOG_ERROR(LOG_TAG,
-              "%s unable to create list for commands pending response.",
-              __func__);
-    goto error;
+  {
+    std::lock_guard<std::recursive_mutex> lock(commands_pending_response_mutex);
+    commands_pending_response.clear();
+    commands_pending_by_opcode.clear();
+    command_latency_stats.clear();
   }
 
   // Make sure we run in a bounded amount of time
@@ -326,8 +362,8 @@ static future_t* hci_module_shut_down() {
 
   {
     std::lock_guard<std::recursive_mutex> lock(commands_pending_response_mutex);
-    list_free(commands_pending_response);
-    commands_pending_response = NULL;
+    commands_pending_response.clear();
+    commands_pending_by_opcode.clear();
   }
 
   packet_fragmenter->cleanup();
@@ -447,23 +483,29 @@ static void startup_timer_expired(UNUSED_ATTR void* context) {
 }
 
 // Command/packet transmitting functions
-static void enqueue_command(waiting_command_t* wait_entry) {
-  base::Closure callback = base::Bind(&event_command_ready, wait_entry);
+static void post_commands(std::vector<base::Closure>* ready) {
+  for (base::Closure& send : *ready) {
+    message_loop_->task_runner()->PostTask(
+        FROM_HERE, task_stats_wrap(thread_get_task_stats(thread), FROM_HERE,
+                                   std::move(send)));
+  }
+}
 
+static void enqueue_command(waiting_command_t* wait_entry) {
   std::lock_guard<std::mutex> command_credits_lock(command_credits_mutex);
-  if (command_credits > 0) {
-    std::lock_guard<std::mutex> message_loop_lock(message_loop_mutex);
-    if (message_loop_ == nullptr) {
-      // HCI Layer was shut down
-      buffer_allocator->free(wait_entry->command);
-      osi_free(wait_entry);
-      return;
-    }
-    message_loop_->task_runner()->PostTask(FROM_HERE, std::move(callback));
-    command_credits--;
-  } else {
-    command_queue.push(std::move(callback));
+  std::lock_guard<std::mutex> message_loop_lock(message_loop_mutex);
+  if (message_loop_ == nullptr) {
+    // HCI Layer was shut down
+    buffer_allocator->free(wait_entry->command);
+    osi_free(wait_entry);
+    return;
   }
+
+  std::vector<base::Closure> ready;
+  command_scheduler.Enqueue(wait_entry->opcode,
+                            base::Bind(&event_command_ready, wait_entry),
+                            get_num_waiting_commands(), &ready);
+  post_commands(&ready);
 }
 
 static void event_command_ready(waiting_command_t* wait_entry) {
@@ -471,7 +513,9 @@ static void event_command_ready(waiting_command_t* wait_entry) {
     /// Move it to the list of commands awaiting response
     std::lock_guard<std::recursive_mutex> lock(commands_pending_response_mutex);
     wait_entry->timestamp = std::chrono::steady_clock::now();
-    list_append(commands_pending_response, wait_entry);
+    commands_pending_by_opcode[wait_entry->opcode].push_back(
+        commands_pending_response.insert(commands_pending_response.end(),
+                                         wait_entry));
   }
   // Send it off
   packet_fragmenter->fragment_and_dispatch(wait_entry->command);
@@ -487,7 +531,8 @@ static void enqueue_packet(void* packet) {
     return;
   }
   message_loop_->task_runner()->PostTask(
-      FROM_HERE, base::Bind(&event_packet_ready, packet));
+      FROM_HERE, task_stats_wrap(thread_get_task_stats(thread), FROM_HERE,
+                                 base::Bind(&event_packet_ready, packet)));
 }
 
 static void event_packet_ready(void* pkt) {
@@ -499,6 +544,9 @@ static void event_packet_ready(void* pkt) {
 // Callback for the fragmenter to send a fragment
 static void transmit_fragment(BT_HDR* packet, bool send_transmit_finished) {
   btsnoop->capture(packet, false);
+  if ((packet->event & MSG_EVT_MASK) == MSG_STACK_TO_HC_HCI_ACL)
+    PACKET_TRACE(PACKET_TRACE_HCI_TX, packet, acl_packet_handle(packet),
+                 packet->len);
 
   /* Parse packet event before transmitting it.
    * This is to avoid use after free for "packet"
@@ -546,7 +594,8 @@ static void command_timed_out(void* original_wait_entry) {
   // Dynamically increase command timeout if applicable.
   {
     std::unique_lock<std::mutex> lock(monitor_cmd_stats);
-    if (cmd_stats.is_monitor_enabled && cmd_stats.no_packets_rx > 0 &&
+    if (cmd_stats.is_monitor_enabled && !commands_pending_response.empty() &&
+        cmd_stats.no_packets_rx > 0 &&
         cmd_stats.no_packets_rx > cmd_stats.prev_no_packets &&
         cmd_stats.lapsed_timeout < MAX_CMD_TIMEOUT) {
       unsigned int curr_no_packets = cmd_stats.no_packets_rx - cmd_stats.prev_no_packets;
@@ -563,7 +612,7 @@ static void command_timed_out(void* original_wait_entry) {
               (unsigned long long)new_timeout);
       cmd_stats.lapsed_timeout += new_timeout;
       alarm_set(command_response_timer, new_timeout, command_timed_out,
-                list_front(commands_pending_response));
+                commands_pending_response.front());
       return;
     }
   }
@@ -571,11 +620,7 @@ static void command_timed_out(void* original_wait_entry) {
   LOG_ERROR(LOG_TAG, "%s: %d commands pending response", __func__,
             get_num_waiting_commands());
 
-  for (const list_node_t* node = list_begin(commands_pending_response);
-       node != list_end(commands_pending_response); node = list_next(node)) {
-    waiting_command_t* wait_entry =
-        reinterpret_cast<waiting_command_t*>(list_node(node));
-
+  for (waiting_command_t* wait_entry : commands_pending_response) {
     int wait_time_ms =
         std::chrono::duration_cast<std::chrono::milliseconds>(
             std::chrono::steady_clock::now() - wait_entry->timestamp)
@@ -645,15 +690,9 @@ void process_command_credits(int credits) {
     return;
   }
 
-  // Subtract commands in flight.
-  command_credits = credits - get_num_waiting_commands();
-
-  while (command_credits > 0 && command_queue.size() > 0) {
-    message_loop_->task_runner()->PostTask(FROM_HERE,
-                                           std::move(command_queue.front()));
-    command_queue.pop();
-    command_credits--;
-  }
+  std::vector<base::Closure> ready;
+  command_scheduler.UpdateCredits(credits, get_num_waiting_commands(), &ready);
+  post_commands(&ready);
 }
 
 // Returns true if the event was intercepted and should not proceed to
@@ -757,59 +796,96 @@ static void dispatch_reassembled(BT_HDR* packet) {
   CHECK((packet->event & MSG_EVT_MASK) != MSG_HC_TO_STACK_HCI_EVT);
   CHECK(!send_data_upwards.is_null());
 
+  if ((packet->event & MSG_EVT_MASK) == MSG_HC_TO_STACK_HCI_ACL)
+    PACKET_TRACE(PACKET_TRACE_REASSEMBLED, packet, acl_packet_handle(packet),
+                 packet->len);
   send_data_upwards.Run(FROM_HERE, packet);
 }
 
 // Misc internal functions
 
-static waiting_command_t* get_waiting_command(command_opcode_t opcode) {
-  std::lock_guard<std::recursive_mutex> lock(commands_pending_response_mutex);
-
-  for (const list_node_t* node = list_begin(commands_pending_response);
-       node != list_end(commands_pending_response); node = list_next(node)) {
-    waiting_command_t* wait_entry =
-        reinterpret_cast<waiting_command_t*>(list_node(node));
+static uint16_t acl_packet_handle(const BT_HDR* packet) {
+  const uint8_t* stream = packet->data + packet->offset;
+  uint16_t handle;
+  STREAM_TO_UINT16(handle, stream);
+  return HCID_GET_HANDLE(handle);
+}
+
+static void record_command_latency(const waiting_command_t* wait_entry) {
+  uint64_t latency_us =
+      std::chrono::duration_cast<std::chrono::microseconds>(
+          std::chrono::steady_clock::now() - wait_entry->timestamp)
+          .count();
+  command_latency_stats_t& stats = command_latency_stats[wait_entry->opcode];
+
+  int bucket = 0;
+  while (bucket < COMMAND_LATENCY_BUCKETS - 1 &&
+         latency_us >= command_latency_bucket_ms[bucket] * 1000)
+    bucket++;
+  stats.buckets[bucket]++;
+  stats.count++;
+  stats.total_us += latency_us;
+  if (latency_us > stats.max_us) stats.max_us = latency_us;
+}
+
+static waiting_command_t* remove_waiting_command(
+    pending_command_list_t::iterator it) {
+  waiting_command_t* wait_entry = *it;
+
+  auto by_opcode = commands_pending_by_opcode.find(wait_entry->opcode);
+  CHECK(by_opcode != commands_pending_by_opcode.end());
+  for (auto entry = by_opcode->second.begin(); entry != by_opcode->second.end();
+       ++entry) {
+    if (*entry == it) {
+      by_opcode->second.erase(entry);
+      break;
+    }
+  }
+  if (by_opcode->second.empty()) commands_pending_by_opcode.erase(by_opcode);
 
-    if (!wait_entry || wait_entry->opcode != opcode) continue;
+  commands_pending_response.erase(it);
+  record_command_latency(wait_entry);
+  return wait_entry;
+}
 
-    list_remove(commands_pending_response, wait_entry);
+static waiting_command_t* get_waiting_command(command_opcode_t opcode) {
+  std::lock_guard<std::recursive_mutex> lock(commands_pending_response_mutex);
 
-    return wait_entry;
+  auto by_opcode = commands_pending_by_opcode.find(opcode);
+  if (by_opcode != commands_pending_by_opcode.end()) {
+    return remove_waiting_command(by_opcode->second.front());
   }
+
   // look for any command complete with improper VS Opcode
-  for (const list_node_t *node = list_begin(commands_pending_response);
-      node != list_end(commands_pending_response);
-      node = list_next(node)) {
-    waiting_command_t *wait_entry =
-        reinterpret_cast<waiting_command_t*> (list_node(node));
-
-    if (wait_entry && (wait_entry->opcode != opcode) &&
-        (((wait_entry->opcode & HCI_GRP_VENDOR_SPECIFIC) == HCI_GRP_VENDOR_SPECIFIC) &&
-         (((opcode & HCI_GRP_VENDOR_SPECIFIC) == HCI_GRP_VENDOR_SPECIFIC) ||
-            opcode == 0))) {
-      LOG_DEBUG(LOG_TAG,"%s Treat it as valid, wait_entry opcode 0x%x opcode 0x%x",
-                __func__, wait_entry->opcode, opcode);
-    } else {
-      continue;
-    }
+  if (((opcode & HCI_GRP_VENDOR_SPECIFIC) != HCI_GRP_VENDOR_SPECIFIC) &&
+      opcode != 0) {
+    return NULL;
+  }
+  for (auto it = commands_pending_response.begin();
+       it != commands_pending_response.end(); ++it) {
+    waiting_command_t* wait_entry = *it;
 
-    list_remove(commands_pending_response, wait_entry);
+    if ((wait_entry->opcode & HCI_GRP_VENDOR_SPECIFIC) !=
+        HCI_GRP_VENDOR_SPECIFIC)
+      continue;
 
-    return wait_entry;
+    LOG_DEBUG(LOG_TAG,"%s Treat it as valid, wait_entry opcode 0x%x opcode 0x%x",
+              __func__, wait_entry->opcode, opcode);
+    return remove_waiting_command(it);
   }
   return NULL;
 }
 
 static int get_num_waiting_commands() {
   std::lock_guard<std::recursive_mutex> lock(commands_pending_response_mutex);
-  return list_length(commands_pending_response);
+  return commands_pending_response.size();
 }
 
 static void update_command_response_timer(void) {
   std::lock_guard<std::recursive_mutex> lock(commands_pending_response_mutex);
 
   if (command_response_timer == NULL) return;
-  if (list_is_empty(commands_pending_response)) {
+  if (commands_pending_response.empty()) {
     if (alarm_is_scheduled(command_response_timer)) {
       alarm_cancel(command_response_timer);
     } else {
@@ -823,7 +899,7 @@ static void update_command_response_timer(void) {
     }
   } else {
     alarm_set(command_response_timer, COMMAND_PENDING_TIMEOUT_MS,
-              command_timed_out, list_front(commands_pending_response));
+              command_timed_out, commands_pending_response.front());
     /* This block of code executes when command is sent out.
      * Start monitoring incoming events.
      */
@@ -882,3 +958,24 @@ const hci_t* hci_layer_get_test_interface(
   init_layer_interface();
   return &interface;
 }
+
+void hci_layer_debug_dump(int fd) {
+  std::lock_guard<std::recursive_mutex> lock(commands_pending_response_mutex);
+
+  dprintf(fd, "\nHCI command round trip latency:\n");
+  dprintf(fd, "  Commands pending response: %zu\n",
+          commands_pending_response.size());
+  if (command_latency_stats.empty()) return;
+
+  dprintf(fd, "  %-8s %8s %10s %10s  %s\n", "Opcode", "Count", "Avg (us)",
+          "Max (us)", "<1 <2 <5 <10 <20 <50 <100 >=100 ms");
+  for (const auto& entry : command_latency_stats) {
+    const command_latency_stats_t& stats = entry.second;
+    dprintf(fd, "  0x%04x   %8u %10llu %10llu ", entry.first, stats.count,
+            (unsigned long long)(stats.total_us / stats.count),
+            (unsigned long long)stats.max_us);
+    for (int i = 0; i < COMMAND_LATENCY_BUCKETS; i++)
+      dprintf(fd, " %u", stats.buckets[i]);
+    dprintf(fd, "\n");
+  }
+}
@@ -28,16 +28,13 @@
 #include "buffer_allocator.h"
 #include "device/include/controller.h"
 #include "hci_internals.h"
+#include "hci_packet_view.h"
 #include "osi/include/log.h"
 #include "osi/include/osi.h"
 
 #define APPLY_CONTINUATION_FLAG(handle) (((handle)&0xCFFF) | 0x1000)
 #define APPLY_START_FLAG(handle) (((handle)&0xCFFF) | 0x2000)
 #define SUB_EVENT(event) ((event)&MSG_SUB_EVT_MASK)
-#define GET_BOUNDARY_FLAG(handle) (((handle) >> 12) & 0x0003)
-#define GET_BROADCAST_FLAG(handle) (((handle) >> 14) & 0x0003)
-
-#define HANDLE_MASK 0x0FFF
 #define START_PACKET_BOUNDARY 2
 #define CONTINUATION_PACKET_BOUNDARY 1
 #define POINT_TO_POINT 0
@@ -62,8 +59,6 @@ static void fragment_and_dispatch(BT_HDR* packet) {
   CHECK(packet != NULL);
 
   uint16_t event = packet->event & MSG_EVT_MASK;
-  uint8_t* stream = packet->data + packet->offset;
-
   // We only fragment ACL packets
   if (event != MSG_STACK_TO_HC_HCI_ACL) {
     callbacks->fragmented(packet, true);
@@ -78,15 +73,12 @@ static void fragment_and_dispatch(BT_HDR* packet) {
   uint16_t max_packet_size = max_data_size + HCI_ACL_PREAMBLE_SIZE;
   uint16_t remaining_length = packet->len;
 
-  uint16_t continuation_handle;
-  STREAM_TO_UINT16(continuation_handle, stream);
-  continuation_handle = APPLY_CONTINUATION_FLAG(continuation_handle);
+  uint16_t continuation_handle = APPLY_CONTINUATION_FLAG(
+      HciAclHeader::HandleAndFlags::Get(packet->data + packet->offset));
 
   while (remaining_length > max_packet_size) {
     // Make sure we use the right ACL packet size
-    stream = packet->data + packet->offset;
-    STREAM_SKIP_UINT16(stream);
-    UINT16_TO_STREAM(stream, max_data_size);
+    HciAclHeader::Length::Set(packet->data + packet->offset, max_data_size);
 
     packet->len = max_packet_size;
     callbacks->fragmented(packet, false);
@@ -96,9 +88,8 @@ static void fragment_and_dispatch(BT_HDR* packet) {
     packet->len = remaining_length;
 
     // Write the ACL header for the next fragment
-    stream = packet->data + packet->offset;
-    UINT16_TO_STREAM(stream, continuation_handle);
-    UINT16_TO_STREAM(stream, remaining_length - HCI_ACL_PREAMBLE_SIZE);
+    HciAclHeader::Write(packet->data + packet->offset, continuation_handle,
+                        remaining_length - HCI_ACL_PREAMBLE_SIZE);
 
     // Apparently L2CAP can set layer_specific to a max number of segments to
     // transmit
@@ -122,18 +113,14 @@ static bool check_uint16_overflow(uint16_t a, uint16_t b) {
 
 static void reassemble_and_dispatch(UNUSED_ATTR BT_HDR* packet) {
   if ((packet->event & MSG_EVT_MASK) == MSG_HC_TO_STACK_HCI_ACL) {
-    uint8_t* stream = packet->data;
-    uint16_t handle;
-    uint16_t acl_length;
-
-    STREAM_TO_UINT16(handle, stream);
-    STREAM_TO_UINT16(acl_length, stream);
-
-    CHECK(acl_length == packet->len - HCI_ACL_PREAMBLE_SIZE);
+    HciAclView acl(HciPacketView(packet->data, packet->len));
+    CHECK(packet->len >= HCI_ACL_PREAMBLE_SIZE &&
+          acl.GetLength() == packet->len - HCI_ACL_PREAMBLE_SIZE);
 
-    uint8_t boundary_flag = GET_BOUNDARY_FLAG(handle);
-    uint8_t broadcast_flag = GET_BROADCAST_FLAG(handle);
-    handle = handle & HANDLE_MASK;
+    uint16_t acl_length = acl.GetLength();
+    uint8_t boundary_flag = acl.GetBoundaryFlag();
+    uint8_t broadcast_flag = acl.GetBroadcastFlag();
+    uint16_t handle = acl.GetHandle();
 
     if (broadcast_flag != POINT_TO_POINT) {
       LOG_WARN(LOG_TAG, "dropping broadcast packet");
@@ -162,6 +149,7 @@ static void reassemble_and_dispatch(UNUSED_ATTR BT_HDR* packet) {
         return;
       }
 
+      uint8_t* stream = packet->data + HCI_ACL_PREAMBLE_SIZE;
       uint16_t l2cap_length;
       STREAM_TO_UINT16(l2cap_length, stream);
 
@@ -198,9 +186,8 @@ static void reassemble_and_dispatch(UNUSED_ATTR BT_HDR* packet) {
       memcpy(partial_packet->data, packet->data, packet->len);
 
       // Update the ACL data size to indicate the full expected length
-      stream = partial_packet->data;
-      STREAM_SKIP_UINT16(stream);  // skip the handle
-      UINT16_TO_STREAM(stream, full_length - HCI_ACL_PREAMBLE_SIZE);
+      HciAclHeader::Length::Set(partial_packet->data,
+                                full_length - HCI_ACL_PREAMBLE_SIZE);
 
       partial_packets[handle] = partial_packet;
 
@@ -0,0 +1,167 @@
+/******************************************************************************
+ *
+ *  Copyright 2019 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <base/bind.h>
+
+#include <vector>
+
+#include "command_scheduler.h"
+#include "hcidefs.h"
+
+namespace {
+
+class CommandSchedulerTest : public ::testing::Test {
+ protected:
+  // Queues a command with |opcode|, tagged |tag|, and runs the commands which
+  // may be sent now.
+  void Enqueue(command_opcode_t opcode, int tag) {
+    std::vector<base::Closure> ready;
+    scheduler_.Enqueue(opcode,
+                       base::Bind(&CommandSchedulerTest::Sent,
+                                  base::Unretained(this), tag),
+                       waiting_, &ready);
+    Run(ready);
+  }
+
+  // The controller grants |credits|, with the sent commands awaiting their
+  // response.
+  void UpdateCredits(int credits) {
+    std::vector<base::Closure> ready;
+    scheduler_.UpdateCredits(credits, waiting_, &ready);
+    Run(ready);
+  }
+
+  // The controller answers |count| sent commands and grants |credits|.
+  void Answer(int count, int credits) {
+    waiting_ -= count;
+    UpdateCredits(credits);
+  }
+
+  void Run(const std::vector<base::Closure>& ready) {
+    for (const base::Closure& send : ready) send.Run();
+  }
+
+  void Sent(int tag) {
+    sent_.push_back(tag);
+    waiting_++;
+  }
+
+  CommandScheduler scheduler_;
+  std::vector<int> sent_;
+  int waiting_ = 0;
+};
+
+}  // namespace
+
+TEST_F(CommandSchedulerTest, cancels_and_encryption_are_not_prioritized) {
+  EXPECT_TRUE(CommandScheduler::IsHighPriority(HCI_DISCONNECT));
+  EXPECT_TRUE(CommandScheduler::IsHighPriority(HCI_BLE_LTK_REQ_REPLY));
+  EXPECT_FALSE(CommandScheduler::IsHighPriority(HCI_CREATE_CONNECTION_CANCEL));
+  EXPECT_FALSE(CommandScheduler::IsHighPriority(HCI_BLE_CREATE_CONN_CANCEL));
+  EXPECT_FALSE(CommandScheduler::IsHighPriority(HCI_SET_CONN_ENCRYPTION));
+  EXPECT_FALSE(CommandScheduler::IsHighPriority(HCI_CREATE_CONNECTION));
+}
+
+TEST_F(CommandSchedulerTest, first_command_uses_the_initial_credit) {
+  Enqueue(HCI_READ_BD_ADDR, 1);
+  EXPECT_EQ(std::vector<int>({1}), sent_);
+  EXPECT_EQ(0, scheduler_.credits());
+
+  // No credit left until the controller answers.
+  Enqueue(HCI_READ_LOCAL_NAME, 2);
+  EXPECT_EQ(std::vector<int>({1}), sent_);
+  EXPECT_EQ(1u, scheduler_.queued());
+
+  Answer(1, 1);
+  EXPECT_EQ(std::vector<int>({1, 2}), sent_);
+  EXPECT_EQ(0u, scheduler_.queued());
+}
+
+TEST_F(CommandSchedulerTest, high_priority_overtakes_queued_commands) {
+  Enqueue(HCI_READ_BD_ADDR, 1);
+  Enqueue(HCI_WRITE_SCAN_ENABLE, 2);
+  Enqueue(HCI_WRITE_PAGE_TOUT, 3);
+  Enqueue(HCI_DISCONNECT, 4);
+  EXPECT_EQ(std::vector<int>({1}), sent_);
+
+  Answer(1, 1);
+  EXPECT_EQ(std::vector<int>({1, 4}), sent_);
+
+  Answer(1, 1);
+  EXPECT_EQ(std::vector<int>({1, 4, 2}), sent_);
+}
+
+TEST_F(CommandSchedulerTest, cancel_stays_after_the_create_it_cancels) {
+  Enqueue(HCI_READ_BD_ADDR, 1);
+  Enqueue(HCI_CREATE_CONNECTION, 2);
+  Enqueue(HCI_CREATE_CONNECTION_CANCEL, 3);
+  Enqueue(HCI_BLE_CREATE_LL_CONN, 4);
+  Enqueue(HCI_BLE_CREATE_CONN_CANCEL, 5);
+
+  for (int i = 0; i < 4; i++) Answer(1, 1);
+  EXPECT_EQ(std::vector<int>({1, 2, 3, 4, 5}), sent_);
+}
+
+TEST_F(CommandSchedulerTest, last_credit_is_reserved_while_commands_fly) {
+  Enqueue(HCI_READ_BD_ADDR, 1);
+  Answer(1, 3);
+
+  // Two normal commands in flight use two of the three credits, the third
+  // is kept back for high priority commands.
+  Enqueue(HCI_WRITE_SCAN_ENABLE, 2);
+  Enqueue(HCI_WRITE_PAGE_TOUT, 3);
+  Enqueue(HCI_WRITE_CLASS_OF_DEVICE, 4);
+  EXPECT_EQ(std::vector<int>({1, 2, 3}), sent_);
+  EXPECT_EQ(1, scheduler_.credits());
+
+  Enqueue(HCI_DISCONNECT, 5);
+  EXPECT_EQ(std::vector<int>({1, 2, 3, 5}), sent_);
+  EXPECT_EQ(0, scheduler_.credits());
+
+  // Everything answered: with nothing in flight the last credit may go to a
+  // normal command.
+  Answer(3, 1);
+  EXPECT_EQ(std::vector<int>({1, 2, 3, 5, 4}), sent_);
+}
+
+TEST_F(CommandSchedulerTest, credits_count_commands_in_flight) {
+  Enqueue(HCI_READ_BD_ADDR, 1);
+  Answer(1, 2);
+  Enqueue(HCI_WRITE_SCAN_ENABLE, 2);
+  EXPECT_EQ(1, scheduler_.credits());
+
+  // An event for another command grants 2 credits while one is in flight.
+  UpdateCredits(2);
+  EXPECT_EQ(1, scheduler_.credits());
+}
+
+TEST_F(CommandSchedulerTest, reset_drops_queued_commands) {
+  Enqueue(HCI_READ_BD_ADDR, 1);
+  Enqueue(HCI_WRITE_SCAN_ENABLE, 2);
+  EXPECT_EQ(0, scheduler_.credits());
+
+  scheduler_.Reset();
+  waiting_ = 0;
+  EXPECT_EQ(1, scheduler_.credits());
+  EXPECT_EQ(0u, scheduler_.queued());
+
+  Enqueue(HCI_READ_LOCAL_NAME, 3);
+  EXPECT_EQ(std::vector<int>({1, 3}), sent_);
+}
@@ -374,9 +374,22 @@
 #define BTM_SCO_DATA_SIZE_MAX 240
 #endif
 
-/* The size in bytes of the BTM inquiry database. */
+/* Depth of the SCO over HCI voice jitter buffer, in 7.5 ms frames. The
+ * buffer targets the smallest depth that absorbs the measured arrival
+ * jitter; this bounds the added latency to 120 ms. */
+#ifndef BTM_SCO_VOICE_JB_MAX_FRAMES
+#define BTM_SCO_VOICE_JB_MAX_FRAMES 16
+#endif
+
+/* The default number of entries in the BTM inquiry database. It can be
+ * changed at runtime with persist.bluetooth.inq_db_size, up to
+ * BTM_INQ_DB_MAX_SIZE. */
 #ifndef BTM_INQ_DB_SIZE
-#define BTM_INQ_DB_SIZE 40
+#define BTM_INQ_DB_SIZE 128
+#endif
+
+#ifndef BTM_INQ_DB_MAX_SIZE
+#define BTM_INQ_DB_MAX_SIZE 1024
 #endif
 
 /* The default scan mode */
@@ -880,6 +893,12 @@
 #define SDP_MAX_REC_ATTR 25
 #endif
 
+/* The maximum number of distinct UUIDs indexed per record for service
+ * searches. Records with more UUIDs are searched attribute by attribute. */
+#ifndef SDP_MAX_REC_UUIDS
+#define SDP_MAX_REC_UUIDS 16
+#endif
+
 #ifndef SDP_MAX_PAD_LEN
 #define SDP_MAX_PAD_LEN 600
 #endif
@@ -910,6 +929,21 @@
 #define SDP_MAX_LIST_BYTE_COUNT 4096
 #endif
 
+/* The number of devices whose ServiceSearchAttribute results are kept in the
+ * discovery cache, the number of results kept per device, and how long they
+ * are used before the remote device is queried again. */
+#ifndef SDP_DISC_CACHE_MAX_DEVICES
+#define SDP_DISC_CACHE_MAX_DEVICES 16
+#endif
+
+#ifndef SDP_DISC_CACHE_MAX_RESULTS
+#define SDP_DISC_CACHE_MAX_RESULTS 16
+#endif
+
+#ifndef SDP_DISC_CACHE_TTL_MS
+#define SDP_DISC_CACHE_TTL_MS (30 * 60 * 1000)
+#endif
+
 /* The maximum number of parameters in an SDP protocol element. */
 #ifndef SDP_MAX_PROTOCOL_PARAMS
 #define SDP_MAX_PROTOCOL_PARAMS 2
@@ -1496,6 +1530,12 @@ incoming connection
 #define BTSNOOP_MEM TRUE
 #endif
 
+/* Enable/disable per-layer ACL packet path tracing. When compiled in it is
+ * still off until persist.bluetooth.packet_trace is set. */
+#ifndef BT_PACKET_TRACE_INCLUDED
+#define BT_PACKET_TRACE_INCLUDED TRUE
+#endif
+
 /* Enable iot info logging */
 #ifndef BT_IOT_LOGGING_ENABLED
 #define BT_IOT_LOGGING_ENABLED TRUE
@@ -0,0 +1,742 @@
+/*
+ * Copyright 2019 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// End to end benchmarks of the stack, from the HAL interface down to the HCI
+// transport, against the emulated controller of vendor_libs/test_vendor_lib.
+// The device has to run the simulated HCI HAL of test/rootcanal, whose test
+// channel the benchmarks use to populate the environment of the controller.
+// Benchmarks are skipped when the test channel can't be reached.
+
+#include <arpa/inet.h>
+#include <benchmark/benchmark.h>
+#include <netinet/in.h>
+#include <stdio.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <hardware/bluetooth.h>
+#include <hardware/bt_gatt.h>
+
+#include "osi/include/osi.h"
+#include "stack/include/bt_types.h"
+#include "stack/include/gatt_api.h"
+
+using ::benchmark::State;
+using bluetooth::Uuid;
+
+// Port of the test channel of the simulated HAL
+#define TEST_CHANNEL_PORT 6111
+
+// Period of the timer driving the emulated devices
+#define CONTROLLER_TICK_MS "10"
+
+// Longest wait for an event of the stack before a benchmark gives up
+#define EVENT_TIMEOUT_MS 10000
+
+// Time given to the controller to apply the test channel commands
+#define SETTLE_MS 200
+
+// Window over which the rate benchmarks count
+#define RATE_WINDOW_MS 1000
+
+// Writes without response queued per iteration of the write benchmark
+#define WRITES_PER_ITERATION 64
+
+// The peer generating the load, and the attributes of its server as
+// documented in vendor_libs/test_vendor_lib/include/load_peer.h
+#define LOAD_PEER_ADDRESS "10:00:00:00:00:01"
+#define LOAD_VALUE_HANDLE 0x002a
+#define LOAD_CCCD_HANDLE 0x002b
+
+#define LOAD_MTU 247
+
+// The HAL interface of libbluetooth
+extern bt_interface_t bluetoothInterface;
+
+namespace {
+
+struct {
+  std::mutex mutex;
+  std::condition_variable changed;
+
+  bt_state_t state = BT_STATE_OFF;
+  int client_if = 0;
+  int conn_id = 0;
+  bool connected = false;
+  size_t searches = 0;
+  size_t registrations = 0;
+  size_t mtu_changes = 0;
+  size_t descriptor_writes = 0;
+  size_t writes = 0;
+  size_t scan_results = 0;
+
+  // Notifications, and the spread of their inter-arrival times.
+  size_t notified_bytes = 0;
+  size_t notifications = 0;
+  std::chrono::steady_clock::time_point last_notification;
+  double interval_sum_us = 0;
+  double interval_square_sum_us = 0;
+} events;
+
+const bt_interface_t* bt_interface = nullptr;
+const btgatt_interface_t* gatt_interface = nullptr;
+int test_channel_fd = -1;
+
+// Runs |update| on the events with the lock held, and wakes up the waiter.
+template <typename Update>
+void update_events(Update update) {
+  {
+    std::lock_guard<std::mutex> lock(events.mutex);
+    update();
+  }
+  events.changed.notify_all();
+}
+
+// Counters the stack keeps updating have to be read with the lock held.
+size_t read_events(const size_t& counter) {
+  std::lock_guard<std::mutex> lock(events.mutex);
+  return counter;
+}
+
+template <typename Predicate>
+bool wait_events(Predicate done) {
+  std::unique_lock<std::mutex> lock(events.mutex);
+  return events.changed.wait_for(
+      lock, std::chrono::milliseconds(EVENT_TIMEOUT_MS), done);
+}
+
+double elapsed_seconds(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                       start)
+      .count();
+}
+
+// CPU time used by all the threads of the process, the stack's included.
+double process_cpu_seconds() {
+  struct timespec ts;
+  clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/*******************************************************************************
+ * HAL callbacks
+ ******************************************************************************/
+
+void adapter_state_changed(bt_state_t state) {
+  update_events([state] { events.state = state; });
+}
+
+void adapter_properties(UNUSED_ATTR bt_status_t status,
+                        UNUSED_ATTR int num_properties,
+                        UNUSED_ATTR bt_property_t* properties) {}
+
+void remote_device_properties(UNUSED_ATTR bt_status_t status,
+                              UNUSED_ATTR RawAddress* bd_addr,
+                              UNUSED_ATTR int num_properties,
+                              UNUSED_ATTR bt_property_t* properties) {}
+
+void device_found(UNUSED_ATTR int num_properties,
+                  UNUSED_ATTR bt_property_t* properties) {}
+
+void discovery_state_changed(UNUSED_ATTR bt_discovery_state_t state) {}
+
+void pin_request(UNUSED_ATTR RawAddress* remote_bd_addr,
+                 UNUSED_ATTR bt_bdname_t* bd_name, UNUSED_ATTR uint32_t cod,
+                 UNUSED_ATTR bool min_16_digit) {}
+
+void ssp_request(UNUSED_ATTR RawAddress* remote_bd_addr,
+                 UNUSED_ATTR bt_bdname_t* bd_name, UNUSED_ATTR uint32_t cod,
+                 UNUSED_ATTR bt_ssp_variant_t pairing_variant,
+                 UNUSED_ATTR uint32_t pass_key) {}
+
+void bond_state_changed(UNUSED_ATTR bt_status_t status,
+                        UNUSED_ATTR RawAddress* remote_bd_addr,
+                        UNUSED_ATTR bt_bond_state_t state) {}
+
+void acl_state_changed(UNUSED_ATTR bt_status_t status,
+                       UNUSED_ATTR RawAddress* remote_bd_addr,
+                       UNUSED_ATTR bt_acl_state_t state) {}
+
+void thread_event(UNUSED_ATTR bt_cb_thread_evt evt) {}
+
+bt_callbacks_t bt_callbacks = {
+    sizeof(bt_callbacks_t),
+    adapter_state_changed,
+    adapter_properties,
+    remote_device_properties,
+    device_found,
+    discovery_state_changed,
+    pin_request,
+    ssp_request,
+    bond_state_changed,
+    acl_state_changed,
+    thread_event,
+    nullptr, /* dut_mode_recv_cb */
+    nullptr, /* le_test_mode_cb */
+    nullptr, /* energy_info_cb */
+    nullptr  /* generate_local_oob_data_cb */
+};
+
+bool set_wake_alarm(UNUSED_ATTR uint64_t delay_millis,
+                    UNUSED_ATTR bool should_wake, UNUSED_ATTR alarm_cb cb,
+                    UNUSED_ATTR void* data) {
+  return false;
+}
+
+int acquire_wake_lock(UNUSED_ATTR const char* lock_name) {
+  return BT_STATUS_SUCCESS;
+}
+
+int release_wake_lock(UNUSED_ATTR const char* lock_name) {
+  return BT_STATUS_SUCCESS;
+}
+
+bt_os_callouts_t bt_os_callouts = {sizeof(bt_os_callouts_t), set_wake_alarm,
+                                   acquire_wake_lock, release_wake_lock};
+
+void register_client(UNUSED_ATTR int status, int client_if,
+                     UNUSED_ATTR const Uuid& app_uuid) {
+  update_events([client_if] { events.client_if = client_if; });
+}
+
+void client_open(int conn_id, int status, UNUSED_ATTR int client_if,
+                 UNUSED_ATTR const RawAddress& bda) {
+  update_events([conn_id, status] {
+    events.conn_id = conn_id;
+    events.connected = status == GATT_SUCCESS;
+  });
+}
+
+void client_close(UNUSED_ATTR int conn_id, UNUSED_ATTR int status,
+                  UNUSED_ATTR int client_if,
+                  UNUSED_ATTR const RawAddress& bda) {
+  update_events([] { events.connected = false; });
+}
+
+void search_complete(UNUSED_ATTR int conn_id, UNUSED_ATTR int status) {
+  update_events([] { events.searches++; });
+}
+
+void register_for_notification(UNUSED_ATTR int conn_id,
+                               UNUSED_ATTR int registered,
+                               UNUSED_ATTR int status,
+                               UNUSED_ATTR uint16_t handle) {
+  update_events([] { events.registrations++; });
+}
+
+void notify(UNUSED_ATTR int conn_id, const btgatt_notify_params_t& p_data) {
+  auto now = std::chrono::steady_clock::now();
+  update_events([&p_data, now] {
+    if (events.notifications != 0) {
+      double interval_us = std::chrono::duration<double, std::micro>(
+                               now - events.last_notification)
+                               .count();
+      events.interval_sum_us += interval_us;
+      events.interval_square_sum_us += interval_us * interval_us;
+    }
+    events.last_notification = now;
+    events.notifications++;
+    events.notified_bytes += p_data.len;
+  });
+}
+
+void read_characteristic(UNUSED_ATTR int conn_id, UNUSED_ATTR int status,
+                         UNUSED_ATTR btgatt_read_params_t* p_data) {}
+
+void write_characteristic(UNUSED_ATTR int conn_id, UNUSED_ATTR int status,
+                          UNUSED_ATTR uint16_t handle) {
+  update_events([] { events.writes++; });
+}
+
+void read_descriptor(UNUSED_ATTR int conn_id, UNUSED_ATTR int status,
+                     UNUSED_ATTR const btgatt_read_params_t& p_data) {}
+
+void write_descriptor(UNUSED_ATTR int conn_id, UNUSED_ATTR int status,
+                      UNUSED_ATTR uint16_t handle) {
+  update_events([] { events.descriptor_writes++; });
+}
+
+void execute_write(UNUSED_ATTR int conn_id, UNUSED_ATTR int status) {}
+
+void read_remote_rssi(UNUSED_ATTR int client_if,
+                      UNUSED_ATTR const RawAddress& bda, UNUSED_ATTR int rssi,
+                      UNUSED_ATTR int status) {}
+
+void configure_mtu(UNUSED_ATTR int conn_id, UNUSED_ATTR int status,
+                   UNUSED_ATTR int mtu) {
+  update_events([] { events.mtu_changes++; });
+}
+
+void congestion(UNUSED_ATTR int conn_id, UNUSED_ATTR bool congested) {}
+
+void get_gatt_db(UNUSED_ATTR int conn_id,
+                 UNUSED_ATTR const btgatt_db_element_t* db,
+                 UNUSED_ATTR int count) {}
+
+void services_removed(UNUSED_ATTR int conn_id,
+                      UNUSED_ATTR uint16_t start_handle,
+                      UNUSED_ATTR uint16_t end_handle) {}
+
+void services_added(UNUSED_ATTR int conn_id,
+                    UNUSED_ATTR const btgatt_db_element_t& added,
+                    UNUSED_ATTR int added_count) {}
+
+void phy_updated(UNUSED_ATTR int conn_id, UNUSED_ATTR uint8_t tx_phy,
+                 UNUSED_ATTR uint8_t rx_phy, UNUSED_ATTR uint8_t status) {}
+
+void conn_updated(UNUSED_ATTR int conn_id, UNUSED_ATTR uint16_t interval,
+                  UNUSED_ATTR uint16_t latency, UNUSED_ATTR uint16_t timeout,
+                  UNUSED_ATTR uint8_t status) {}
+
+void service_changed(UNUSED_ATTR int conn_id) {}
+
+const btgatt_client_callbacks_t client_callbacks = {
+    register_client,
+    client_open,
+    client_close,
+    search_complete,
+    register_for_notification,
+    notify,
+    read_characteristic,
+    write_characteristic,
+    read_descriptor,
+    write_descriptor,
+    execute_write,
+    read_remote_rssi,
+    configure_mtu,
+    congestion,
+    get_gatt_db,
+    services_removed,
+    services_added,
+    phy_updated,
+    conn_updated,
+    service_changed,
+};
+
+void scan_result(UNUSED_ATTR uint16_t event_type, UNUSED_ATTR uint8_t addr_type,
+                 UNUSED_ATTR RawAddress* bda, UNUSED_ATTR uint8_t primary_phy,
+                 UNUSED_ATTR uint8_t secondary_phy,
+                 UNUSED_ATTR uint8_t advertising_sid,
+                 UNUSED_ATTR int8_t tx_power, UNUSED_ATTR int8_t rssi,
+                 UNUSED_ATTR uint16_t periodic_adv_int,
+                 UNUSED_ATTR std::vector<uint8_t> adv_data,
+                 UNUSED_ATTR RawAddress* original_bda) {
+  update_events([] { events.scan_results++; });
+}
+
+const btgatt_server_callbacks_t server_callbacks = {};
+
+const btgatt_scanner_callbacks_t scanner_callbacks = {
+    scan_result, nullptr, nullptr, nullptr,
+};
+
+const btgatt_callbacks_t gatt_callbacks = {
+    sizeof(btgatt_callbacks_t), &client_callbacks, &server_callbacks,
+    &scanner_callbacks,
+};
+
+/*******************************************************************************
+ * Test channel of the emulated controller
+ ******************************************************************************/
+
+bool test_channel_open() {
+  if (test_channel_fd != -1) return true;
+
+  int fd = socket(AF_INET, SOCK_STREAM, 0);
+  if (fd < 0) return false;
+
+  struct sockaddr_in addr = {};
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(TEST_CHANNEL_PORT);
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  if (connect(fd, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
+    close(fd);
+    return false;
+  }
+
+  test_channel_fd = fd;
+  return true;
+}
+
+// Sends a command encoded as scripts/test_channel.py does: the length and
+// characters of the name, the number of arguments, then the length and
+// characters of each argument.
+bool test_channel_send(const std::string& name,
+                       const std::vector<std::string>& args) {
+  std::string command(1, (char)name.size());
+  command += name;
+  command += (char)args.size();
+  for (const std::string& arg : args) {
+    command += (char)arg.size();
+    command += arg;
+  }
+  return send(test_channel_fd, command.data(), command.size(), 0) ==
+         (ssize_t)command.size();
+}
+
+// Starts from an empty environment, with |devices| added.
+bool test_channel_populate(
+    const std::vector<std::vector<std::string>>& devices) {
+  if (!test_channel_send("clear", {})) return false;
+  if (!test_channel_send("timer", {CONTROLLER_TICK_MS})) return false;
+  if (!test_channel_send("credits", {"0"})) return false;
+  for (const std::vector<std::string>& device : devices)
+    if (!test_channel_send("add", device)) return false;
+  std::this_thread::sleep_for(std::chrono::milliseconds(SETTLE_MS));
+  return true;
+}
+
+/*******************************************************************************
+ * Stack
+ ******************************************************************************/
+
+bool stack_enable() {
+  if (bt_interface->enable() != BT_STATUS_SUCCESS) return false;
+  return wait_events([] { return events.state == BT_STATE_ON; });
+}
+
+bool stack_disable() {
+  if (bt_interface->disable() != BT_STATUS_SUCCESS) return false;
+  return wait_events([] { return events.state == BT_STATE_OFF; });
+}
+
+// Loads and enables the stack, once for all the benchmarks.
+bool stack_start() {
+  if (gatt_interface != nullptr) return true;
+
+  bt_interface = &bluetoothInterface;
+  if (bt_interface->init(&bt_callbacks, false, false, 0, false) !=
+      BT_STATUS_SUCCESS)
+    return false;
+  bt_interface->set_os_callouts(&bt_os_callouts);
+
+  const btgatt_interface_t* gatt =
+      (const btgatt_interface_t*)bt_interface->get_profile_interface(
+          BT_PROFILE_GATT_ID);
+  if (gatt == nullptr || gatt->init(&gatt_callbacks) != BT_STATUS_SUCCESS)
+    return false;
+
+  if (!stack_enable()) return false;
+
+  gatt->client->register_client(
+      Uuid::FromString("0000beef-0000-1000-8000-00805f9b34fb"), false);
+  if (!wait_events([] { return events.client_if != 0; })) return false;
+
+  gatt_interface = gatt;
+  return true;
+}
+
+RawAddress load_peer_address() {
+  RawAddress addr;
+  RawAddress::FromString(LOAD_PEER_ADDRESS, addr);
+  return addr;
+}
+
+bool load_peer_connect() {
+  gatt_interface->client->connect(events.client_if, load_peer_address(), true,
+                                  BT_TRANSPORT_LE, false, 1 /* LE 1M */);
+  return wait_events([] { return events.connected; });
+}
+
+bool load_peer_disconnect() {
+  gatt_interface->client->disconnect(events.client_if, load_peer_address(),
+                                     events.conn_id);
+  return wait_events([] { return !events.connected; });
+}
+
+// Connects to the peer, discovers its server and raises the MTU so that
+// values of up to LOAD_MTU - 3 bytes fit in a PDU.
+bool load_peer_setup() {
+  if (!load_peer_connect()) return false;
+
+  size_t searches = events.searches;
+  gatt_interface->client->search_service(events.conn_id, nullptr);
+  if (!wait_events([searches] { return events.searches > searches; }))
+    return false;
+
+  size_t mtu_changes = events.mtu_changes;
+  gatt_interface->client->configure_mtu(events.conn_id, LOAD_MTU);
+  return wait_events(
+      [mtu_changes] { return events.mtu_changes > mtu_changes; });
+}
+
+}  // namespace
+
+class BM_Stack : public ::benchmark::Fixture {
+ protected:
+  void SetUp(State& st) override {
+    ::benchmark::Fixture::SetUp(st);
+    if (!test_channel_open()) {
+      st.SkipWithError("test channel of the emulated controller unreachable");
+      return;
+    }
+    if (!stack_start()) st.SkipWithError("failed to enable the stack");
+  }
+};
+
+BENCHMARK_DEFINE_F(BM_Stack, enable)(State& state) {
+  if (!test_channel_populate({})) {
+    state.SkipWithError("test channel failure");
+    return;
+  }
+  for (auto _ : state) {
+    if (!stack_disable()) {
+      state.SkipWithError("failed to disable the stack");
+      break;
+    }
+    auto start = std::chrono::steady_clock::now();
+    if (!stack_enable()) {
+      state.SkipWithError("failed to enable the stack");
+      break;
+    }
+    state.SetIterationTime(elapsed_seconds(start));
+  }
+}
+
+// Reports of |state.range(0)| advertisers rotating their resolvable private
+// addresses, as ingested by the scanner.
+BENCHMARK_DEFINE_F(BM_Stack, scan_ingestion)(State& state) {
+  std::vector<std::vector<std::string>> advertisers;
+  for (int i = 0; i < state.range(0); i++)
+    advertisers.push_back(
+        {"rpa_advertiser", std::to_string(i + 1), "20", "1000"});
+  if (!test_channel_populate(advertisers)) {
+    state.SkipWithError("test channel failure");
+    return;
+  }
+
+  gatt_interface->scanner->Scan(true);
+  size_t results = 0;
+  for (auto _ : state) {
+    size_t first = read_events(events.scan_results);
+    std::this_thread::sleep_for(std::chrono::milliseconds(RATE_WINDOW_MS));
+    results += read_events(events.scan_results) - first;
+  }
+  gatt_interface->scanner->Scan(false);
+
+  state.SetItemsProcessed(results);
+}
+
+// Reports of |state.range(0)| beacon swarms, each advertising from a new
+// address at every tick, as ingested by the scanner. The emulated controller
+// packs the reports of a scan in as few events as fit, so this measures the
+// cost per report of the batches, in CPU time of the stack process.
+BENCHMARK_DEFINE_F(BM_Stack, beacon_swarm_ingestion)(State& state) {
+  std::vector<std::vector<std::string>> swarms;
+  for (int i = 0; i < state.range(0); i++) {
+    char address[18];
+    snprintf(address, sizeof(address), "c0:00:00:00:%02x:00", i + 1);
+    swarms.push_back({"beacon_swarm", address, "20"});
+  }
+  if (!test_channel_populate(swarms)) {
+    state.SkipWithError("test channel failure");
+    return;
+  }
+
+  gatt_interface->scanner->Scan(true);
+  size_t results = 0;
+  double cpu_seconds = 0;
+  for (auto _ : state) {
+    size_t first = read_events(events.scan_results);
+    double cpu_start = process_cpu_seconds();
+    std::this_thread::sleep_for(std::chrono::milliseconds(RATE_WINDOW_MS));
+    cpu_seconds += process_cpu_seconds() - cpu_start;
+    results += read_events(events.scan_results) - first;
+  }
+  gatt_interface->scanner->Scan(false);
+
+  state.SetItemsProcessed(results);
+  if (results != 0)
+    state.counters["cpu_us_per_report"] = cpu_seconds * 1e6 / results;
+}
+
+// From the connect request of the client to the open callback.
+BENCHMARK_DEFINE_F(BM_Stack, le_connect)(State& state) {
+  if (!test_channel_populate(
+          {{"load_peer", LOAD_PEER_ADDRESS, "le", "gatt", "20", "0"}})) {
+    state.SkipWithError("test channel failure");
+    return;
+  }
+
+  for (auto _ : state) {
+    auto start = std::chrono::steady_clock::now();
+    if (!load_peer_connect()) {
+      state.SkipWithError("connection timed out");
+      break;
+    }
+    state.SetIterationTime(elapsed_seconds(start));
+
+    if (!load_peer_disconnect()) {
+      state.SkipWithError("disconnection timed out");
+      break;
+    }
+  }
+}
+
+// Discovery of the database of the peer, with the cache cleared first.
+BENCHMARK_DEFINE_F(BM_Stack, gatt_discovery)(State& state) {
+  if (!test_channel_populate(
+          {{"load_peer", LOAD_PEER_ADDRESS, "le", "gatt", "20", "0"}}) ||
+      !load_peer_connect()) {
+    state.SkipWithError("failed to connect to the peer");
+    return;
+  }
+
+  RawAddress peer = load_peer_address();
+  for (auto _ : state) {
+    gatt_interface->client->refresh(events.client_if, peer);
+    size_t searches = events.searches;
+    auto start = std::chrono::steady_clock::now();
+    gatt_interface->client->search_service(events.conn_id, nullptr);
+    if (!wait_events([searches] { return events.searches > searches; })) {
+      state.SkipWithError("discovery timed out");
+      break;
+    }
+    state.SetIterationTime(elapsed_seconds(start));
+  }
+
+  load_peer_disconnect();
+}
+
+// Notifications of |state.range(0)| bytes the peer sends in bursts of
+// |state.range(1)| every tick of the controller, as delivered to the client.
+// The spread of their inter-arrival times is reported as the jitter.
+BENCHMARK_DEFINE_F(BM_Stack, gatt_notify)(State& state) {
+  if (!test_channel_populate({{"load_peer", LOAD_PEER_ADDRESS, "le", "gatt",
+                               std::to_string(state.range(0)),
+                               std::to_string(state.range(1))}}) ||
+      !load_peer_setup()) {
+    state.SkipWithError("failed to set up the peer");
+    return;
+  }
+
+  RawAddress peer = load_peer_address();
+  size_t registrations = events.registrations;
+  size_t descriptor_writes = events.descriptor_writes;
+  gatt_interface->client->register_for_notification(events.client_if, peer,
+                                                    LOAD_VALUE_HANDLE);
+  gatt_interface->client->write_descriptor(events.conn_id, LOAD_CCCD_HANDLE,
+                                           GATT_AUTH_REQ_NONE, {0x01, 0x00});
+  if (!wait_events([registrations, descriptor_writes] {
+        return events.registrations > registrations &&
+               events.descriptor_writes > descriptor_writes;
+      })) {
+    state.SkipWithError("failed to enable the notifications");
+    load_peer_disconnect();
+    return;
+  }
+
+  update_events([] {
+    events.notifications = 0;
+    events.interval_sum_us = 0;
+    events.interval_square_sum_us = 0;
+  });
+  size_t bytes = 0;
+  for (auto _ : state) {
+    size_t first = read_events(events.notified_bytes);
+    std::this_thread::sleep_for(std::chrono::milliseconds(RATE_WINDOW_MS));
+    bytes += read_events(events.notified_bytes) - first;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(events.mutex);
+    if (events.notifications > 1) {
+      double n = events.notifications - 1;
+      double mean = events.interval_sum_us / n;
+      state.counters["interval_us"] = mean;
+      state.counters["jitter_us"] = std::sqrt(
+          std::max(0.0, events.interval_square_sum_us / n - mean * mean));
+    }
+  }
+  state.SetBytesProcessed(bytes);
+
+  gatt_interface->client->deregister_for_notification(events.client_if, peer,
+                                                      LOAD_VALUE_HANDLE);
+  load_peer_disconnect();
+}
+
+// Writes without response of |state.range(0)| bytes, with the controller
+// completing |state.range(1)| ACL packets per tick, 0 for as fast as they
+// come, so that the flow control of the host is part of the measure.
+BENCHMARK_DEFINE_F(BM_Stack, gatt_write)(State& state) {
+  if (!test_channel_populate(
+          {{"load_peer", LOAD_PEER_ADDRESS, "le", "gatt", "20", "0"}}) ||
+      !load_peer_setup() ||
+      !test_channel_send("credits", {std::to_string(state.range(1))})) {
+    state.SkipWithError("failed to set up the peer");
+    return;
+  }
+
+  std::vector<uint8_t> value(state.range(0), 0x55);
+  for (auto _ : state) {
+    size_t writes = read_events(events.writes);
+    for (size_t i = 0; i < WRITES_PER_ITERATION; i++)
+      gatt_interface->client->write_characteristic(
+          events.conn_id, LOAD_VALUE_HANDLE, GATT_WRITE_NO_RSP,
+          GATT_AUTH_REQ_NONE, value);
+    if (!wait_events([writes] {
+          return events.writes >= writes + WRITES_PER_ITERATION;
+        })) {
+      state.SkipWithError("writes timed out");
+      break;
+    }
+  }
+  state.SetBytesProcessed(state.iterations() * WRITES_PER_ITERATION *
+                          value.size());
+
+  test_channel_send("credits", {"0"});
+  load_peer_disconnect();
+}
+
+BENCHMARK_REGISTER_F(BM_Stack, enable)->UseManualTime()->Iterations(10);
+BENCHMARK_REGISTER_F(BM_Stack, scan_ingestion)
+    ->Arg(8)
+    ->Arg(64)
+    ->Arg(256)
+    ->UseRealTime()
+    ->Iterations(5);
+BENCHMARK_REGISTER_F(BM_Stack, beacon_swarm_ingestion)
+    ->Arg(4)
+    ->Arg(16)
+    ->Arg(64)
+    ->UseRealTime()
+    ->Iterations(5);
+BENCHMARK_REGISTER_F(BM_Stack, le_connect)->UseManualTime()->Iterations(20);
+BENCHMARK_REGISTER_F(BM_Stack, gatt_discovery)
+    ->UseManualTime()
+    ->Iterations(20);
+BENCHMARK_REGISTER_F(BM_Stack, gatt_notify)
+    ->Args({20, 4})
+    ->Args({244, 4})
+    ->Args({244, 16})
+    ->UseRealTime()
+    ->Iterations(5);
+BENCHMARK_REGISTER_F(BM_Stack, gatt_write)
+    ->Args({20, 0})
+    ->Args({244, 0})
+    ->Args({244, 4})
+    ->UseRealTime();
+
+BENCHMARK_MAIN();
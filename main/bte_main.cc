@@ -109,7 +109,8 @@ void post_to_hci_message_loop(const base::Location& from_here,
   }
 
   hci_message_loop->task_runner()->PostTask(
-      from_here, base::Bind(&btu_hci_msg_process, p_msg));
+      from_here, task_stats_wrap(get_message_loop_task_stats(), from_here,
+                                 base::Bind(&btu_hci_msg_process, p_msg)));
 }
 
 /******************************************************************************
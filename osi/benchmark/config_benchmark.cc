@@ -0,0 +1,69 @@
+/*
+ * Copyright 2019 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+#include <stdio.h>
+
+#include "osi/include/config.h"
+
+using ::benchmark::State;
+
+// Keys btif_storage reads for every bonded device while loading bonds at
+// enable, across its bonded device, HID and hearing aid passes
+static const char* kBondKeys[] = {
+    "LinkKey",     "LinkKeyType", "PinLength",   "DevClass",   "DevType",
+    "AddrType",    "Name",        "Aliasname",   "Service",    "LE_KEY_PENC",
+    "LE_KEY_PID",  "LE_KEY_PCSRK", "LE_KEY_LENC", "LE_KEY_LCSRK", "HidAttrMask",
+    "HidSubClass", "HidAppId",    "HidVendorId", "HidProductId",
+};
+
+static void bond_section_name(int i, char* name, size_t size) {
+  snprintf(name, size, "00:11:22:33:%02x:%02x", (i >> 8) & 0xff, i & 0xff);
+}
+
+static config_t* make_bond_config(int bonds) {
+  config_t* config = config_new_empty();
+  config_set_string(config, "Adapter", "Address", "00:11:22:33:44:55");
+  for (int i = 0; i < bonds; i++) {
+    char section[32];
+    bond_section_name(i, section, sizeof(section));
+    for (const char* key : kBondKeys) {
+      config_set_string(config, section, key, "0123456789abcdef");
+    }
+  }
+  return config;
+}
+
+// Mirrors btif_storage_load_bonded_devices(): one pass over all sections,
+// reading every key of every bonded device section
+static void BM_LoadBondedDevices(State& state) {
+  config_t* config = make_bond_config(state.range(0));
+  for (auto _ : state) {
+    int found = 0;
+    for (const config_section_node_t* node = config_section_begin(config);
+         node != config_section_end(config); node = config_section_next(node)) {
+      const char* section = config_section_name(node);
+      for (const char* key : kBondKeys) {
+        if (config_get_string(config, section, key, NULL) != NULL) found++;
+      }
+    }
+    benchmark::DoNotOptimize(found);
+  }
+  config_free(config);
+}
+BENCHMARK(BM_LoadBondedDevices)->Arg(10)->Arg(100)->Arg(1000);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,106 @@
+/*
+ * Copyright 2019 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <atomic>
+
+#include "bt_target.h"
+
+// Boundaries an ACL packet crosses on its way through the stack. Points are
+// ordered by direction so that a span is always from a lower to a higher
+// point of the same direction.
+typedef enum {
+  // Receive path.
+  PACKET_TRACE_HCI_RX = 0,     // ACL fragment handed up by the HAL
+  PACKET_TRACE_REASSEMBLED,    // packet_fragmenter finished reassembly
+  PACKET_TRACE_BTU_RX,         // btu_hci_msg_process on the main thread
+  PACKET_TRACE_L2CAP_RX,       // l2c_rcv_acl_data
+  PACKET_TRACE_PROFILE_RX,     // L2CAP handed the SDU to a profile
+  PACKET_TRACE_UHID_WRITE,     // HID input report written to uhid
+  // Transmit path.
+  PACKET_TRACE_PROFILE_TX,     // profile handed an SDU to L2CAP
+  PACKET_TRACE_L2CAP_TX,       // L2CAP queued the PDU for HCI
+  PACKET_TRACE_HCI_TX,         // fragment handed down to the HAL
+  PACKET_TRACE_POINT_COUNT,
+} packet_trace_point_t;
+
+// Enables or disables recording at runtime. Recording is off by default and
+// is turned on by the hci layer when persist.bluetooth.packet_trace is set.
+void packet_trace_set_enabled(bool enabled);
+
+// Records that |packet| crossed |point|. |id| is the connection handle or
+// channel id known at that boundary (0 if none) and |len| the payload length.
+// Entries go into a ring owned by the calling thread, so this never blocks.
+// Packets are correlated by buffer address; a layer that copies or segments
+// the data starts a new chain.
+void packet_trace_record(packet_trace_point_t point, const void* packet,
+                         uint16_t id, uint16_t len);
+
+// Records that the packet L2CAP last handed to a profile on the calling thread
+// crossed |point|. This is for layers that only see a copy or a part of the
+// payload, and is only meaningful when they run synchronously from the L2CAP
+// data callback.
+void packet_trace_record_last_rx(packet_trace_point_t point, uint16_t id,
+                                 uint16_t len);
+
+// Forgets the packet L2CAP last handed to a profile on the calling thread.
+// L2CAP calls this when the profile's data callback returns, as the profile
+// may have freed or queued the packet by then.
+void packet_trace_clear_last_rx(void);
+
+// Writes the recorded spans to |fd| in the Chrome trace event JSON format,
+// which can be loaded into chrome://tracing or ui.perfetto.dev.
+void packet_trace_dump_json(int fd);
+
+// Dump per-layer latency statistics to the |fd| file descriptor.
+// The caller is responsible for closing the |fd|.
+void packet_trace_debug_dump(int fd);
+
+#if (BT_PACKET_TRACE_INCLUDED == TRUE)
+extern std::atomic<bool> packet_trace_enabled;
+
+#define PACKET_TRACE(point, packet, id, len)                          \
+  do {                                                                \
+    if (packet_trace_enabled.load(std::memory_order_relaxed))         \
+      packet_trace_record((point), (packet), (id), (len));            \
+  } while (0)
+
+#define PACKET_TRACE_LAST_RX(point, id, len)                          \
+  do {                                                                \
+    if (packet_trace_enabled.load(std::memory_order_relaxed))         \
+      packet_trace_record_last_rx((point), (id), (len));              \
+  } while (0)
+
+// Called whether tracing is enabled or not, so that disabling tracing while
+// a profile handles a packet never leaves a stale packet behind.
+#define PACKET_TRACE_CLEAR_LAST_RX() packet_trace_clear_last_rx()
+#else
+#define PACKET_TRACE(point, packet, id, len) \
+  do {                                       \
+  } while (0)
+
+#define PACKET_TRACE_LAST_RX(point, id, len) \
+  do {                                       \
+  } while (0)
+
+#define PACKET_TRACE_CLEAR_LAST_RX() \
+  do {                               \
+  } while (0)
+#endif
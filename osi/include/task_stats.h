@@ -0,0 +1,67 @@
+/*
+ * Copyright 2019 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <base/callback.h>
+#include <base/location.h>
+
+// Per-thread task timing: how long posted tasks wait before they start and
+// how long they then hold the thread. Shared by osi |thread_t|, the message
+// loops run on a |thread_t| and |bluetooth::common::MessageLoopThread|.
+
+typedef struct task_stats_t task_stats_t;
+
+// Creates a stats object for the thread called |name| and registers it for
+// |task_stats_debug_dump|. Must be freed with |task_stats_free|.
+task_stats_t* task_stats_new(const char* name);
+
+// Unregisters and frees |stats|. |stats| may be NULL.
+void task_stats_free(task_stats_t* stats);
+
+// Enables or disables collection for all threads. Collection is off by
+// default and is turned on when persist.bluetooth.task_stats is set.
+void task_stats_set_enabled(bool enabled);
+
+// Returns true if task timing should be collected. Posting threads check this
+// before taking the enqueue timestamp so that the disabled cost is one load.
+bool task_stats_is_enabled(void);
+
+// Records one task that was posted at |enqueue_us|, started at |start_us| and
+// finished at |end_us| (all from |time_get_os_boottime_us|). The origin is
+// |origin_file|:|origin_line| when the poster supplied a location, otherwise
+// the task function |origin_pc|.
+void task_stats_record(task_stats_t* stats, const char* origin_file,
+                       int origin_line, const void* origin_pc,
+                       uint64_t enqueue_us, uint64_t start_us,
+                       uint64_t end_us);
+
+// Returns |task| wrapped so that running it records, in |stats|, how long it
+// waited from now and how long it ran, with |from_here| as its origin. This is
+// for the tasks of a libchrome message loop run by a thread, which are posted
+// to the loop rather than with |thread_post|. |task| is returned as is while
+// collection is disabled or when |stats| is NULL.
+base::OnceClosure task_stats_wrap(task_stats_t* stats,
+                                  const base::Location& from_here,
+                                  base::OnceClosure task);
+
+// Dump queueing-delay and run-time histograms plus the slowest task origins
+// of every registered thread to the |fd| file descriptor.
+// The caller is responsible for closing the |fd|.
+void task_stats_debug_dump(int fd);
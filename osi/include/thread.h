@@ -24,6 +24,7 @@
 #define THREAD_NAME_MAX 16
 
 typedef struct reactor_t reactor_t;
+typedef struct task_stats_t task_stats_t;
 typedef struct thread_t thread_t;
 
 typedef void (*thread_fn)(void* context);
@@ -80,5 +81,9 @@ bool thread_is_self(const thread_t* thread);
 // Returns the reactor for the given |thread|. |thread| may not be NULL.
 reactor_t* thread_get_reactor(const thread_t* thread);
 
+// Returns the task statistics of the given |thread|, which a message loop run
+// on |thread| records its own tasks in. |thread| may not be NULL.
+task_stats_t* thread_get_task_stats(const thread_t* thread);
+
 // Returns the name of the given |thread|. |thread| may not be NULL.
 const char* thread_name(const thread_t* thread);
@@ -44,6 +44,7 @@
 #include "osi/include/log.h"
 #include "osi/include/osi.h"
 #include "osi/include/semaphore.h"
+#include "osi/include/task_stats.h"
 #include "osi/include/thread.h"
 #include "osi/include/wakelock.h"
 
@@ -52,6 +53,7 @@ using base::CancelableClosure;
 using base::MessageLoop;
 
 extern base::MessageLoop* get_message_loop();
+extern task_stats_t* get_message_loop_task_stats();
 
 // Callback and timer threads should run at RT priority in order to ensure they
 // meet audio deadlines.  Use this priority for all audio/timer related thread.
@@ -174,8 +176,10 @@ alarm_t* alarm_new_periodic(const char* name) {
 }
 
 static alarm_t* alarm_new_internal(const char* name, bool is_periodic) {
-  // Make sure we have a list we can insert alarms into.
-  if (!alarms && !lazy_initialize()) {
+  // Make sure we have a list we can insert alarms into. Modules starting up in
+  // parallel may get here at the same time, lazy_initialize() checks |alarms|
+  // under |alarms_mutex|.
+  if (!lazy_initialize()) {
     CHECK(false);  // if initialization failed, we should not continue
     return NULL;
   }
@@ -323,15 +327,14 @@ void alarm_cleanup(void) {
 }
 
 static bool lazy_initialize(void) {
-  CHECK(alarms == NULL);
+  std::lock_guard<std::mutex> lock(alarms_mutex);
+  if (alarms != NULL) return true;
 
   // timer_t doesn't have an invalid value so we must track whether
   // the |timer| variable is valid ourselves.
   bool timer_initialized = false;
   bool wakeup_timer_initialized = false;
 
-  std::lock_guard<std::mutex> lock(alarms_mutex);
-
   alarms = list_new(NULL);
   if (!alarms) {
     LOG_ERROR(LOG_TAG, "%s unable to allocate alarm list.", __func__);
@@ -660,7 +663,9 @@ static void callback_dispatch(UNUSED_ATTR void* context) {
       }
 
       alarm->closure.i.Reset(Bind(alarm_ready_mloop, alarm));
-      get_message_loop()->task_runner()->PostTask(FROM_HERE, alarm->closure.i.callback());
+      get_message_loop()->task_runner()->PostTask(
+          FROM_HERE, task_stats_wrap(get_message_loop_task_stats(), FROM_HERE,
+                                     alarm->closure.i.callback()));
     } else {
       fixed_queue_enqueue(alarm->queue, alarm);
     }
@@ -32,6 +32,9 @@
 #include <sys/stat.h>
 #include <unistd.h>
 
+#include <string>
+#include <unordered_map>
+
 #include "osi/include/allocator.h"
 #include "osi/include/list.h"
 #include "osi/include/log.h"
@@ -52,6 +55,10 @@ typedef struct {
 
 struct config_t {
   list_t* sections;
+  // Sections by name, so that lookups do not have to walk |sections|. With a
+  // section per bonded device, every key read would otherwise cost a scan of
+  // all bonds.
+  std::unordered_map<std::string, section_t*> section_index;
 };
 
 // Empty definition; this type is aliased to list_node_t.
@@ -62,6 +69,7 @@ static bool config_parse(FILE* fp, config_t* config);
 static section_t* section_new(const char* name);
 static void section_free(void* ptr);
 static section_t* section_find(const config_t* config, const char* section);
+static void section_add(config_t* config, section_t* section);
 
 static entry_t* entry_new(const char* key, const char* value);
 static void entry_free(void* ptr);
@@ -69,7 +77,7 @@ static entry_t* entry_find(const config_t* config, const char* section,
                            const char* key);
 
 config_t* config_new_empty(void) {
-  config_t* config = static_cast<config_t*>(osi_calloc(sizeof(config_t)));
+  config_t* config = new config_t();
 
   config->sections = list_new(section_free);
   if (!config->sections) {
@@ -149,7 +157,7 @@ void config_free(config_t* config) {
   if (!config) return;
 
   list_free(config->sections);
-  osi_free(config);
+  delete config;
 }
 
 bool config_has_section(const config_t* config, const char* section) {
@@ -285,7 +293,7 @@ void config_set_string(config_t* config, const char* section, const char* key,
   if (!sec) {
     sec = section_new(section);
     if (sec)
-      list_append(config->sections, sec);
+      section_add(config, sec);
     else {
       LOG_ERROR(LOG_TAG,"%s: Unable to allocate memory for section", __func__);
     }
@@ -324,6 +332,7 @@ bool config_remove_section(config_t* config, const char* section) {
   section_t* sec = section_find(config, section);
   if (!sec) return false;
 
+  config->section_index.erase(sec->name);
   return list_remove(config->sections, sec);
 }
 
@@ -701,7 +710,7 @@ static bool config_parse(FILE* fp, config_t* config) {
         if(!section_find(config, comment)) {
             section_t *sec = section_new(comment);
             if (sec)
-                list_append(config->sections, sec);
+                section_add(config, sec);
         }
     } else if (*line_ptr == '[') {
       size_t len = strlen(line_ptr);
@@ -749,13 +758,13 @@ static void section_free(void* ptr) {
 }
 
 static section_t* section_find(const config_t* config, const char* section) {
-  for (const list_node_t* node = list_begin(config->sections);
-       node != list_end(config->sections); node = list_next(node)) {
-    section_t* sec = static_cast<section_t*>(list_node(node));
-    if (sec && !strcmp(sec->name, section)) return sec;
+  auto it = config->section_index.find(section);
+  return (it != config->section_index.end()) ? it->second : NULL;
 }
 
-  return NULL;
+static void section_add(config_t* config, section_t* section) {
+  list_append(config->sections, section);
+  config->section_index[section->name] = section;
 }
 
 static entry_t* entry_new(const char* key, const char* value) {
@@ -0,0 +1,321 @@
+/*
+ * Copyright 2019 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "bt_osi_packet_trace"
+
+#include "osi/include/packet_trace.h"
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <mutex>
+#include <vector>
+
+#include "osi/include/compat.h"
+#include "osi/include/log.h"
+#include "osi/include/time.h"
+
+// Entries kept per recording thread. Only a handful of threads touch ACL
+// data (hci, bt_main_thread, a2dp), so this bounds memory to a few hundred KB.
+#define PACKET_TRACE_RING_SIZE 4096
+
+// Two consecutive points of the same buffer further apart than this are
+// assumed to belong to different packets that reused the same allocation.
+#define PACKET_TRACE_MAX_SPAN_US (2 * 1000 * 1000)
+
+typedef struct {
+  uint64_t timestamp_us;
+  uintptr_t packet;
+  uint16_t id;
+  uint16_t len;
+  uint8_t point;
+} packet_trace_entry_t;
+
+// One entry of a ring, published through a per-slot sequence number. It is
+// odd while the owner writes the slot, then 2 * (index + 1) for the ring
+// index the slot holds. Readers keep a copy only if the sequence number was
+// the one of the index they expected both before and after copying.
+typedef struct {
+  std::atomic<uint32_t> seq;
+  std::atomic<uint64_t> timestamp_us;
+  std::atomic<uintptr_t> packet;
+  std::atomic<uint16_t> id;
+  std::atomic<uint16_t> len;
+  std::atomic<uint8_t> point;
+} packet_trace_slot_t;
+
+// Single-writer ring. The owning thread is the only writer; readers copy it
+// without blocking it. |tid|, |first| and |in_use| are guarded by
+// rings_mutex.
+typedef struct {
+  pid_t tid;
+  // Index of the first entry recorded by |tid|. The entries before it were
+  // recorded by a thread that has exited since.
+  uint32_t first;
+  bool in_use;
+  std::atomic<uint32_t> head;
+  packet_trace_slot_t slots[PACKET_TRACE_RING_SIZE];
+} packet_trace_ring_t;
+
+typedef struct {
+  packet_trace_entry_t entry;
+  pid_t tid;
+} packet_trace_sample_t;
+
+typedef struct {
+  size_t count;
+  uint64_t total_us;
+  uint64_t max_us;
+} packet_trace_span_stats_t;
+
+std::atomic<bool> packet_trace_enabled(false);
+
+static const char* point_names[PACKET_TRACE_POINT_COUNT] = {
+    "hci_rx",     "reassembled", "btu_rx",   "l2cap_rx", "profile_rx",
+    "uhid_write", "profile_tx",  "l2cap_tx", "hci_tx",
+};
+
+// A thread that exits hands its ring back, and the next thread that records
+// takes it over. The stack's threads are restarted on every enable, so there
+// are never more rings than threads recording at the same time. Until then a
+// dump can still read what the exited thread recorded.
+static std::mutex rings_mutex;
+static std::vector<packet_trace_ring_t*> rings;
+
+class RingOwner {
+ public:
+  ~RingOwner() {
+    if (ring == nullptr) return;
+    std::lock_guard<std::mutex> lock(rings_mutex);
+    ring->in_use = false;
+  }
+
+  packet_trace_ring_t* ring = nullptr;
+};
+
+static thread_local RingOwner local_ring;
+static thread_local const void* last_rx_packet = nullptr;
+
+static packet_trace_ring_t* get_local_ring() {
+  if (local_ring.ring != nullptr) return local_ring.ring;
+
+  std::lock_guard<std::mutex> lock(rings_mutex);
+  packet_trace_ring_t* ring = nullptr;
+  for (packet_trace_ring_t* unused : rings) {
+    if (!unused->in_use) {
+      ring = unused;
+      break;
+    }
+  }
+  if (ring == nullptr) {
+    ring = new packet_trace_ring_t();
+    ring->head = 0;
+    rings.push_back(ring);
+  }
+
+  // The head carries on from the previous owner, so that none of its slots
+  // can be mistaken for one of the new owner.
+  ring->tid = gettid();
+  ring->first = ring->head.load(std::memory_order_relaxed);
+  ring->in_use = true;
+  local_ring.ring = ring;
+  return ring;
+}
+
+static bool is_rx_point(uint8_t point) {
+  return point <= PACKET_TRACE_UHID_WRITE;
+}
+
+void packet_trace_set_enabled(bool enabled) {
+  if (packet_trace_enabled.exchange(enabled) != enabled)
+    LOG_INFO(LOG_TAG, "%s packet tracing %s", __func__,
+             enabled ? "enabled" : "disabled");
+}
+
+void packet_trace_record(packet_trace_point_t point, const void* packet,
+                         uint16_t id, uint16_t len) {
+  packet_trace_ring_t* ring = get_local_ring();
+  uint32_t head = ring->head.load(std::memory_order_relaxed);
+
+  packet_trace_slot_t& slot = ring->slots[head % PACKET_TRACE_RING_SIZE];
+  slot.seq.store(2 * head + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  slot.timestamp_us.store(time_get_os_boottime_us(), std::memory_order_relaxed);
+  slot.packet.store(reinterpret_cast<uintptr_t>(packet),
+                    std::memory_order_relaxed);
+  slot.id.store(id, std::memory_order_relaxed);
+  slot.len.store(len, std::memory_order_relaxed);
+  slot.point.store(point, std::memory_order_relaxed);
+  slot.seq.store(2 * head + 2, std::memory_order_release);
+
+  ring->head.store(head + 1, std::memory_order_release);
+
+  if (point == PACKET_TRACE_PROFILE_RX) last_rx_packet = packet;
+}
+
+void packet_trace_record_last_rx(packet_trace_point_t point, uint16_t id,
+                                 uint16_t len) {
+  if (last_rx_packet != nullptr)
+    packet_trace_record(point, last_rx_packet, id, len);
+}
+
+void packet_trace_clear_last_rx(void) { last_rx_packet = nullptr; }
+
+// Copies every ring into one list sorted by buffer and time, so that the
+// points a packet crossed end up adjacent to each other.
+static std::vector<packet_trace_sample_t> collect_samples() {
+  std::vector<packet_trace_sample_t> samples;
+  std::lock_guard<std::mutex> lock(rings_mutex);
+
+  for (packet_trace_ring_t* ring : rings) {
+    uint32_t head = ring->head.load(std::memory_order_acquire);
+    uint32_t first =
+        head > PACKET_TRACE_RING_SIZE ? head - PACKET_TRACE_RING_SIZE : 0;
+    // Indexes wrap around, compare distances from the head only
+    if (head - ring->first < head - first) first = ring->first;
+
+    for (uint32_t i = first; i != head; i++) {
+      const packet_trace_slot_t& slot =
+          ring->slots[i % PACKET_TRACE_RING_SIZE];
+      uint32_t seq = slot.seq.load(std::memory_order_acquire);
+      if (seq != 2 * i + 2) continue;
+
+      packet_trace_sample_t sample;
+      sample.entry.timestamp_us =
+          slot.timestamp_us.load(std::memory_order_relaxed);
+      sample.entry.packet = slot.packet.load(std::memory_order_relaxed);
+      sample.entry.id = slot.id.load(std::memory_order_relaxed);
+      sample.entry.len = slot.len.load(std::memory_order_relaxed);
+      sample.entry.point = slot.point.load(std::memory_order_relaxed);
+      sample.tid = ring->tid;
+
+      // The writer overwrote the slot while we were copying it
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if (slot.seq.load(std::memory_order_relaxed) != seq) continue;
+
+      samples.push_back(sample);
+    }
+  }
+
+  std::sort(samples.begin(), samples.end(),
+            [](const packet_trace_sample_t& a, const packet_trace_sample_t& b) {
+              if (a.entry.packet != b.entry.packet)
+                return a.entry.packet < b.entry.packet;
+              return a.entry.timestamp_us < b.entry.timestamp_us;
+            });
+  return samples;
+}
+
+// Returns true if |from| and |to| are two consecutive boundaries of the same
+// packet.
+static bool is_span(const packet_trace_sample_t& from,
+                    const packet_trace_sample_t& to) {
+  return from.entry.packet == to.entry.packet &&
+         is_rx_point(from.entry.point) == is_rx_point(to.entry.point) &&
+         from.entry.point < to.entry.point &&
+         to.entry.timestamp_us - from.entry.timestamp_us <=
+             PACKET_TRACE_MAX_SPAN_US;
+}
+
+static void add_span(
+    packet_trace_span_stats_t stats[][PACKET_TRACE_POINT_COUNT],
+    const packet_trace_sample_t& from, const packet_trace_sample_t& to) {
+  uint64_t duration_us = to.entry.timestamp_us - from.entry.timestamp_us;
+  packet_trace_span_stats_t& span = stats[from.entry.point][to.entry.point];
+
+  span.count++;
+  span.total_us += duration_us;
+  span.max_us = std::max(span.max_us, duration_us);
+}
+
+void packet_trace_dump_json(int fd) {
+  std::vector<packet_trace_sample_t> samples = collect_samples();
+  pid_t pid = getpid();
+  bool first = true;
+
+  dprintf(fd, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+  for (size_t i = 0; i + 1 < samples.size(); i++) {
+    const packet_trace_sample_t& from = samples[i];
+    const packet_trace_sample_t& to = samples[i + 1];
+    if (!is_span(from, to)) continue;
+
+    // The span is attributed to the thread that picked the packet up, which
+    // is where any queueing delay shows up.
+    dprintf(fd,
+            "%s\n{\"name\":\"%s->%s\",\"cat\":\"bt_%s\",\"ph\":\"X\","
+            "\"ts\":%" PRIu64 ",\"dur\":%" PRIu64
+            ",\"pid\":%d,\"tid\":%d,"
+            "\"args\":{\"packet\":\"0x%" PRIxPTR
+            "\",\"id\":%u,\"len\":%u}}",
+            first ? "" : ",", point_names[from.entry.point],
+            point_names[to.entry.point],
+            is_rx_point(from.entry.point) ? "rx" : "tx",
+            from.entry.timestamp_us,
+            to.entry.timestamp_us - from.entry.timestamp_us, pid, to.tid,
+            from.entry.packet, to.entry.id, to.entry.len);
+    first = false;
+  }
+  dprintf(fd, "\n]}\n");
+}
+
+void packet_trace_debug_dump(int fd) {
+  dprintf(fd, "\nPacket path tracing:\n");
+#if (BT_PACKET_TRACE_INCLUDED != TRUE)
+  dprintf(fd, "  Not compiled in\n");
+#else
+  dprintf(fd, "  Enabled: %s (set persist.bluetooth.packet_trace=1 to enable)\n",
+          packet_trace_enabled.load() ? "true" : "false");
+
+  std::vector<packet_trace_sample_t> samples = collect_samples();
+  packet_trace_span_stats_t
+      stats[PACKET_TRACE_POINT_COUNT][PACKET_TRACE_POINT_COUNT] = {};
+  size_t chain_start = 0;
+
+  for (size_t i = 0; i + 1 < samples.size(); i++) {
+    if (!is_span(samples[i], samples[i + 1])) {
+      chain_start = i + 1;
+      continue;
+    }
+    add_span(stats, samples[i], samples[i + 1]);
+
+    // Once a packet's chain ends, also account it from its first to its last
+    // point, which gives the end-to-end latency such as hci_rx->uhid_write.
+    bool chain_ends = i + 2 >= samples.size() ||
+                      !is_span(samples[i + 1], samples[i + 2]);
+    if (chain_ends && i + 1 - chain_start > 1)
+      add_span(stats, samples[chain_start], samples[i + 1]);
+  }
+
+  dprintf(fd, "  Samples: %zu\n", samples.size());
+  dprintf(fd, "  %-26s %8s %10s %10s\n", "Span", "Count", "Avg (us)",
+          "Max (us)");
+  for (int from = 0; from < PACKET_TRACE_POINT_COUNT; from++) {
+    for (int to = 0; to < PACKET_TRACE_POINT_COUNT; to++) {
+      const packet_trace_span_stats_t& span = stats[from][to];
+      if (span.count == 0) continue;
+
+      char name[32];
+      snprintf(name, sizeof(name), "%s->%s", point_names[from],
+               point_names[to]);
+      dprintf(fd, "  %-26s %8zu %10" PRIu64 " %10" PRIu64 "\n", name,
+              span.count, span.total_us / span.count, span.max_us);
+    }
+  }
+#endif
+}
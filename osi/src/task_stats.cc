@@ -0,0 +1,235 @@
+/*
+ * Copyright 2019 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "bt_osi_task_stats"
+
+#include "osi/include/task_stats.h"
+
+#include <dlfcn.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <algorithm>
+#include <atomic>
+#include <list>
+#include <map>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <base/bind.h>
+
+#include "osi/include/log.h"
+#include "osi/include/thread.h"
+#include "osi/include/time.h"
+
+// Upper bounds of the histogram buckets, in microseconds. The last bucket
+// counts everything at or above the previous bound.
+static const uint64_t bucket_bounds_us[] = {100,   500,   1000,   5000,
+                                            10000, 50000, 100000, UINT64_MAX};
+#define TASK_STATS_BUCKETS \
+  (sizeof(bucket_bounds_us) / sizeof(bucket_bounds_us[0]))
+
+// Number of task origins listed per thread, slowest first.
+#define TASK_STATS_TOP_ORIGINS 10
+
+typedef struct {
+  size_t count;
+  uint64_t total_us;
+  uint64_t max_us;
+  size_t buckets[TASK_STATS_BUCKETS];
+} histogram_t;
+
+typedef struct {
+  const char* file;
+  int line;
+  const void* pc;
+  size_t count;
+  uint64_t total_run_us;
+  uint64_t max_run_us;
+  uint64_t max_queued_us;
+} origin_stats_t;
+
+struct task_stats_t {
+  std::mutex mutex;
+  char name[THREAD_NAME_MAX + 1];
+  histogram_t queued;
+  histogram_t run;
+  // Keyed by file/line when known, otherwise by the task function address.
+  std::map<std::pair<const void*, int>, origin_stats_t> origins;
+};
+
+static std::atomic<bool> enabled(false);
+static std::mutex registry_mutex;
+static std::list<task_stats_t*> registry;
+
+static void histogram_add(histogram_t* histogram, uint64_t value_us) {
+  size_t bucket = 0;
+  while (value_us >= bucket_bounds_us[bucket]) bucket++;
+  histogram->buckets[bucket]++;
+  histogram->count++;
+  histogram->total_us += value_us;
+  histogram->max_us = std::max(histogram->max_us, value_us);
+}
+
+static void histogram_dump(int fd, const char* title,
+                           const histogram_t* histogram) {
+  if (histogram->count == 0) return;
+
+  dprintf(fd, "    %s: count %zu, avg %" PRIu64 " us, max %" PRIu64 " us\n",
+          title, histogram->count, histogram->total_us / histogram->count,
+          histogram->max_us);
+  dprintf(fd, "     ");
+  for (size_t i = 0; i < TASK_STATS_BUCKETS; i++) {
+    if (i + 1 < TASK_STATS_BUCKETS)
+      dprintf(fd, " <%" PRIu64 "us:%zu", bucket_bounds_us[i],
+              histogram->buckets[i]);
+    else
+      dprintf(fd, " >=%" PRIu64 "us:%zu", bucket_bounds_us[i - 1],
+              histogram->buckets[i]);
+  }
+  dprintf(fd, "\n");
+}
+
+static std::string origin_name(const origin_stats_t& origin) {
+  char buffer[128];
+  if (origin.file != NULL) {
+    const char* base_name = strrchr(origin.file, '/');
+    snprintf(buffer, sizeof(buffer), "%s:%d",
+             base_name ? base_name + 1 : origin.file, origin.line);
+    return buffer;
+  }
+
+  Dl_info info;
+  if (dladdr(origin.pc, &info) != 0 && info.dli_sname != NULL)
+    return info.dli_sname;
+  snprintf(buffer, sizeof(buffer), "%p", origin.pc);
+  return buffer;
+}
+
+task_stats_t* task_stats_new(const char* name) {
+  task_stats_t* stats = new task_stats_t();
+  strncpy(stats->name, name, THREAD_NAME_MAX);
+
+  std::lock_guard<std::mutex> lock(registry_mutex);
+  registry.push_back(stats);
+  return stats;
+}
+
+void task_stats_free(task_stats_t* stats) {
+  if (stats == NULL) return;
+
+  {
+    std::lock_guard<std::mutex> lock(registry_mutex);
+    registry.remove(stats);
+  }
+  delete stats;
+}
+
+void task_stats_set_enabled(bool enable) {
+  if (enabled.exchange(enable) != enable)
+    LOG_INFO(LOG_TAG, "%s task stats %s", __func__,
+             enable ? "enabled" : "disabled");
+}
+
+bool task_stats_is_enabled(void) {
+  return enabled.load(std::memory_order_relaxed);
+}
+
+void task_stats_record(task_stats_t* stats, const char* origin_file,
+                       int origin_line, const void* origin_pc,
+                       uint64_t enqueue_us, uint64_t start_us,
+                       uint64_t end_us) {
+  uint64_t queued_us = start_us - enqueue_us;
+  uint64_t run_us = end_us - start_us;
+
+  std::lock_guard<std::mutex> lock(stats->mutex);
+  histogram_add(&stats->queued, queued_us);
+  histogram_add(&stats->run, run_us);
+
+  std::pair<const void*, int> key =
+      origin_file != NULL ? std::make_pair((const void*)origin_file, origin_line)
+                          : std::make_pair(origin_pc, 0);
+  origin_stats_t& origin = stats->origins[key];
+  if (origin.count == 0) {
+    origin.file = origin_file;
+    origin.line = origin_line;
+    origin.pc = origin_pc;
+  }
+  origin.count++;
+  origin.total_run_us += run_us;
+  origin.max_run_us = std::max(origin.max_run_us, run_us);
+  origin.max_queued_us = std::max(origin.max_queued_us, queued_us);
+}
+
+static void run_timed_task(task_stats_t* stats, const base::Location& from_here,
+                           uint64_t enqueue_us, base::OnceClosure task) {
+  uint64_t start_us = time_get_os_boottime_us();
+  std::move(task).Run();
+  task_stats_record(stats, from_here.file_name(), from_here.line_number(),
+                    from_here.program_counter(), enqueue_us, start_us,
+                    time_get_os_boottime_us());
+}
+
+base::OnceClosure task_stats_wrap(task_stats_t* stats,
+                                  const base::Location& from_here,
+                                  base::OnceClosure task) {
+  if (stats == NULL || !task_stats_is_enabled()) return task;
+
+  return base::BindOnce(&run_timed_task, stats, from_here,
+                        time_get_os_boottime_us(), std::move(task));
+}
+
+void task_stats_debug_dump(int fd) {
+  dprintf(fd, "\nThread task statistics:\n");
+  if (!task_stats_is_enabled()) {
+    dprintf(fd, "  Disabled (set persist.bluetooth.task_stats=1 to enable)\n");
+    return;
+  }
+
+  std::lock_guard<std::mutex> registry_lock(registry_mutex);
+  for (task_stats_t* stats : registry) {
+    std::lock_guard<std::mutex> lock(stats->mutex);
+    dprintf(fd, "  %s:\n", stats->name);
+    if (stats->run.count == 0) {
+      dprintf(fd, "    No tasks recorded\n");
+      continue;
+    }
+    histogram_dump(fd, "Queued", &stats->queued);
+    histogram_dump(fd, "Run", &stats->run);
+
+    std::vector<const origin_stats_t*> slowest;
+    for (const auto& entry : stats->origins) slowest.push_back(&entry.second);
+    size_t top = std::min<size_t>(slowest.size(), TASK_STATS_TOP_ORIGINS);
+    std::partial_sort(slowest.begin(), slowest.begin() + top, slowest.end(),
+                      [](const origin_stats_t* a, const origin_stats_t* b) {
+                        return a->max_run_us > b->max_run_us;
+                      });
+
+    dprintf(fd, "    %-40s %8s %12s %12s %12s\n", "Slowest origins", "Count",
+            "Avg run us", "Max run us", "Max queue us");
+    for (size_t i = 0; i < top; i++) {
+      const origin_stats_t* origin = slowest[i];
+      dprintf(fd,
+              "    %-40s %8zu %12" PRIu64 " %12" PRIu64 " %12" PRIu64 "\n",
+              origin_name(*origin).c_str(), origin->count,
+              origin->total_run_us / origin->count, origin->max_run_us,
+              origin->max_queued_us);
+    }
+  }
+}
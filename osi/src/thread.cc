@@ -38,6 +38,8 @@
 #include "osi/include/log.h"
 #include "osi/include/reactor.h"
 #include "osi/include/semaphore.h"
+#include "osi/include/task_stats.h"
+#include "osi/include/time.h"
 
 struct thread_t {
   std::atomic_bool is_joined{false};
@@ -46,6 +48,7 @@ struct thread_t {
   char name[THREAD_NAME_MAX + 1];
   reactor_t* reactor;
   fixed_queue_t* work_queue;
+  task_stats_t* task_stats;
 };
 
 struct start_arg {
@@ -57,10 +60,12 @@ struct start_arg {
 typedef struct {
   thread_fn func;
   void* context;
+  uint64_t enqueue_us;  // 0 if task stats were disabled when posted
 } work_item_t;
 
 static void* run_thread(void* start_arg);
 static void work_queue_read_cb(void* context);
+static void run_work_item(thread_t* thread, work_item_t* item);
 
 static const size_t DEFAULT_WORK_QUEUE_CAPACITY = 128;
 
@@ -79,6 +84,8 @@ thread_t* thread_new_sized(const char* name, size_t work_queue_capacity) {
   ret->work_queue = fixed_queue_new(work_queue_capacity);
   if (!ret->work_queue) goto error;
 
+  ret->task_stats = task_stats_new(name);
+
   // Start is on the stack, but we use a semaphore, so it's safe
   struct start_arg start;
   start.start_sem = semaphore_new(0);
@@ -99,6 +106,7 @@ error:;
   if (ret) {
     fixed_queue_free(ret->work_queue, osi_free);
     reactor_free(ret->reactor);
+    task_stats_free(ret->task_stats);
   }
   osi_free(ret);
   return NULL;
@@ -116,6 +124,7 @@ void thread_free(thread_t* thread) {
 
   fixed_queue_free(thread->work_queue, osi_free);
   reactor_free(thread->reactor);
+  task_stats_free(thread->task_stats);
   osi_free(thread);
 }
 
@@ -139,6 +148,7 @@ bool thread_post(thread_t* thread, thread_fn func, void* context) {
   work_item_t* item = (work_item_t*)osi_malloc(sizeof(work_item_t));
   item->func = func;
   item->context = context;
+  item->enqueue_us = task_stats_is_enabled() ? time_get_os_boottime_us() : 0;
   fixed_queue_enqueue(thread->work_queue, item);
   return true;
 }
@@ -189,6 +199,11 @@ reactor_t* thread_get_reactor(const thread_t* thread) {
   return thread->reactor;
 }
 
+task_stats_t* thread_get_task_stats(const thread_t* thread) {
+  CHECK(thread != NULL);
+  return thread->task_stats;
+}
+
 const char* thread_name(const thread_t* thread) {
   CHECK(thread != NULL);
   return thread->name;
@@ -217,7 +232,7 @@ static void* run_thread(void* start_arg) {
   semaphore_post(start->start_sem);
 
   int fd = fixed_queue_get_dequeue_fd(thread->work_queue);
-  void* context = thread->work_queue;
+  void* context = thread;
 
   reactor_object_t* work_queue_object =
       reactor_register(thread->reactor, fd, context, work_queue_read_cb, NULL);
@@ -231,8 +246,7 @@ static void* run_thread(void* start_arg) {
   work_item_t* item =
       static_cast<work_item_t*>(fixed_queue_try_dequeue(thread->work_queue));
   while (item && count <= fixed_queue_capacity(thread->work_queue)) {
-    item->func(item->context);
-    osi_free(item);
+    run_work_item(thread, item);
     item =
         static_cast<work_item_t*>(fixed_queue_try_dequeue(thread->work_queue));
     ++count;
@@ -249,8 +263,20 @@ static void* run_thread(void* start_arg) {
 static void work_queue_read_cb(void* context) {
   CHECK(context != NULL);
 
-  fixed_queue_t* queue = (fixed_queue_t*)context;
-  work_item_t* item = static_cast<work_item_t*>(fixed_queue_dequeue(queue));
-  item->func(item->context);
+  thread_t* thread = (thread_t*)context;
+  work_item_t* item =
+      static_cast<work_item_t*>(fixed_queue_dequeue(thread->work_queue));
+  run_work_item(thread, item);
+}
+
+static void run_work_item(thread_t* thread, work_item_t* item) {
+  if (item->enqueue_us == 0) {
+    item->func(item->context);
+  } else {
+    uint64_t start_us = time_get_os_boottime_us();
+    item->func(item->context);
+    task_stats_record(thread->task_stats, NULL, 0, (const void*)item->func,
+                      item->enqueue_us, start_us, time_get_os_boottime_us());
+  }
   osi_free(item);
 }
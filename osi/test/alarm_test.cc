@@ -58,6 +58,7 @@ void message_loop_run(UNUSED_ATTR void* context) {
 }
 
 base::MessageLoop* get_message_loop() { return message_loop_; }
+task_stats_t* get_message_loop_task_stats() { return NULL; }
 
 class AlarmTest : public AlarmTestHarness {
  protected:
@@ -95,6 +96,34 @@ TEST_F(AlarmTest, test_new_free_simple) {
 
 TEST_F(AlarmTest, test_free_null) { alarm_free(NULL); }
 
+static semaphore_t* start_gate;
+
+static void new_alarm_when_started(void* context) {
+  semaphore_wait(start_gate);
+  *(alarm_t**)context = alarm_new("alarm_test.test_new_concurrent_first_use");
+}
+
+// Modules starting up in parallel may create the first alarms at the same time
+TEST_F(AlarmTest, test_new_concurrent_first_use) {
+  const int num_threads = 4;
+  thread_t* threads[num_threads];
+  alarm_t* alarms[num_threads] = {};
+
+  start_gate = semaphore_new(0);
+  for (int i = 0; i < num_threads; i++) {
+    threads[i] = thread_new("alarm_test.first_use");
+    thread_post(threads[i], new_alarm_when_started, &alarms[i]);
+  }
+  for (int i = 0; i < num_threads; i++) semaphore_post(start_gate);
+  for (int i = 0; i < num_threads; i++) thread_free(threads[i]);
+  semaphore_free(start_gate);
+
+  for (int i = 0; i < num_threads; i++) {
+    EXPECT_TRUE(alarms[i] != NULL);
+    alarm_free(alarms[i]);
+  }
+}
+
 TEST_F(AlarmTest, test_simple_cancel) {
   alarm_t* alarm = alarm_new("alarm_test.test_simple_cancel");
   alarm_cancel(alarm);
@@ -143,6 +143,33 @@ TEST_F(ConfigTest, config_remove_section) {
   config_free(config);
 }
 
+TEST_F(ConfigTest, config_remove_section_then_add) {
+  config_t* config = config_new(CONFIG_FILE);
+  EXPECT_TRUE(config_remove_section(config, "DID"));
+  config_set_int(config, "DID", "productId", 0x1300);
+  EXPECT_TRUE(config_has_section(config, "DID"));
+  EXPECT_EQ(config_get_int(config, "DID", "productId", 999), 0x1300);
+  EXPECT_FALSE(config_has_key(config, "DID", "version"));
+  config_free(config);
+}
+
+TEST_F(ConfigTest, config_many_sections) {
+  config_t* config = config_new_empty();
+  char section[32];
+  for (int i = 0; i < 1000; i++) {
+    snprintf(section, sizeof(section), "00:00:00:00:%02x:%02x", i >> 8,
+             i & 0xff);
+    config_set_int(config, section, "DevType", i);
+  }
+  for (int i = 999; i >= 0; i--) {
+    snprintf(section, sizeof(section), "00:00:00:00:%02x:%02x", i >> 8,
+             i & 0xff);
+    EXPECT_EQ(config_get_int(config, section, "DevType", -1), i);
+  }
+  EXPECT_FALSE(config_has_section(config, "00:00:00:00:ff:ff"));
+  config_free(config);
+}
+
 TEST_F(ConfigTest, config_remove_section_missing) {
   config_t* config = config_new(CONFIG_FILE);
   EXPECT_FALSE(config_remove_section(config, "not a section"));
@@ -0,0 +1,123 @@
+/*
+ * Copyright 2019 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <string>
+#include <thread>
+
+#include "AllocationTestHarness.h"
+
+#include "osi/include/packet_trace.h"
+
+class PacketTraceTest : public AllocationTestHarness {
+ protected:
+  std::string DumpJson() { return Dump(packet_trace_dump_json); }
+
+  size_t DumpSampleCount() {
+    std::string dump = Dump(packet_trace_debug_dump);
+    size_t samples = dump.find("Samples: ");
+    if (samples == std::string::npos) return 0;
+    return std::stoul(dump.substr(samples + strlen("Samples: ")));
+  }
+
+  std::string Dump(void (*dump)(int)) {
+    FILE* file = tmpfile();
+    dump(fileno(file));
+    rewind(file);
+
+    std::string json;
+    char buffer[1024];
+    size_t read;
+    while ((read = fread(buffer, 1, sizeof(buffer), file)) > 0)
+      json.append(buffer, read);
+    fclose(file);
+    return json;
+  }
+};
+
+TEST_F(PacketTraceTest, test_rx_spans_across_threads) {
+  static const char packet[] = "rx";
+
+  packet_trace_record(PACKET_TRACE_HCI_RX, packet, 0x0001, 27);
+  packet_trace_record(PACKET_TRACE_REASSEMBLED, packet, 0x0001, 27);
+  std::thread([] {
+    packet_trace_record(PACKET_TRACE_BTU_RX, packet, 0x0001, 27);
+    packet_trace_record(PACKET_TRACE_L2CAP_RX, packet, 0x0001, 27);
+  }).join();
+
+  std::string json = DumpJson();
+  EXPECT_NE(std::string::npos, json.find("\"hci_rx->reassembled\""));
+  EXPECT_NE(std::string::npos, json.find("\"reassembled->btu_rx\""));
+  EXPECT_NE(std::string::npos, json.find("\"btu_rx->l2cap_rx\""));
+  EXPECT_EQ(std::string::npos, json.find("\"hci_rx->btu_rx\""));
+}
+
+TEST_F(PacketTraceTest, test_no_span_between_directions) {
+  static const char packet[] = "reused";
+
+  packet_trace_record(PACKET_TRACE_PROFILE_RX, packet, 0x0040, 10);
+  packet_trace_record(PACKET_TRACE_PROFILE_TX, packet, 0x0040, 10);
+  packet_trace_record(PACKET_TRACE_L2CAP_TX, packet, 0x0001, 14);
+
+  std::string json = DumpJson();
+  EXPECT_EQ(std::string::npos, json.find("\"profile_rx->profile_tx\""));
+  EXPECT_NE(std::string::npos, json.find("\"profile_tx->l2cap_tx\""));
+}
+
+TEST_F(PacketTraceTest, test_last_rx_continues_profile_chain) {
+  static const char packet[] = "report";
+
+  packet_trace_record(PACKET_TRACE_L2CAP_RX, packet, 0x0041, 12);
+  packet_trace_record(PACKET_TRACE_PROFILE_RX, packet, 0x0041, 12);
+  packet_trace_record_last_rx(PACKET_TRACE_UHID_WRITE, 0x0001, 8);
+
+  std::string json = DumpJson();
+  EXPECT_NE(std::string::npos, json.find("\"profile_rx->uhid_write\""));
+}
+
+TEST_F(PacketTraceTest, test_last_rx_cleared_after_dispatch) {
+  static const char packet[] = "queued";
+
+  packet_trace_record(PACKET_TRACE_L2CAP_RX, packet, 0x0042, 12);
+  packet_trace_record(PACKET_TRACE_PROFILE_RX, packet, 0x0042, 12);
+  packet_trace_clear_last_rx();
+  // A write for a report the profile queued is not attributed to |packet|
+  packet_trace_record_last_rx(PACKET_TRACE_UHID_WRITE, 0x0002, 8);
+
+  std::string json = DumpJson();
+  EXPECT_EQ(std::string::npos, json.find("\"id\":2,\"len\":8"));
+}
+
+TEST_F(PacketTraceTest, test_ring_of_exited_thread_is_reused) {
+  static const char packet[] = "reuse";
+
+  std::thread([] {
+    packet_trace_record(PACKET_TRACE_HCI_TX, packet, 0x0001, 4);
+  }).join();
+  size_t samples = DumpSampleCount();
+  EXPECT_NE(0u, samples);
+
+  // The second thread takes over the ring of the first one, whose entry is
+  // replaced rather than kept in a ring of its own
+  std::thread([] {
+    packet_trace_record(PACKET_TRACE_HCI_TX, packet, 0x0001, 4);
+  }).join();
+  EXPECT_EQ(samples, DumpSampleCount());
+}
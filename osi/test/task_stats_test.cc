@@ -0,0 +1,130 @@
+/*
+ * Copyright 2019 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <base/bind.h>
+#include <gtest/gtest.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <string>
+
+#include "AllocationTestHarness.h"
+
+#include "osi/include/semaphore.h"
+#include "osi/include/task_stats.h"
+#include "osi/include/thread.h"
+
+class TaskStatsTest : public AllocationTestHarness {
+ protected:
+  void TearDown() override {
+    task_stats_set_enabled(false);
+    AllocationTestHarness::TearDown();
+  }
+
+  std::string Dump() {
+    FILE* file = tmpfile();
+    task_stats_debug_dump(fileno(file));
+    rewind(file);
+
+    std::string dump;
+    char buffer[1024];
+    size_t read;
+    while ((read = fread(buffer, 1, sizeof(buffer), file)) > 0)
+      dump.append(buffer, read);
+    fclose(file);
+    return dump;
+  }
+};
+
+static void post_semaphore(void* context) {
+  semaphore_post(static_cast<semaphore_t*>(context));
+}
+
+TEST_F(TaskStatsTest, test_disabled_by_default) {
+  EXPECT_FALSE(task_stats_is_enabled());
+  EXPECT_NE(std::string::npos, Dump().find("Disabled"));
+}
+
+TEST_F(TaskStatsTest, test_thread_post_is_recorded) {
+  task_stats_set_enabled(true);
+  thread_t* thread = thread_new("stats_test");
+  semaphore_t* done = semaphore_new(0);
+
+  for (int i = 0; i < 3; i++) thread_post(thread, post_semaphore, done);
+  for (int i = 0; i < 3; i++) semaphore_wait(done);
+
+  // A task is recorded after it returns, so the last one may still be in
+  // flight; by the time a fourth one runs the first three are recorded.
+  thread_post(thread, post_semaphore, done);
+  semaphore_wait(done);
+
+  std::string dump = Dump();
+  size_t section = dump.find("stats_test:");
+  ASSERT_NE(std::string::npos, section);
+  size_t run = dump.find("Run: count ", section);
+  ASSERT_NE(std::string::npos, run);
+  EXPECT_GE(atoi(dump.c_str() + run + strlen("Run: count ")), 3);
+  EXPECT_NE(std::string::npos, dump.find("Queued: count ", section));
+
+  semaphore_free(done);
+  thread_free(thread);
+  EXPECT_EQ(std::string::npos, Dump().find("stats_test:"));
+}
+
+TEST_F(TaskStatsTest, test_origins_keyed_by_location) {
+  task_stats_set_enabled(true);
+  task_stats_t* stats = task_stats_new("location_test");
+
+  task_stats_record(stats, "path/to/caller.cc", 42, NULL, 100, 150, 1150);
+  task_stats_record(stats, "path/to/caller.cc", 42, NULL, 200, 200, 300);
+  task_stats_record(stats, "path/to/caller.cc", 7, NULL, 300, 300, 310);
+
+  std::string dump = Dump();
+  size_t line = dump.find("caller.cc:42");
+  ASSERT_NE(std::string::npos, line);
+  EXPECT_LT(line, dump.find("caller.cc:7"));
+  EXPECT_NE(std::string::npos, dump.find("Run: count 3"));
+
+  task_stats_free(stats);
+}
+
+TEST_F(TaskStatsTest, test_wrapped_task_is_recorded) {
+  task_stats_t* stats = task_stats_new("wrap_test");
+  int runs = 0;
+
+  // Not recorded while disabled.
+  task_stats_wrap(stats, FROM_HERE,
+                  base::BindOnce([](int* runs) { (*runs)++; }, &runs))
+      .Run();
+  task_stats_set_enabled(true);
+  std::string dump = Dump();
+  EXPECT_NE(std::string::npos,
+            dump.find("No tasks recorded", dump.find("wrap_test:")));
+
+  task_stats_wrap(stats, FROM_HERE,
+                  base::BindOnce([](int* runs) { (*runs)++; }, &runs))
+      .Run();
+  EXPECT_EQ(2, runs);
+
+  dump = Dump();
+  size_t section = dump.find("wrap_test:");
+  ASSERT_NE(std::string::npos, section);
+  EXPECT_NE(std::string::npos, dump.find("Run: count 1", section));
+  EXPECT_NE(std::string::npos, dump.find("task_stats_test.cc:", section));
+
+  task_stats_free(stats);
+}
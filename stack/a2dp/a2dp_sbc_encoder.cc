@@ -18,12 +18,17 @@
  ******************************************************************************/
 
 #define LOG_TAG "a2dp_sbc_encoder"
+#define ATRACE_TAG ATRACE_TAG_AUDIO
 
 #include "a2dp_sbc_encoder.h"
 
+#ifndef OS_GENERIC
+#include <cutils/trace.h>
+#endif
 #include <limits.h>
 #include <stdio.h>
 #include <string.h>
+#include <algorithm>
 
 #include "a2dp_sbc.h"
 #include "a2dp_sbc_up_sample.h"
@@ -57,6 +62,20 @@
 #define A2DP_SBC_MAX_HQ_FRAME_SIZE_44_1 119
 #define A2DP_SBC_MAX_HQ_FRAME_SIZE_48 115
 
+/*
+ * Adaptive bitpool: the typical runlevel of the TX queue is ~1 packet. When
+ * the link cannot drain the queue (RF congestion), lower the bitpool before
+ * the queue overflows and gets flushed, and raise it again once the queue has
+ * stayed short for a while.
+ */
+#define A2DP_SBC_ABR_QUEUE_HIGH 3   /* packets */
+#define A2DP_SBC_ABR_QUEUE_LOW 1    /* packets */
+#define A2DP_SBC_ABR_DOWN_TICKS 2   /* ticks above high mark before lowering */
+#define A2DP_SBC_ABR_UP_TICKS 50    /* ticks at low mark before raising */
+#define A2DP_SBC_ABR_BITPOOL_STEP 4
+/* Never go below this share (in percent) of the configured bitpool */
+#define A2DP_SBC_ABR_MIN_BITPOOL_PERCENT 60
+
 /* Define the bitrate step when trying to match bitpool value */
 #define A2DP_SBC_BITRATE_STEP 5
 
@@ -111,6 +130,20 @@ typedef struct {
   tA2DP_FEEDING_PARAMS feeding_params;
   tA2DP_SBC_FEEDING_STATE feeding_state;
   int16_t pcmBuffer[SBC_MAX_PCM_BUFFER_SIZE];
+  /* PCM read from the source, and its up-sampled copy (which also keeps the
+   * residue between two reads) */
+  uint16_t read_buffer[SBC_MAX_NUM_FRAME * SBC_MAX_NUM_OF_BLOCKS *
+                       SBC_MAX_NUM_OF_CHANNELS * SBC_MAX_NUM_OF_SUBBANDS];
+  uint16_t up_sampled_buffer[SBC_MAX_NUM_FRAME * SBC_MAX_NUM_OF_BLOCKS *
+                             SBC_MAX_NUM_OF_CHANNELS *
+                             SBC_MAX_NUM_OF_SUBBANDS * 2];
+
+  size_t TxQueueLength; /* Last known length of the TX queue */
+  int16_t abr_max_bitpool; /* Bitpool selected for the codec configuration */
+  int16_t abr_min_bitpool; /* Lowest bitpool the adaptation may use */
+  uint16_t abr_high_ticks; /* Consecutive ticks above the high queue mark */
+  uint16_t abr_low_ticks;  /* Consecutive ticks at or below the low mark */
+  size_t abr_adjustments;
 
   a2dp_sbc_encoder_stats_t stats;
 } tA2DP_SBC_ENCODER_CB;
@@ -124,6 +157,7 @@ static void a2dp_sbc_encoder_update(uint16_t peer_mtu,
                                     bool* p_restart_input,
                                     bool* p_restart_output,
                                     bool* p_config_updated);
+static void a2dp_sbc_adjust_bitpool(void);
 static bool a2dp_sbc_read_feeding(uint32_t* bytes);
 static void a2dp_sbc_encode_frames(uint8_t nb_frame);
 static void a2dp_sbc_get_num_frame_iteration(uint8_t* num_of_iterations,
@@ -387,6 +421,16 @@ static void a2dp_sbc_encoder_update(uint16_t peer_mtu,
   LOG_DEBUG(LOG_TAG, "%s: final bit rate %d, final bit pool %d", __func__,
             p_encoder_params->u16BitRate, p_encoder_params->s16BitPool);
 
+  /* Let the adaptive bitpool work below the selected bitpool only */
+  a2dp_sbc_encoder_cb.abr_max_bitpool = p_encoder_params->s16BitPool;
+  a2dp_sbc_encoder_cb.abr_min_bitpool = std::min<int16_t>(
+      p_encoder_params->s16BitPool,
+      std::max<int16_t>(min_bitpool, p_encoder_params->s16BitPool *
+                                         A2DP_SBC_ABR_MIN_BITPOOL_PERCENT /
+                                         100));
+  a2dp_sbc_encoder_cb.abr_high_ticks = 0;
+  a2dp_sbc_encoder_cb.abr_low_ticks = 0;
+
   /* Reset entirely the SBC encoder */
   SBC_Encoder_Init(&a2dp_sbc_encoder_cb.sbc_encoder_params);
   a2dp_sbc_encoder_cb.tx_sbc_frames = calculate_max_frames_per_packet();
@@ -453,12 +497,55 @@ void a2dp_sbc_send_frames(uint64_t timestamp_us) {
               __func__, nb_frame, nb_iterations);
   if (nb_frame == 0) return;
 
+  a2dp_sbc_adjust_bitpool();
+
   for (uint8_t counter = 0; counter < nb_iterations; counter++) {
     // Transcode frame and enqueue
     a2dp_sbc_encode_frames(nb_frame);
   }
 }
 
+void a2dp_sbc_set_transmit_queue_length(size_t transmit_queue_length) {
+  a2dp_sbc_encoder_cb.TxQueueLength = transmit_queue_length;
+}
+
+// Adjusts the bitpool to the TX queue length, which reflects how fast the
+// link actually drains the encoded packets. SBC carries the bitpool in each
+// frame header, so it can change between frames within the negotiated range.
+static void a2dp_sbc_adjust_bitpool(void) {
+  SBC_ENC_PARAMS* p_encoder_params = &a2dp_sbc_encoder_cb.sbc_encoder_params;
+  int16_t bitpool = p_encoder_params->s16BitPool;
+
+  if (a2dp_sbc_encoder_cb.TxQueueLength >= A2DP_SBC_ABR_QUEUE_HIGH) {
+    a2dp_sbc_encoder_cb.abr_low_ticks = 0;
+    if (++a2dp_sbc_encoder_cb.abr_high_ticks < A2DP_SBC_ABR_DOWN_TICKS) return;
+    a2dp_sbc_encoder_cb.abr_high_ticks = 0;
+    bitpool = std::max<int16_t>(bitpool - A2DP_SBC_ABR_BITPOOL_STEP,
+                                a2dp_sbc_encoder_cb.abr_min_bitpool);
+  } else if (a2dp_sbc_encoder_cb.TxQueueLength <= A2DP_SBC_ABR_QUEUE_LOW) {
+    a2dp_sbc_encoder_cb.abr_high_ticks = 0;
+    if (++a2dp_sbc_encoder_cb.abr_low_ticks < A2DP_SBC_ABR_UP_TICKS) return;
+    a2dp_sbc_encoder_cb.abr_low_ticks = 0;
+    bitpool = std::min<int16_t>(bitpool + A2DP_SBC_ABR_BITPOOL_STEP,
+                                a2dp_sbc_encoder_cb.abr_max_bitpool);
+  } else {
+    a2dp_sbc_encoder_cb.abr_high_ticks = 0;
+    a2dp_sbc_encoder_cb.abr_low_ticks = 0;
+    return;
+  }
+
+  if (bitpool == p_encoder_params->s16BitPool) return;
+
+  LOG_DEBUG(LOG_TAG, "%s: TX queue length %zu, bitpool %d -> %d", __func__,
+            a2dp_sbc_encoder_cb.TxQueueLength, p_encoder_params->s16BitPool,
+            bitpool);
+  p_encoder_params->s16BitPool = bitpool;
+  a2dp_sbc_encoder_cb.abr_adjustments++;
+#ifndef OS_GENERIC
+  ATRACE_INT("SBC bitpool", bitpool);
+#endif
+}
+
 // Obtains the number of frames to send and number of iterations
 // to be used. |num_of_iterations| and |num_of_frames| parameters
 // are used as output param for returning the respective values.
@@ -645,12 +732,8 @@ static bool a2dp_sbc_read_feeding(uint32_t* bytes_read) {
   uint16_t bytes_needed = blocm_x_subband * p_encoder_params->s16NumOfChannels *
                           a2dp_sbc_encoder_cb.feeding_params.bits_per_sample /
                           8;
-  static uint16_t up_sampled_buffer[SBC_MAX_NUM_FRAME * SBC_MAX_NUM_OF_BLOCKS *
-                                    SBC_MAX_NUM_OF_CHANNELS *
-                                    SBC_MAX_NUM_OF_SUBBANDS * 2];
-  static uint16_t read_buffer[SBC_MAX_NUM_FRAME * SBC_MAX_NUM_OF_BLOCKS *
-                              SBC_MAX_NUM_OF_CHANNELS *
-                              SBC_MAX_NUM_OF_SUBBANDS];
+  uint16_t* up_sampled_buffer = a2dp_sbc_encoder_cb.up_sampled_buffer;
+  uint16_t* read_buffer = a2dp_sbc_encoder_cb.read_buffer;
   uint32_t src_size_used;
   uint32_t dst_size_used;
   bool fract_needed;
@@ -768,7 +851,7 @@ static bool a2dp_sbc_read_feeding(uint32_t* bytes_read) {
       (uint8_t*)read_buffer,
       (uint8_t*)up_sampled_buffer +
           a2dp_sbc_encoder_cb.feeding_state.aa_feed_residue,
-      nb_byte_read, sizeof(up_sampled_buffer) -
+      nb_byte_read, sizeof(a2dp_sbc_encoder_cb.up_sampled_buffer) -
                         a2dp_sbc_encoder_cb.feeding_state.aa_feed_residue,
       &src_size_used);
 
@@ -1145,4 +1228,19 @@ void A2dpCodecConfigSbc::debug_codec_dump(int fd) {
           "%zu\n",
           stats->media_read_total_expected_frames,
           stats->media_read_total_dropped_frames);
+
+  dprintf(fd,
+          "  TX queue length                                         : %zu\n",
+          a2dp_sbc_encoder_cb.TxQueueLength);
+
+  dprintf(fd,
+          "  Adaptive bitpool (current/min/max)                      : %d / "
+          "%d / %d\n",
+          a2dp_sbc_encoder_cb.sbc_encoder_params.s16BitPool,
+          a2dp_sbc_encoder_cb.abr_min_bitpool,
+          a2dp_sbc_encoder_cb.abr_max_bitpool);
+
+  dprintf(fd,
+          "  Adaptive bitpool adjustments                            : %zu\n",
+          a2dp_sbc_encoder_cb.abr_adjustments);
 }
@@ -0,0 +1,249 @@
+/*
+ * Copyright 2019 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+#include <string.h>
+
+#include <random>
+#include <vector>
+
+#include "btm_ble_host_filter.h"
+
+using ::benchmark::State;
+using bluetooth::Uuid;
+
+// Reports received per second by a busy scanner, filtered per iteration: an
+// iteration takes the share of one CPU the filter needs at that rate
+#define REPORTS_PER_SECOND 10000
+
+// Filters of the host filter
+#define NUM_FILTERS 64
+
+// Advertisers around, and the share of them the filters look for
+#define NUM_ADVERTISERS 256
+#define MATCHING_ADVERTISERS 16
+
+#define COMPANY_APPLE 0x004c
+#define UUID_EDDYSTONE 0xfeaa
+
+struct Report {
+  RawAddress bda;
+  int8_t rssi;
+  std::vector<uint8_t> data;
+};
+
+static RawAddress advertiser_address(int advertiser) {
+  return RawAddress({0xc0, 0x00, 0x00, 0x00, (uint8_t)(advertiser >> 8),
+                     (uint8_t)advertiser});
+}
+
+// The data of |advertiser|, cycling through the kinds of advertisers seen in
+// a crowded place: iBeacons, Eddystone beacons, devices listing services and
+// named devices. The filters look for the first MATCHING_ADVERTISERS.
+static std::vector<uint8_t> advertiser_data(int advertiser,
+                                            std::mt19937& rng) {
+  std::vector<uint8_t> data{0x02, 0x01, 0x06};
+  uint8_t id = advertiser < MATCHING_ADVERTISERS ? advertiser : rng();
+  switch (advertiser % 4) {
+    case 0:
+      data.insert(data.end(), {0x1a, 0xff, COMPANY_APPLE, 0x00, 0x02, 0x15});
+      for (int i = 0; i < 15; i++) data.push_back(i == 0 ? id : rng());
+      data.insert(data.end(), {0x00, 0x01, 0x00, 0x02, 0xc5});
+      break;
+    case 1:
+      data.insert(data.end(), {0x03, 0x03, 0xaa, 0xfe, 0x17, 0x16, 0xaa,
+                               0xfe, 0x00, 0xee});
+      for (int i = 0; i < 19; i++) data.push_back(i == 0 ? id : rng());
+      break;
+    case 2:
+      data.insert(data.end(), {0x07, 0x03, 0x0f, 0x18, 0x0a, 0x18});
+      data.push_back(rng());
+      data.push_back(0x18);
+      data.insert(data.end(), {0x05, 0xff, 0x06, 0x00, 0x01, id});
+      break;
+    case 3:
+      data.insert(data.end(), {0x09, 0x09, 'd', 'e', 'v', 'i', 'c', 'e'});
+      data.push_back('0' + id / 16 % 16);
+      data.push_back('0' + id % 16);
+      break;
+  }
+  return data;
+}
+
+// One second of traffic, with a fixed seed so that every run filters the same
+// reports
+static std::vector<Report> traffic() {
+  std::mt19937 rng(0x4846);
+  std::vector<std::vector<uint8_t>> data;
+  for (int i = 0; i < NUM_ADVERTISERS; i++)
+    data.push_back(advertiser_data(i, rng));
+
+  std::vector<Report> reports;
+  for (int i = 0; i < REPORTS_PER_SECOND; i++) {
+    int advertiser = rng() % NUM_ADVERTISERS;
+    reports.push_back({advertiser_address(advertiser),
+                       (int8_t)(-40 - rng() % 50), data[advertiser]});
+  }
+  return reports;
+}
+
+static ApcfCommand command(uint8_t type) {
+  ApcfCommand cmd = {};
+  cmd.type = type;
+  return cmd;
+}
+
+// The conditions of filter |index|: a mix of the conditions apps use, looking
+// for the matching advertisers and for some that are not around
+static ApcfCommand filter_condition(int index) {
+  int advertiser = index % (2 * MATCHING_ADVERTISERS);
+  uint8_t id = advertiser < MATCHING_ADVERTISERS ? advertiser : 0xf0 + index;
+  switch (index % 5) {
+    case 0: {
+      ApcfCommand cmd = command(BTM_BLE_PF_MANU_DATA);
+      cmd.company = COMPANY_APPLE;
+      cmd.data = {0x02, 0x15, id};
+      cmd.data_mask = {0xff, 0xff, 0xff};
+      return cmd;
+    }
+    case 1: {
+      ApcfCommand cmd = command(BTM_BLE_PF_SRVC_DATA_PATTERN);
+      cmd.data = {0xaa, 0xfe, 0x00, 0xee, id};
+      cmd.data_mask = {0xff, 0xff, 0xff, 0xff, 0xff};
+      return cmd;
+    }
+    case 2: {
+      ApcfCommand cmd = command(BTM_BLE_PF_SRVC_UUID);
+      cmd.uuid = Uuid::From16Bit(0x1800 + index);
+      return cmd;
+    }
+    case 3: {
+      ApcfCommand cmd = command(BTM_BLE_PF_LOCAL_NAME);
+      cmd.name = {'d', 'e', 'v', 'i', 'c', 'e', (uint8_t)('0' + id / 16 % 16),
+                  (uint8_t)('0' + id % 16)};
+      return cmd;
+    }
+    default: {
+      ApcfCommand cmd = command(BTM_BLE_PF_ADDR_FILTER);
+      cmd.address = advertiser_address(advertiser);
+      return cmd;
+    }
+  }
+}
+
+static void set_up_filters(BleHostFilter* p_filter) {
+  for (int i = 0; i < NUM_FILTERS; i++) {
+    ApcfCommand cmd = filter_condition(i);
+    btgatt_filt_param_setup_t params = {};
+    params.feat_seln = 1 << cmd.type;
+    params.rssi_high_thres = (uint8_t)-127;
+    p_filter->AddConditions(i, {cmd});
+    p_filter->SetFilter(i, params);
+  }
+  p_filter->Enable(true);
+}
+
+// Checks every filter in turn, looking for its condition in the data, the way
+// the filters are matched one by one when they are not compiled
+static bool matches_one_by_one(const std::vector<ApcfCommand>& filters,
+                               const Report& report) {
+  for (const ApcfCommand& cmd : filters) {
+    if (cmd.type == BTM_BLE_PF_ADDR_FILTER) {
+      if (cmd.address == report.bda) return true;
+      continue;
+    }
+
+    const std::vector<uint8_t>& data = report.data;
+    for (size_t pos = 0; pos + 1 < data.size(); pos += data[pos] + 1) {
+      uint8_t ad_len = data[pos];
+      if (ad_len == 0 || pos + 1 + ad_len > data.size()) break;
+      uint8_t ad_type = data[pos + 1];
+      const uint8_t* p_value = &data[pos + 2];
+      size_t len = ad_len - 1;
+
+      if (cmd.type == BTM_BLE_PF_SRVC_UUID &&
+          ad_type == BT_EIR_COMPLETE_16BITS_UUID_TYPE) {
+        for (size_t i = 0; i + 1 < len; i += 2) {
+          if (Uuid::From16Bit(p_value[i] | (p_value[i + 1] << 8)) == cmd.uuid)
+            return true;
+        }
+      } else if (cmd.type == BTM_BLE_PF_LOCAL_NAME &&
+                 ad_type == BT_EIR_COMPLETE_LOCAL_NAME_TYPE) {
+        if (len == cmd.name.size() &&
+            memcmp(p_value, cmd.name.data(), len) == 0)
+          return true;
+      } else if ((cmd.type == BTM_BLE_PF_MANU_DATA &&
+                  ad_type == BT_EIR_MANUFACTURER_SPECIFIC_TYPE) ||
+                 (cmd.type == BTM_BLE_PF_SRVC_DATA_PATTERN &&
+                  ad_type == BT_EIR_SERVICE_DATA_16BITS_UUID_TYPE)) {
+        std::vector<uint8_t> pattern;
+        if (cmd.type == BTM_BLE_PF_MANU_DATA)
+          pattern = {(uint8_t)cmd.company, (uint8_t)(cmd.company >> 8)};
+        pattern.insert(pattern.end(), cmd.data.begin(), cmd.data.end());
+        if (len >= pattern.size() &&
+            memcmp(p_value, pattern.data(), pattern.size()) == 0)
+          return true;
+      }
+    }
+  }
+  return false;
+}
+
+static void BM_HostFilterOneByOne(State& state) {
+  std::vector<Report> reports = traffic();
+  std::vector<ApcfCommand> filters;
+  for (int i = 0; i < NUM_FILTERS; i++) filters.push_back(filter_condition(i));
+
+  size_t matched = 0;
+  for (auto _ : state) {
+    for (const Report& report : reports)
+      matched += matches_one_by_one(filters, report);
+  }
+  benchmark::DoNotOptimize(matched);
+  state.counters["matched"] = matched / state.iterations();
+  state.SetItemsProcessed(state.iterations() * reports.size());
+}
+BENCHMARK(BM_HostFilterOneByOne);
+
+static void BM_HostFilterCompiled(State& state) {
+  std::vector<Report> reports = traffic();
+  BleHostFilter filter;
+  set_up_filters(&filter);
+
+  size_t matched = 0;
+  for (auto _ : state) {
+    for (const Report& report : reports) {
+      matched += filter.Matches(report.bda, report.rssi, report.data.data(),
+                                report.data.size());
+    }
+  }
+  benchmark::DoNotOptimize(matched);
+  state.counters["matched"] = matched / state.iterations();
+  state.SetItemsProcessed(state.iterations() * reports.size());
+}
+BENCHMARK(BM_HostFilterCompiled);
+
+// Setting the filters up again, as when an app starts or stops scanning
+static void BM_HostFilterCompile(State& state) {
+  for (auto _ : state) {
+    BleHostFilter filter;
+    set_up_filters(&filter);
+    benchmark::DoNotOptimize(filter);
+  }
+}
+BENCHMARK(BM_HostFilterCompile);
+
+BENCHMARK_MAIN();
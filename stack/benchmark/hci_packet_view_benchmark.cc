@@ -0,0 +1,270 @@
+/*
+ * Copyright 2019 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+#include <string.h>
+
+#include <random>
+#include <vector>
+
+#include "bt_types.h"
+#include "hci_packet_view.h"
+#include "hcimsgs.h"
+
+using ::benchmark::State;
+
+// Events of each kind parsed per iteration
+#define NUM_EVENTS 256
+
+// Connections in a Number Of Completed Packets event
+#define NUM_COMPLETED_HANDLES 4
+
+// Reports in an advertising report event, and the data of each of them
+#define NUM_REPORTS 3
+#define ADV_DATA_LEN 31
+
+typedef std::vector<std::vector<uint8_t>> Events;
+
+static Events number_of_completed_packets_events() {
+  Events events;
+  for (int i = 0; i < NUM_EVENTS; i++) {
+    std::vector<uint8_t> event(1 + NUM_COMPLETED_HANDLES * 4);
+    HciPacketBuilder builder(event.data(), event.size());
+    builder.Append<uint8_t>(NUM_COMPLETED_HANDLES);
+    for (int h = 0; h < NUM_COMPLETED_HANDLES; h++) {
+      builder.Append<uint16_t>(0x0040 + h).Append<uint16_t>(1 + (i + h) % 3);
+    }
+    events.push_back(event);
+  }
+  return events;
+}
+
+// Reports of random advertisers, with a fixed seed so that every run parses
+// the same traffic.
+static Events advertising_report_events(bool extended) {
+  std::mt19937 rng(0x4144);
+  Events events;
+  uint8_t data[ADV_DATA_LEN];
+  for (int i = 0; i < NUM_EVENTS; i++) {
+    size_t report_size = extended ? 24 : 10;
+    std::vector<uint8_t> event(1 + NUM_REPORTS * (report_size + ADV_DATA_LEN));
+    HciPacketBuilder builder(event.data(), event.size());
+    builder.Append<uint8_t>(NUM_REPORTS);
+    for (int r = 0; r < NUM_REPORTS; r++) {
+      RawAddress bda;
+      for (uint8_t& b : bda.address) b = rng();
+      for (uint8_t& b : data) b = rng();
+      int8_t rssi = -40 - rng() % 50;
+      if (extended) {
+        builder.Append<uint16_t>(0x0013)
+            .Append<uint8_t>(BLE_ADDR_RANDOM)
+            .AppendAddress(bda)
+            .Append<uint8_t>(PHY_LE_1M)
+            .Append<uint8_t>(PHY_LE_NO_PACKET)
+            .Append<uint8_t>(NO_ADI_PRESENT)
+            .Append<int8_t>(TX_POWER_NOT_PRESENT)
+            .Append<int8_t>(rssi)
+            .Append<uint16_t>(0)
+            .Append<uint8_t>(0)
+            .AppendAddress(RawAddress::kEmpty)
+            .Append<uint8_t>(ADV_DATA_LEN)
+            .AppendBytes(data, ADV_DATA_LEN);
+      } else {
+        builder.Append<uint8_t>(0x00)
+            .Append<uint8_t>(BLE_ADDR_RANDOM)
+            .AppendAddress(bda)
+            .Append<uint8_t>(ADV_DATA_LEN)
+            .AppendBytes(data, ADV_DATA_LEN)
+            .Append<int8_t>(rssi);
+      }
+    }
+    events.push_back(event);
+  }
+  return events;
+}
+
+static size_t total_size(const Events& events) {
+  size_t bytes = 0;
+  for (const std::vector<uint8_t>& event : events) bytes += event.size();
+  return bytes;
+}
+
+// Parses the events the way l2c_link_process_num_completed_pkts() did before
+// it used the views: with the STREAM macros, checking the length up front.
+static void BM_NumberOfCompletedPacketsStream(State& state) {
+  Events events = number_of_completed_packets_events();
+  for (auto _ : state) {
+    for (const std::vector<uint8_t>& event : events) {
+      uint8_t* p = (uint8_t*)event.data();
+      uint8_t num_handles;
+      uint16_t handle, num_sent;
+      uint32_t sent = 0;
+      STREAM_TO_UINT8(num_handles, p);
+      if (1 + num_handles * 4 > (int)event.size()) continue;
+      for (int i = 0; i < num_handles; i++) {
+        STREAM_TO_UINT16(handle, p);
+        STREAM_TO_UINT16(num_sent, p);
+        handle = HCID_GET_HANDLE(handle);
+        sent += handle + num_sent;
+      }
+      benchmark::DoNotOptimize(sent);
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * events.size());
+  state.SetBytesProcessed(state.iterations() * total_size(events));
+}
+BENCHMARK(BM_NumberOfCompletedPacketsStream);
+
+static void BM_NumberOfCompletedPacketsView(State& state) {
+  Events events = number_of_completed_packets_events();
+  for (auto _ : state) {
+    for (const std::vector<uint8_t>& event : events) {
+      HciNumberOfCompletedPacketsView nocp(
+          HciPacketView(event.data(), event.size()));
+      uint32_t sent = 0;
+      if (!nocp.IsValid()) continue;
+      uint8_t num_handles = nocp.GetNumHandles();
+      for (int i = 0; i < num_handles; i++) {
+        sent += nocp.GetHandle(i) + nocp.GetCompleted(i);
+      }
+      benchmark::DoNotOptimize(sent);
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * events.size());
+  state.SetBytesProcessed(state.iterations() * total_size(events));
+}
+BENCHMARK(BM_NumberOfCompletedPacketsView);
+
+// Parses the events the way btm_ble_process_adv_pkt() did before it used the
+// views: with the STREAM macros, checking every report against the end of the
+// event.
+static void BM_LeAdvertisingReportStream(State& state) {
+  Events events = advertising_report_events(false);
+  for (auto _ : state) {
+    for (const std::vector<uint8_t>& event : events) {
+      uint8_t* p = (uint8_t*)event.data();
+      uint8_t* end = p + event.size();
+      uint8_t num_reports;
+      STREAM_TO_UINT8(num_reports, p);
+      while (num_reports--) {
+        if (p + 9 > end) break;
+        uint8_t evt_type, addr_type, pkt_data_len;
+        RawAddress bda;
+        int8_t rssi;
+        STREAM_TO_UINT8(evt_type, p);
+        STREAM_TO_UINT8(addr_type, p);
+        STREAM_TO_BDADDR(bda, p);
+        STREAM_TO_UINT8(pkt_data_len, p);
+        uint8_t* pkt_data = p;
+        p += pkt_data_len;
+        if (p + 1 > end) break;
+        STREAM_TO_INT8(rssi, p);
+        benchmark::DoNotOptimize(evt_type);
+        benchmark::DoNotOptimize(addr_type);
+        benchmark::DoNotOptimize(bda);
+        benchmark::DoNotOptimize(pkt_data);
+        benchmark::DoNotOptimize(rssi);
+      }
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * events.size() * NUM_REPORTS);
+  state.SetBytesProcessed(state.iterations() * total_size(events));
+}
+BENCHMARK(BM_LeAdvertisingReportStream);
+
+static void BM_LeAdvertisingReportView(State& state) {
+  Events events = advertising_report_events(false);
+  HciAdvertisingReport report;
+  for (auto _ : state) {
+    for (const std::vector<uint8_t>& event : events) {
+      HciLeAdvertisingReportView reports(
+          HciPacketView(event.data(), event.size()));
+      while (reports.Next(&report)) benchmark::DoNotOptimize(report);
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * events.size() * NUM_REPORTS);
+  state.SetBytesProcessed(state.iterations() * total_size(events));
+}
+BENCHMARK(BM_LeAdvertisingReportView);
+
+// Parses the events the way btm_ble_process_ext_adv_pkt() did before it used
+// the views.
+static void BM_LeExtendedAdvertisingReportStream(State& state) {
+  Events events = advertising_report_events(true);
+  for (auto _ : state) {
+    for (const std::vector<uint8_t>& event : events) {
+      uint8_t* p = (uint8_t*)event.data();
+      uint8_t* end = p + event.size();
+      uint8_t num_reports;
+      STREAM_TO_UINT8(num_reports, p);
+      while (num_reports--) {
+        if (p + 24 > end) break;
+        uint16_t event_type, periodic_adv_int;
+        uint8_t addr_type, primary_phy, secondary_phy, advertising_sid;
+        uint8_t direct_address_type, pkt_data_len;
+        int8_t rssi, tx_power;
+        RawAddress bda, direct_address;
+        STREAM_TO_UINT16(event_type, p);
+        STREAM_TO_UINT8(addr_type, p);
+        STREAM_TO_BDADDR(bda, p);
+        STREAM_TO_UINT8(primary_phy, p);
+        STREAM_TO_UINT8(secondary_phy, p);
+        STREAM_TO_UINT8(advertising_sid, p);
+        STREAM_TO_INT8(tx_power, p);
+        STREAM_TO_INT8(rssi, p);
+        STREAM_TO_UINT16(periodic_adv_int, p);
+        STREAM_TO_UINT8(direct_address_type, p);
+        STREAM_TO_BDADDR(direct_address, p);
+        STREAM_TO_UINT8(pkt_data_len, p);
+        uint8_t* pkt_data = p;
+        p += pkt_data_len;
+        if (p > end) break;
+        benchmark::DoNotOptimize(event_type);
+        benchmark::DoNotOptimize(addr_type);
+        benchmark::DoNotOptimize(bda);
+        benchmark::DoNotOptimize(primary_phy);
+        benchmark::DoNotOptimize(secondary_phy);
+        benchmark::DoNotOptimize(advertising_sid);
+        benchmark::DoNotOptimize(tx_power);
+        benchmark::DoNotOptimize(rssi);
+        benchmark::DoNotOptimize(periodic_adv_int);
+        benchmark::DoNotOptimize(direct_address_type);
+        benchmark::DoNotOptimize(direct_address);
+        benchmark::DoNotOptimize(pkt_data);
+      }
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * events.size() * NUM_REPORTS);
+  state.SetBytesProcessed(state.iterations() * total_size(events));
+}
+BENCHMARK(BM_LeExtendedAdvertisingReportStream);
+
+static void BM_LeExtendedAdvertisingReportView(State& state) {
+  Events events = advertising_report_events(true);
+  HciAdvertisingReport report;
+  for (auto _ : state) {
+    for (const std::vector<uint8_t>& event : events) {
+      HciLeExtendedAdvertisingReportView reports(
+          HciPacketView(event.data(), event.size()));
+      while (reports.Next(&report)) benchmark::DoNotOptimize(report);
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * events.size() * NUM_REPORTS);
+  state.SetBytesProcessed(state.iterations() * total_size(events));
+}
+BENCHMARK(BM_LeExtendedAdvertisingReportView);
+
+BENCHMARK_MAIN();
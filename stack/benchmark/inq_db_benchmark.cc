@@ -0,0 +1,106 @@
+/*
+ * Copyright 2019 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+#include <string.h>
+#include <vector>
+
+#include "btm_int.h"
+#include "types/raw_address.h"
+
+using ::benchmark::State;
+
+// Distinct advertisers seen during one scan in a crowded venue
+#define NUM_ADVERTISERS 5000
+
+// Advertisers that keep reporting while the scan is running
+#define NUM_NEARBY_ADVERTISERS 64
+
+// Runs the inquiry database part of btm_ble_process_adv_pkt_cont() for every
+// report, without the HCI parsing and the scan result callbacks.
+static void process_adv_report(const RawAddress& bda) {
+  tBTM_INQUIRY_VAR_ST* p_inq = &btm_cb.btm_inq_vars;
+  tINQ_DB_ENT* p_i = btm_inq_db_find(bda);
+
+  /* Already reported in this inquiry as an LE device with a scan response */
+  if (btm_inq_find_bdaddr(bda, BT_DEVICE_TYPE_BLE) && p_i &&
+      (p_i->inq_info.results.device_type & BT_DEVICE_TYPE_BLE) && p_i->scan_rsp)
+    return;
+
+  if (p_i == NULL) {
+    p_i = btm_inq_db_new(bda, false);
+    p_inq->inq_cmpl_info.num_resp++;
+  } else if (p_i->inq_count != p_inq->inq_counter) {
+    p_inq->inq_cmpl_info.num_resp++;
+  }
+
+  btm_inq_db_update_resp_time(p_i);
+  p_i->inq_info.results.device_type |= BT_DEVICE_TYPE_BLE;
+  p_i->scan_rsp = true;
+  p_i->inq_count = p_inq->inq_counter;
+}
+
+class BM_InqDb : public ::benchmark::Fixture {
+ protected:
+  void SetUp(State& st) override {
+    ::benchmark::Fixture::SetUp(st);
+    memset(&btm_cb, 0, sizeof(btm_cb));
+    btm_inq_db_init();
+
+    // Same state as a general inquiry with duplicate filtering
+    btm_cb.btm_inq_vars.inq_active = BTM_GENERAL_INQUIRY;
+    btm_cb.btm_inq_vars.inq_counter = 1;
+    btm_cb.btm_inq_vars.max_bd_entries = 1024;
+
+    for (uint32_t i = 0; i < NUM_ADVERTISERS; i++) {
+      RawAddress bda;
+      bda.address[0] = 0xc0;
+      bda.address[1] = 0x01;
+      bda.address[2] = (i >> 24) & 0xff;
+      bda.address[3] = (i >> 16) & 0xff;
+      bda.address[4] = (i >> 8) & 0xff;
+      bda.address[5] = i & 0xff;
+      advertisers_.push_back(bda);
+    }
+  }
+
+  void TearDown(State& st) override {
+    btm_inq_db_free();
+    ::benchmark::Fixture::TearDown(st);
+  }
+
+  std::vector<RawAddress> advertisers_;
+};
+
+BENCHMARK_F(BM_InqDb, distinct_advertisers)(State& state) {
+  for (auto _ : state) {
+    // Each pass is a new inquiry, so every report goes to the database
+    btm_cb.btm_inq_vars.inq_counter++;
+    for (const RawAddress& bda : advertisers_) process_adv_report(bda);
+  }
+  state.SetItemsProcessed(state.iterations() * NUM_ADVERTISERS);
+};
+
+BENCHMARK_F(BM_InqDb, repeated_reports)(State& state) {
+  for (auto _ : state) {
+    btm_cb.btm_inq_vars.inq_counter++;
+    for (int i = 0; i < NUM_ADVERTISERS; i++)
+      process_adv_report(advertisers_[i % NUM_NEARBY_ADVERTISERS]);
+  }
+  state.SetItemsProcessed(state.iterations() * NUM_ADVERTISERS);
+};
+
+BENCHMARK_MAIN();
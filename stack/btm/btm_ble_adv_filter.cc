@@ -23,6 +23,7 @@
 #include "bt_types.h"
 #include "bt_utils.h"
 #include "btm_ble_api.h"
+#include "btm_ble_host_filter.h"
 #include "btm_int.h"
 #include "btu.h"
 #include "device/include/controller.h"
@@ -58,6 +59,9 @@ using bluetooth::Uuid;
 tBTM_BLE_ADV_FILTER_CB btm_ble_adv_filt_cb;
 tBTM_BLE_VSC_CB cmn_ble_vsc_cb;
 
+/* Filters applied by the host when the controller doesn't support APCF */
+static BleHostFilter btm_ble_host_filter;
+
 static uint8_t btm_ble_cs_update_pf_counter(tBTM_BLE_SCAN_COND_OP action,
                                             uint8_t cond_type,
                                             tBLE_BD_ADDR* p_bd_addr,
@@ -710,11 +714,77 @@ void BTM_LE_PF_group_filter(tBTM_BLE_SCAN_COND_OP action,
 static std::unordered_map<tBTM_BLE_PF_FILT_INDEX, RawAddress>
     remove_me_later_map;
 
+/* Removes the record kept for the IRK of filter |filt_index|, unless the
+ * device got bonded meanwhile. Returns false if the device couldn't be
+ * removed because it is connected. */
+static bool btm_ble_pf_remove_irk(tBTM_BLE_PF_FILT_INDEX filt_index) {
+  auto entry = remove_me_later_map.find(filt_index);
+  if (entry != remove_me_later_map.end()) {
+    LOG_WARN(LOG_TAG, "Replacing existing filter index entry with new address");
+    // If device is not bonded, then try removing the device
+    // If the device doesn't get removed then it is currently connected
+    // (may be pairing?) If we do delete the device we want to erase the
+    // filter index so we can replace it If the device is bonded, we
+    // want to erase the filter index so we don't delete it in the later
+    // BTM_LE_PF_clear call.
+    if (!btm_sec_is_a_bonded_dev(entry->second)) {
+      if (!BTM_SecDeleteDevice(entry->second)) {
+        LOG_WARN(LOG_TAG, "Unable to remove device, still connected.");
+        return false;
+      }
+    }
+    remove_me_later_map.erase(filt_index);
+  }
+  return true;
+}
+
+/* Adds the IRK of an address filter to the security database, so that the
+ * resolvable private addresses of the device are resolved, and keeps track
+ * of the record to remove it with the filter. Returns false if the record
+ * couldn't be set up. */
+static bool btm_ble_pf_add_irk(tBTM_BLE_PF_FILT_INDEX filt_index,
+                               const ApcfCommand& cmd) {
+  // Save index and addr
+  if (!btm_ble_pf_remove_irk(filt_index)) return false;
+  if (btm_find_dev(cmd.address) != nullptr) {
+    // Unless the user tries to bond with a device in between the
+    // scanner app starting a scan, then crashing, then being restarted
+    // and we get to this same point with the same filt_index (whose
+    // value is managed by the Java layer) then we might have a device
+    // record here, in which case something else is managing the device
+    // and we do not want to interfere with that experience.
+    LOG_WARN(LOG_TAG, "Address record already exists...this is unexpected...");
+    return false;
+  }
+  // Allocate a new "temporary" device record
+  btm_sec_alloc_dev(cmd.address);
+  remove_me_later_map.emplace(filt_index, cmd.address);
+  // Set the IRK
+  tBTM_LE_PID_KEYS pid_keys;
+  pid_keys.irk = cmd.irk;
+  pid_keys.identity_addr_type = cmd.addr_type;
+  pid_keys.identity_addr = cmd.address;
+  // Add it to the union to pass to SecAddBleKey
+  tBTM_LE_KEY_VALUE le_key;
+  le_key.pid_key = pid_keys;
+  BTM_SecAddBleKey(cmd.address, &le_key, BTM_LE_KEY_PID);
+  return true;
+}
+
 void BTM_LE_PF_set(tBTM_BLE_PF_FILT_INDEX filt_index,
                    std::vector<ApcfCommand> commands,
                    tBTM_BLE_PF_CFG_CBACK cb) {
   if (!is_filtering_supported()) {
-    cb.Run(0, BTM_BLE_PF_ENABLE, 1 /* BTA_FAILURE */);
+    if (!btm_ble_host_filter.AddConditions(filt_index, commands)) {
+      cb.Run(0, BTM_BLE_PF_ENABLE, 1 /* BTA_FAILURE */);
+      return;
+    }
+    for (const ApcfCommand& cmd : commands) {
+      if (cmd.type == BTM_BLE_PF_ADDR_FILTER && !is_empty_128bit(cmd.irk) &&
+          !btm_ble_pf_add_irk(filt_index, cmd))
+        return;
+    }
+    cb.Run(0, 0, 0);
     return;
   }
 
@@ -745,48 +815,8 @@ void BTM_LE_PF_set(tBTM_BLE_PF_FILT_INDEX filt_index,
         BTM_ReadDevScanInfo(target_addr.bda, &dev_type, &target_addr.type);
         BTM_LE_PF_addr_filter(action, filt_index, target_addr,
                               base::DoNothing());
-        if (!is_empty_128bit(cmd.irk)) {
-          // Save index and addr
-          auto entry = remove_me_later_map.find(filt_index);
-          if (entry != remove_me_later_map.end()) {
-            LOG_WARN(LOG_TAG, "Replacing existing filter index entry with new address");
-            // If device is not bonded, then try removing the device
-            // If the device doesn't get removed then it is currently connected
-            // (may be pairing?) If we do delete the device we want to erase the
-            // filter index so we can replace it If the device is bonded, we
-            // want to erase the filter index so we don't delete it in the later
-            // BTM_LE_PF_clear call.
-            if (!btm_sec_is_a_bonded_dev(entry->second)) {
-              if (!BTM_SecDeleteDevice(entry->second)) {
-                LOG_WARN(LOG_TAG, "Unable to remove device, still connected.");
-                return;
-              }
-            }
-            remove_me_later_map.erase(filt_index);
-          }
-          if (btm_find_dev(cmd.address) != nullptr) {
-            // Unless the user tries to bond with a device in between the
-            // scanner app starting a scan, then crashing, then being restarted
-            // and we get to this same point with the same filt_index (whose
-            // value is managed by the Java layer) then we might have a device
-            // record here, in which case something else is managing the device
-            // and we do not want to interfere with that experience.
-            LOG_WARN(LOG_TAG, "Address record already exists...this is unexpected...");
-            return;
-          }
-          // Allocate a new "temporary" device record
-          btm_sec_alloc_dev(cmd.address);
-          remove_me_later_map.emplace(filt_index, cmd.address);
-          // Set the IRK
-          tBTM_LE_PID_KEYS pid_keys;
-          pid_keys.irk = cmd.irk;
-          pid_keys.identity_addr_type = cmd.addr_type;
-          pid_keys.identity_addr = cmd.address;
-          // Add it to the union to pass to SecAddBleKey
-          tBTM_LE_KEY_VALUE le_key;
-          le_key.pid_key = pid_keys;
-          BTM_SecAddBleKey(cmd.address, &le_key, BTM_LE_KEY_PID);
-        }
+        if (!is_empty_128bit(cmd.irk) && !btm_ble_pf_add_irk(filt_index, cmd))
+          return;
         break;
       }
 
@@ -847,7 +877,13 @@ void BTM_LE_PF_set(tBTM_BLE_PF_FILT_INDEX filt_index,
 void BTM_LE_PF_clear(tBTM_BLE_PF_FILT_INDEX filt_index,
                      tBTM_BLE_PF_CFG_CBACK cb) {
   if (!is_filtering_supported()) {
-    cb.Run(0, BTM_BLE_PF_ENABLE, 1 /* BTA_FAILURE */);
+    btm_ble_host_filter.ClearConditions(filt_index);
+    auto entry = remove_me_later_map.find(filt_index);
+    if (entry != remove_me_later_map.end() &&
+        !btm_sec_is_a_bonded_dev(entry->second))
+      BTM_SecDeleteDevice(entry->second);
+    cb.Run(btm_ble_host_filter.GetAvailableSpace(), BTM_BLE_SCAN_COND_CLEAR,
+           0);
     return;
   }
 
@@ -940,7 +976,19 @@ void BTM_BleAdvFilterParamSetup(
   uint8_t param[len], *p;
 
   if (!is_filtering_supported()) {
-    cb.Run(0, BTM_BLE_PF_ENABLE, 1 /* BTA_FAILURE */);
+    if (BTM_BLE_SCAN_COND_ADD == action) {
+      if (!p_filt_params ||
+          !btm_ble_host_filter.SetFilter(filt_index, *p_filt_params)) {
+        cb.Run(0, BTM_BLE_PF_ENABLE, 1 /* BTA_FAILURE */);
+        return;
+      }
+    } else if (BTM_BLE_SCAN_COND_DELETE == action) {
+      btm_ble_host_filter.DeleteFilter(filt_index);
+      btm_ble_pf_remove_irk(filt_index);
+    } else if (BTM_BLE_SCAN_COND_CLEAR == action) {
+      btm_ble_host_filter.DeleteAllFilters();
+    }
+    cb.Run(btm_ble_host_filter.GetAvailableSpace(), action, 0);
     return;
   }
 
@@ -1010,24 +1058,7 @@ void BTM_BleAdvFilterParamSetup(
         (uint8_t)(BTM_BLE_ADV_FILT_META_HDR_LENGTH),
         base::Bind(&btm_flt_update_cb, BTM_BLE_META_PF_FEAT_SEL, cb));
 
-    auto entry = remove_me_later_map.find(filt_index);
-    if (entry != remove_me_later_map.end()) {
-      LOG_WARN(LOG_TAG, "Replacing existing filter index entry with new address");
-      // If device is not bonded, then try removing the device
-      // If the device doesn't get removed then it is currently connected
-      // (may be pairing?) If we do delete the device we want to erase the
-      // filter index so we can replace it If the device is bonded, we
-      // want to erase the filter index so we don't delete it in the later
-      // BTM_LE_PF_clear call.
-      if (!btm_sec_is_a_bonded_dev(entry->second)) {
-        if (!BTM_SecDeleteDevice(entry->second)) {
-          LOG_WARN(LOG_TAG, "Unable to remove device, still connected.");
-          return;
-        }
-      }
-      remove_me_later_map.erase(filt_index);
-    }
-
+    btm_ble_pf_remove_irk(filt_index);
   } else if (BTM_BLE_SCAN_COND_CLEAR == action) {
     /* Deallocate all filters here */
     btm_ble_dealloc_addr_filter_counter(NULL, BTM_BLE_PF_TYPE_ALL);
@@ -1077,7 +1108,8 @@ void enable_cmpl_cback(tBTM_BLE_PF_STATUS_CBACK p_stat_cback, uint8_t* p,
 void BTM_BleEnableDisableFilterFeature(uint8_t enable,
                                        tBTM_BLE_PF_STATUS_CBACK p_stat_cback) {
   if (!is_filtering_supported()) {
-    if (p_stat_cback) p_stat_cback.Run(BTM_BLE_PF_ENABLE, 1 /* BTA_FAILURE */);
+    btm_ble_host_filter.Enable(enable != 0);
+    if (p_stat_cback) p_stat_cback.Run(enable, BTM_SUCCESS);
     return;
   }
 
@@ -1093,6 +1125,22 @@ void BTM_BleEnableDisableFilterFeature(uint8_t enable,
                             base::Bind(&enable_cmpl_cback, p_stat_cback));
 }
 
+/*******************************************************************************
+ *
+ * Function         BTM_BleMaxAdvFilterSupported
+ *
+ * Description      This function returns the number of filter indexes the
+ *                  upper layers can set up. Without APCF in the controller,
+ *                  those are the indexes of the host filter.
+ *
+ * Returns          number of filters
+ *
+ ******************************************************************************/
+uint8_t BTM_BleMaxAdvFilterSupported(void) {
+  if (is_filtering_supported()) return cmn_ble_vsc_cb.max_filter;
+  return BTM_BLE_HOST_FILTER_MAX;
+}
+
 /*******************************************************************************
  *
  * Function         btm_ble_adv_filter_init
@@ -1130,4 +1178,38 @@ void btm_ble_adv_filter_init(void) {
  ******************************************************************************/
 void btm_ble_adv_filter_cleanup(void) {
   osi_free_and_reset((void**)&btm_ble_adv_filt_cb.p_addr_filter_count);
+  btm_ble_host_filter.Reset();
+}
+
+/*******************************************************************************
+ *
+ * Function         btm_ble_adv_filter_host_enabled
+ *
+ * Description      This function tells whether the host filters the
+ *                  advertising reports, in place of a controller without APCF
+ *
+ * Returns          true if the reports go through the host filter
+ *
+ ******************************************************************************/
+bool btm_ble_adv_filter_host_enabled(void) {
+  return btm_ble_host_filter.IsEnabled();
+}
+
+/*******************************************************************************
+ *
+ * Function         btm_ble_adv_filter_host_match
+ *
+ * Description      This function matches advertising data against the host
+ *                  filters
+ *
+ * Parameters       bda - address of the advertiser, after resolution
+ *                  rssi - RSSI of the report
+ *                  p_data, len - advertising data
+ *
+ * Returns          true if the report passes the filters
+ *
+ ******************************************************************************/
+bool btm_ble_adv_filter_host_match(const RawAddress& bda, int8_t rssi,
+                                   const uint8_t* p_data, size_t len) {
+  return btm_ble_host_filter.Matches(bda, rssi, p_data, len);
 }
@@ -40,6 +40,7 @@
 #include "btu.h"
 #include "device/include/controller.h"
 #include "gap_api.h"
+#include "hci_packet_view.h"
 #include "hcimsgs.h"
 #include "stack_config.h"
 #include "osi/include/osi.h"
@@ -105,6 +106,13 @@ class AdvertisingCache {
     return items.front().data;
   }
 
+  /* Returns the data kept for device |addr_type, addr|, NULL if there is
+   * none */
+  const std::vector<uint8_t>* Get(uint8_t addr_type, const RawAddress& addr) {
+    auto it = Find(addr_type, addr);
+    return it != items.end() ? &it->data : NULL;
+  }
+
   /* Clear data for device |addr_type, addr| */
   void Clear(uint8_t addr_type, const RawAddress& addr) {
     auto it = Find(addr_type, addr);
@@ -225,7 +233,7 @@ static void btm_ble_process_adv_pkt_cont(
     uint16_t evt_type, uint8_t addr_type, const RawAddress& bda,
     uint8_t primary_phy, uint8_t secondary_phy, uint8_t advertising_sid,
     int8_t tx_power, int8_t rssi, uint16_t periodic_adv_int, uint8_t data_len,
-    uint8_t* data, const RawAddress& original_bda);
+    const uint8_t* data, const RawAddress& original_bda);
 static uint8_t btm_set_conn_mode_adv_init_addr(tBTM_BLE_INQ_CB* p_cb,
                                                RawAddress& p_peer_addr_ptr,
                                                tBLE_ADDR_TYPE* p_peer_addr_type,
@@ -473,13 +481,16 @@ void BTM_BleUpdateAdvFilterPolicy(tBTM_BLE_AFP adv_policy) {
  *
  * Parameters       start: start or stop observe.
  *                  white_list: use white list in observer mode or not.
+ *                  p_batch_end_cb: called, if not NULL, after the results
+ *                  of each advertising report event were reported.
  *
  * Returns          void
  *
  ******************************************************************************/
 tBTM_STATUS BTM_BleObserve(bool start, uint8_t duration,
                            tBTM_INQ_RESULTS_CB* p_results_cb,
-                           tBTM_CMPL_CB* p_cmpl_cb) {
+                           tBTM_CMPL_CB* p_cmpl_cb,
+                           tBTM_INQ_BATCH_END_CB* p_batch_end_cb) {
   tBTM_BLE_INQ_CB* p_inq = &btm_cb.ble_ctr_cb.inq_var;
   tBTM_STATUS status = BTM_WRONG_MODE;
   uint8_t i=0;
@@ -514,6 +525,7 @@ tBTM_STATUS BTM_BleObserve(bool start, uint8_t duration,
 
     btm_cb.ble_ctr_cb.p_obs_results_cb = p_results_cb;
     btm_cb.ble_ctr_cb.p_obs_cmpl_cb = p_cmpl_cb;
+    btm_cb.ble_ctr_cb.p_obs_batch_end_cb = p_batch_end_cb;
     status = BTM_CMD_STARTED;
 
     /* scan is not started */
@@ -2632,13 +2644,13 @@ void btm_clear_all_pending_le_entry(void) {
   uint16_t xx;
   tINQ_DB_ENT* p_ent = btm_cb.btm_inq_vars.inq_db;
 
-  for (xx = 0; xx < BTM_INQ_DB_SIZE; xx++, p_ent++) {
+  for (xx = 0; xx < btm_cb.btm_inq_vars.inq_db_size; xx++, p_ent++) {
     /* mark all pending LE entry as unused if an LE only device has scan
      * response outstanding */
     if ((p_ent->in_use) &&
         (p_ent->inq_info.results.device_type == BT_DEVICE_TYPE_BLE) &&
         !p_ent->scan_rsp)
-      p_ent->in_use = false;
+      btm_inq_db_release(p_ent);
   }
 }
 
@@ -2668,86 +2680,153 @@ void btm_ble_process_adv_addr(RawAddress& bda, uint8_t* addr_type) {
 #endif
 }
 
+namespace {
+
+/* A report of the advertising report event being processed, with the address
+ * it was received from before resolution */
+struct AdvBatchReport {
+  HciAdvertisingReport report;
+  RawAddress original_bda;
+  uint8_t original_addr_type;
+};
+
+/* Reports of the event being processed, kept from one event to the next so
+ * that their storage is reused */
+std::vector<AdvBatchReport> adv_batch;
+
+/* Whether results of the event being processed were passed to the observer */
+bool adv_batch_obs_results = false;
+
+/* Advertising data of a device assembled from several reports, to be matched
+ * against the host filter */
+std::vector<uint8_t> adv_filter_data;
+
+}  // namespace
+
 /**
- * This function is called when extended advertising report event is received .
- * It updates the inquiry database. If the inquiry database is full, the oldest
- * entry is discarded.
+ * Resolves the addresses of the reports of one advertising report event. An
+ * advertiser often has several reports in the same event, such as an
+ * advertisement and its scan response, so each address is resolved once.
  */
-void btm_ble_process_ext_adv_pkt(uint8_t data_len, uint8_t* data) {
-  RawAddress bda, direct_address;
-  uint8_t* p = data;
-  uint8_t addr_type, num_reports, pkt_data_len, primary_phy, secondary_phy,
-      advertising_sid;
-  int8_t rssi, tx_power;
-  uint16_t event_type, periodic_adv_int, direct_address_type;
-  size_t bytes_to_process;
+static void btm_ble_process_adv_addr_batch(std::vector<AdvBatchReport>& batch) {
+  for (size_t i = 0; i < batch.size(); i++) {
+    HciAdvertisingReport& report = batch[i].report;
+    if (report.address_type == BLE_ADDR_ANONYMOUS) continue;
+
+    size_t prev = 0;
+    while (prev < i && (batch[prev].original_addr_type != report.address_type ||
+                        batch[prev].original_bda != report.address))
+      prev++;
+
+    if (prev < i) {
+      report.address = batch[prev].report.address;
+      report.address_type = batch[prev].report.address_type;
+    } else {
+      btm_ble_process_adv_addr(report.address, &report.address_type);
+    }
+  }
+}
 
-  /* Only process the results if the inquiry is still active */
-  if (!BTM_BLE_IS_SCAN_ACTIVE(btm_cb.ble_ctr_cb.scan_activity)) return;
+/**
+ * Matches a report against the host side advertising filter, for
+ * controllers without APCF. A report that completes the data of a device is
+ * matched together with the data received before it, and the data is
+ * dropped when it doesn't pass. Reports followed by more data are let
+ * through, to be kept until then.
+ */
+static bool btm_ble_adv_filter_host_passes(const HciAdvertisingReport& report) {
+  uint16_t evt_type = report.event_type;
+  if (ble_evt_type_data_status(evt_type) == 0x01) return true;
 
-  bytes_to_process = 1;
+  bool is_scannable = ble_evt_type_is_scannable(evt_type);
+  bool is_scan_resp = ble_evt_type_is_scan_resp(evt_type);
+  if (btm_cb.ble_ctr_cb.inq_var.scan_type == BTM_BLE_SCAN_MODE_ACTI &&
+      is_scannable && !is_scan_resp)
+    return true;
 
-  if (data_len < bytes_to_process) {
-    LOG(ERROR) << "Malformed LE extended advertising packet: not enough room "
-                  "for num reports";
-    return;
+  /* Mirrors btm_ble_process_adv_pkt_cont(): the first report of a scannable
+   * legacy advertiser replaces the data kept, the others add to it */
+  bool is_start =
+      ble_evt_type_is_legacy(evt_type) && is_scannable && !is_scan_resp;
+  const std::vector<uint8_t>* p_kept =
+      is_start ? NULL : cache.Get(report.address_type, report.address);
+  if (p_kept == NULL || p_kept->empty()) {
+    return btm_ble_adv_filter_host_match(report.address, report.rssi,
+                                         report.data, report.data_len);
+  }
+
+  adv_filter_data.assign(p_kept->begin(), p_kept->end());
+  adv_filter_data.insert(adv_filter_data.end(), report.data,
+                         report.data + report.data_len);
+  if (btm_ble_adv_filter_host_match(report.address, report.rssi,
+                                    adv_filter_data.data(),
+                                    adv_filter_data.size()))
+    return true;
+
+  cache.Clear(report.address_type, report.address);
+  return false;
+}
+
+/**
+ * Processes the reports of one advertising report event, then lets the
+ * observer know that the results of the event were all reported.
+ */
+static void btm_ble_process_adv_batch(std::vector<AdvBatchReport>& batch) {
+  btm_ble_process_adv_addr_batch(batch);
+
+  bool host_filter = btm_ble_adv_filter_host_enabled();
+  adv_batch_obs_results = false;
+  for (const AdvBatchReport& r : batch) {
+    const HciAdvertisingReport& report = r.report;
+    if (host_filter && !btm_ble_adv_filter_host_passes(report)) continue;
+
+    btm_ble_process_adv_pkt_cont(
+        report.event_type, report.address_type, report.address,
+        report.primary_phy, report.secondary_phy, report.advertising_sid,
+        report.tx_power, report.rssi, report.periodic_adv_int, report.data_len,
+        report.data, r.original_bda);
   }
+  batch.clear();
 
-  /* Extract the number of reports in this event. */
-  STREAM_TO_UINT8(num_reports, p);
+  /* The observer may have been stopped by one of the results */
+  tBTM_INQ_BATCH_END_CB* p_obs_batch_end_cb =
+      btm_cb.ble_ctr_cb.p_obs_batch_end_cb;
+  if (p_obs_batch_end_cb && adv_batch_obs_results) (p_obs_batch_end_cb)();
+}
 
-  while (num_reports--) {
-    bytes_to_process += 24;
-    if (data_len < bytes_to_process) {
-      LOG(ERROR) << "Malformed LE extended advertising packet: not enough room "
-                    "for metadata";
-      return;
-    }
+/**
+ * This function is called when extended advertising report event is received .
+ * It updates the inquiry database. If the inquiry database is full, the oldest
+ * entry is discarded.
+ */
+void btm_ble_process_ext_adv_pkt(uint8_t data_len, uint8_t* data) {
+  AdvBatchReport r;
 
-    /* Extract inquiry results */
-    STREAM_TO_UINT16(event_type, p);
-    STREAM_TO_UINT8(addr_type, p);
-    STREAM_TO_BDADDR(bda, p);
-    STREAM_TO_UINT8(primary_phy, p);
-    STREAM_TO_UINT8(secondary_phy, p);
-    STREAM_TO_UINT8(advertising_sid, p);
-    STREAM_TO_INT8(tx_power, p);
-    STREAM_TO_INT8(rssi, p);
-    STREAM_TO_UINT16(periodic_adv_int, p);
-    STREAM_TO_UINT8(direct_address_type, p);
-    STREAM_TO_BDADDR(direct_address, p);
-    STREAM_TO_UINT8(pkt_data_len, p);
-
-    uint8_t* pkt_data = p;
-    p += pkt_data_len; /* Advance to the the next packet*/
-
-    bytes_to_process += pkt_data_len;
-    if (data_len < bytes_to_process) {
-      LOG(ERROR) << "Malformed LE extended advertising packet: not enough room "
-                    "for packet data";
-      return;
-    }
+  /* Only process the results if the inquiry is still active */
+  if (!BTM_BLE_IS_SCAN_ACTIVE(btm_cb.ble_ctr_cb.scan_activity)) return;
 
-    if (rssi >= 21 && rssi <= 126) {
+  HciLeExtendedAdvertisingReportView reports(HciPacketView(data, data_len));
+  while (reports.Next(&r.report)) {
+    if (r.report.rssi >= 21 && r.report.rssi <= 126) {
       BTM_TRACE_ERROR("%s: bad rssi value in advertising report: %d", __func__,
-                      rssi);
+                      r.report.rssi);
     }
 
-    BTM_TRACE_EVENT("%s Address type %d", __func__, addr_type);
-    VLOG(1) << __func__ << ": bda=" << bda;
+    BTM_TRACE_EVENT("%s Address type %d", __func__, r.report.address_type);
+    VLOG(1) << __func__ << ": bda=" << r.report.address;
 
     // Store this to pass up the callback chain to GattService#onScanResult for the check
     // in ScanFilter#matches
-    RawAddress original_bda = bda;
+    r.original_bda = r.report.address;
+    r.original_addr_type = r.report.address_type;
+    adv_batch.push_back(r);
+  }
 
-    if (addr_type != BLE_ADDR_ANONYMOUS) {
-      btm_ble_process_adv_addr(bda, &addr_type);
-    }
+  if (reports.IsTruncated())
+    LOG(ERROR) << "Malformed LE extended advertising packet: not enough room "
+                  "for the reports";
 
-    btm_ble_process_adv_pkt_cont(event_type, addr_type, bda, primary_phy,
-                                 secondary_phy, advertising_sid, tx_power, rssi,
-                                 periodic_adv_int, pkt_data_len, pkt_data, original_bda);
-  }
+  btm_ble_process_adv_batch(adv_batch);
 }
 
 /**
@@ -2756,90 +2835,51 @@ void btm_ble_process_ext_adv_pkt(uint8_t data_len, uint8_t* data) {
  * discarded.
  */
 void btm_ble_process_adv_pkt(uint8_t data_len, uint8_t* data) {
-  RawAddress bda;
-  uint8_t* p = data;
-  uint8_t legacy_evt_type, addr_type, num_reports, pkt_data_len;
-  int8_t rssi;
-  size_t bytes_to_process;
+  AdvBatchReport r;
 
   /* Only process the results if the inquiry is still active */
   if (!BTM_BLE_IS_SCAN_ACTIVE(btm_cb.ble_ctr_cb.scan_activity)) return;
 
-  bytes_to_process = 1;
-
-  if (data_len < bytes_to_process) {
-    LOG(ERROR)
-        << "Malformed LE advertising packet: not enough room for num reports";
-    return;
-  }
-
-  /* Extract the number of reports in this event. */
-  STREAM_TO_UINT8(num_reports, p);
-
-  while (num_reports--) {
-    bytes_to_process += 9;
-
-    if (data_len < bytes_to_process) {
-      LOG(ERROR)
-          << "Malformed LE advertising packet: not enough room for metadata";
-      return;
-    }
-
-    /* Extract inquiry results */
-    STREAM_TO_UINT8(legacy_evt_type, p);
-    STREAM_TO_UINT8(addr_type, p);
-    STREAM_TO_BDADDR(bda, p);
-    STREAM_TO_UINT8(pkt_data_len, p);
-
-    uint8_t* pkt_data = p;
-    p += pkt_data_len; /* Advance to the the rssi byte */
-
-    // include rssi for this check
-    bytes_to_process += pkt_data_len + 1;
-    if (data_len < bytes_to_process) {
-      LOG(ERROR) << "Malformed LE advertising packet: not enough room for "
-                    "packet data and/or RSSI";
-      return;
-    }
-
-    STREAM_TO_INT8(rssi, p);
-
-    if (rssi >= 21 && rssi <= 126) {
-      BTM_TRACE_ERROR("%s: bad rssi value in advertising report: ", __func__,
-                      pkt_data_len, rssi);
+  HciLeAdvertisingReportView reports(HciPacketView(data, data_len));
+  while (reports.Next(&r.report)) {
+    if (r.report.rssi >= 21 && r.report.rssi <= 126) {
+      BTM_TRACE_ERROR("%s: bad rssi value in advertising report: %d", __func__,
+                      r.report.rssi);
     }
 
-    // Pass up the address to GattService#onScanResult to use in ScanFilter#matches
-    RawAddress original_bda = bda;
-
-    btm_ble_process_adv_addr(bda, &addr_type);
-
-    uint16_t event_type;
+    uint16_t legacy_evt_type = r.report.event_type;
     if (legacy_evt_type == 0x00) {  // ADV_IND;
-      event_type = 0x0013;
+      r.report.event_type = 0x0013;
     } else if (legacy_evt_type == 0x01) {  // ADV_DIRECT_IND;
-      event_type = 0x0015;
+      r.report.event_type = 0x0015;
     } else if (legacy_evt_type == 0x02) {  // ADV_SCAN_IND;
-      event_type = 0x0012;
+      r.report.event_type = 0x0012;
     } else if (legacy_evt_type == 0x03) {  // ADV_NONCONN_IND;
-      event_type = 0x0010;
+      r.report.event_type = 0x0010;
     } else if (legacy_evt_type == 0x04) {  // SCAN_RSP;
       // We can't distinguish between "SCAN_RSP to an ADV_IND", and "SCAN_RSP to
       // an ADV_SCAN_IND", so always return "SCAN_RSP to an ADV_IND"
-      event_type = 0x001B;
+      r.report.event_type = 0x001B;
     } else {
       BTM_TRACE_ERROR(
           "Malformed LE Advertising Report Event - unsupported "
           "legacy_event_type 0x%02x",
           legacy_evt_type);
-      return;
+      /* The reports before this one are still processed */
+      break;
     }
 
-    btm_ble_process_adv_pkt_cont(
-        event_type, addr_type, bda, PHY_LE_1M, PHY_LE_NO_PACKET, NO_ADI_PRESENT,
-        TX_POWER_NOT_PRESENT, rssi, 0x00 /* no periodic adv */, pkt_data_len,
-        pkt_data, original_bda);
+    // Pass up the address to GattService#onScanResult to use in ScanFilter#matches
+    r.original_bda = r.report.address;
+    r.original_addr_type = r.report.address_type;
+    adv_batch.push_back(r);
   }
+
+  if (reports.IsTruncated())
+    LOG(ERROR) << "Malformed LE advertising packet: not enough room for the "
+                  "reports";
+
+  btm_ble_process_adv_batch(adv_batch);
 }
 
 /**
@@ -2850,7 +2890,7 @@ static void btm_ble_process_adv_pkt_cont(
     uint16_t evt_type, uint8_t addr_type, const RawAddress& bda,
     uint8_t primary_phy, uint8_t secondary_phy, uint8_t advertising_sid,
     int8_t tx_power, int8_t rssi, uint16_t periodic_adv_int, uint8_t data_len,
-    uint8_t* data, const RawAddress& original_bda) {
+    const uint8_t* data, const RawAddress& original_bda) {
   tBTM_INQUIRY_VAR_ST* p_inq = &btm_cb.btm_inq_vars;
   bool update = true;
 
@@ -2935,7 +2975,7 @@ static void btm_ble_process_adv_pkt_cont(
     p_inq->inq_cmpl_info.num_resp++;
   }
 
-  p_i->time_of_resp = time_get_os_boottime_ms();
+  btm_inq_db_update_resp_time(p_i);
 
   /* update the LE device information in inquiry database */
   btm_ble_update_inq_result(p_i, addr_type, bda, evt_type, primary_phy,
@@ -2987,6 +3027,7 @@ static void btm_ble_process_adv_pkt_cont(
 
   tBTM_INQ_RESULTS_CB* p_obs_results_cb = btm_cb.ble_ctr_cb.p_obs_results_cb;
   if (p_obs_results_cb && (result & BTM_BLE_OBS_RESULT)) {
+    adv_batch_obs_results = true;
     (p_obs_results_cb)((tBTM_INQ_RESULTS*)&p_i->inq_info.results,
                        const_cast<uint8_t*>(adv_data.data()), adv_data.size());
   }
@@ -3109,6 +3150,7 @@ static void btm_ble_stop_observe(void) {
 
   p_ble_cb->p_obs_results_cb = NULL;
   p_ble_cb->p_obs_cmpl_cb = NULL;
+  p_ble_cb->p_obs_batch_end_cb = NULL;
 
   if (!BTM_BLE_IS_SCAN_ACTIVE(p_ble_cb->scan_activity)) btm_ble_stop_scan();
 
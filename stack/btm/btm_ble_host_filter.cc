@@ -0,0 +1,450 @@
+/******************************************************************************
+ *
+ *  Copyright 2019 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+/******************************************************************************
+ *
+ *  This file implements the host side advertising packet content filter:
+ *  the compilation of the filter conditions into indexes, and the matching
+ *  of advertising data against them.
+ *
+ ******************************************************************************/
+
+#include "btm_ble_host_filter.h"
+
+#include <string.h>
+
+#include <algorithm>
+
+using bluetooth::Uuid;
+
+/* AD types of the Service Solicitation lists, not used elsewhere in the
+ * stack */
+#define AD_TYPE_SOL_16BITS_UUID 0x14
+#define AD_TYPE_SOL_128BITS_UUID 0x15
+#define AD_TYPE_SOL_32BITS_UUID 0x1F
+
+#define FEATURE_BIT(type) ((uint16_t)(1 << (type)))
+
+/* Features compared to the content of the reports. The service data change
+ * feature has nothing to compare and is left out, so it doesn't restrict
+ * the filters selecting it. */
+static const uint8_t checked_features[] = {
+    BTM_BLE_PF_ADDR_FILTER, BTM_BLE_PF_SRVC_UUID,
+    BTM_BLE_PF_SRVC_SOL_UUID, BTM_BLE_PF_LOCAL_NAME,
+    BTM_BLE_PF_MANU_DATA, BTM_BLE_PF_SRVC_DATA_PATTERN};
+
+/* Features the host doesn't check: filters selecting them match every
+ * report */
+#define UNCHECKED_FEATURES \
+  (FEATURE_BIT(BTM_BLE_PF_TDS_DATA) | FEATURE_BIT(BTM_BLE_PF_GROUP_FILTER))
+
+/* Like the APCF commands, names longer than this are compared on their
+ * first bytes only, and the data patterns, which follow a two byte company
+ * identifier or UUID, are cut to the same total length */
+#define NAME_LEN_MAX BTM_BLE_PF_STR_LEN_MAX
+#define PATTERN_LEN_MAX (BTM_BLE_PF_STR_LEN_MAX - 2)
+
+static uint16_t prefix_of(const uint8_t* p) {
+  return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+bool BleHostFilter::AddConditions(tBTM_BLE_PF_FILT_INDEX filt_index,
+                                  const std::vector<ApcfCommand>& commands) {
+  if (filt_index >= BTM_BLE_HOST_FILTER_MAX) return false;
+
+  for (const ApcfCommand& cmd : commands) {
+    /* Data and mask are given with the same length, like for the APCF
+     * commands */
+    if (cmd.data.size() != cmd.data_mask.size() && cmd.data.size() != 0 &&
+        cmd.data_mask.size() != 0)
+      continue;
+    filters_[filt_index].conditions.push_back(cmd);
+  }
+  Compile();
+  return true;
+}
+
+void BleHostFilter::ClearConditions(tBTM_BLE_PF_FILT_INDEX filt_index) {
+  if (filt_index >= BTM_BLE_HOST_FILTER_MAX) return;
+
+  filters_[filt_index].conditions.clear();
+  Compile();
+}
+
+bool BleHostFilter::SetFilter(tBTM_BLE_PF_FILT_INDEX filt_index,
+                              const btgatt_filt_param_setup_t& params) {
+  if (filt_index >= BTM_BLE_HOST_FILTER_MAX) return false;
+
+  Filter& filter = filters_[filt_index];
+  filter.active = true;
+  filter.feat_seln = params.feat_seln;
+  filter.rssi_high_thres = (int8_t)params.rssi_high_thres;
+  Compile();
+  return true;
+}
+
+void BleHostFilter::DeleteFilter(tBTM_BLE_PF_FILT_INDEX filt_index) {
+  if (filt_index >= BTM_BLE_HOST_FILTER_MAX) return;
+
+  filters_[filt_index].active = false;
+  Compile();
+}
+
+void BleHostFilter::DeleteAllFilters() {
+  for (Filter& filter : filters_) filter.active = false;
+  Compile();
+}
+
+uint8_t BleHostFilter::GetAvailableSpace() const {
+  uint8_t available = 0;
+  for (const Filter& filter : filters_) {
+    if (!filter.active) available++;
+  }
+  return available;
+}
+
+void BleHostFilter::Reset() { *this = BleHostFilter(); }
+
+void BleHostFilter::AddUuid(UuidIndex* p_index, const ApcfCommand& cmd,
+                            uint64_t filter) {
+  if (cmd.uuid_mask.IsEmpty()) {
+    if (cmd.uuid.GetShortestRepresentationSize() != Uuid::kNumBytes128) {
+      p_index->short_uuids[cmd.uuid.As32Bit()] |= filter;
+      return;
+    }
+    for (auto& entry : p_index->long_uuids) {
+      if (entry.first == cmd.uuid) {
+        entry.second |= filter;
+        return;
+      }
+    }
+    p_index->long_uuids.emplace_back(cmd.uuid, filter);
+    return;
+  }
+
+  MaskedUuid masked;
+  const Uuid::UUID128Bit& uuid = cmd.uuid.To128BitBE();
+  masked.mask = cmd.uuid_mask.To128BitBE();
+  for (size_t i = 0; i < Uuid::kNumBytes128; i++)
+    masked.uuid[i] = uuid[i] & masked.mask[i];
+  masked.filters = filter;
+  p_index->masked_uuids.push_back(masked);
+}
+
+void BleHostFilter::AddPattern(PatternIndex* p_index,
+                               std::vector<uint8_t> data,
+                               std::vector<uint8_t> mask, uint64_t filter) {
+  for (size_t i = 0; i < data.size(); i++) data[i] &= mask[i];
+
+  std::vector<DataPattern>* p_patterns = &p_index->others;
+  if (data.size() >= 2 && mask[0] == 0xFF && mask[1] == 0xFF)
+    p_patterns = &p_index->by_prefix[prefix_of(data.data())];
+
+  for (DataPattern& pattern : *p_patterns) {
+    if (pattern.data == data && pattern.mask == mask) {
+      pattern.filters |= filter;
+      return;
+    }
+  }
+  p_patterns->push_back({std::move(data), std::move(mask), filter});
+}
+
+void BleHostFilter::Compile() {
+  active_ = 0;
+  all_pass_ = 0;
+  memset(required_, 0, sizeof(required_));
+  rssi_thresholds_.clear();
+  addresses_.clear();
+  service_uuids_ = UuidIndex();
+  solicitation_uuids_ = UuidIndex();
+  names_.clear();
+  name_prefixes_.clear();
+  manufacturer_data_ = PatternIndex();
+  service_data_ = PatternIndex();
+
+  for (int i = 0; i < BTM_BLE_HOST_FILTER_MAX; i++) {
+    const Filter& filter = filters_[i];
+    if (!filter.active) continue;
+
+    uint64_t bit = (uint64_t)1 << i;
+    active_ |= bit;
+    rssi_thresholds_.emplace_back(filter.rssi_high_thres, bit);
+
+    if (filter.feat_seln == 0 || (filter.feat_seln & UNCHECKED_FEATURES)) {
+      all_pass_ |= bit;
+      continue;
+    }
+
+    for (uint8_t type : checked_features) {
+      if (filter.feat_seln & FEATURE_BIT(type)) required_[type] |= bit;
+    }
+
+    for (const ApcfCommand& cmd : filter.conditions) {
+      if (cmd.type >= BTM_BLE_PF_TYPE_MAX || !(required_[cmd.type] & bit))
+        continue;
+
+      switch (cmd.type) {
+        case BTM_BLE_PF_ADDR_FILTER:
+          addresses_[cmd.address] |= bit;
+          break;
+
+        case BTM_BLE_PF_SRVC_UUID:
+          AddUuid(&service_uuids_, cmd, bit);
+          break;
+
+        case BTM_BLE_PF_SRVC_SOL_UUID:
+          AddUuid(&solicitation_uuids_, cmd, bit);
+          break;
+
+        case BTM_BLE_PF_LOCAL_NAME: {
+          std::string name(cmd.name.begin(), cmd.name.end());
+          if (name.empty() || name.size() > NAME_LEN_MAX) {
+            name.resize(std::min(name.size(), (size_t)NAME_LEN_MAX));
+            name_prefixes_.emplace_back(name, bit);
+          } else {
+            names_[name] |= bit;
+          }
+          break;
+        }
+
+        case BTM_BLE_PF_MANU_DATA: {
+          /* As for the APCF command, the data is only compared when it has
+           * a mask, and an empty company mask compares the whole company */
+          uint16_t company_mask = cmd.company_mask ? cmd.company_mask : 0xFFFF;
+          std::vector<uint8_t> data{(uint8_t)cmd.company,
+                                    (uint8_t)(cmd.company >> 8)};
+          std::vector<uint8_t> mask{(uint8_t)company_mask,
+                                    (uint8_t)(company_mask >> 8)};
+          if (!cmd.data_mask.empty()) {
+            size_t size = std::min(cmd.data.size(), (size_t)PATTERN_LEN_MAX);
+            data.insert(data.end(), cmd.data.begin(), cmd.data.begin() + size);
+            mask.insert(mask.end(), cmd.data_mask.begin(),
+                        cmd.data_mask.begin() + size);
+          }
+          AddPattern(&manufacturer_data_, std::move(data), std::move(mask),
+                     bit);
+          break;
+        }
+
+        case BTM_BLE_PF_SRVC_DATA_PATTERN: {
+          size_t size = std::min(cmd.data.size(), (size_t)PATTERN_LEN_MAX);
+          std::vector<uint8_t> data(cmd.data.begin(), cmd.data.begin() + size);
+          std::vector<uint8_t> mask(size, 0xFF);
+          if (!cmd.data_mask.empty())
+            mask.assign(cmd.data_mask.begin(), cmd.data_mask.begin() + size);
+          AddPattern(&service_data_, std::move(data), std::move(mask), bit);
+          break;
+        }
+      }
+    }
+  }
+
+  /* Accumulate the filters of the lower thresholds into each one */
+  std::sort(rssi_thresholds_.begin(), rssi_thresholds_.end());
+  size_t n = 0;
+  for (size_t i = 0; i < rssi_thresholds_.size(); i++) {
+    uint64_t filters = rssi_thresholds_[i].second;
+    if (n > 0) filters |= rssi_thresholds_[n - 1].second;
+    if (n > 0 && rssi_thresholds_[n - 1].first == rssi_thresholds_[i].first) {
+      rssi_thresholds_[n - 1].second = filters;
+    } else {
+      rssi_thresholds_[n++] = {rssi_thresholds_[i].first, filters};
+    }
+  }
+  rssi_thresholds_.resize(n);
+}
+
+uint64_t BleHostFilter::MatchPatterns(const PatternIndex& index,
+                                      const uint8_t* p_value, size_t len) {
+  auto matches = [p_value, len](const DataPattern& pattern) {
+    if (len < pattern.data.size()) return false;
+    for (size_t i = 0; i < pattern.data.size(); i++) {
+      if ((p_value[i] & pattern.mask[i]) != pattern.data[i]) return false;
+    }
+    return true;
+  };
+
+  uint64_t met = 0;
+  if (len >= 2 && !index.by_prefix.empty()) {
+    auto it = index.by_prefix.find(prefix_of(p_value));
+    if (it != index.by_prefix.end()) {
+      for (const DataPattern& pattern : it->second) {
+        if (matches(pattern)) met |= pattern.filters;
+      }
+    }
+  }
+  for (const DataPattern& pattern : index.others) {
+    if (matches(pattern)) met |= pattern.filters;
+  }
+  return met;
+}
+
+uint64_t BleHostFilter::MatchUuid(const UuidIndex& index, const Uuid& uuid) {
+  uint64_t met = 0;
+  if (uuid.GetShortestRepresentationSize() != Uuid::kNumBytes128) {
+    auto it = index.short_uuids.find(uuid.As32Bit());
+    if (it != index.short_uuids.end()) met |= it->second;
+  } else {
+    for (const auto& entry : index.long_uuids) {
+      if (entry.first == uuid) met |= entry.second;
+    }
+  }
+
+  if (!index.masked_uuids.empty()) {
+    const Uuid::UUID128Bit& be = uuid.To128BitBE();
+    for (const MaskedUuid& masked : index.masked_uuids) {
+      size_t i = 0;
+      while (i < Uuid::kNumBytes128 &&
+             (be[i] & masked.mask[i]) == masked.uuid[i])
+        i++;
+      if (i == Uuid::kNumBytes128) met |= masked.filters;
+    }
+  }
+  return met;
+}
+
+uint64_t BleHostFilter::MatchUuids(const UuidIndex& index,
+                                   const uint8_t* p_value, size_t len,
+                                   size_t uuid_len) {
+  uint64_t met = 0;
+  for (; len >= uuid_len; p_value += uuid_len, len -= uuid_len) {
+    if (uuid_len != Uuid::kNumBytes128 && index.masked_uuids.empty()) {
+      /* The common case: look the short form up without building the UUID */
+      uint32_t uuid32 = p_value[0] | (p_value[1] << 8);
+      if (uuid_len == Uuid::kNumBytes32)
+        uuid32 |= (uint32_t)(p_value[2] | (p_value[3] << 8)) << 16;
+      auto it = index.short_uuids.find(uuid32);
+      if (it != index.short_uuids.end()) met |= it->second;
+      continue;
+    }
+
+    Uuid uuid;
+    if (uuid_len == Uuid::kNumBytes16)
+      uuid = Uuid::From16Bit(p_value[0] | (p_value[1] << 8));
+    else if (uuid_len == Uuid::kNumBytes32)
+      uuid = Uuid::From32Bit(p_value[0] | (p_value[1] << 8) |
+                             (p_value[2] << 16) | ((uint32_t)p_value[3] << 24));
+    else
+      uuid = Uuid::From128BitLE(p_value);
+    met |= MatchUuid(index, uuid);
+  }
+  return met;
+}
+
+bool BleHostFilter::Matches(const RawAddress& bda, int8_t rssi,
+                            const uint8_t* p_data, size_t len) const {
+  if (!enabled_) return true;
+
+  uint64_t candidates = 0;
+  for (const auto& threshold : rssi_thresholds_) {
+    if (threshold.first > rssi) break;
+    candidates = threshold.second;
+  }
+  if (candidates & all_pass_) return true;
+  if (candidates == 0) return false;
+
+  /* The candidate filters met by the report, by feature */
+  uint64_t met[BTM_BLE_PF_TYPE_MAX] = {};
+  auto wanted = [this, candidates](uint8_t type) {
+    return (required_[type] & candidates) != 0;
+  };
+
+  if (wanted(BTM_BLE_PF_ADDR_FILTER)) {
+    auto it = addresses_.find(bda);
+    if (it != addresses_.end()) met[BTM_BLE_PF_ADDR_FILTER] = it->second;
+  }
+
+  size_t pos = 0;
+  while (pos < len) {
+    /* A zero length ends the significant part of the data */
+    uint8_t ad_len = p_data[pos];
+    if (ad_len == 0 || ad_len > len - pos - 1) break;
+
+    uint8_t ad_type = p_data[pos + 1];
+    const uint8_t* p_value = p_data + pos + 2;
+    size_t value_len = ad_len - 1;
+    pos += ad_len + 1;
+
+    switch (ad_type) {
+      case BT_EIR_MORE_16BITS_UUID_TYPE:
+      case BT_EIR_COMPLETE_16BITS_UUID_TYPE:
+      case BT_EIR_MORE_32BITS_UUID_TYPE:
+      case BT_EIR_COMPLETE_32BITS_UUID_TYPE:
+      case BT_EIR_MORE_128BITS_UUID_TYPE:
+      case BT_EIR_COMPLETE_128BITS_UUID_TYPE: {
+        if (!wanted(BTM_BLE_PF_SRVC_UUID)) break;
+        size_t uuid_len = ad_type <= BT_EIR_COMPLETE_16BITS_UUID_TYPE
+                              ? Uuid::kNumBytes16
+                              : ad_type <= BT_EIR_COMPLETE_32BITS_UUID_TYPE
+                                    ? Uuid::kNumBytes32
+                                    : Uuid::kNumBytes128;
+        met[BTM_BLE_PF_SRVC_UUID] |=
+            MatchUuids(service_uuids_, p_value, value_len, uuid_len);
+        break;
+      }
+
+      case AD_TYPE_SOL_16BITS_UUID:
+      case AD_TYPE_SOL_32BITS_UUID:
+      case AD_TYPE_SOL_128BITS_UUID: {
+        if (!wanted(BTM_BLE_PF_SRVC_SOL_UUID)) break;
+        size_t uuid_len = ad_type == AD_TYPE_SOL_16BITS_UUID
+                              ? Uuid::kNumBytes16
+                              : ad_type == AD_TYPE_SOL_32BITS_UUID
+                                    ? Uuid::kNumBytes32
+                                    : Uuid::kNumBytes128;
+        met[BTM_BLE_PF_SRVC_SOL_UUID] |=
+            MatchUuids(solicitation_uuids_, p_value, value_len, uuid_len);
+        break;
+      }
+
+      case BT_EIR_SHORTENED_LOCAL_NAME_TYPE:
+      case BT_EIR_COMPLETE_LOCAL_NAME_TYPE: {
+        if (!wanted(BTM_BLE_PF_LOCAL_NAME)) break;
+        if (!names_.empty()) {
+          auto it = names_.find(std::string((const char*)p_value, value_len));
+          if (it != names_.end()) met[BTM_BLE_PF_LOCAL_NAME] |= it->second;
+        }
+        for (const auto& prefix : name_prefixes_) {
+          if (value_len >= prefix.first.size() &&
+              memcmp(p_value, prefix.first.data(), prefix.first.size()) == 0)
+            met[BTM_BLE_PF_LOCAL_NAME] |= prefix.second;
+        }
+        break;
+      }
+
+      case BT_EIR_MANUFACTURER_SPECIFIC_TYPE:
+        if (!wanted(BTM_BLE_PF_MANU_DATA)) break;
+        met[BTM_BLE_PF_MANU_DATA] |=
+            MatchPatterns(manufacturer_data_, p_value, value_len);
+        break;
+
+      case BT_EIR_SERVICE_DATA_16BITS_UUID_TYPE:
+      case BT_EIR_SERVICE_DATA_32BITS_UUID_TYPE:
+      case BT_EIR_SERVICE_DATA_128BITS_UUID_TYPE:
+        if (!wanted(BTM_BLE_PF_SRVC_DATA_PATTERN)) break;
+        met[BTM_BLE_PF_SRVC_DATA_PATTERN] |=
+            MatchPatterns(service_data_, p_value, value_len);
+        break;
+    }
+  }
+
+  /* A candidate fails when one of the features it selects is not met */
+  uint64_t failed = 0;
+  for (uint8_t type : checked_features) failed |= required_[type] & ~met[type];
+  return (candidates & ~failed) != 0;
+}
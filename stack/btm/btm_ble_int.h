@@ -185,6 +185,9 @@ extern void btm_ble_batchscan_init(void);
 extern void btm_ble_batchscan_cleanup(void);
 extern void btm_ble_adv_filter_init(void);
 extern void btm_ble_adv_filter_cleanup(void);
+extern bool btm_ble_adv_filter_host_enabled(void);
+extern bool btm_ble_adv_filter_host_match(const RawAddress& bda, int8_t rssi,
+                                          const uint8_t* p_data, size_t len);
 extern bool btm_ble_topology_check(tBTM_BLE_STATE_MASK request);
 extern bool btm_ble_clear_topology_mask(tBTM_BLE_STATE_MASK request_state);
 extern bool btm_ble_set_topology_mask(tBTM_BLE_STATE_MASK request_state);
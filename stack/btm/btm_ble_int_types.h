@@ -287,6 +287,7 @@ typedef struct {
   /* observer callback and timer */
   tBTM_INQ_RESULTS_CB* p_obs_results_cb;
   tBTM_CMPL_CB* p_obs_cmpl_cb;
+  tBTM_INQ_BATCH_END_CB* p_obs_batch_end_cb;
   alarm_t* observer_timer;
 
   /* background connection procedure cb value */
@@ -71,6 +71,7 @@
 #include "hcidefs.h"
 #include "hcimsgs.h"
 #include "l2c_api.h"
+#include "sdp_api.h"
 #include "btif_util.h"
 #include "btif_storage.h"
 
@@ -206,6 +207,9 @@ bool BTM_SecDeleteDevice(const RawAddress& bd_addr) {
     return false;
   }
 
+  /* The device may come back with different services */
+  SDP_InvalidateDiscoveryCache(bd_addr);
+
   tBTM_SEC_DEV_REC* p_dev_rec = btm_find_dev(bd_addr);
   if (p_dev_rec != NULL) {
     RawAddress bda = p_dev_rec->bd_addr;
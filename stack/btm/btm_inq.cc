@@ -30,8 +30,14 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include <algorithm>
+#include <list>
+#include <unordered_map>
+#include <vector>
+
 #include "device/include/controller.h"
 #include "osi/include/osi.h"
+#include "osi/include/properties.h"
 #include "osi/include/time.h"
 
 #include "advertise_data_parser.h"
@@ -48,6 +54,10 @@ using bluetooth::Uuid;
 /* 3 second timeout waiting for responses */
 #define BTM_INQ_REPLY_TIMEOUT_MS (3 * 1000)
 
+/* Maximum number of responders remembered per inquiry to filter duplicate
+ * responses */
+#define BTM_INQ_MAX_BD_ENTRIES 1024
+
 /* TRUE to enable DEBUG traces for btm_inq */
 #ifndef BTM_INQ_DEBUG
 #define BTM_INQ_DEBUG FALSE
@@ -109,6 +119,19 @@ const uint16_t BTM_EIR_UUID_LKUP_TBL[BTM_EIR_MAX_SERVICES] = {
     UUID_SERVCLASS_MESSAGE_ACCESS, UUID_SERVCLASS_MESSAGE_NOTIFICATION,
     UUID_SERVCLASS_HDP_SOURCE, UUID_SERVCLASS_HDP_SINK};
 
+/* In-use inquiry database entries, least recently responded first, and their
+ * index by address. Entries are never moved in btm_cb.btm_inq_vars.inq_db,
+ * so pointers handed out by btm_inq_db_find() stay valid until released. */
+typedef std::list<tINQ_DB_ENT*> tINQ_DB_LRU;
+static tINQ_DB_LRU inq_db_lru;
+static std::unordered_map<RawAddress, tINQ_DB_LRU::iterator> inq_db_index;
+static std::vector<tINQ_DB_ENT*> inq_db_free_list;
+static uint16_t inq_db_keep_count;
+
+/* Devices that responded to the current inquiry, keyed by address and device
+ * type, with the inquiry count of their last response */
+static std::unordered_map<uint64_t, uint32_t> inq_bd_db;
+
 /******************************************************************************/
 /*            L O C A L    F U N C T I O N     P R O T O T Y P E S            */
 /******************************************************************************/
@@ -116,6 +139,7 @@ static void btm_initiate_inquiry(tBTM_INQUIRY_VAR_ST* p_inq);
 static tBTM_STATUS btm_set_inq_event_filter(uint8_t filter_cond_type,
                                             tBTM_INQ_FILT_COND* p_filt_cond);
 static void btm_clr_inq_result_flt(void);
+static void btm_inq_db_rebuild_index(void);
 
 static uint8_t btm_convert_uuid_to_eir_service(uint16_t uuid16);
 static void btm_set_eir_uuid(uint8_t* p_eir, tBTM_INQ_RESULTS* p_results);
@@ -1055,7 +1079,7 @@ tBTM_INQ_INFO* BTM_InqDbFirst(void) {
   uint16_t xx;
   tINQ_DB_ENT* p_ent = btm_cb.btm_inq_vars.inq_db;
 
-  for (xx = 0; xx < BTM_INQ_DB_SIZE; xx++, p_ent++) {
+  for (xx = 0; xx < btm_cb.btm_inq_vars.inq_db_size; xx++, p_ent++) {
     if (p_ent->in_use) return (&p_ent->inq_info);
   }
 
@@ -1082,8 +1106,8 @@ tBTM_INQ_INFO* BTM_InqDbNext(tBTM_INQ_INFO* p_cur) {
     p_ent = (tINQ_DB_ENT*)((uint8_t*)p_cur - offsetof(tINQ_DB_ENT, inq_info));
     inx = (uint16_t)((p_ent - btm_cb.btm_inq_vars.inq_db) + 1);
 
-    for (p_ent = &btm_cb.btm_inq_vars.inq_db[inx]; inx < BTM_INQ_DB_SIZE;
-         inx++, p_ent++) {
+    for (p_ent = &btm_cb.btm_inq_vars.inq_db[inx];
+         inx < btm_cb.btm_inq_vars.inq_db_size; inx++, p_ent++) {
       if (p_ent->in_use) return (&p_ent->inq_info);
     }
 
@@ -1236,14 +1260,29 @@ void btm_inq_db_reset(void) {
  *
  ******************************************************************************/
 void btm_inq_db_init(void) {
-  alarm_free(btm_cb.btm_inq_vars.remote_name_timer);
-  btm_cb.btm_inq_vars.remote_name_timer =
-      alarm_new("btm_inq.remote_name_timer");
-  btm_cb.btm_inq_vars.no_inc_ssp = BTM_NO_SSP_ON_INQUIRY;
+  tBTM_INQUIRY_VAR_ST* p_inq = &btm_cb.btm_inq_vars;
+  int32_t size =
+      osi_property_get_int32("persist.bluetooth.inq_db_size", BTM_INQ_DB_SIZE);
+
+  alarm_free(p_inq->remote_name_timer);
+  p_inq->remote_name_timer = alarm_new("btm_inq.remote_name_timer");
+  p_inq->no_inc_ssp = BTM_NO_SSP_ON_INQUIRY;
+
+  size = std::max(size, (int32_t)BTM_INQ_DB_HID_KEEP_MAX + 1);
+  size = std::min(size, (int32_t)BTM_INQ_DB_MAX_SIZE);
+
+  osi_free(p_inq->inq_db);
+  p_inq->inq_db_size = (uint16_t)size;
+  p_inq->inq_db =
+      (tINQ_DB_ENT*)osi_calloc(p_inq->inq_db_size * sizeof(tINQ_DB_ENT));
+  btm_inq_db_rebuild_index();
 }
 
 void btm_inq_db_free(void) {
   alarm_free(btm_cb.btm_inq_vars.remote_name_timer);
+  osi_free_and_reset((void**)&btm_cb.btm_inq_vars.inq_db);
+  btm_cb.btm_inq_vars.inq_db_size = 0;
+  btm_inq_db_rebuild_index();
 }
 
 /*******************************************************************************
@@ -1316,12 +1355,12 @@ void btm_clr_inq_db(const RawAddress* p_bda) {
   BTM_TRACE_DEBUG("btm_clr_inq_db: inq_active:0x%x state:%d",
                   btm_cb.btm_inq_vars.inq_active, btm_cb.btm_inq_vars.state);
 #endif
-  for (xx = 0; xx < BTM_INQ_DB_SIZE; xx++, p_ent++) {
-    if (p_ent->in_use) {
-      /* If this is the specified BD_ADDR or clearing all devices */
-      if (p_bda == NULL || (p_ent->inq_info.results.remote_bd_addr == *p_bda)) {
-        p_ent->in_use = false;
-      }
+  if (p_bda != NULL) {
+    p_ent = btm_inq_db_find(*p_bda);
+    if (p_ent) btm_inq_db_release(p_ent);
+  } else {
+    for (xx = 0; xx < p_inq->inq_db_size; xx++, p_ent++) {
+      if (p_ent->in_use) btm_inq_db_release(p_ent);
     }
   }
 #if (BTM_INQ_DEBUG == TRUE)
@@ -1343,8 +1382,7 @@ void btm_clr_inq_db(const RawAddress* p_bda) {
 static void btm_clr_inq_result_flt(void) {
   tBTM_INQUIRY_VAR_ST* p_inq = &btm_cb.btm_inq_vars;
 
-  osi_free_and_reset((void**)&p_inq->p_bd_db);
-  p_inq->num_bd_entries = 0;
+  inq_bd_db.clear();
   p_inq->max_bd_entries = 0;
 }
 
@@ -1360,24 +1398,22 @@ static void btm_clr_inq_result_flt(void) {
  ******************************************************************************/
 bool btm_inq_find_bdaddr(const RawAddress& p_bda, tBT_DEVICE_TYPE p_dev_type) {
   tBTM_INQUIRY_VAR_ST* p_inq = &btm_cb.btm_inq_vars;
-  tINQ_BDADDR* p_db = &p_inq->p_bd_db[0];
-  uint16_t xx;
+  uint64_t key = p_dev_type;
 
   /* Don't bother searching, database doesn't exist or periodic mode */
-  if ((p_inq->inq_active & BTM_PERIODIC_INQUIRY_ACTIVE) || !p_db)
+  if ((p_inq->inq_active & BTM_PERIODIC_INQUIRY_ACTIVE) ||
+      p_inq->max_bd_entries == 0)
     return (false);
 
-  for (xx = 0; xx < p_inq->num_bd_entries; xx++, p_db++) {
-    if (p_db->bd_addr == p_bda && p_db->inq_count == p_inq->inq_counter &&
-        p_db->device_type == p_dev_type)
-      return (true);
-  }
+  for (int i = 0; i < RawAddress::kLength; i++)
+    key = (key << 8) | p_bda.address[i];
 
-  if (xx < p_inq->max_bd_entries) {
-    p_db->inq_count = p_inq->inq_counter;
-    p_db->bd_addr = p_bda;
-    p_db->device_type = p_dev_type;
-    p_inq->num_bd_entries++;
+  auto it = inq_bd_db.find(key);
+  if (it != inq_bd_db.end()) {
+    if (it->second == p_inq->inq_counter) return (true);
+    it->second = p_inq->inq_counter;
+  } else if (inq_bd_db.size() < p_inq->max_bd_entries) {
+    inq_bd_db[key] = p_inq->inq_counter;
   }
 
   /* If here, New Entry */
@@ -1395,77 +1431,135 @@ bool btm_inq_find_bdaddr(const RawAddress& p_bda, tBT_DEVICE_TYPE p_dev_type) {
  *
  ******************************************************************************/
 tINQ_DB_ENT* btm_inq_db_find(const RawAddress& p_bda) {
-  uint16_t xx;
-  tINQ_DB_ENT* p_ent = btm_cb.btm_inq_vars.inq_db;
-
-  for (xx = 0; xx < BTM_INQ_DB_SIZE; xx++, p_ent++) {
-    if (p_ent->in_use && p_ent->inq_info.results.remote_bd_addr == p_bda)
-      return (p_ent);
-  }
+  auto it = inq_db_index.find(p_bda);
+  if (it == inq_db_index.end()) return (NULL);
 
-  /* If here, not found */
-  return (NULL);
+  return (*it->second);
 }
 
 /*******************************************************************************
  *
  * Function         btm_inq_db_new
  *
- * Description      This function looks through the inquiry database for an
- *                  unused entry. If no entry is free, it allocates the oldest
- *                  entry.
+ * Description      This function takes an unused entry from the inquiry
+ *                  database. If no entry is free, it reuses the entry that
+ *                  responded least recently, skipping the ones kept for a
+ *                  name request.
  *
  * Returns          pointer to entry
  *
  ******************************************************************************/
 tINQ_DB_ENT* btm_inq_db_new(const RawAddress& p_bda, bool keep) {
-  uint16_t xx;
-  tINQ_DB_ENT* p_ent = btm_cb.btm_inq_vars.inq_db;
-  tINQ_DB_ENT* p_old = btm_cb.btm_inq_vars.inq_db;
-  uint32_t ot = 0xFFFFFFFF;
-  uint8_t keep_counter = 0;
-
-  for (xx = 0; xx < BTM_INQ_DB_SIZE; xx++, p_ent++) {
-    if (!p_ent->in_use) {
-      memset(p_ent, 0, sizeof(tINQ_DB_ENT));
-      p_ent->inq_info.results.remote_bd_addr = p_bda;
-      p_ent->in_use = true;
-      /* The keep flag is set as true only for the first 4 HID devices */
-      if (keep_counter < BTM_INQ_DB_HID_KEEP_MAX)
-        p_ent->keep = keep;
-      else
-        p_ent->keep = false;
-
-      return (p_ent);
-    }
+  tINQ_DB_ENT* p_ent;
 
-    if (p_ent->keep) {
-      keep_counter++;
+  if (!inq_db_free_list.empty()) {
+    p_ent = inq_db_free_list.back();
+  } else {
+    /* If here, no free entry found. Reuse the oldest. */
+    auto it = inq_db_lru.begin();
+    while (it != inq_db_lru.end() && (*it)->keep) {
+      LOG(INFO) << __func__ << ": keep "
+                << (*it)->inq_info.results.remote_bd_addr;
+      it++;
     }
+    if (it == inq_db_lru.end()) it = inq_db_lru.begin();
+    p_ent = *it;
+    btm_inq_db_release(p_ent);
+  }
+  inq_db_free_list.pop_back();
 
-    if (p_ent->time_of_resp < ot) {
-      if (p_ent->keep) {
-        LOG(INFO) << __func__ << ": keep "
-                  << p_ent->inq_info.results.remote_bd_addr;
-      } else {
-        p_old = p_ent;
-        ot = p_ent->time_of_resp;
-      }
-    }
+  memset(p_ent, 0, sizeof(tINQ_DB_ENT));
+  p_ent->inq_info.results.remote_bd_addr = p_bda;
+  p_ent->in_use = true;
+  /* The keep flag is set as true only for the first 4 HID devices */
+  if (keep && inq_db_keep_count < BTM_INQ_DB_HID_KEEP_MAX) {
+    p_ent->keep = true;
+    inq_db_keep_count++;
   }
 
-  /* If here, no free entry found. Return the oldest. */
+  inq_db_index[p_bda] = inq_db_lru.insert(inq_db_lru.end(), p_ent);
+  return (p_ent);
+}
 
-  memset(p_old, 0, sizeof(tINQ_DB_ENT));
-  p_old->inq_info.results.remote_bd_addr = p_bda;
-  p_old->in_use = true;
-  /* The keep flag is set as true only for the first 4 HID devices */
-  if (keep_counter < BTM_INQ_DB_HID_KEEP_MAX)
-    p_old->keep = keep;
-  else
-    p_old->keep = false;
+/*******************************************************************************
+ *
+ * Function         btm_inq_db_release
+ *
+ * Description      This function returns an entry to the free entries of the
+ *                  inquiry database.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+void btm_inq_db_release(tINQ_DB_ENT* p_ent) {
+  auto it = inq_db_index.find(p_ent->inq_info.results.remote_bd_addr);
+  if (it == inq_db_index.end() || *it->second != p_ent) return;
+
+  inq_db_lru.erase(it->second);
+  inq_db_index.erase(it);
+  if (p_ent->keep) inq_db_keep_count--;
+  p_ent->in_use = false;
+  inq_db_free_list.push_back(p_ent);
+}
 
-  return (p_old);
+/*******************************************************************************
+ *
+ * Function         btm_inq_db_update_resp_time
+ *
+ * Description      This function records that the device of an entry has just
+ *                  responded, which makes it the last one to be reused.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+void btm_inq_db_update_resp_time(tINQ_DB_ENT* p_ent) {
+  auto it = inq_db_index.find(p_ent->inq_info.results.remote_bd_addr);
+
+  p_ent->time_of_resp = time_get_os_boottime_ms();
+  if (it != inq_db_index.end())
+    inq_db_lru.splice(inq_db_lru.end(), inq_db_lru, it->second);
+}
+
+/*******************************************************************************
+ *
+ * Function         btm_inq_db_rebuild_index
+ *
+ * Description      This function rebuilds the address index, the response
+ *                  order and the free entries from the inquiry database
+ *                  contents, after the entries have been moved around.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+static void btm_inq_db_rebuild_index(void) {
+  tBTM_INQUIRY_VAR_ST* p_inq = &btm_cb.btm_inq_vars;
+  std::vector<tINQ_DB_ENT*> in_use;
+  int xx;
+
+  inq_db_lru.clear();
+  inq_db_index.clear();
+  inq_db_free_list.clear();
+  inq_db_keep_count = 0;
+  inq_db_index.reserve(p_inq->inq_db_size);
+
+  /* Hand out free entries from the start of the database first */
+  for (xx = p_inq->inq_db_size - 1; xx >= 0; xx--) {
+    tINQ_DB_ENT* p_ent = &p_inq->inq_db[xx];
+    if (p_ent->in_use)
+      in_use.push_back(p_ent);
+    else
+      inq_db_free_list.push_back(p_ent);
+  }
+
+  std::stable_sort(in_use.begin(), in_use.end(),
+                   [](const tINQ_DB_ENT* a, const tINQ_DB_ENT* b) {
+                     return a->time_of_resp < b->time_of_resp;
+                   });
+  for (tINQ_DB_ENT* p_ent : in_use) {
+    if (p_ent->keep) inq_db_keep_count++;
+    inq_db_index[p_ent->inq_info.results.remote_bd_addr] =
+        inq_db_lru.insert(inq_db_lru.end(), p_ent);
+  }
 }
 
 /*******************************************************************************
@@ -1683,9 +1777,8 @@ static void btm_initiate_inquiry(tBTM_INQUIRY_VAR_ST* p_inq) {
 
   /* Make sure the number of responses doesn't overflow the database
    * configuration */
-  p_inqparms->max_resps = (uint8_t)((p_inqparms->max_resps <= BTM_INQ_DB_SIZE)
-                                        ? p_inqparms->max_resps
-                                        : BTM_INQ_DB_SIZE);
+  if (p_inqparms->max_resps > p_inq->inq_db_size)
+    p_inqparms->max_resps = (uint8_t)p_inq->inq_db_size;
 
   lap = (p_inq->inq_active & BTM_LIMITED_INQUIRY_ACTIVE) ? &limited_inq_lap
                                                          : &general_inq_lap;
@@ -1696,10 +1789,9 @@ static void btm_initiate_inquiry(tBTM_INQUIRY_VAR_ST* p_inq) {
   } else {
     btm_clr_inq_result_flt();
 
-    /* Allocate memory to hold bd_addrs responding */
-    p_inq->p_bd_db = (tINQ_BDADDR*)osi_calloc(BT_DEFAULT_BUFFER_SIZE);
-    p_inq->max_bd_entries =
-        (uint16_t)(BT_DEFAULT_BUFFER_SIZE / sizeof(tINQ_BDADDR));
+    /* Start tracking the bd_addrs responding */
+    p_inq->max_bd_entries = BTM_INQ_MAX_BD_ENTRIES;
+    inq_bd_db.reserve(BTM_INQ_MAX_BD_ENTRIES);
 
     btsnd_hcic_inquiry(*lap, p_inqparms->duration, 0);
   }
@@ -1866,7 +1958,7 @@ void btm_process_inq_results(uint8_t* p, uint8_t inq_res_mode) {
       BTM_TRACE_WARNING ("btm_process_inq_results: Dev class: %02x-%02x-%02x",
                   p_cur->dev_class[0], p_cur->dev_class[1], p_cur->dev_class[2]);
 
-      p_i->time_of_resp = time_get_os_boottime_ms();
+      btm_inq_db_update_resp_time(p_i);
 
       if (p_i->inq_count != p_inq->inq_counter)
         p_inq->inq_cmpl_info.num_resp++; /* A new response was found */
@@ -1929,15 +2021,14 @@ void btm_process_inq_results(uint8_t* p, uint8_t inq_res_mode) {
  *
  ******************************************************************************/
 void btm_sort_inq_result(void) {
-  uint8_t xx, yy, num_resp;
+  uint16_t xx, yy, num_resp;
   tINQ_DB_ENT* p_ent = btm_cb.btm_inq_vars.inq_db;
   tINQ_DB_ENT* p_next = btm_cb.btm_inq_vars.inq_db + 1;
   int size;
   tINQ_DB_ENT* p_tmp = (tINQ_DB_ENT*)osi_malloc(sizeof(tINQ_DB_ENT));
 
-  num_resp = (btm_cb.btm_inq_vars.inq_cmpl_info.num_resp < BTM_INQ_DB_SIZE)
-                 ? btm_cb.btm_inq_vars.inq_cmpl_info.num_resp
-                 : BTM_INQ_DB_SIZE;
+  num_resp = std::min<uint16_t>(btm_cb.btm_inq_vars.inq_cmpl_info.num_resp,
+                                btm_cb.btm_inq_vars.inq_db_size);
 
   size = sizeof(tINQ_DB_ENT);
   for (xx = 0; xx < num_resp - 1; xx++, p_ent++) {
@@ -1951,6 +2042,7 @@ void btm_sort_inq_result(void) {
   }
 
   osi_free(p_tmp);
+  btm_inq_db_rebuild_index();
 }
 
 /*******************************************************************************
@@ -1993,6 +2085,7 @@ void btm_process_inq_complete(uint8_t status, uint8_t mode) {
     /*end of LE observe*/
     p_inq->p_inq_ble_results_cb = (tBTM_INQ_RESULTS_CB*)NULL;
     p_inq->p_inq_ble_cmpl_cb = (tBTM_CMPL_CB*)NULL;
+    p_inq->p_inq_ble_batch_end_cb = (tBTM_INQ_BATCH_END_CB*)NULL;
     p_inq->scan_type = INQ_NONE;
   }
 
@@ -2056,7 +2149,7 @@ void btm_process_inq_complete(uint8_t status, uint8_t mode) {
     if (p_inq->p_inq_ble_results_cb != NULL) {
       BTM_TRACE_DEBUG("BTM Inq Compl: resuming a pending LE scan");
       BTM_BleObserve(1, 0, p_inq->p_inq_ble_results_cb,
-                     p_inq->p_inq_ble_cmpl_cb);
+                     p_inq->p_inq_ble_cmpl_cb, p_inq->p_inq_ble_batch_end_cb);
     }
   }
 #if (BTM_INQ_DEBUG == TRUE)
@@ -293,6 +293,8 @@ extern tL2CAP_LE_RESULT_CODE btm_ble_start_sec_check(
     tBTM_SEC_CALLBACK* p_callback, void* p_ref_data);
 
 extern tINQ_DB_ENT* btm_inq_db_new(const RawAddress& p_bda, bool keep);
+extern void btm_inq_db_release(tINQ_DB_ENT* p_ent);
+extern void btm_inq_db_update_resp_time(tINQ_DB_ENT* p_ent);
 
 extern void btm_rem_oob_req(uint8_t* p);
 extern void btm_read_local_oob_complete(uint8_t* p);
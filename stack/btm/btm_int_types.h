@@ -231,15 +231,6 @@ typedef struct {
 #define BTM_MIN_INQ_TX_POWER (-70)
 #define BTM_MAX_INQ_TX_POWER 20
 
-typedef struct {
-  uint32_t inq_count; /* Used for determining if a response has already been */
-  /* received for the current inquiry operation. (We do not   */
-  /* want to flood the caller with multiple responses from    */
-  /* the same device.                                         */
-  RawAddress bd_addr;
-  tBT_DEVICE_TYPE device_type;
-} tINQ_BDADDR;
-
 typedef struct {
   uint32_t time_of_resp;
   uint32_t
@@ -287,15 +278,17 @@ typedef struct {
       p_inq_ble_cmpl_cb; /*completion callback exclusively for LE Observe*/
   tBTM_INQ_RESULTS_CB*
       p_inq_ble_results_cb; /*results callback exclusively for LE observe*/
+  tBTM_INQ_BATCH_END_CB*
+      p_inq_ble_batch_end_cb; /*batch end callback exclusively for LE observe*/
   tBTM_CMPL_CB* p_inqfilter_cmpl_cb; /* Called (if not NULL) after inquiry
                                         filter completed */
   uint32_t inq_counter; /* Counter incremented each time an inquiry completes */
   /* Used for determining whether or not duplicate devices */
   /* have responded to the same inquiry */
-  tINQ_BDADDR* p_bd_db;    /* Pointer to memory that holds bdaddrs */
-  uint16_t num_bd_entries; /* Number of entries in database */
-  uint16_t max_bd_entries; /* Maximum number of entries that can be stored */
-  tINQ_DB_ENT inq_db[BTM_INQ_DB_SIZE];
+  uint16_t max_bd_entries; /* Maximum number of responders tracked, 0 if the
+                              current inquiry does not track them */
+  tINQ_DB_ENT* inq_db;  /* inq_db_size entries, see btm_inq_db_init */
+  uint16_t inq_db_size;
   tBTM_INQ_PARMS inqparms; /* Contains the parameters for the current inquiry */
   tBTM_INQUIRY_CMPL
       inq_cmpl_info; /* Status and number of responses from the last inquiry */
@@ -388,6 +381,8 @@ typedef struct {
   tBTM_ESCO_INFO esco; /* Current settings             */
 #if (BTM_SCO_HCI_INCLUDED == TRUE)
   fixed_queue_t* xmit_data_q; /* SCO data transmitting queue  */
+  tBTM_SCO_DATA_CB* p_data_cb; /* Own callback for SCO data over HCI, */
+                               /* NULL to follow BTM_ConfigScoPath   */
 #endif
   tBTM_SCO_CB* p_conn_cb; /* Callback for when connected  */
   tBTM_SCO_CB* p_disc_cb; /* Callback for when disconnect */
@@ -402,7 +397,8 @@ typedef struct {
 typedef struct {
   tBTM_SCO_IND_CBACK* app_sco_ind_cb;
 #if (BTM_SCO_HCI_INCLUDED == TRUE)
-  tBTM_SCO_DATA_CB* p_data_cb; /* Callback for SCO data over HCI */
+  tBTM_SCO_DATA_CB* p_data_cb; /* Callback for SCO data over HCI of the */
+                               /* links created with BTM_CreateSco     */
 #endif
   tSCO_CONN sco_db[BTM_MAX_SCO_LINKS];
   enh_esco_params_t def_esco_parms;
@@ -86,7 +86,6 @@ void btm_sco_flush_sco_data(uint16_t sco_inx) {
       osi_free(p_buf);
   }
 }
-}
 #else
 void btm_sco_flush_sco_data(UNUSED_ATTR uint16_t sco_inx) {}
 #endif
@@ -111,6 +110,37 @@ void btm_sco_init(void) {
   btm_cb.sco_cb.sco_route = ESCO_DATA_PATH_PCM;
 }
 
+/*******************************************************************************
+ *
+ * Function         btm_sco_data_path
+ *
+ * Description      Returns the data path of SCO link |p|: HCI for the links
+ *                  created with their own data callback, the route set with
+ *                  BTM_ConfigScoPath otherwise.
+ *
+ ******************************************************************************/
+static esco_data_path_t btm_sco_data_path(const tSCO_CONN* p) {
+#if (BTM_SCO_HCI_INCLUDED == TRUE)
+  if (p->p_data_cb != NULL) return ESCO_DATA_PATH_HCI;
+#endif
+  return btm_cb.sco_cb.sco_route;
+}
+
+#if (BTM_SCO_HCI_INCLUDED == TRUE)
+/*******************************************************************************
+ *
+ * Function         btm_sco_data_cb
+ *
+ * Description      Returns the callback the data received on SCO link |p| is
+ *                  passed to, NULL if it isn't routed over HCI.
+ *
+ ******************************************************************************/
+static tBTM_SCO_DATA_CB* btm_sco_data_cb(const tSCO_CONN* p) {
+  if (p->p_data_cb != NULL) return p->p_data_cb;
+  return btm_cb.sco_cb.p_data_cb;
+}
+#endif
+
 /*******************************************************************************
  *
  * Function         btm_esco_conn_rsp
@@ -192,9 +222,9 @@ static void btm_esco_conn_rsp(uint16_t sco_inx, uint8_t hci_status,
     if (controller_get_interface()
             ->supports_enhanced_setup_synchronous_connection() &&
          soc_type != BT_SOC_TYPE_SMD && soc_type != BT_SOC_TYPE_ROME) {
-      /* Use the saved SCO routing */
+      /* Use the SCO routing of the link */
       p_setup->input_data_path = p_setup->output_data_path =
-          btm_cb.sco_cb.sco_route;
+          btm_sco_data_path(p_sco);
 
       BTM_TRACE_DEBUG(
           "%s: txbw 0x%x, rxbw 0x%x, lat 0x%x, retrans 0x%02x, "
@@ -241,7 +271,8 @@ void btm_sco_check_send_pkts(uint16_t sco_inx) {
                     fixed_queue_length(p_ccb->xmit_data_q) + 1);
 #endif
 
-    HCI_SCO_DATA_TO_LOWER(p_buf);
+    bte_main_hci_send(p_buf, (uint16_t)(BT_EVT_TO_LM_HCI_SCO |
+                                        LOCAL_BR_EDR_CONTROLLER_ID));
   }
 }
 #endif /* BTM_SCO_HCI_INCLUDED == TRUE */
@@ -272,12 +303,13 @@ void btm_route_sco_data(BT_HDR* p_msg) {
   sco_inx = btm_find_scb_by_handle(handle);
   if (sco_inx != BTM_MAX_SCO_LINKS) {
     /* send data callback */
-    if (!btm_cb.sco_cb.p_data_cb)
+    tBTM_SCO_DATA_CB* p_data_cb =
+        btm_sco_data_cb(&btm_cb.sco_cb.sco_db[sco_inx]);
+    if (!p_data_cb)
       /* if no data callback registered,  just free the buffer  */
       osi_free(p_msg);
     else {
-      (*btm_cb.sco_cb.p_data_cb)(sco_inx, p_msg,
-                                 (tBTM_SCO_DATA_FLAG)pkt_status);
+      (*p_data_cb)(sco_inx, p_msg, (tBTM_SCO_DATA_FLAG)pkt_status);
     }
   } else /* no mapping handle SCO connection is active, free the buffer */
   {
@@ -288,6 +320,47 @@ void btm_route_sco_data(BT_HDR* p_msg) {
 #endif
 }
 
+/*******************************************************************************
+ *
+ * Function         BTM_ConfigScoPath
+ *
+ * Description      This function enable/disable SCO over HCI and registers SCO
+ *                  data callback if SCO over HCI is enabled. The path is
+ *                  applied to the next (e)SCO connections.
+ *
+ * Returns          BTM_SUCCESS if the successful.
+ *                  BTM_ILLEGAL_VALUE: invalid callback function pointer.
+ *
+ ******************************************************************************/
+#if (BTM_SCO_HCI_INCLUDED == TRUE)
+tBTM_STATUS BTM_ConfigScoPath(esco_data_path_t path,
+                              tBTM_SCO_DATA_CB* p_sco_data_cb,
+                              UNUSED_ATTR tBTM_SCO_PCM_PARAM* p_pcm_param,
+                              bool err_data_rpt) {
+  if (path == ESCO_DATA_PATH_HCI && p_sco_data_cb == NULL)
+    return BTM_ILLEGAL_VALUE;
+
+  btm_cb.sco_cb.sco_route = path;
+  btm_cb.sco_cb.p_data_cb =
+      (path == ESCO_DATA_PATH_HCI) ? p_sco_data_cb : NULL;
+
+  /* Have the controller report erroneous packets with their status instead of
+   * dropping them, so that the receiver can conceal them */
+  if (path == ESCO_DATA_PATH_HCI && err_data_rpt)
+    btsnd_hcic_write_default_erroneous_data_rpt(1);
+
+  return BTM_SUCCESS;
+}
+#else
+tBTM_STATUS BTM_ConfigScoPath(esco_data_path_t path,
+                              UNUSED_ATTR tBTM_SCO_DATA_CB* p_sco_data_cb,
+                              UNUSED_ATTR tBTM_SCO_PCM_PARAM* p_pcm_param,
+                              UNUSED_ATTR bool err_data_rpt) {
+  btm_cb.sco_cb.sco_route = path;
+  return BTM_SUCCESS;
+}
+#endif
+
 /*******************************************************************************
  *
  * Function         BTM_WriteScoData
@@ -315,7 +388,7 @@ tBTM_STATUS BTM_WriteScoData(uint16_t sco_inx, BT_HDR* p_buf) {
   uint8_t* p;
   tBTM_STATUS status = BTM_SUCCESS;
 
-  if (sco_inx < BTM_MAX_SCO_LINKS && btm_cb.sco_cb.p_data_cb &&
+  if (sco_inx < BTM_MAX_SCO_LINKS && btm_sco_data_cb(p_ccb) &&
       p_ccb->state == SCO_ST_CONNECTED) {
     /* Ensure we have enough space in the buffer for the SCO and HCI headers */
     if (p_buf->offset < HCI_SCO_PREAMBLE_SIZE) {
@@ -373,8 +446,9 @@ tBTM_STATUS BTM_WriteScoData(UNUSED_ATTR uint16_t sco_inx,
  * Returns          void
  *
  ******************************************************************************/
-static tBTM_STATUS btm_send_connect_request(uint16_t acl_handle,
-                                            enh_esco_params_t* p_setup) {
+static tBTM_STATUS btm_send_connect_request(tSCO_CONN* p_sco,
+                                            uint16_t acl_handle) {
+  enh_esco_params_t* p_setup = &p_sco->esco.setup;
   tACL_CONN* p_acl;
 
   /* Send connect request depending on version of spec */
@@ -458,9 +532,9 @@ static tBTM_STATUS btm_send_connect_request(uint16_t acl_handle,
     if (controller_get_interface()
             ->supports_enhanced_setup_synchronous_connection() &&
          soc_type != BT_SOC_TYPE_SMD && soc_type != BT_SOC_TYPE_ROME) {
-      /* Use the saved SCO routing */
+      /* Use the SCO routing of the link */
       p_setup->input_data_path = p_setup->output_data_path =
-          btm_cb.sco_cb.sco_route;
+          btm_sco_data_path(p_sco);
 
       LOG(INFO) << __func__ << std::hex << ": enhanced parameter list"
                 << " txbw=0x" << unsigned(p_setup->transmit_bandwidth)
@@ -563,27 +637,18 @@ void btm_reject_sco_link(uint16_t sco_inx) {
 
 /*******************************************************************************
  *
- * Function         BTM_CreateSco
+ * Function         btm_create_sco
  *
- * Description      This function is called to create an SCO connection. If the
- *                  "is_orig" flag is true, the connection will be originated,
- *                  otherwise BTM will wait for the other side to connect.
- *
- *                  NOTE:  If BTM_IGNORE_SCO_PKT_TYPE is passed in the pkt_types
- *                      parameter the default packet types is used.
- *
- * Returns          BTM_UNKNOWN_ADDR if the ACL connection is not up
- *                  BTM_BUSY         if another SCO being set up to
- *                                   the same BD address
- *                  BTM_NO_RESOURCES if the max SCO limit has been reached
- *                  BTM_CMD_STARTED  if the connection establishment is started.
- *                                   In this case, "*p_sco_inx" is filled in
- *                                   with the sco index used for the connection.
+ * Description      Creates an SCO connection, see BTM_CreateSco. The data of
+ *                  the link goes to |p_data_cb| over HCI if it isn't NULL,
+ *                  along the route set with BTM_ConfigScoPath otherwise.
  *
  ******************************************************************************/
-tBTM_STATUS BTM_CreateSco(const RawAddress* remote_bda, bool is_orig,
-                          uint16_t pkt_types, uint16_t* p_sco_inx,
-                          tBTM_SCO_CB* p_conn_cb, tBTM_SCO_CB* p_disc_cb) {
+static tBTM_STATUS btm_create_sco(const RawAddress* remote_bda, bool is_orig,
+                                  uint16_t pkt_types, uint16_t* p_sco_inx,
+                                  tBTM_SCO_CB* p_conn_cb,
+                                  tBTM_SCO_CB* p_disc_cb,
+                                  UNUSED_ATTR tBTM_SCO_DATA_CB* p_data_cb) {
 #if (BTM_MAX_SCO_LINKS > 0)
   enh_esco_params_t* p_setup;
   tSCO_CONN* p = &btm_cb.sco_cb.sco_db[0];
@@ -688,6 +753,9 @@ tBTM_STATUS BTM_CreateSco(const RawAddress* remote_bda, bool is_orig,
 
       p->p_conn_cb = p_conn_cb;
       p->p_disc_cb = p_disc_cb;
+#if (BTM_SCO_HCI_INCLUDED == TRUE)
+      p->p_data_cb = p_data_cb;
+#endif
       p->hci_handle = BTM_INVALID_HCI_HANDLE;
       p->is_orig = is_orig;
 
@@ -710,7 +778,7 @@ tBTM_STATUS BTM_CreateSco(const RawAddress* remote_bda, bool is_orig,
           BTM_TRACE_API("%s:(e)SCO Link for ACL handle 0x%04x", __func__,
                         acl_handle);
 
-          if ((btm_send_connect_request(acl_handle, p_setup)) !=
+          if ((btm_send_connect_request(p, acl_handle)) !=
               BTM_CMD_STARTED) {
             LOG(ERROR) << __func__ << ": failed to send connect request for "
                        << *remote_bda;
@@ -737,6 +805,59 @@ tBTM_STATUS BTM_CreateSco(const RawAddress* remote_bda, bool is_orig,
   return BTM_NO_RESOURCES;
 }
 
+/*******************************************************************************
+ *
+ * Function         BTM_CreateSco
+ *
+ * Description      This function is called to create an SCO connection. If the
+ *                  "is_orig" flag is true, the connection will be originated,
+ *                  otherwise BTM will wait for the other side to connect.
+ *
+ *                  NOTE:  If BTM_IGNORE_SCO_PKT_TYPE is passed in the pkt_types
+ *                      parameter the default packet types is used.
+ *
+ * Returns          BTM_UNKNOWN_ADDR if the ACL connection is not up
+ *                  BTM_BUSY         if another SCO being set up to
+ *                                   the same BD address
+ *                  BTM_NO_RESOURCES if the max SCO limit has been reached
+ *                  BTM_CMD_STARTED  if the connection establishment is started.
+ *                                   In this case, "*p_sco_inx" is filled in
+ *                                   with the sco index used for the connection.
+ *
+ ******************************************************************************/
+tBTM_STATUS BTM_CreateSco(const RawAddress* remote_bda, bool is_orig,
+                          uint16_t pkt_types, uint16_t* p_sco_inx,
+                          tBTM_SCO_CB* p_conn_cb, tBTM_SCO_CB* p_disc_cb) {
+  return btm_create_sco(remote_bda, is_orig, pkt_types, p_sco_inx, p_conn_cb,
+                        p_disc_cb, NULL);
+}
+
+#if (BTM_SCO_HCI_INCLUDED == TRUE)
+/*******************************************************************************
+ *
+ * Function         BTM_CreateScoOverHci
+ *
+ * Description      Creates an SCO connection like BTM_CreateSco, with its
+ *                  data routed over HCI to |p_sco_data_cb| whatever the route
+ *                  set with BTM_ConfigScoPath for the other links. The
+ *                  controller is asked to report erroneous packets.
+ *
+ * Returns          As BTM_CreateSco, BTM_ILLEGAL_VALUE if |p_sco_data_cb| is
+ *                  NULL.
+ *
+ ******************************************************************************/
+tBTM_STATUS BTM_CreateScoOverHci(const RawAddress* remote_bda, bool is_orig,
+                                 uint16_t pkt_types, uint16_t* p_sco_inx,
+                                 tBTM_SCO_CB* p_conn_cb, tBTM_SCO_CB* p_disc_cb,
+                                 tBTM_SCO_DATA_CB* p_sco_data_cb) {
+  if (p_sco_data_cb == NULL) return BTM_ILLEGAL_VALUE;
+
+  btsnd_hcic_write_default_erroneous_data_rpt(1);
+  return btm_create_sco(remote_bda, is_orig, pkt_types, p_sco_inx, p_conn_cb,
+                        p_disc_cb, p_sco_data_cb);
+}
+#endif
+
 #if (BTM_SCO_WAKE_PARKED_LINK == TRUE)
 /*******************************************************************************
  *
@@ -766,7 +887,7 @@ void btm_sco_chk_pend_unpark(uint8_t hci_status, uint16_t hci_handle) {
           "handle 0x%04x, hci_status 0x%02x",
           __func__, acl_handle, hci_status);
 
-      if ((btm_send_connect_request(acl_handle, &p->esco.setup)) ==
+      if ((btm_send_connect_request(p, acl_handle)) ==
           BTM_CMD_STARTED)
         p->state = SCO_ST_CONNECTING;
       else {
@@ -806,7 +927,7 @@ void btm_sco_chk_pend_rolechange(uint16_t hci_handle) {
           "btm_sco_chk_pend_rolechange -> (e)SCO Link for ACL handle 0x%04x",
           acl_handle);
 
-      if ((btm_send_connect_request(acl_handle, &p->esco.setup)) ==
+      if ((btm_send_connect_request(p, acl_handle)) ==
           BTM_CMD_STARTED)
         p->state = SCO_ST_CONNECTING;
     }
@@ -1596,9 +1717,9 @@ tBTM_STATUS BTM_ChangeEScoLinkParms(uint16_t sco_inx,
     if (controller_get_interface()
             ->supports_enhanced_setup_synchronous_connection() &&
          soc_type != BT_SOC_TYPE_SMD && soc_type != BT_SOC_TYPE_ROME) {
-      /* Use the saved SCO routing */
+      /* Use the SCO routing of the link */
       p_setup->input_data_path = p_setup->output_data_path =
-          btm_cb.sco_cb.sco_route;
+          btm_sco_data_path(p_sco);
 
       btsnd_hcic_enhanced_set_up_synchronous_connection(p_sco->hci_handle,
                                                         p_setup);
@@ -0,0 +1,536 @@
+/******************************************************************************
+ *
+ *  Copyright 2019 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+/******************************************************************************
+ *
+ *  This file implements the voice pipeline of SCO links routed over HCI:
+ *  frame reassembly, mSBC coding with the H2 synchronization header, the
+ *  playout jitter buffer and packet loss concealment.
+ *
+ ******************************************************************************/
+
+#include "btm_sco_voice.h"
+
+#include <string.h>
+
+#include "bt_target.h"
+#include "oi_codec_sbc.h"
+#include "oi_status.h"
+#include "osi/include/allocator.h"
+#include "sbc_encoder.h"
+
+/* On air an mSBC frame takes 60 bytes: the 2 byte H2 header, the 57 byte
+ * frame and one byte of padding. */
+#define MSBC_H2_LEN 2
+#define MSBC_PKT_LEN 60
+#define MSBC_FRAME_SAMPLES SBC_MSBC_SAMPLES
+
+/* CVSD frames are 7.5 ms of 16 bit linear PCM at 8 kHz. */
+#define CVSD_FRAME_SAMPLES 60
+#define CVSD_PKT_LEN (CVSD_FRAME_SAMPLES * 2)
+
+/* Until a packet is received, send packets of the size used with the
+ * default eSCO parameters. */
+#define TX_PKT_LEN_DEFAULT 60
+
+#define RX_BUF_LEN (CVSD_PKT_LEN + 256)
+#define TX_BUF_LEN (2 * CVSD_PKT_LEN + BTM_SCO_DATA_SIZE_MAX)
+
+/* The jitter buffer starts at this depth, and adapts once the arrival
+ * jitter has been measured over a window. A measured jitter below the slack
+ * is covered by the frame being played. */
+#define JB_INITIAL_TARGET 2
+#define JB_WINDOW_FRAMES 200
+#define JB_JITTER_SLACK_US 1000
+
+/* Packet loss concealment repeats the last pitch period found in the
+ * history, searched between 2.5 and 20 ms (400 to 50 Hz), by matching the
+ * last 5 ms. Values are for 16 kHz and halved for 8 kHz. */
+#define PLC_MIN_LAG 40
+#define PLC_MAX_LAG 320
+#define PLC_TEMPLATE_LEN 80
+#define PLC_HIST_LEN (PLC_MAX_LAG + PLC_TEMPLATE_LEN)
+
+/* The first lost frame is played at full level, each following one fades
+ * by a quarter, so that a burst longer than 30 ms turns into silence. */
+#define PLC_FADE_PER_FRAME 0.25f
+
+/* H2 header: 0x01 followed by the sequence number coded on a nibble pair. */
+static const uint8_t msbc_h2_seq[4] = {0x08, 0x38, 0xc8, 0xf8};
+
+typedef struct {
+  int16_t pcm[BTM_SCO_VOICE_MAX_FRAME_SAMPLES];
+  bool bad;
+} tSCO_VOICE_FRAME;
+
+struct tBTM_SCO_VOICE {
+  tBTM_SCO_VOICE_CODEC codec;
+  uint16_t frame_samples;
+  uint16_t plc_scale; /* 1 for 16 kHz, 2 for 8 kHz */
+
+  /* Reassembly of received packets into frames */
+  uint8_t rx_buf[RX_BUF_LEN];
+  tBTM_SCO_DATA_FLAG rx_status[RX_BUF_LEN]; /* status of each byte */
+  uint16_t rx_len;
+  uint16_t rx_skipped; /* bytes dropped while looking for an H2 header */
+  uint16_t rx_lost;    /* frames counted as lost since the last header */
+  int8_t rx_seq;       /* last H2 sequence number, -1 if none yet */
+
+  /* mSBC codec */
+  SBC_ENC_PARAMS encoder;
+  OI_CODEC_SBC_DECODER_CONTEXT decoder;
+  OI_CODEC_SBC_CODEC_DATA_MONO decoder_data;
+  uint8_t tx_seq;
+
+  /* Coded bytes waiting to be sent */
+  uint8_t tx_buf[TX_BUF_LEN];
+  uint16_t tx_len;
+  uint16_t tx_pkt_len;
+
+  /* Jitter buffer */
+  tSCO_VOICE_FRAME jb[BTM_SCO_VOICE_JB_MAX_FRAMES];
+  uint16_t jb_head;
+  uint16_t jb_count;
+  uint16_t jb_target;
+  bool jb_playing;
+
+  /* Arrival jitter, measured against the nominal frame clock */
+  uint64_t rx_timeline; /* frames received or known lost */
+  int64_t win_min_us;
+  int64_t win_max_us;
+  uint16_t win_frames;
+  uint32_t jitter_us;
+
+  /* Packet loss concealment */
+  int16_t plc_hist[PLC_HIST_LEN];
+  uint16_t plc_lag;
+  uint16_t plc_lost_run;
+  float plc_gain;
+
+  tBTM_SCO_VOICE_STATS stats;
+};
+
+/* Number of frames the jitter buffer needs to absorb |jitter_us|. */
+static uint16_t sco_voice_frames_for_jitter(int64_t jitter_us) {
+  int64_t frames = 1;
+  if (jitter_us > JB_JITTER_SLACK_US)
+    frames += (jitter_us - JB_JITTER_SLACK_US + BTM_SCO_VOICE_FRAME_US - 1) /
+              BTM_SCO_VOICE_FRAME_US;
+  if (frames > BTM_SCO_VOICE_JB_MAX_FRAMES - 2)
+    frames = BTM_SCO_VOICE_JB_MAX_FRAMES - 2;
+  return (uint16_t)frames;
+}
+
+/* Tracks how late frames arrive compared with the earliest one of the
+ * window. Lateness beyond the current target raises it at once, the target
+ * is only lowered one frame per window. */
+static void sco_voice_track_arrival(tBTM_SCO_VOICE* p_voice, uint64_t now_us) {
+  int64_t offset_us = (int64_t)now_us -
+                      (int64_t)(p_voice->rx_timeline * BTM_SCO_VOICE_FRAME_US);
+  p_voice->rx_timeline++;
+
+  if (p_voice->win_frames == 0 || offset_us < p_voice->win_min_us)
+    p_voice->win_min_us = offset_us;
+  if (p_voice->win_frames == 0 || offset_us > p_voice->win_max_us)
+    p_voice->win_max_us = offset_us;
+
+  int64_t late_us = offset_us - p_voice->win_min_us;
+  uint16_t needed = sco_voice_frames_for_jitter(late_us);
+  if (needed > p_voice->jb_target) p_voice->jb_target = needed;
+
+  if (++p_voice->win_frames < JB_WINDOW_FRAMES) return;
+
+  p_voice->jitter_us = (uint32_t)(p_voice->win_max_us - p_voice->win_min_us);
+  needed = sco_voice_frames_for_jitter(p_voice->jitter_us);
+  if (needed < p_voice->jb_target) p_voice->jb_target--;
+  p_voice->win_frames = 0;
+}
+
+/* Queues a frame for playout, |p_pcm| is NULL for a lost frame. */
+static void sco_voice_push_frame(tBTM_SCO_VOICE* p_voice, const int16_t* p_pcm,
+                                 uint64_t now_us) {
+  sco_voice_track_arrival(p_voice, now_us);
+
+  if (p_voice->jb_count == BTM_SCO_VOICE_JB_MAX_FRAMES) {
+    p_voice->jb_head = (p_voice->jb_head + 1) % BTM_SCO_VOICE_JB_MAX_FRAMES;
+    p_voice->jb_count--;
+    p_voice->stats.discarded_frames++;
+  }
+
+  tSCO_VOICE_FRAME* p_frame =
+      &p_voice->jb[(p_voice->jb_head + p_voice->jb_count) %
+                   BTM_SCO_VOICE_JB_MAX_FRAMES];
+  p_voice->jb_count++;
+  p_voice->stats.rx_frames++;
+
+  p_frame->bad = (p_pcm == NULL);
+  if (p_pcm)
+    memcpy(p_frame->pcm, p_pcm, p_voice->frame_samples * sizeof(int16_t));
+}
+
+static void sco_voice_consume_rx(tBTM_SCO_VOICE* p_voice, uint16_t len) {
+  p_voice->rx_len -= len;
+  memmove(p_voice->rx_buf, p_voice->rx_buf + len, p_voice->rx_len);
+  memmove(p_voice->rx_status, p_voice->rx_status + len,
+          p_voice->rx_len * sizeof(tBTM_SCO_DATA_FLAG));
+}
+
+/* The controller has no data for bytes reported as lost. */
+static bool sco_voice_is_lost(tBTM_SCO_DATA_FLAG status) {
+  return status == BTM_SCO_DATA_NONE || status == BTM_SCO_DATA_PAR_LOST;
+}
+
+/* CVSD tolerates bit errors, mSBC frames with any error are concealed. */
+static bool sco_voice_rx_is_bad(const tBTM_SCO_VOICE* p_voice, uint16_t len) {
+  for (uint16_t i = 0; i < len; i++) {
+    tBTM_SCO_DATA_FLAG status = p_voice->rx_status[i];
+    if (sco_voice_is_lost(status)) return true;
+    if (status != BTM_SCO_DATA_CORRECT &&
+        p_voice->codec == BTM_SCO_VOICE_CODEC_MSBC)
+      return true;
+  }
+  return false;
+}
+
+/* Drops the leading bytes the controller reported as lost, they cannot
+ * start a header. A frame is queued as lost for every frame worth of
+ * dropped bytes, so that playout conceals it on time. */
+static void sco_voice_skip_rx(tBTM_SCO_VOICE* p_voice, uint16_t len,
+                              uint64_t now_us) {
+  while (len < p_voice->rx_len && sco_voice_is_lost(p_voice->rx_status[len]))
+    len++;
+  p_voice->rx_skipped += len;
+  sco_voice_consume_rx(p_voice, len);
+
+  while (p_voice->rx_skipped >= MSBC_PKT_LEN) {
+    sco_voice_push_frame(p_voice, NULL, now_us);
+    p_voice->stats.rx_missing_frames++;
+    p_voice->rx_skipped -= MSBC_PKT_LEN;
+    p_voice->rx_lost++;
+  }
+}
+
+/* Returns the H2 sequence number of the mSBC packet at |p|, -1 if |p| does
+ * not start with an H2 header followed by the mSBC syncword. */
+static int sco_voice_h2_seq(const uint8_t* p) {
+  if (p[0] != 0x01 || p[MSBC_H2_LEN] != OI_mSBC_SYNCWORD) return -1;
+  for (int seq = 0; seq < 4; seq++) {
+    if (p[1] == msbc_h2_seq[seq]) return seq;
+  }
+  return -1;
+}
+
+static void sco_voice_assemble_msbc(tBTM_SCO_VOICE* p_voice,
+                                    uint64_t now_us) {
+  sco_voice_skip_rx(p_voice, 0, now_us);
+  while (p_voice->rx_len >= MSBC_PKT_LEN) {
+    uint16_t start = 0;
+    int seq = -1;
+    for (; start + MSBC_PKT_LEN <= p_voice->rx_len; start++) {
+      seq = sco_voice_h2_seq(p_voice->rx_buf + start);
+      if (seq >= 0) break;
+    }
+    if (seq < 0) {
+      /* Keep the tail, it may start a header */
+      sco_voice_skip_rx(p_voice, start, now_us);
+      continue;
+    }
+    p_voice->rx_skipped += start;
+    sco_voice_consume_rx(p_voice, start);
+
+    /* Account for the frames lost since the last header: as many as the
+     * skipped bytes could hold, rounded up to match the sequence gap. */
+    uint16_t lost = p_voice->rx_lost +
+                    (p_voice->rx_skipped + MSBC_PKT_LEN / 2) / MSBC_PKT_LEN;
+    if (p_voice->rx_seq >= 0) {
+      int gap = (seq - p_voice->rx_seq - 1) & 3;
+      while ((lost & 3) != gap) lost++;
+    }
+    for (uint16_t i = p_voice->rx_lost; i < lost; i++) {
+      sco_voice_push_frame(p_voice, NULL, now_us);
+      p_voice->stats.rx_missing_frames++;
+    }
+    p_voice->rx_skipped = 0;
+    p_voice->rx_lost = 0;
+    p_voice->rx_seq = seq;
+
+    int16_t pcm[MSBC_FRAME_SAMPLES];
+    bool decoded = false;
+    if (!sco_voice_rx_is_bad(p_voice, MSBC_PKT_LEN)) {
+      const OI_BYTE* p_frame = p_voice->rx_buf + MSBC_H2_LEN;
+      uint32_t frame_bytes = SBC_MSBC_FRAME_LEN;
+      uint32_t pcm_bytes = sizeof(pcm);
+      OI_STATUS status = OI_CODEC_SBC_DecodeFrame(
+          &p_voice->decoder, &p_frame, &frame_bytes, pcm, &pcm_bytes);
+      decoded = OI_SUCCESS(status) && pcm_bytes == sizeof(pcm);
+    }
+    if (!decoded) p_voice->stats.rx_bad_frames++;
+    sco_voice_push_frame(p_voice, decoded ? pcm : NULL, now_us);
+    sco_voice_consume_rx(p_voice, MSBC_PKT_LEN);
+  }
+}
+
+static void sco_voice_assemble_cvsd(tBTM_SCO_VOICE* p_voice,
+                                    uint64_t now_us) {
+  while (p_voice->rx_len >= CVSD_PKT_LEN) {
+    int16_t pcm[CVSD_FRAME_SAMPLES];
+    const uint8_t* p = p_voice->rx_buf;
+    for (int i = 0; i < CVSD_FRAME_SAMPLES; i++, p += 2)
+      pcm[i] = (int16_t)(p[0] | (p[1] << 8));
+
+    bool bad = sco_voice_rx_is_bad(p_voice, CVSD_PKT_LEN);
+    if (bad) p_voice->stats.rx_bad_frames++;
+    sco_voice_push_frame(p_voice, bad ? NULL : pcm, now_us);
+    sco_voice_consume_rx(p_voice, CVSD_PKT_LEN);
+  }
+}
+
+/* Returns the lag that best continues the history as a periodic signal. */
+static uint16_t sco_voice_plc_find_lag(const tBTM_SCO_VOICE* p_voice) {
+  uint16_t min_lag = PLC_MIN_LAG / p_voice->plc_scale;
+  uint16_t max_lag = PLC_MAX_LAG / p_voice->plc_scale;
+  uint16_t template_len = PLC_TEMPLATE_LEN / p_voice->plc_scale;
+  const int16_t* p_template = p_voice->plc_hist + PLC_HIST_LEN - template_len;
+
+  uint16_t best_lag = max_lag;
+  float best_score = 0;
+  for (uint16_t lag = min_lag; lag <= max_lag; lag++) {
+    const int16_t* p_past = p_template - lag;
+    int64_t corr = 0, energy = 0;
+    for (uint16_t i = 0; i < template_len; i++) {
+      corr += p_template[i] * p_past[i];
+      energy += p_past[i] * p_past[i];
+    }
+    if (corr <= 0) continue;
+
+    /* Normalized correlation, squared to keep the sign test above */
+    float score = (float)corr * (float)corr / (float)energy;
+    if (score > best_score) {
+      best_score = score;
+      best_lag = lag;
+    }
+  }
+  return best_lag;
+}
+
+/* Continues the history periodically for |len| samples. */
+static void sco_voice_plc_extend(const tBTM_SCO_VOICE* p_voice,
+                                 int16_t* p_out, uint16_t len) {
+  for (uint16_t i = 0; i < len; i++) {
+    int idx = (int)i - p_voice->plc_lag;
+    p_out[i] = idx < 0 ? p_voice->plc_hist[PLC_HIST_LEN + idx] : p_out[idx];
+  }
+}
+
+static void sco_voice_plc_append(tBTM_SCO_VOICE* p_voice,
+                                 const int16_t* p_pcm) {
+  uint16_t len = p_voice->frame_samples;
+  memmove(p_voice->plc_hist, p_voice->plc_hist + len,
+          (PLC_HIST_LEN - len) * sizeof(int16_t));
+  memcpy(p_voice->plc_hist + PLC_HIST_LEN - len, p_pcm, len * sizeof(int16_t));
+}
+
+static void sco_voice_plc_conceal(tBTM_SCO_VOICE* p_voice, int16_t* p_pcm) {
+  uint16_t len = p_voice->frame_samples;
+  if (p_voice->plc_lost_run == 0)
+    p_voice->plc_lag = sco_voice_plc_find_lag(p_voice);
+  p_voice->plc_lost_run++;
+  p_voice->stats.concealed_frames++;
+
+  int16_t synth[BTM_SCO_VOICE_MAX_FRAME_SAMPLES];
+  sco_voice_plc_extend(p_voice, synth, len);
+
+  float gain_start = p_voice->plc_gain;
+  float gain_end = 1.0f - (p_voice->plc_lost_run - 1) * PLC_FADE_PER_FRAME;
+  if (gain_end < 0) gain_end = 0;
+  for (uint16_t i = 0; i < len; i++) {
+    float gain = gain_start + (gain_end - gain_start) * (i + 1) / len;
+    p_pcm[i] = (int16_t)(synth[i] * gain);
+  }
+  p_voice->plc_gain = gain_end;
+
+  /* The history keeps the unattenuated signal, so that the next lost frame
+   * continues the same waveform. */
+  sco_voice_plc_append(p_voice, synth);
+}
+
+/* Plays a good frame, cross-fading from the concealment that preceded it.
+ * The mSBC decoder restarts from stale filter state after a loss, the fade
+ * covers its settling time. */
+static void sco_voice_plc_good(tBTM_SCO_VOICE* p_voice, const int16_t* p_in,
+                               int16_t* p_pcm) {
+  uint16_t len = p_voice->frame_samples;
+  memcpy(p_pcm, p_in, len * sizeof(int16_t));
+
+  if (p_voice->plc_lost_run > 0) {
+    uint16_t fade_len = len / 2;
+    int16_t synth[BTM_SCO_VOICE_MAX_FRAME_SAMPLES];
+    sco_voice_plc_extend(p_voice, synth, fade_len);
+    for (uint16_t i = 0; i < fade_len; i++) {
+      float w = (float)(i + 1) / (fade_len + 1);
+      p_pcm[i] =
+          (int16_t)(w * p_in[i] + (1.0f - w) * p_voice->plc_gain * synth[i]);
+    }
+    p_voice->plc_lost_run = 0;
+  }
+  p_voice->plc_gain = 1.0f;
+
+  sco_voice_plc_append(p_voice, p_in);
+}
+
+tBTM_SCO_VOICE* BTM_ScoVoiceNew(tBTM_SCO_VOICE_CODEC codec) {
+  tBTM_SCO_VOICE* p_voice =
+      (tBTM_SCO_VOICE*)osi_calloc(sizeof(tBTM_SCO_VOICE));
+
+  p_voice->codec = codec;
+  p_voice->rx_seq = -1;
+  p_voice->tx_pkt_len = TX_PKT_LEN_DEFAULT;
+  p_voice->jb_target = JB_INITIAL_TARGET;
+  p_voice->plc_gain = 1.0f;
+
+  if (codec == BTM_SCO_VOICE_CODEC_MSBC) {
+    p_voice->frame_samples = MSBC_FRAME_SAMPLES;
+    p_voice->plc_scale = 1;
+
+    p_voice->encoder.Format = SBC_FORMAT_MSBC;
+    SBC_Encoder_Init(&p_voice->encoder);
+
+    OI_STATUS status = OI_CODEC_mSBC_DecoderReset(
+        &p_voice->decoder, p_voice->decoder_data.data,
+        sizeof(p_voice->decoder_data.data));
+    if (!OI_SUCCESS(status)) {
+      osi_free(p_voice);
+      return NULL;
+    }
+  } else {
+    p_voice->frame_samples = CVSD_FRAME_SAMPLES;
+    p_voice->plc_scale = 2;
+  }
+
+  return p_voice;
+}
+
+void BTM_ScoVoiceFree(tBTM_SCO_VOICE* p_voice) { osi_free(p_voice); }
+
+uint16_t BTM_ScoVoiceFrameSamples(const tBTM_SCO_VOICE* p_voice) {
+  return p_voice->frame_samples;
+}
+
+void BTM_ScoVoiceReceive(tBTM_SCO_VOICE* p_voice, const uint8_t* p_data,
+                         uint16_t len, tBTM_SCO_DATA_FLAG status,
+                         uint64_t now_us) {
+  if (len == 0) return;
+  if (len <= BTM_SCO_DATA_SIZE_MAX) p_voice->tx_pkt_len = len;
+
+  while (len > 0) {
+    uint16_t copy_len = RX_BUF_LEN - p_voice->rx_len;
+    if (copy_len > len) copy_len = len;
+    memcpy(p_voice->rx_buf + p_voice->rx_len, p_data, copy_len);
+    memset(p_voice->rx_status + p_voice->rx_len, status,
+           copy_len * sizeof(tBTM_SCO_DATA_FLAG));
+    p_voice->rx_len += copy_len;
+    p_data += copy_len;
+    len -= copy_len;
+
+    if (p_voice->codec == BTM_SCO_VOICE_CODEC_MSBC)
+      sco_voice_assemble_msbc(p_voice, now_us);
+    else
+      sco_voice_assemble_cvsd(p_voice, now_us);
+  }
+}
+
+void BTM_ScoVoiceReadPcm(tBTM_SCO_VOICE* p_voice, int16_t* p_pcm) {
+  if (!p_voice->jb_playing) {
+    if (p_voice->jb_count < p_voice->jb_target) {
+      memset(p_pcm, 0, p_voice->frame_samples * sizeof(int16_t));
+      return;
+    }
+    p_voice->jb_playing = true;
+  }
+
+  /* Shed the latency left over from a jitter burst, one frame at a time */
+  if (p_voice->jb_count > p_voice->jb_target + 1) {
+    p_voice->jb_head = (p_voice->jb_head + 1) % BTM_SCO_VOICE_JB_MAX_FRAMES;
+    p_voice->jb_count--;
+    p_voice->stats.discarded_frames++;
+  }
+
+  if (p_voice->jb_count == 0) {
+    p_voice->stats.underruns++;
+    sco_voice_plc_conceal(p_voice, p_pcm);
+    return;
+  }
+
+  const tSCO_VOICE_FRAME* p_frame = &p_voice->jb[p_voice->jb_head];
+  p_voice->jb_head = (p_voice->jb_head + 1) % BTM_SCO_VOICE_JB_MAX_FRAMES;
+  p_voice->jb_count--;
+
+  if (p_frame->bad)
+    sco_voice_plc_conceal(p_voice, p_pcm);
+  else
+    sco_voice_plc_good(p_voice, p_frame->pcm, p_pcm);
+}
+
+void BTM_ScoVoiceWritePcm(tBTM_SCO_VOICE* p_voice, const int16_t* p_pcm) {
+  uint16_t frame_len = p_voice->codec == BTM_SCO_VOICE_CODEC_MSBC
+                           ? MSBC_PKT_LEN
+                           : CVSD_PKT_LEN;
+
+  /* Nobody is sending, drop the oldest frame rather than the newest */
+  if (p_voice->tx_len + frame_len > TX_BUF_LEN) {
+    p_voice->tx_len -= frame_len;
+    memmove(p_voice->tx_buf, p_voice->tx_buf + frame_len, p_voice->tx_len);
+  }
+
+  uint8_t* p = p_voice->tx_buf + p_voice->tx_len;
+  if (p_voice->codec == BTM_SCO_VOICE_CODEC_MSBC) {
+    int16_t pcm[MSBC_FRAME_SAMPLES];
+    memcpy(pcm, p_pcm, sizeof(pcm));
+
+    p[0] = 0x01;
+    p[1] = msbc_h2_seq[p_voice->tx_seq];
+    p_voice->tx_seq = (p_voice->tx_seq + 1) & 3;
+    SBC_Encode(&p_voice->encoder, pcm, p + MSBC_H2_LEN);
+    p[MSBC_PKT_LEN - 1] = 0;
+  } else {
+    for (int i = 0; i < CVSD_FRAME_SAMPLES; i++) {
+      *p++ = (uint8_t)(p_pcm[i] & 0xff);
+      *p++ = (uint8_t)((p_pcm[i] >> 8) & 0xff);
+    }
+  }
+  p_voice->tx_len += frame_len;
+  p_voice->stats.tx_frames++;
+}
+
+uint16_t BTM_ScoVoiceGetTxPacket(tBTM_SCO_VOICE* p_voice, uint8_t* p_buf) {
+  uint16_t len = p_voice->tx_pkt_len;
+  if (p_voice->tx_len < len) return 0;
+
+  memcpy(p_buf, p_voice->tx_buf, len);
+  p_voice->tx_len -= len;
+  memmove(p_voice->tx_buf, p_voice->tx_buf + len, p_voice->tx_len);
+  return len;
+}
+
+void BTM_ScoVoiceGetStats(const tBTM_SCO_VOICE* p_voice,
+                          tBTM_SCO_VOICE_STATS* p_stats) {
+  *p_stats = p_voice->stats;
+  p_stats->jitter_buffer_depth = p_voice->jb_count;
+  p_stats->jitter_buffer_target = p_voice->jb_target;
+  p_stats->jitter_us = p_voice->jitter_us;
+}
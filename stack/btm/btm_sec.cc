@@ -41,6 +41,7 @@
 #include "btu.h"
 #include "hcimsgs.h"
 #include "l2c_int.h"
+#include "sdp_api.h"
 
 #include "gatt_int.h"
 #include "device/include/device_iot_config.h"
@@ -4917,8 +4918,11 @@ void btm_sec_link_key_notification(const RawAddress& p_bda,
   /* If connection was made to do bonding restore link security if changed */
   btm_restore_mode();
 
-  if (key_type != BTM_LKEY_TYPE_CHANGED_COMB)
+  if (key_type != BTM_LKEY_TYPE_CHANGED_COMB) {
     p_dev_rec->link_key_type = key_type;
+    /* A new bond may mean the device was reset or updated */
+    SDP_InvalidateDiscoveryCache(p_bda);
+  }
 
   p_dev_rec->sec_flags |= BTM_SEC_LINK_KEY_KNOWN;
 
@@ -33,6 +33,7 @@
 #include "bte.h"
 #include "btif/include/btif_common.h"
 #include "osi/include/osi.h"
+#include "osi/include/packet_trace.h"
 #include "osi/include/thread.h"
 #include "stack/btm/btm_int.h"
 #include "stack/include/btu.h"
@@ -48,12 +49,14 @@ extern thread_t* bt_workqueue_thread;
 static base::MessageLoop* message_loop_ = NULL;
 static base::RunLoop* run_loop_ = NULL;
 static thread_t* message_loop_thread_;
+static task_stats_t* message_loop_task_stats_ = NULL;
 
 void btu_hci_msg_process(BT_HDR* p_msg) {
   /* Determine the input message type. */
   switch (p_msg->event & BT_EVT_MASK) {
     case BT_EVT_TO_BTU_HCI_ACL:
       /* All Acl Data goes to L2CAP */
+      PACKET_TRACE(PACKET_TRACE_BTU_RX, p_msg, 0, p_msg->len);
       l2c_rcv_acl_data(p_msg);
       break;
 
@@ -85,6 +88,8 @@ void btu_hci_msg_process(BT_HDR* p_msg) {
 
 base::MessageLoop* get_message_loop() { return message_loop_; }
 
+task_stats_t* get_message_loop_task_stats() { return message_loop_task_stats_; }
+
 void btu_message_loop_run(UNUSED_ATTR void* context) {
   message_loop_ = new base::MessageLoop();
   run_loop_ = new base::RunLoop();
@@ -128,6 +133,7 @@ void btu_task_start_up(UNUSED_ATTR void* context) {
     LOG(FATAL) << __func__ << " unable to create btu message loop thread.";
   }
 
+  message_loop_task_stats_ = thread_get_task_stats(message_loop_thread_);
   thread_set_rt_priority(message_loop_thread_, THREAD_RT_PRIORITY);
   thread_post(message_loop_thread_, btu_message_loop_run, nullptr);
 
@@ -26,6 +26,7 @@
 #include "bt_common.h"
 #include "bt_target.h"
 #include "btu.h"
+#include "hci_packet_view.h"
 #include "hcidefs.h"
 #include "hcimsgs.h"
 
@@ -165,35 +166,31 @@ void btsnd_hcic_ble_set_scan_params(uint8_t scan_type, uint16_t scan_int,
                                     uint16_t scan_win, uint8_t addr_type_own,
                                     uint8_t scan_filter_policy) {
   BT_HDR* p = (BT_HDR*)osi_malloc(HCI_CMD_BUF_SIZE);
-  uint8_t* pp = (uint8_t*)(p + 1);
-
-  p->len = HCIC_PREAMBLE_SIZE + HCIC_PARAM_SIZE_BLE_WRITE_SCAN_PARAM;
+  p->len = 0;
   p->offset = 0;
 
-  UINT16_TO_STREAM(pp, HCI_BLE_WRITE_SCAN_PARAMS);
-  UINT8_TO_STREAM(pp, HCIC_PARAM_SIZE_BLE_WRITE_SCAN_PARAM);
-
-  UINT8_TO_STREAM(pp, scan_type);
-  UINT16_TO_STREAM(pp, scan_int);
-  UINT16_TO_STREAM(pp, scan_win);
-  UINT8_TO_STREAM(pp, addr_type_own);
-  UINT8_TO_STREAM(pp, scan_filter_policy);
+  HciPacketBuilder(p, HCI_CMD_BUF_SIZE - BT_HDR_SIZE)
+      .Append<uint16_t>(HCI_BLE_WRITE_SCAN_PARAMS)
+      .Append<uint8_t>(HCIC_PARAM_SIZE_BLE_WRITE_SCAN_PARAM)
+      .Append(scan_type)
+      .Append(scan_int)
+      .Append(scan_win)
+      .Append(addr_type_own)
+      .Append(scan_filter_policy);
 
   btu_hcif_send_cmd(LOCAL_BR_EDR_CONTROLLER_ID, p);
 }
 
 void btsnd_hcic_ble_set_scan_enable(uint8_t scan_enable, uint8_t duplicate) {
   BT_HDR* p = (BT_HDR*)osi_malloc(HCI_CMD_BUF_SIZE);
-  uint8_t* pp = (uint8_t*)(p + 1);
-
-  p->len = HCIC_PREAMBLE_SIZE + HCIC_PARAM_SIZE_BLE_WRITE_SCAN_ENABLE;
+  p->len = 0;
   p->offset = 0;
 
-  UINT16_TO_STREAM(pp, HCI_BLE_WRITE_SCAN_ENABLE);
-  UINT8_TO_STREAM(pp, HCIC_PARAM_SIZE_BLE_WRITE_SCAN_ENABLE);
-
-  UINT8_TO_STREAM(pp, scan_enable);
-  UINT8_TO_STREAM(pp, duplicate);
+  HciPacketBuilder(p, HCI_CMD_BUF_SIZE - BT_HDR_SIZE)
+      .Append<uint16_t>(HCI_BLE_WRITE_SCAN_ENABLE)
+      .Append<uint8_t>(HCIC_PARAM_SIZE_BLE_WRITE_SCAN_ENABLE)
+      .Append(scan_enable)
+      .Append(duplicate);
 
   btu_hcif_send_cmd(LOCAL_BR_EDR_CONTROLLER_ID, p);
 }
@@ -731,26 +728,25 @@ void btsnd_hcic_ble_set_extended_scan_params(uint8_t own_address_type,
                                              uint8_t scanning_phys,
                                              scanning_phy_cfg* phy_cfg) {
   BT_HDR* p = (BT_HDR*)osi_malloc(HCI_CMD_BUF_SIZE);
-  uint8_t* pp = (uint8_t*)(p + 1);
+  p->len = 0;
+  p->offset = 0;
 
   int phy_cnt =
       std::bitset<std::numeric_limits<uint8_t>::digits>(scanning_phys).count();
 
-  uint16_t param_len = 3 + (5 * phy_cnt);
-  p->len = HCIC_PREAMBLE_SIZE + param_len;
-  p->offset = 0;
-
-  UINT16_TO_STREAM(pp, HCI_LE_SET_EXTENDED_SCAN_PARAMETERS);
-  UINT8_TO_STREAM(pp, param_len);
+  uint8_t param_len = 3 + (5 * phy_cnt);
 
-  UINT8_TO_STREAM(pp, own_address_type);
-  UINT8_TO_STREAM(pp, scanning_filter_policy);
-  UINT8_TO_STREAM(pp, scanning_phys);
+  HciPacketBuilder builder(p, HCI_CMD_BUF_SIZE - BT_HDR_SIZE);
+  builder.Append<uint16_t>(HCI_LE_SET_EXTENDED_SCAN_PARAMETERS)
+      .Append(param_len)
+      .Append(own_address_type)
+      .Append(scanning_filter_policy)
+      .Append(scanning_phys);
 
   for (int i = 0; i < phy_cnt; i++) {
-    UINT8_TO_STREAM(pp, phy_cfg[i].scan_type);
-    UINT16_TO_STREAM(pp, phy_cfg[i].scan_int);
-    UINT16_TO_STREAM(pp, phy_cfg[i].scan_win);
+    builder.Append(phy_cfg[i].scan_type)
+        .Append(phy_cfg[i].scan_int)
+        .Append(phy_cfg[i].scan_win);
   }
 
   btu_hcif_send_cmd(LOCAL_BR_EDR_CONTROLLER_ID, p);
@@ -761,19 +757,17 @@ void btsnd_hcic_ble_set_extended_scan_enable(uint8_t enable,
                                              uint16_t duration,
                                              uint16_t period) {
   BT_HDR* p = (BT_HDR*)osi_malloc(HCI_CMD_BUF_SIZE);
-  uint8_t* pp = (uint8_t*)(p + 1);
-
-  const int param_len = 6;
-  p->len = HCIC_PREAMBLE_SIZE + param_len;
+  p->len = 0;
   p->offset = 0;
 
-  UINT16_TO_STREAM(pp, HCI_LE_SET_EXTENDED_SCAN_ENABLE);
-  UINT8_TO_STREAM(pp, param_len);
-
-  UINT8_TO_STREAM(pp, enable);
-  UINT8_TO_STREAM(pp, filter_duplicates);
-  UINT16_TO_STREAM(pp, duration);
-  UINT16_TO_STREAM(pp, period);
+  const uint8_t param_len = 6;
+  HciPacketBuilder(p, HCI_CMD_BUF_SIZE - BT_HDR_SIZE)
+      .Append<uint16_t>(HCI_LE_SET_EXTENDED_SCAN_ENABLE)
+      .Append(param_len)
+      .Append(enable)
+      .Append(filter_duplicates)
+      .Append(duration)
+      .Append(period);
 
   btu_hcif_send_cmd(LOCAL_BR_EDR_CONTROLLER_ID, p);
 }
@@ -2118,7 +2118,9 @@ extern uint8_t BTM_GetEirUuidList(uint8_t* p_eir, size_t eir_len,
  * Function         BTM_ConfigScoPath
  *
  * Description      This function enable/disable SCO over HCI and registers SCO
- *                  data callback if SCO over HCI is enabled.
+ *                  data callback if SCO over HCI is enabled. It applies to the
+ *                  links created with BTM_CreateSco, not to the ones created
+ *                  with BTM_CreateScoOverHci.
  *
  * Parameter        path: SCO or HCI
  *                  p_sco_data_cb: callback function or SCO data if path is set
@@ -2143,6 +2145,26 @@ extern tBTM_STATUS BTM_ConfigScoPath(esco_data_path_t path,
                                      tBTM_SCO_PCM_PARAM* p_pcm_param,
                                      bool err_data_rpt);
 
+/*******************************************************************************
+ *
+ * Function         BTM_CreateScoOverHci
+ *
+ * Description      This function is called to create an SCO connection like
+ *                  BTM_CreateSco, with its data routed over HCI to
+ *                  p_sco_data_cb whatever the path set with BTM_ConfigScoPath
+ *                  for the other links.
+ *
+ * Returns          As BTM_CreateSco.
+ *                  BTM_ILLEGAL_VALUE: invalid callback function pointer.
+ *
+ ******************************************************************************/
+extern tBTM_STATUS BTM_CreateScoOverHci(const RawAddress* remote_bda,
+                                        bool is_orig, uint16_t pkt_types,
+                                        uint16_t* p_sco_inx,
+                                        tBTM_SCO_CB* p_conn_cb,
+                                        tBTM_SCO_CB* p_disc_cb,
+                                        tBTM_SCO_DATA_CB* p_sco_data_cb);
+
 /*******************************************************************************
  *
  * Function         BTM_WriteScoData
@@ -734,6 +734,12 @@ typedef void(tBTM_INQ_DB_CHANGE_CB)(void* p1, bool is_new);
 typedef void(tBTM_INQ_RESULTS_CB)(tBTM_INQ_RESULTS* p_inq_results,
                                   uint8_t* p_eir, uint16_t eir_len);
 
+/* Callback function for notifications that the inquiry responses of one HCI
+ * event were all passed to the results callback, so that the receiver can
+ * hand them on as a batch.
+*/
+typedef void(tBTM_INQ_BATCH_END_CB)(void);
+
 /*****************************************************************************
  *  ACL CHANNEL MANAGEMENT
  ****************************************************************************/
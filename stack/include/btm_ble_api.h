@@ -189,13 +189,16 @@ extern void BTM_BleWriteScanRsp(uint8_t* data, uint8_t length,
  *                  events from a broadcast device.
  *
  * Parameters       start: start or stop observe.
+ *                  p_batch_end_cb: called, if not NULL, after the results
+ *                  of each advertising report event were reported.
  *
  * Returns          void
  *
  ******************************************************************************/
 extern tBTM_STATUS BTM_BleObserve(bool start, uint8_t duration,
                                   tBTM_INQ_RESULTS_CB* p_results_cb,
-                                  tBTM_CMPL_CB* p_cmpl_cb);
+                                  tBTM_CMPL_CB* p_cmpl_cb,
+                                  tBTM_INQ_BATCH_END_CB* p_batch_end_cb);
 
 /** Returns local device encryption root (ER) */
 const Octet16& BTM_GetDeviceEncRoot();
@@ -777,6 +780,10 @@ extern void BTM_BleAdvFilterParamSetup(
 
 /**
  * This functions are called to configure the adv data payload filter condition
+ *
+ * When the controller doesn't support APCF, these functions and
+ * BTM_BleAdvFilterParamSetup() set up the same filters on the host, and the
+ * advertising reports are matched against them before they are processed.
  */
 extern void BTM_LE_PF_set(tBTM_BLE_PF_FILT_INDEX filt_index,
                           std::vector<ApcfCommand> commands,
@@ -796,6 +803,17 @@ extern void BTM_LE_PF_clear(tBTM_BLE_PF_FILT_INDEX filt_index,
 extern void BTM_BleEnableDisableFilterFeature(
     uint8_t enable, tBTM_BLE_PF_STATUS_CBACK p_stat_cback);
 
+/*******************************************************************************
+ *
+ * Function         BTM_BleMaxAdvFilterSupported
+ *
+ * Description      Returns the number of advertising packet content filters:
+ *                  those of the controller if it supports APCF, those of the
+ *                  host filter otherwise
+ *
+ ******************************************************************************/
+extern uint8_t BTM_BleMaxAdvFilterSupported(void);
+
 /*******************************************************************************
  *
  * Function         BTM_BleGetEnergyInfo
@@ -0,0 +1,177 @@
+/******************************************************************************
+ *
+ *  Copyright 2019 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+/******************************************************************************
+ *
+ *  Host side advertising packet content filter.
+ *
+ *  Applies the scan filters that the APCF vendor commands program into
+ *  controllers supporting them, for controllers that don't. Filters are set
+ *  up in the same steps: conditions are added to a filter index, the index
+ *  is set up with the features it checks and its RSSI threshold, and
+ *  filtering as a whole is enabled.
+ *
+ *  Whenever the filters change, their conditions are compiled into indexes
+ *  keyed by what a report carries: its address, the UUIDs it lists, its
+ *  local name, and the first two bytes of its manufacturer and service data
+ *  (the company identifier and the 16 bit service UUID). The value of a key
+ *  is the bitmask of the filters it satisfies, so a report is matched
+ *  against all filters at once, walking its AD structures a single time.
+ *
+ *  Within a filter the selected features must all be met, and conditions of
+ *  the same feature are alternatives, as with the list and filter logic the
+ *  framework programs. Filtering is a first pass made before the reports
+ *  are processed: filters selecting a feature the host doesn't check (the
+ *  transport discovery data and group filters) let every report through,
+ *  and the framework still matches the results against its scan filters.
+ *
+ *  A filter is not thread safe, the caller serializes all calls on it.
+ *
+ ******************************************************************************/
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "bt_types.h"
+#include "btm_api_types.h"
+#include "btm_ble_api_types.h"
+#include "types/raw_address.h"
+
+/* Number of filter indexes of the host filter, one bit of a mask each */
+#define BTM_BLE_HOST_FILTER_MAX 64
+
+class BleHostFilter {
+ public:
+  // Adds |commands| to the conditions of filter |filt_index|. Conditions
+  // only take part in the matching when the filter selects their feature.
+  // Returns false if |filt_index| is out of range.
+  bool AddConditions(tBTM_BLE_PF_FILT_INDEX filt_index,
+                     const std::vector<ApcfCommand>& commands);
+
+  // Removes all the conditions of filter |filt_index|.
+  void ClearConditions(tBTM_BLE_PF_FILT_INDEX filt_index);
+
+  // Sets up filter |filt_index| with the features selected by |params| and
+  // its RSSI threshold, and makes it take part in the matching. A filter
+  // selecting no feature matches every report. Returns false if |filt_index|
+  // is out of range.
+  bool SetFilter(tBTM_BLE_PF_FILT_INDEX filt_index,
+                 const btgatt_filt_param_setup_t& params);
+
+  // Removes filter |filt_index| from the matching. Its conditions are kept.
+  void DeleteFilter(tBTM_BLE_PF_FILT_INDEX filt_index);
+
+  // Removes all the filters from the matching.
+  void DeleteAllFilters();
+
+  // Enables or disables filtering. While it is disabled every report
+  // matches; once enabled, reports matching none of the filters are dropped.
+  void Enable(bool enable) { enabled_ = enable; }
+  bool IsEnabled() const { return enabled_; }
+
+  // Returns the number of filter indexes not set up.
+  uint8_t GetAvailableSpace() const;
+
+  // Removes all filters and conditions, and disables filtering.
+  void Reset();
+
+  // Returns whether the advertising data |p_data| of |len| bytes, received
+  // from |bda| with |rssi|, matches one of the filters. |bda| is the address
+  // after resolution, which address conditions are compared to.
+  bool Matches(const RawAddress& bda, int8_t rssi, const uint8_t* p_data,
+               size_t len) const;
+
+ private:
+  // A pattern the start of an AD structure is compared to, and the filters
+  // it satisfies. The data is stored masked.
+  struct DataPattern {
+    std::vector<uint8_t> data;
+    std::vector<uint8_t> mask;
+    uint64_t filters;
+  };
+
+  // Patterns of one kind of AD structure. Those comparing all the bits of
+  // their first two bytes are keyed by them.
+  struct PatternIndex {
+    std::unordered_map<uint16_t, std::vector<DataPattern>> by_prefix;
+    std::vector<DataPattern> others;
+  };
+
+  // A UUID compared on the bits set in its mask, both big endian. The UUID
+  // is stored masked.
+  struct MaskedUuid {
+    bluetooth::Uuid::UUID128Bit uuid;
+    bluetooth::Uuid::UUID128Bit mask;
+    uint64_t filters;
+  };
+
+  // UUID conditions of one kind. UUIDs compared on all their bits that have
+  // a 16 or 32 bit form are keyed by it.
+  struct UuidIndex {
+    std::unordered_map<uint32_t, uint64_t> short_uuids;
+    std::vector<std::pair<bluetooth::Uuid, uint64_t>> long_uuids;
+    std::vector<MaskedUuid> masked_uuids;
+  };
+
+  struct Filter {
+    std::vector<ApcfCommand> conditions;
+    bool active;
+    uint16_t feat_seln;
+    int8_t rssi_high_thres;
+  };
+
+  void Compile();
+  static void AddUuid(UuidIndex* p_index, const ApcfCommand& cmd,
+                      uint64_t filter);
+  static void AddPattern(PatternIndex* p_index, std::vector<uint8_t> data,
+                         std::vector<uint8_t> mask, uint64_t filter);
+
+  static uint64_t MatchPatterns(const PatternIndex& index,
+                                const uint8_t* p_value, size_t len);
+  static uint64_t MatchUuid(const UuidIndex& index,
+                            const bluetooth::Uuid& uuid);
+  static uint64_t MatchUuids(const UuidIndex& index, const uint8_t* p_value,
+                             size_t len, size_t uuid_len);
+
+  bool enabled_ = false;
+  Filter filters_[BTM_BLE_HOST_FILTER_MAX] = {};
+
+  // The compiled filters: the filters set up, those matching every report,
+  // and, by feature, the filters selecting it.
+  uint64_t active_ = 0;
+  uint64_t all_pass_ = 0;
+  uint64_t required_[BTM_BLE_PF_TYPE_MAX] = {};
+
+  // RSSI thresholds in increasing order, with the filters whose threshold
+  // is at most each of them
+  std::vector<std::pair<int8_t, uint64_t>> rssi_thresholds_;
+
+  std::unordered_map<RawAddress, uint64_t> addresses_;
+  UuidIndex service_uuids_;
+  UuidIndex solicitation_uuids_;
+  std::unordered_map<std::string, uint64_t> names_;
+  std::vector<std::pair<std::string, uint64_t>> name_prefixes_;
+  PatternIndex manufacturer_data_;
+  PatternIndex service_data_;
+};
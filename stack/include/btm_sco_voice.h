@@ -0,0 +1,102 @@
+/******************************************************************************
+ *
+ *  Copyright 2019 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+//
+// Voice pipeline for SCO links routed over HCI
+//
+// Turns the SCO packets received from the controller into a steady stream of
+// PCM frames, and PCM frames into SCO packets. A frame is 7.5 ms of audio:
+// 120 samples at 16 kHz for mSBC, 60 samples at 8 kHz for CVSD, where the
+// controller does the CVSD coding and the host exchanges linear PCM.
+//
+// Receive path: packets are reassembled into frames (mSBC frames are found
+// through their H2 synchronization header), decoded and queued in an
+// adaptive jitter buffer. Frames flagged by the controller through the
+// Packet_Status_Flag, frames that fail to decode, frames missing from the
+// H2 sequence and jitter buffer underruns are replaced by packet loss
+// concealment.
+//
+// A pipeline is not thread safe, the caller serializes all calls on it.
+//
+
+#ifndef BTM_SCO_VOICE_H
+#define BTM_SCO_VOICE_H
+
+#include <stdint.h>
+
+#include "btm_api_types.h"
+
+#define BTM_SCO_VOICE_FRAME_US 7500
+#define BTM_SCO_VOICE_MAX_FRAME_SAMPLES 120
+
+typedef enum {
+  BTM_SCO_VOICE_CODEC_CVSD, /* 8 kHz linear PCM, coded by the controller */
+  BTM_SCO_VOICE_CODEC_MSBC, /* 16 kHz, mSBC in transparent air mode */
+} tBTM_SCO_VOICE_CODEC;
+
+typedef struct {
+  uint32_t rx_frames;         /* frames queued for playout */
+  uint32_t rx_bad_frames;     /* frames flagged or failing to decode */
+  uint32_t rx_missing_frames; /* frames lost before reaching the host */
+  uint32_t concealed_frames;  /* frames replaced by packet loss concealment */
+  uint32_t underruns;         /* playout found the jitter buffer empty */
+  uint32_t discarded_frames;  /* frames dropped to shrink the jitter buffer */
+  uint32_t tx_frames;
+  uint16_t jitter_buffer_depth;  /* frames currently queued */
+  uint16_t jitter_buffer_target; /* frames the buffer settles at */
+  uint32_t jitter_us;            /* arrival jitter of the last window */
+} tBTM_SCO_VOICE_STATS;
+
+typedef struct tBTM_SCO_VOICE tBTM_SCO_VOICE;
+
+// Creates a voice pipeline for |codec|. Returns NULL if the decoder cannot
+// be set up.
+tBTM_SCO_VOICE* BTM_ScoVoiceNew(tBTM_SCO_VOICE_CODEC codec);
+
+// Frees |p_voice|. NULL is ignored.
+void BTM_ScoVoiceFree(tBTM_SCO_VOICE* p_voice);
+
+// Returns the number of samples per frame, 120 for mSBC and 60 for CVSD.
+uint16_t BTM_ScoVoiceFrameSamples(const tBTM_SCO_VOICE* p_voice);
+
+// Handles the |len| bytes of payload of a received SCO packet, with the
+// Packet_Status_Flag the controller reported for it. |now_us| is the arrival
+// time, from any monotonic clock that is also used for the next calls.
+void BTM_ScoVoiceReceive(tBTM_SCO_VOICE* p_voice, const uint8_t* p_data,
+                         uint16_t len, tBTM_SCO_DATA_FLAG status,
+                         uint64_t now_us);
+
+// Fills |p_pcm| with the next frame to play. This is expected to be called
+// once every 7.5 ms; it plays silence until the jitter buffer is primed, and
+// concealment when the next frame is lost or late.
+void BTM_ScoVoiceReadPcm(tBTM_SCO_VOICE* p_voice, int16_t* p_pcm);
+
+// Encodes one frame of |p_pcm| for transmission. The coded bytes are
+// fetched with BTM_ScoVoiceGetTxPacket().
+void BTM_ScoVoiceWritePcm(tBTM_SCO_VOICE* p_voice, const int16_t* p_pcm);
+
+// Copies the next SCO packet payload to send into |p_buf|, which holds at
+// least BTM_SCO_DATA_SIZE_MAX bytes. Packets are sized like the ones the
+// controller sends us. Returns the payload length, 0 if there is none.
+uint16_t BTM_ScoVoiceGetTxPacket(tBTM_SCO_VOICE* p_voice, uint8_t* p_buf);
+
+// Copies the statistics of |p_voice| into |p_stats|.
+void BTM_ScoVoiceGetStats(const tBTM_SCO_VOICE* p_voice,
+                          tBTM_SCO_VOICE_STATS* p_stats);
+
+#endif  // BTM_SCO_VOICE_H
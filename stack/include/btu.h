@@ -33,6 +33,7 @@
 #include "bt_common.h"
 #include "bt_target.h"
 #include "osi/include/alarm.h"
+#include "osi/include/task_stats.h"
 
 /* Global BTU data */
 extern uint8_t btu_trace_level;
@@ -57,6 +58,9 @@ void btu_free_core(void);
  ***********************************
 */
 base::MessageLoop* get_message_loop();
+/* Statistics of the tasks of the message loop, to pass to task_stats_wrap()
+ * when posting to it */
+task_stats_t* get_message_loop_task_stats();
 
 void BTU_StartUp(void);
 void BTU_ShutDown(void);
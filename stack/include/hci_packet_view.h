@@ -0,0 +1,474 @@
+/******************************************************************************
+ *
+ *  Copyright 2019 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+/******************************************************************************
+ *
+ *  Views and builders of HCI packets.
+ *
+ *  The layout of a packet is described once, as fields at constant offsets,
+ *  and read or written through it:
+ *   - a view looks at the bytes of a received packet in place, without
+ *     copying them. It checks once, when it is created or when it steps to
+ *     the next entry of a list, that the fields it gives access to are
+ *     within the packet, so the accessors don't check again;
+ *   - a builder appends fields to a buffer of a given capacity, typically
+ *     the data of a BT_HDR taken from the buffer allocator, and keeps track
+ *     of whether they fit.
+ *
+ ******************************************************************************/
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <type_traits>
+
+#include "bt_types.h"
+#include "btm_api_types.h"
+#include "hcidefs.h"
+#include "types/raw_address.h"
+
+/*****************************************************************************
+ *  Fields
+ ****************************************************************************/
+
+// A little endian integer of type |T| at |Offset| bytes from the start of its
+// structure.
+template <typename T, size_t Offset>
+struct HciField {
+  static constexpr size_t kOffset = Offset;
+  static constexpr size_t kSize = sizeof(T);
+  static constexpr size_t kEnd = Offset + sizeof(T);
+
+  // On little endian hosts, fields are read and written with a single
+  // unaligned access, which compilers don't reliably merge the bytes into.
+  static T Get(const uint8_t* p) {
+    p += Offset;
+    typename std::make_unsigned<T>::type value = 0;
+#if (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+    memcpy(&value, p, sizeof(T));
+#else
+    for (size_t i = 0; i < sizeof(T); i++)
+      value |= (typename std::make_unsigned<T>::type)p[i] << (8 * i);
+#endif
+    return (T)value;
+  }
+
+  static void Set(uint8_t* p, T value) {
+    p += Offset;
+#if (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+    memcpy(p, &value, sizeof(T));
+#else
+    for (size_t i = 0; i < sizeof(T); i++) p[i] = (uint8_t)(value >> (8 * i));
+#endif
+  }
+};
+
+// A device address, least significant byte first as on the wire.
+template <size_t Offset>
+struct HciAddressField {
+  static constexpr size_t kOffset = Offset;
+  static constexpr size_t kSize = BD_ADDR_LEN;
+  static constexpr size_t kEnd = Offset + BD_ADDR_LEN;
+
+  static void Get(const uint8_t* p, RawAddress& address) {
+    p += Offset;
+    for (size_t i = 0; i < BD_ADDR_LEN; i++)
+      address.address[BD_ADDR_LEN - 1 - i] = p[i];
+  }
+
+  static void Set(uint8_t* p, const RawAddress& address) {
+    p += Offset;
+    for (size_t i = 0; i < BD_ADDR_LEN; i++)
+      p[i] = address.address[BD_ADDR_LEN - 1 - i];
+  }
+};
+
+/*****************************************************************************
+ *  Layouts
+ ****************************************************************************/
+
+// ACL data packet header
+struct HciAclHeader {
+  using HandleAndFlags = HciField<uint16_t, 0>;
+  using Length = HciField<uint16_t, 2>;
+  static constexpr size_t kSize = Length::kEnd;
+
+  static constexpr uint16_t kHandleMask = 0x0fff;
+  static constexpr uint8_t kBoundaryShift = 12;
+  static constexpr uint8_t kBroadcastShift = 14;
+
+  static void Write(uint8_t* p, uint16_t handle_and_flags, uint16_t length) {
+    HandleAndFlags::Set(p, handle_and_flags);
+    Length::Set(p, length);
+  }
+};
+static_assert(HciAclHeader::kSize == HCI_DATA_PREAMBLE_SIZE,
+              "ACL header layout mismatch");
+
+// Parameters of the Number Of Completed Packets event, an array of
+// |NumHandles| entries.
+struct HciNumberOfCompletedPackets {
+  using NumHandles = HciField<uint8_t, 0>;
+  static constexpr size_t kEntriesOffset = NumHandles::kEnd;
+
+  struct Entry {
+    using Handle = HciField<uint16_t, 0>;
+    using Completed = HciField<uint16_t, 2>;
+    static constexpr size_t kSize = Completed::kEnd;
+  };
+};
+
+// Parameters of the LE Advertising Report event, after the subevent code:
+// |NumReports| reports, each with |DataLength| bytes of data followed by the
+// RSSI.
+struct HciLeAdvertisingReport {
+  using NumReports = HciField<uint8_t, 0>;
+  static constexpr size_t kReportsOffset = NumReports::kEnd;
+
+  struct Report {
+    using EventType = HciField<uint8_t, 0>;
+    using AddressType = HciField<uint8_t, 1>;
+    using Address = HciAddressField<2>;
+    using DataLength = HciField<uint8_t, 8>;
+    static constexpr size_t kDataOffset = DataLength::kEnd;
+    // Fixed part of a report, the RSSI included.
+    static constexpr size_t kMinSize = kDataOffset + 1;
+  };
+};
+
+// Parameters of the LE Extended Advertising Report event, after the subevent
+// code: |NumReports| reports, each ending with |DataLength| bytes of data.
+struct HciLeExtendedAdvertisingReport {
+  using NumReports = HciField<uint8_t, 0>;
+  static constexpr size_t kReportsOffset = NumReports::kEnd;
+
+  struct Report {
+    using EventType = HciField<uint16_t, 0>;
+    using AddressType = HciField<uint8_t, 2>;
+    using Address = HciAddressField<3>;
+    using PrimaryPhy = HciField<uint8_t, 9>;
+    using SecondaryPhy = HciField<uint8_t, 10>;
+    using AdvertisingSid = HciField<uint8_t, 11>;
+    using TxPower = HciField<int8_t, 12>;
+    using Rssi = HciField<int8_t, 13>;
+    using PeriodicAdvertisingInterval = HciField<uint16_t, 14>;
+    using DirectAddressType = HciField<uint8_t, 16>;
+    using DirectAddress = HciAddressField<17>;
+    using DataLength = HciField<uint8_t, 23>;
+    static constexpr size_t kDataOffset = DataLength::kEnd;
+    static constexpr size_t kMinSize = kDataOffset;
+  };
+};
+
+/*****************************************************************************
+ *  Views
+ ****************************************************************************/
+
+// The bytes of a packet, as they are in the buffer holding them.
+class HciPacketView {
+ public:
+  HciPacketView() : data_(nullptr), size_(0) {}
+  HciPacketView(const uint8_t* data, size_t size) : data_(data), size_(size) {}
+
+  // The data of |p_buf|, from its offset on.
+  explicit HciPacketView(const BT_HDR* p_buf)
+      : data_(p_buf->data + p_buf->offset), size_(p_buf->len) {}
+
+  const uint8_t* data() const { return data_; }
+  size_t size() const { return size_; }
+
+  // Whether |length| bytes at |offset| are within the packet.
+  bool Has(size_t offset, size_t length) const {
+    return offset <= size_ && length <= size_ - offset;
+  }
+
+  // The |length| bytes at |offset|, empty if they aren't all there.
+  HciPacketView Slice(size_t offset, size_t length) const {
+    if (!Has(offset, length)) return HciPacketView();
+    return HciPacketView(data_ + offset, length);
+  }
+
+ private:
+  const uint8_t* data_;
+  size_t size_;
+};
+
+// An ACL data packet, header included.
+class HciAclView {
+ public:
+  explicit HciAclView(HciPacketView packet) : packet_(packet) {}
+
+  // The header is there, and the payload it announces too.
+  bool IsValid() const {
+    return packet_.Has(0, HciAclHeader::kSize) &&
+           packet_.Has(HciAclHeader::kSize, GetLength());
+  }
+
+  uint16_t GetHandleAndFlags() const {
+    return HciAclHeader::HandleAndFlags::Get(packet_.data());
+  }
+  uint16_t GetHandle() const {
+    return GetHandleAndFlags() & HciAclHeader::kHandleMask;
+  }
+  uint8_t GetBoundaryFlag() const {
+    return (GetHandleAndFlags() >> HciAclHeader::kBoundaryShift) & 0x03;
+  }
+  uint8_t GetBroadcastFlag() const {
+    return (GetHandleAndFlags() >> HciAclHeader::kBroadcastShift) & 0x03;
+  }
+  uint16_t GetLength() const { return HciAclHeader::Length::Get(packet_.data()); }
+
+  HciPacketView GetPayload() const {
+    return packet_.Slice(HciAclHeader::kSize, GetLength());
+  }
+
+ private:
+  HciPacketView packet_;
+};
+
+// The parameters of a Number Of Completed Packets event.
+class HciNumberOfCompletedPacketsView {
+ public:
+  explicit HciNumberOfCompletedPacketsView(HciPacketView params)
+      : params_(params) {}
+
+  // All the entries the event announces are there.
+  bool IsValid() const {
+    return params_.Has(0, HciNumberOfCompletedPackets::NumHandles::kEnd) &&
+           params_.Has(HciNumberOfCompletedPackets::kEntriesOffset,
+                       GetNumHandles() *
+                           HciNumberOfCompletedPackets::Entry::kSize);
+  }
+
+  uint8_t GetNumHandles() const {
+    return HciNumberOfCompletedPackets::NumHandles::Get(params_.data());
+  }
+
+  // Handle, without the flags, of entry |i| < GetNumHandles().
+  uint16_t GetHandle(size_t i) const {
+    return HciNumberOfCompletedPackets::Entry::Handle::Get(Entry(i)) &
+           HciAclHeader::kHandleMask;
+  }
+
+  uint16_t GetCompleted(size_t i) const {
+    return HciNumberOfCompletedPackets::Entry::Completed::Get(Entry(i));
+  }
+
+ private:
+  const uint8_t* Entry(size_t i) const {
+    return params_.data() + HciNumberOfCompletedPackets::kEntriesOffset +
+           i * HciNumberOfCompletedPackets::Entry::kSize;
+  }
+
+  HciPacketView params_;
+};
+
+// One report of an LE Advertising Report or LE Extended Advertising Report
+// event, in the format of the latter. |data| points into the event.
+struct HciAdvertisingReport {
+  uint16_t event_type;
+  uint8_t address_type;
+  RawAddress address;
+  uint8_t primary_phy;
+  uint8_t secondary_phy;
+  uint8_t advertising_sid;
+  int8_t tx_power;
+  int8_t rssi;
+  uint16_t periodic_adv_int;
+  uint8_t direct_address_type;
+  RawAddress direct_address;
+  uint8_t data_len;
+  const uint8_t* data;
+};
+
+// Steps through the reports of the parameters of an LE Advertising Report
+// event. Reports that don't fit in the event end the iteration.
+class HciLeAdvertisingReportView {
+ public:
+  explicit HciLeAdvertisingReportView(HciPacketView params)
+      : params_(params),
+        position_(HciLeAdvertisingReport::kReportsOffset),
+        remaining_(params.Has(0, HciLeAdvertisingReport::NumReports::kEnd)
+                       ? HciLeAdvertisingReport::NumReports::Get(params.data())
+                       : 0),
+        truncated_(!params.Has(0, HciLeAdvertisingReport::NumReports::kEnd)) {}
+
+  // Fills |report| with the next report, with the legacy event type as is,
+  // and returns true, or returns false when there is none left.
+  bool Next(HciAdvertisingReport* report) {
+    using Report = HciLeAdvertisingReport::Report;
+    if (remaining_ == 0) return false;
+
+    if (!params_.Has(position_, Report::kMinSize)) return Truncate();
+    const uint8_t* p = params_.data() + position_;
+    uint8_t data_len = Report::DataLength::Get(p);
+    if (!params_.Has(position_, Report::kMinSize + data_len)) return Truncate();
+
+    report->event_type = Report::EventType::Get(p);
+    report->address_type = Report::AddressType::Get(p);
+    Report::Address::Get(p, report->address);
+    report->primary_phy = PHY_LE_1M;
+    report->secondary_phy = PHY_LE_NO_PACKET;
+    report->advertising_sid = NO_ADI_PRESENT;
+    report->tx_power = TX_POWER_NOT_PRESENT;
+    report->rssi = (int8_t)p[Report::kDataOffset + data_len];
+    report->periodic_adv_int = 0;
+    report->direct_address_type = 0;
+    report->data_len = data_len;
+    report->data = p + Report::kDataOffset;
+
+    position_ += Report::kMinSize + data_len;
+    remaining_--;
+    return true;
+  }
+
+  // Whether the event ended before the reports it announced.
+  bool IsTruncated() const { return truncated_; }
+
+ private:
+  bool Truncate() {
+    truncated_ = true;
+    remaining_ = 0;
+    return false;
+  }
+
+  HciPacketView params_;
+  size_t position_;
+  uint8_t remaining_;
+  bool truncated_;
+};
+
+// Steps through the reports of the parameters of an LE Extended Advertising
+// Report event.
+class HciLeExtendedAdvertisingReportView {
+ public:
+  explicit HciLeExtendedAdvertisingReportView(HciPacketView params)
+      : params_(params),
+        position_(HciLeExtendedAdvertisingReport::kReportsOffset),
+        remaining_(
+            params.Has(0, HciLeExtendedAdvertisingReport::NumReports::kEnd)
+                ? HciLeExtendedAdvertisingReport::NumReports::Get(params.data())
+                : 0),
+        truncated_(
+            !params.Has(0, HciLeExtendedAdvertisingReport::NumReports::kEnd)) {
+  }
+
+  bool Next(HciAdvertisingReport* report) {
+    using Report = HciLeExtendedAdvertisingReport::Report;
+    if (remaining_ == 0) return false;
+
+    if (!params_.Has(position_, Report::kMinSize)) return Truncate();
+    const uint8_t* p = params_.data() + position_;
+    uint8_t data_len = Report::DataLength::Get(p);
+    if (!params_.Has(position_, Report::kMinSize + data_len)) return Truncate();
+
+    report->event_type = Report::EventType::Get(p);
+    report->address_type = Report::AddressType::Get(p);
+    Report::Address::Get(p, report->address);
+    report->primary_phy = Report::PrimaryPhy::Get(p);
+    report->secondary_phy = Report::SecondaryPhy::Get(p);
+    report->advertising_sid = Report::AdvertisingSid::Get(p);
+    report->tx_power = Report::TxPower::Get(p);
+    report->rssi = Report::Rssi::Get(p);
+    report->periodic_adv_int = Report::PeriodicAdvertisingInterval::Get(p);
+    report->direct_address_type = Report::DirectAddressType::Get(p);
+    Report::DirectAddress::Get(p, report->direct_address);
+    report->data_len = data_len;
+    report->data = p + Report::kDataOffset;
+
+    position_ += Report::kMinSize + data_len;
+    remaining_--;
+    return true;
+  }
+
+  bool IsTruncated() const { return truncated_; }
+
+ private:
+  bool Truncate() {
+    truncated_ = true;
+    remaining_ = 0;
+    return false;
+  }
+
+  HciPacketView params_;
+  size_t position_;
+  uint8_t remaining_;
+  bool truncated_;
+};
+
+/*****************************************************************************
+ *  Builders
+ ****************************************************************************/
+
+// Appends little endian fields to the |capacity| bytes at |data|. Whatever
+// doesn't fit is dropped and the builder is marked as overrun.
+class HciPacketBuilder {
+ public:
+  HciPacketBuilder(uint8_t* data, size_t capacity)
+      : data_(data), capacity_(capacity), size_(0), overrun_(false) {}
+
+  // Appends to the data of |p_buf|, which has room for |capacity| bytes from
+  // its offset on, and keeps its length up to date.
+  HciPacketBuilder(BT_HDR* p_buf, size_t capacity)
+      : HciPacketBuilder(p_buf->data + p_buf->offset, capacity) {
+    p_buf_ = p_buf;
+    size_ = p_buf->len;
+  }
+
+  template <typename T>
+  HciPacketBuilder& Append(T value) {
+    if (Reserve(sizeof(T))) HciField<T, 0>::Set(data_ + size_, value);
+    return Commit(sizeof(T));
+  }
+
+  HciPacketBuilder& AppendAddress(const RawAddress& address) {
+    if (Reserve(BD_ADDR_LEN)) HciAddressField<0>::Set(data_ + size_, address);
+    return Commit(BD_ADDR_LEN);
+  }
+
+  HciPacketBuilder& AppendBytes(const uint8_t* bytes, size_t length) {
+    if (Reserve(length)) memcpy(data_ + size_, bytes, length);
+    return Commit(length);
+  }
+
+  size_t size() const { return size_; }
+  bool IsOverrun() const { return overrun_; }
+
+ private:
+  bool Reserve(size_t length) {
+    if (!overrun_ && size_ <= capacity_ && length <= capacity_ - size_)
+      return true;
+    overrun_ = true;
+    return false;
+  }
+
+  HciPacketBuilder& Commit(size_t length) {
+    if (overrun_) return *this;
+    size_ += length;
+    if (p_buf_ != nullptr) p_buf_->len = size_;
+    return *this;
+  }
+
+  uint8_t* data_;
+  size_t capacity_;
+  size_t size_;
+  bool overrun_;
+  BT_HDR* p_buf_ = nullptr;
+};
@@ -634,6 +634,8 @@ extern void btsnd_hcic_write_inqscan_type(
     uint8_t type); /* Write Inquiry Scan Type */
 extern void btsnd_hcic_write_inquiry_mode(
     uint8_t type); /* Write Inquiry Mode */
+extern void btsnd_hcic_write_default_erroneous_data_rpt(
+    uint8_t mode); /* Write Default Erroneous Data Reporting */
 
 /* Enhanced setup SCO connection (CSA2) */
 extern void btsnd_hcic_enhanced_set_up_synchronous_connection(
@@ -157,6 +157,7 @@ typedef struct {
   uint16_t num_attr_filters; /* Number of attribute filters  */
   uint16_t attr_filters[SDP_MAX_ATTR_FILTERS]; /* Attributes to filter */
   uint8_t* p_free_mem; /* Pointer to free memory       */
+  bool bypass_cache;   /* Query the remote even if the result is cached */
 #if (SDP_RAW_DATA_INCLUDED == TRUE)
   uint8_t*
       raw_data; /* Received record from server. allocated/released by client  */
@@ -703,4 +704,30 @@ bool SDP_AddProfileDescriptorListUuid128(uint32_t handle, uint8_t *profile_uuid,
 
 bool SDP_AddServiceClassIdListUuid128(uint32_t handle, uint8_t* p_service_uuids);
 
+/*******************************************************************************
+ *
+ * Function         SDP_InvalidateDiscoveryCache
+ *
+ * Description      This function drops the cached ServiceSearchAttribute
+ *                  results of a device, so that the next query goes over the
+ *                  air. Call it when the services of the device may have
+ *                  changed.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+void SDP_InvalidateDiscoveryCache(const RawAddress& bd_addr);
+
+/*******************************************************************************
+ *
+ * Function         SDP_DumpDiscoveryCache
+ *
+ * Description      This function dumps the SDP discovery cache contents and
+ *                  hit statistics to the |fd| file descriptor.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+void SDP_DumpDiscoveryCache(int fd);
+
 #endif /* SDP_API_H */
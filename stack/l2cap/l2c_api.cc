@@ -41,6 +41,7 @@
 #include "l2cdefs.h"
 #include "osi/include/allocator.h"
 #include "osi/include/log.h"
+#include "osi/include/packet_trace.h"
 
 using base::StringPrintf;
 
@@ -2271,6 +2272,7 @@ uint16_t L2CA_SendFixedChnlData(uint16_t fixed_cid, const RawAddress& rem_bda,
 
   p_buf->event = 0;
   p_buf->layer_specific = L2CAP_FLUSHABLE_CH_BASED;
+  PACKET_TRACE(PACKET_TRACE_PROFILE_TX, p_buf, fixed_cid, p_buf->len);
 
   if (!p_lcb->p_fixed_ccbs[fixed_cid - L2CAP_FIRST_FIXED_CHNL]) {
     if (!l2cu_initialize_fixed_ccb(
@@ -34,8 +34,10 @@
 #include "hcimsgs.h"
 #include "l2c_int.h"
 #include "l2cdefs.h"
+#include "sdp_api.h"
 #include "device/include/interop.h"
 #include "hci/include/btsnoop.h"
+#include "osi/include/packet_trace.h"
 
 /******************************************************************************/
 /*            L O C A L    F U N C T I O N     P R O T O T Y P E S            */
@@ -1000,6 +1002,9 @@ static void l2c_csm_w4_l2cap_connect_rsp(tL2C_CCB* p_ccb, uint16_t event,
       L2CAP_TRACE_API(
           "L2CAP - Calling Connect_Cfm_Cb(), CID: 0x%04x, Failure Code: %d",
           p_ccb->local_cid, p_ci->l2cap_result);
+      /* The PSM may have come from a cached SDP record that is out of date */
+      if (p_ccb->p_lcb->transport == BT_TRANSPORT_BR_EDR)
+        SDP_InvalidateDiscoveryCache(p_ccb->p_lcb->remote_bd_addr);
       l2cu_release_ccb(p_ccb);
       if (connect_cfm) {
         (*connect_cfm)(local_cid, p_ci->l2cap_result);
@@ -1701,7 +1706,10 @@ static void l2c_csm_config(tL2C_CCB* p_ccb, uint16_t event, void* p_data) {
       }
 #endif
       if (p_ccb->p_rcb && p_ccb->p_rcb->api.pL2CA_DataInd_Cb) {
+        PACKET_TRACE(PACKET_TRACE_PROFILE_RX, p_data, p_ccb->local_cid,
+                     ((BT_HDR*)p_data)->len);
         (*p_ccb->p_rcb->api.pL2CA_DataInd_Cb)(p_ccb->local_cid, (BT_HDR*)p_data);
+        PACKET_TRACE_CLEAR_LAST_RX();
       }
       break;
 
@@ -37,11 +37,13 @@
 #include "btu.h"
 #include "device/include/controller.h"
 #include "device/include/interop.h"
+#include "hci_packet_view.h"
 #include "hcimsgs.h"
 #include "l2c_api.h"
 #include "l2c_int.h"
 #include "l2cdefs.h"
 #include "osi/include/osi.h"
+#include "osi/include/packet_trace.h"
 #include "device/include/device_iot_config.h"
 #include "btif/include/btif_av.h"
 
@@ -1214,6 +1216,8 @@ static bool l2c_link_send_to_lower(tL2C_LCB* p_lcb, BT_HDR* p_buf,
   uint16_t xmit_window, acl_data_size;
   const controller_t* controller = controller_get_interface();
 
+  PACKET_TRACE(PACKET_TRACE_L2CAP_TX, p_buf, p_lcb->handle, p_buf->len);
+
   if ((p_buf->len <= controller->get_acl_packet_size_classic() &&
        (p_lcb->transport == BT_TRANSPORT_BR_EDR)) ||
       ((p_lcb->transport == BT_TRANSPORT_LE) &&
@@ -1310,24 +1314,28 @@ static bool l2c_link_send_to_lower(tL2C_LCB* p_lcb, BT_HDR* p_buf,
  *
  * Description      This function is called when a "number-of-completed-packets"
  *                  event is received from the controller. It updates all the
- *                  LCB transmit counts.
+ *                  LCB transmit counts. |p| points to the |evt_len| bytes of
+ *                  the parameters of the event.
  *
  * Returns          void
  *
  ******************************************************************************/
-void l2c_link_process_num_completed_pkts(uint8_t* p) {
+void l2c_link_process_num_completed_pkts(uint8_t* p, uint8_t evt_len) {
   uint8_t num_handles, xx;
   uint16_t handle;
   uint16_t num_sent;
   tL2C_LCB* p_lcb;
 
-  STREAM_TO_UINT8(num_handles, p);
+  HciNumberOfCompletedPacketsView event(HciPacketView(p, evt_len));
+  if (!event.IsValid()) {
+    L2CAP_TRACE_ERROR("%s: malformed event of %d bytes", __func__, evt_len);
+    return;
+  }
 
+  num_handles = event.GetNumHandles();
   for (xx = 0; xx < num_handles; xx++) {
-    STREAM_TO_UINT16(handle, p);
-    /* Extract the handle */
-    handle = HCID_GET_HANDLE(handle);
-    STREAM_TO_UINT16(num_sent, p);
+    handle = event.GetHandle(xx);
+    num_sent = event.GetCompleted(xx);
 
     p_lcb = l2cu_find_lcb_by_handle(handle);
 
@@ -34,6 +34,7 @@
 #include "btu.h"
 #include "device/include/controller.h"
 #include "hci/include/btsnoop.h"
+#include "hci_packet_view.h"
 #include "hcimsgs.h"
 #include "l2c_api.h"
 #include "l2c_int.h"
@@ -41,6 +42,7 @@
 #include "stack_config.h"
 #include "osi/include/log.h"
 #include "osi/include/osi.h"
+#include "osi/include/packet_trace.h"
 #if (OFF_TARGET_TEST_ENABLED == TRUE)
 #include "linux_include/log/log.h"
 #endif
@@ -74,10 +76,19 @@ void l2c_rcv_acl_data(BT_HDR* p_msg) {
   uint16_t l2cap_len, rcv_cid;
   uint16_t soc_log_stats_id;
 
-  /* Extract the handle */
-  STREAM_TO_UINT16(handle, p);
-  pkt_type = HCID_GET_EVENT(handle);
-  handle = HCID_GET_HANDLE(handle);
+  /* Extract the handle and the length */
+  HciAclView acl(HciPacketView{p_msg});
+  if (!acl.IsValid()) {
+    L2CAP_TRACE_WARNING("L2CAP - got truncated hci header, len:%d",
+                        p_msg->len);
+    osi_free(p_msg);
+    return;
+  }
+  pkt_type = acl.GetBoundaryFlag();
+  handle = acl.GetHandle();
+  hci_len = acl.GetLength();
+  p += HCI_DATA_PREAMBLE_SIZE;
+  PACKET_TRACE(PACKET_TRACE_L2CAP_RX, p_msg, handle, p_msg->len);
 
   /* Since the HCI Transport is putting segmented packets back together, we */
   /* should never get a valid packet with the type set to "continuation"    */
@@ -90,7 +101,6 @@ void l2c_rcv_acl_data(BT_HDR* p_msg) {
       /* There is a slight possibility (specifically with USB) that we get an */
       /* L2CAP connection request before we get the HCI connection complete.  */
       /* So for these types of messages, hold them for up to 2 seconds.       */
-      STREAM_TO_UINT16(hci_len, p);
       STREAM_TO_UINT16(l2cap_len, p);
       STREAM_TO_UINT16(rcv_cid, p);
       STREAM_TO_UINT8(cmd_code, p);
@@ -134,9 +144,8 @@ void l2c_rcv_acl_data(BT_HDR* p_msg) {
     return;
   }
 
-  /* Extract the length and update the buffer header */
-  STREAM_TO_UINT16(hci_len, p);
-  p_msg->offset += 4;
+  /* Update the buffer header */
+  p_msg->offset += HCI_DATA_PREAMBLE_SIZE;
 
   if (hci_len < L2CAP_PKT_OVERHEAD) {
     /* Must receive at least the L2CAP length and CID */
@@ -213,11 +222,14 @@ void l2c_rcv_acl_data(BT_HDR* p_msg) {
                                  .fixed_chnl_opts)) {
       p_ccb = p_lcb->p_fixed_ccbs[rcv_cid - L2CAP_FIRST_FIXED_CHNL];
 
-      if (p_ccb->peer_cfg.fcr.mode != L2CAP_FCR_BASIC_MODE)
+      if (p_ccb->peer_cfg.fcr.mode != L2CAP_FCR_BASIC_MODE) {
         l2c_fcr_proc_pdu(p_ccb, p_msg);
-      else
+      } else {
+        PACKET_TRACE(PACKET_TRACE_PROFILE_RX, p_msg, rcv_cid, p_msg->len);
         (*l2cb.fixed_reg[rcv_cid - L2CAP_FIRST_FIXED_CHNL].pL2CA_FixedData_Cb)(
             rcv_cid, p_lcb->remote_bd_addr, p_msg);
+        PACKET_TRACE_CLEAR_LAST_RX();
+      }
     } else
       osi_free(p_msg);
   }
@@ -1261,6 +1273,8 @@ uint8_t l2c_data_write(uint16_t cid, BT_HDR* p_data, uint16_t flags) {
     return (L2CAP_DW_FAILED);
   }
 
+  PACKET_TRACE(PACKET_TRACE_PROFILE_TX, p_data, cid, p_data->len);
+
 #ifndef TESTER /* Tester may send any amount of data. otherwise sending \
                   message                                               \
                   bigger than mtu size of peer is a violation of protocol */
@@ -34,6 +34,7 @@
 #include "btu.h"
 #include "device/include/controller.h"
 #include "hci/include/btsnoop.h"
+#include "hci_packet_view.h"
 #include "hcidefs.h"
 #include "hcimsgs.h"
 #include "l2c_int.h"
@@ -330,39 +331,39 @@ bool l2c_is_cmd_rejected(uint8_t cmd_code, uint8_t id, tL2C_LCB* p_lcb) {
 BT_HDR* l2cu_build_header(tL2C_LCB* p_lcb, uint16_t len, uint8_t cmd,
                           uint8_t id) {
   BT_HDR* p_buf = (BT_HDR*)osi_malloc(L2CAP_CMD_BUF_SIZE);
-  uint8_t* p;
+  uint16_t handle_and_flags;
 
   p_buf->offset = L2CAP_SEND_CMD_OFFSET;
   p_buf->len =
       len + HCI_DATA_PREAMBLE_SIZE + L2CAP_PKT_OVERHEAD + L2CAP_CMD_OVERHEAD;
-  p = (uint8_t*)(p_buf + 1) + L2CAP_SEND_CMD_OFFSET;
 
-  /* Put in HCI header - handle + pkt boundary */
+  /* HCI header - handle + pkt boundary */
   if (p_lcb->transport == BT_TRANSPORT_LE) {
-    UINT16_TO_STREAM(p, (p_lcb->handle | (L2CAP_PKT_START_NON_FLUSHABLE
-                                          << L2CAP_PKT_TYPE_SHIFT)));
+    handle_and_flags = p_lcb->handle | (L2CAP_PKT_START_NON_FLUSHABLE
+                                        << L2CAP_PKT_TYPE_SHIFT);
   } else {
 #if (L2CAP_NON_FLUSHABLE_PB_INCLUDED == TRUE)
-    UINT16_TO_STREAM(p, p_lcb->handle | l2cb.non_flushable_pbf);
+    handle_and_flags = p_lcb->handle | l2cb.non_flushable_pbf;
 #else
-    UINT16_TO_STREAM(
-        p, (p_lcb->handle | (L2CAP_PKT_START << L2CAP_PKT_TYPE_SHIFT)));
+    handle_and_flags =
+        p_lcb->handle | (L2CAP_PKT_START << L2CAP_PKT_TYPE_SHIFT);
 #endif
   }
 
-  UINT16_TO_STREAM(p, len + L2CAP_PKT_OVERHEAD + L2CAP_CMD_OVERHEAD);
-  UINT16_TO_STREAM(p, len + L2CAP_CMD_OVERHEAD);
-
-  if (p_lcb->transport == BT_TRANSPORT_LE) {
-    UINT16_TO_STREAM(p, L2CAP_BLE_SIGNALLING_CID);
-  } else {
-    UINT16_TO_STREAM(p, L2CAP_SIGNALLING_CID);
-  }
-
-  /* Put in L2CAP command header */
-  UINT8_TO_STREAM(p, cmd);
-  UINT8_TO_STREAM(p, id);
-  UINT16_TO_STREAM(p, len);
+  /* The payload of the command is written after the headers by the caller */
+  HciPacketBuilder((uint8_t*)(p_buf + 1) + L2CAP_SEND_CMD_OFFSET,
+                   L2CAP_CMD_BUF_SIZE - BT_HDR_SIZE - L2CAP_SEND_CMD_OFFSET)
+      .Append(handle_and_flags)
+      .Append<uint16_t>(len + L2CAP_PKT_OVERHEAD + L2CAP_CMD_OVERHEAD)
+      /* L2CAP packet header */
+      .Append<uint16_t>(len + L2CAP_CMD_OVERHEAD)
+      .Append<uint16_t>(p_lcb->transport == BT_TRANSPORT_LE
+                            ? L2CAP_BLE_SIGNALLING_CID
+                            : L2CAP_SIGNALLING_CID)
+      /* L2CAP command header */
+      .Append(cmd)
+      .Append(id)
+      .Append(len);
 
   return (p_buf);
 }
@@ -3669,24 +3670,13 @@ BT_HDR* l2cu_get_next_buffer_to_send(tL2C_LCB* p_lcb,
  *
  ******************************************************************************/
 void l2cu_set_acl_hci_header(BT_HDR* p_buf, tL2C_CCB* p_ccb) {
-  uint8_t* p;
-
-  /* Set the pointer to the beginning of the data minus 4 bytes for the packet
-   * header */
-  p = (uint8_t*)(p_buf + 1) + p_buf->offset - HCI_DATA_PREAMBLE_SIZE;
+  uint16_t handle_and_flags;
+  uint16_t acl_data_size;
 
   if (p_ccb->p_lcb->transport == BT_TRANSPORT_LE) {
-    UINT16_TO_STREAM(p, p_ccb->p_lcb->handle | (L2CAP_PKT_START_NON_FLUSHABLE
-                                                << L2CAP_PKT_TYPE_SHIFT));
-
-    uint16_t acl_data_size =
-        controller_get_interface()->get_acl_data_size_ble();
-    /* The HCI transport will segment the buffers. */
-    if (p_buf->len > acl_data_size) {
-      UINT16_TO_STREAM(p, acl_data_size);
-    } else {
-      UINT16_TO_STREAM(p, p_buf->len);
-    }
+    handle_and_flags = p_ccb->p_lcb->handle | (L2CAP_PKT_START_NON_FLUSHABLE
+                                               << L2CAP_PKT_TYPE_SHIFT);
+    acl_data_size = controller_get_interface()->get_acl_data_size_ble();
   } else {
 #if (L2CAP_NON_FLUSHABLE_PB_INCLUDED == TRUE)
     if ((((p_buf->layer_specific & L2CAP_FLUSHABLE_MASK) ==
@@ -3694,25 +3684,24 @@ void l2cu_set_acl_hci_header(BT_HDR* p_buf, tL2C_CCB* p_ccb) {
          (p_ccb->is_flushable)) ||
         ((p_buf->layer_specific & L2CAP_FLUSHABLE_MASK) ==
          L2CAP_FLUSHABLE_PKT)) {
-      UINT16_TO_STREAM(
-          p, p_ccb->p_lcb->handle | (L2CAP_PKT_START << L2CAP_PKT_TYPE_SHIFT));
+      handle_and_flags =
+          p_ccb->p_lcb->handle | (L2CAP_PKT_START << L2CAP_PKT_TYPE_SHIFT);
     } else {
-      UINT16_TO_STREAM(p, p_ccb->p_lcb->handle | l2cb.non_flushable_pbf);
+      handle_and_flags = p_ccb->p_lcb->handle | l2cb.non_flushable_pbf;
     }
 #else
-    UINT16_TO_STREAM(
-        p, p_ccb->p_lcb->handle | (L2CAP_PKT_START << L2CAP_PKT_TYPE_SHIFT));
+    handle_and_flags =
+        p_ccb->p_lcb->handle | (L2CAP_PKT_START << L2CAP_PKT_TYPE_SHIFT);
 #endif
-
-    uint16_t acl_data_size =
-        controller_get_interface()->get_acl_data_size_classic();
-    /* The HCI transport will segment the buffers. */
-    if (p_buf->len > acl_data_size) {
-      UINT16_TO_STREAM(p, acl_data_size);
-    } else {
-      UINT16_TO_STREAM(p, p_buf->len);
-    }
+    acl_data_size = controller_get_interface()->get_acl_data_size_classic();
   }
+
+  /* Write the packet header in the 4 bytes before the data. The HCI transport
+   * will segment the buffers. */
+  HciAclHeader::Write(
+      (uint8_t*)(p_buf + 1) + p_buf->offset - HCI_DATA_PREAMBLE_SIZE,
+      handle_and_flags,
+      (p_buf->len > acl_data_size) ? acl_data_size : p_buf->len);
   p_buf->offset -= HCI_DATA_PREAMBLE_SIZE;
   p_buf->len += HCI_DATA_PREAMBLE_SIZE;
 }
@@ -4779,7 +4768,9 @@ void l2cu_post_data_ind_cb_to_btu(tL2C_CCB* p_ccb) {
 
   if ((p_ccb->p_rcb) && (p_ccb->p_rcb->coc_api.pL2CA_CocDataInd_Cb)) {
     btu_message_loop->task_runner()->PostTask(FROM_HERE,
-        base::Bind(*p_ccb->p_rcb->coc_api.pL2CA_CocDataInd_Cb, p_ccb->local_cid));
+        task_stats_wrap(get_message_loop_task_stats(), FROM_HERE,
+            base::Bind(*p_ccb->p_rcb->coc_api.pL2CA_CocDataInd_Cb,
+                       p_ccb->local_cid)));
   }
 }
 
@@ -37,6 +37,7 @@
 #include "port_int.h"
 #include "rfc_int.h"
 #include "rfcdefs.h"
+#include "sdp_api.h"
 
 #include "stack/l2cap/l2c_int.h"
 #include "hci/include/btsnoop.h"
@@ -480,6 +481,8 @@ void PORT_DlcEstablishCnf(tRFC_MCB* p_mcb, uint8_t dlci, uint16_t mtu,
   if (!p_port) return;
 
   if (result != RFCOMM_SUCCESS) {
+    /* The SCN may have come from a cached SDP record that is out of date */
+    SDP_InvalidateDiscoveryCache(p_mcb->bd_addr);
     p_port->error = PORT_START_FAILED;
     port_rfc_closed(p_port, PORT_START_FAILED);
     return;
@@ -22,10 +22,15 @@
  *
  ******************************************************************************/
 
+#include <base/bind.h>
+#include <base/location.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
+#include <list>
+#include <vector>
+
 #include "bt_common.h"
 #include "bt_target.h"
 #include "bt_utils.h"
@@ -40,9 +45,109 @@
 #include "avrc_defs.h"
 
 #include "osi/include/osi.h"
+#include "osi/include/time.h"
 
 using bluetooth::Uuid;
 
+/* A request answered from the discovery cache, waiting to be delivered */
+typedef struct {
+  uint32_t id;
+  RawAddress bd_addr;
+  tSDP_DISCOVERY_DB* p_db;
+  tSDP_DISC_CMPL_CB* p_cb;
+  tSDP_DISC_CMPL_CB2* p_cb2;
+  void* user_data;
+  std::vector<uint8_t> attr_lists;
+  uint64_t request_us;
+} tSDP_CACHED_REPLY;
+
+/* Only used on the BTU thread */
+static std::list<tSDP_CACHED_REPLY> sdp_cached_replies;
+static uint32_t sdp_cached_reply_next_id;
+
+/* Runs on the BTU thread, after the request has returned to the caller. */
+static void sdp_deliver_cached_reply(uint32_t id) {
+  auto it = sdp_cached_replies.begin();
+  while (it != sdp_cached_replies.end() && it->id != id) it++;
+  if (it == sdp_cached_replies.end()) return; /* cancelled */
+
+  tSDP_CACHED_REPLY reply = std::move(*it);
+  sdp_cached_replies.erase(it);
+
+  uint16_t status = SDP_SUCCESS;
+  uint8_t* p = reply.attr_lists.data();
+  uint8_t* p_end = p + reply.attr_lists.size();
+  while (p < p_end) {
+    p = sdp_disc_save_attr_seq(reply.p_db, reply.bd_addr, p, p_end);
+    if (!p) {
+      status = SDP_DB_FULL;
+      break;
+    }
+  }
+  sdp_cache_hit_done(time_get_os_boottime_us() - reply.request_us);
+
+  if (reply.p_cb)
+    (*reply.p_cb)(status);
+  else if (reply.p_cb2)
+    (*reply.p_cb2)(status, reply.user_data);
+}
+
+/*******************************************************************************
+ *
+ * Function         sdp_reply_from_cache
+ *
+ * Description      This function is called before a ServiceSearchAttribute
+ *                  request goes over the air. If the discovery cache has the
+ *                  result, it is parsed into |p_db| and the callback is
+ *                  called from the BTU message loop, as it would be for a
+ *                  remote query.
+ *
+ * Returns          true if the request is answered from the cache
+ *
+ ******************************************************************************/
+static bool sdp_reply_from_cache(const RawAddress& bd_addr,
+                                 tSDP_DISCOVERY_DB* p_db,
+                                 tSDP_DISC_CMPL_CB* p_cb,
+                                 tSDP_DISC_CMPL_CB2* p_cb2, void* user_data) {
+#if (SDP_RAW_DATA_INCLUDED == TRUE)
+  /* Callers asking for the raw records need the remote query */
+  if (p_db->raw_data) return false;
+#endif
+  if (p_db->bypass_cache) return false;
+
+  base::MessageLoop* btu_message_loop = get_message_loop();
+  if (!btu_message_loop || !btu_message_loop->task_runner().get())
+    return false;
+
+  uint64_t request_us = time_get_os_boottime_us();
+  std::vector<uint8_t> attr_lists;
+  if (!sdp_cache_find(bd_addr, p_db, &attr_lists)) return false;
+
+  if (++sdp_cached_reply_next_id == 0) sdp_cached_reply_next_id = 1;
+  sdp_cached_replies.push_back({sdp_cached_reply_next_id, bd_addr, p_db, p_cb,
+                                p_cb2, user_data, std::move(attr_lists),
+                                request_us});
+  btu_message_loop->task_runner()->PostTask(
+      FROM_HERE,
+      task_stats_wrap(
+          get_message_loop_task_stats(), FROM_HERE,
+          base::Bind(&sdp_deliver_cached_reply, sdp_cached_reply_next_id)));
+
+  SDP_TRACE_DEBUG("%s: served %s from cache", __func__,
+                  bd_addr.ToString().c_str());
+  return true;
+}
+
+/*******************************************************************************
+ *
+ * Function         sdp_free_cached_replies
+ *
+ * Description      This function drops the cached replies not delivered yet
+ *                  when the stack shuts down.
+ *
+ ******************************************************************************/
+void sdp_free_cached_replies(void) { sdp_cached_replies.clear(); }
+
 /**********************************************************************
  *   C L I E N T    F U N C T I O N    P R O T O T Y P E S            *
  **********************************************************************/
@@ -116,6 +221,14 @@ bool SDP_InitDiscoveryDb(tSDP_DISCOVERY_DB* p_db, uint32_t len,
  *
  ******************************************************************************/
 bool SDP_CancelServiceSearch(tSDP_DISCOVERY_DB* p_db) {
+  for (auto it = sdp_cached_replies.begin(); it != sdp_cached_replies.end();
+       it++) {
+    if (it->p_db == p_db) {
+      sdp_cached_replies.erase(it);
+      return (true);
+    }
+  }
+
   tCONN_CB* p_ccb = sdpu_find_ccb_by_db(p_db);
   if (!p_ccb) return (false);
 
@@ -161,6 +274,11 @@ bool SDP_ServiceSearchRequest(const RawAddress& p_bd_addr,
  *                  combined ServiceSearchAttributeRequest SDP function.
  *                  (This is for Unplug Testing)
  *
+ *                  If a query to the same device for the same UUIDs and at
+ *                  least the same attributes completed before, its cached
+ *                  result is used instead of a new SDP connection, unless
+ *                  |p_db| asks to bypass the cache.
+ *
  * Returns          true if discovery started, false if failed.
  *
  ******************************************************************************/
@@ -169,6 +287,8 @@ bool SDP_ServiceSearchAttributeRequest(const RawAddress& p_bd_addr,
                                        tSDP_DISC_CMPL_CB* p_cb) {
   tCONN_CB* p_ccb;
 
+  if (sdp_reply_from_cache(p_bd_addr, p_db, p_cb, NULL, NULL)) return (true);
+
   /* Specific BD address */
   p_ccb = sdp_conn_originate(p_bd_addr);
 
@@ -179,6 +299,7 @@ bool SDP_ServiceSearchAttributeRequest(const RawAddress& p_bd_addr,
   p_ccb->p_cb = p_cb;
 
   p_ccb->is_attr_search = true;
+  p_ccb->disc_start_us = time_get_os_boottime_us();
 
   return (true);
 }
@@ -193,6 +314,11 @@ bool SDP_ServiceSearchAttributeRequest(const RawAddress& p_bd_addr,
  *                  combined ServiceSearchAttributeRequest SDP function.
  *                  (This is for Unplug Testing)
  *
+ *                  If a query to the same device for the same UUIDs and at
+ *                  least the same attributes completed before, its cached
+ *                  result is used instead of a new SDP connection, unless
+ *                  |p_db| asks to bypass the cache.
+ *
  * Returns          true if discovery started, false if failed.
  *
  ******************************************************************************/
@@ -202,6 +328,9 @@ bool SDP_ServiceSearchAttributeRequest2(const RawAddress& p_bd_addr,
                                         void* user_data) {
   tCONN_CB* p_ccb;
 
+  if (sdp_reply_from_cache(p_bd_addr, p_db, NULL, p_cb2, user_data))
+    return (true);
+
   /* Specific BD address */
   p_ccb = sdp_conn_originate(p_bd_addr);
 
@@ -213,6 +342,7 @@ bool SDP_ServiceSearchAttributeRequest2(const RawAddress& p_bd_addr,
 
   p_ccb->is_attr_search = true;
   p_ccb->user_data = user_data;
+  p_ccb->disc_start_us = time_get_os_boottime_us();
 
   return (true);
 }
@@ -0,0 +1,394 @@
+/******************************************************************************
+ *
+ *  Copyright 2019 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+/******************************************************************************
+ *
+ *  This file keeps the attribute lists returned by remote SDP servers for
+ *  ServiceSearchAttribute requests, so that reconnecting a profile to a known
+ *  device can be answered without opening another SDP connection.
+ *
+ *  The cache holds one entry per remote device, with the results of the
+ *  queries made to it. A query is answered from a result for the same UUIDs
+ *  that fetched at least the attributes asked for, so a profile can reuse
+ *  what a wider query got. Results outlive the ACL link and expire after
+ *  SDP_DISC_CACHE_TTL_MS. All the results of a device are dropped when:
+ *  - it is unbonded or paired again;
+ *  - it sends a GATT Service Changed indication;
+ *  - a new query returns different records than the cached result;
+ *  - it refuses a connection to one of its L2CAP or RFCOMM channels, which
+ *    may have come from an old record.
+ *
+ ******************************************************************************/
+
+#include <stdio.h>
+#include <string.h>
+
+#include <algorithm>
+#include <list>
+#include <mutex>
+#include <vector>
+
+#include "bt_target.h"
+#include "osi/include/time.h"
+#include "sdp_api.h"
+#include "sdpint.h"
+
+using bluetooth::Uuid;
+
+typedef struct {
+  std::vector<Uuid> uuid_filters;
+  std::vector<uint16_t> attr_filters; /* sorted, empty for all attributes */
+  std::vector<uint8_t> attr_lists;    /* sequence of attribute lists */
+  uint32_t stored_ms;
+  uint32_t query_us; /* time the over-the-air query took */
+} tSDP_CACHE_RESULT;
+
+typedef struct {
+  RawAddress bd_addr;
+  std::list<tSDP_CACHE_RESULT> results; /* most recently used first */
+} tSDP_CACHE_DEVICE;
+
+/* Most recently used device first */
+static std::list<tSDP_CACHE_DEVICE> sdp_cache;
+
+static struct {
+  uint32_t hits;
+  uint64_t hit_us; /* request to completion, for the hits */
+  uint32_t misses;
+  uint64_t miss_us; /* request to completion, for the stored misses */
+  uint32_t changed; /* devices dropped because their records changed */
+} sdp_cache_stats;
+
+/* Guards everything above: lookups and stores run on the BTU thread, the
+ * invalidations on the BTU and BTA threads, and the dump on the dump
+ * thread. */
+static std::mutex sdp_cache_mutex;
+
+static std::list<tSDP_CACHE_DEVICE>::iterator sdp_cache_find_device(
+    const RawAddress& bd_addr) {
+  return std::find_if(sdp_cache.begin(), sdp_cache.end(),
+                      [&bd_addr](const tSDP_CACHE_DEVICE& device) {
+                        return device.bd_addr == bd_addr;
+                      });
+}
+
+/* A record matches a search if it contains all the UUIDs, in any order */
+static bool sdp_cache_same_uuids(const tSDP_CACHE_RESULT& result,
+                                 const tSDP_DISCOVERY_DB* p_db) {
+  if (result.uuid_filters.size() != p_db->num_uuid_filters) return false;
+
+  for (uint16_t xx = 0; xx < p_db->num_uuid_filters; xx++) {
+    if (std::find(result.uuid_filters.begin(), result.uuid_filters.end(),
+                  p_db->uuid_filters[xx]) == result.uuid_filters.end())
+      return false;
+  }
+  return true;
+}
+
+static bool sdp_cache_same_attrs(const tSDP_CACHE_RESULT& result,
+                                 const tSDP_DISCOVERY_DB* p_db) {
+  return std::equal(result.attr_filters.begin(), result.attr_filters.end(),
+                    p_db->attr_filters,
+                    p_db->attr_filters + p_db->num_attr_filters);
+}
+
+/* The attribute filters are sorted by SDP_InitDiscoveryDb */
+static bool sdp_cache_covers_attrs(const tSDP_CACHE_RESULT& result,
+                                   const tSDP_DISCOVERY_DB* p_db) {
+  if (result.attr_filters.empty()) return true;
+  if (p_db->num_attr_filters == 0) return false;
+
+  return std::includes(result.attr_filters.begin(), result.attr_filters.end(),
+                       p_db->attr_filters,
+                       p_db->attr_filters + p_db->num_attr_filters);
+}
+
+/* Reads the header of the data element at |p|. Returns a pointer to its
+ * value, of |*p_len| bytes, or NULL if it does not fit before |p_end|. */
+static const uint8_t* sdp_cache_read_element(const uint8_t* p,
+                                             const uint8_t* p_end,
+                                             uint8_t* p_type,
+                                             uint32_t* p_len) {
+  if (p >= p_end) return NULL;
+
+  uint8_t type = *p++;
+  uint32_t len = 0;
+  switch (type & 0x07) {
+    case SIZE_ONE_BYTE:
+      len = ((type >> 3) == NULL_DESC_TYPE) ? 0 : 1;
+      break;
+    case SIZE_TWO_BYTES:
+      len = 2;
+      break;
+    case SIZE_FOUR_BYTES:
+      len = 4;
+      break;
+    case SIZE_EIGHT_BYTES:
+      len = 8;
+      break;
+    case SIZE_SIXTEEN_BYTES:
+      len = 16;
+      break;
+    case SIZE_IN_NEXT_BYTE:
+      if (p_end - p < 1) return NULL;
+      len = *p++;
+      break;
+    case SIZE_IN_NEXT_WORD:
+      if (p_end - p < 2) return NULL;
+      BE_STREAM_TO_UINT16(len, p);
+      break;
+    case SIZE_IN_NEXT_LONG:
+      if (p_end - p < 4) return NULL;
+      BE_STREAM_TO_UINT32(len, p);
+      break;
+  }
+  if ((uint32_t)(p_end - p) < len) return NULL;
+
+  *p_type = type >> 3;
+  *p_len = len;
+  return p;
+}
+
+/* Appends to |p_out| the attribute lists in [p, p_end) keeping only the
+ * attributes of |p_db|. */
+static bool sdp_cache_filter_attrs(const uint8_t* p, const uint8_t* p_end,
+                                   const tSDP_DISCOVERY_DB* p_db,
+                                   std::vector<uint8_t>* p_out) {
+  const uint16_t* p_attr_end = p_db->attr_filters + p_db->num_attr_filters;
+
+  while (p < p_end) {
+    uint8_t type;
+    uint32_t seq_len;
+    const uint8_t* p_seq = sdp_cache_read_element(p, p_end, &type, &seq_len);
+    if (!p_seq || type != DATA_ELE_SEQ_DESC_TYPE) return false;
+    const uint8_t* p_seq_end = p_seq + seq_len;
+
+    std::vector<uint8_t> attrs;
+    p = p_seq;
+    while (p < p_seq_end) {
+      const uint8_t* p_attr = p;
+      uint32_t len;
+      const uint8_t* p_id = sdp_cache_read_element(p, p_seq_end, &type, &len);
+      if (!p_id || type != UINT_DESC_TYPE || len != 2) return false;
+      uint16_t attr_id;
+      p = p_id;
+      BE_STREAM_TO_UINT16(attr_id, p);
+
+      const uint8_t* p_value = sdp_cache_read_element(p, p_seq_end, &type, &len);
+      if (!p_value) return false;
+      p = p_value + len;
+
+      if (std::binary_search(p_db->attr_filters, p_attr_end, attr_id))
+        attrs.insert(attrs.end(), p_attr, p);
+    }
+
+    /* The result was at most SDP_MAX_LIST_BYTE_COUNT bytes */
+    p_out->push_back((DATA_ELE_SEQ_DESC_TYPE << 3) | SIZE_IN_NEXT_WORD);
+    p_out->push_back(attrs.size() >> 8);
+    p_out->push_back(attrs.size() & 0xff);
+    p_out->insert(p_out->end(), attrs.begin(), attrs.end());
+  }
+  return true;
+}
+
+/*******************************************************************************
+ *
+ * Function         sdp_cache_find
+ *
+ * Description      This function is called before a ServiceSearchAttribute
+ *                  request goes over the air. It looks for a cached result
+ *                  of |bd_addr| for the same UUIDs as |p_db|, with at least
+ *                  its attributes.
+ *
+ * Returns          true if found, with the attribute lists in |p_attr_lists|
+ *
+ ******************************************************************************/
+bool sdp_cache_find(const RawAddress& bd_addr, const tSDP_DISCOVERY_DB* p_db,
+                    std::vector<uint8_t>* p_attr_lists) {
+  std::lock_guard<std::mutex> lock(sdp_cache_mutex);
+  auto device = sdp_cache_find_device(bd_addr);
+  if (device == sdp_cache.end()) return false;
+
+  uint32_t now_ms = time_get_os_boottime_ms();
+  std::list<tSDP_CACHE_RESULT>& results = device->results;
+  for (auto it = results.begin(); it != results.end();) {
+    if (now_ms - it->stored_ms > SDP_DISC_CACHE_TTL_MS) {
+      it = results.erase(it);
+      continue;
+    }
+    if (!sdp_cache_same_uuids(*it, p_db) || !sdp_cache_covers_attrs(*it, p_db)) {
+      it++;
+      continue;
+    }
+
+    p_attr_lists->clear();
+    if (sdp_cache_same_attrs(*it, p_db)) {
+      *p_attr_lists = it->attr_lists;
+    } else if (!sdp_cache_filter_attrs(
+                   it->attr_lists.data(),
+                   it->attr_lists.data() + it->attr_lists.size(), p_db,
+                   p_attr_lists)) {
+      it = results.erase(it);
+      continue;
+    }
+
+    results.splice(results.begin(), results, it);
+    sdp_cache.splice(sdp_cache.begin(), sdp_cache, device);
+    return true;
+  }
+
+  if (results.empty()) sdp_cache.erase(device);
+  return false;
+}
+
+/*******************************************************************************
+ *
+ * Function         sdp_cache_store
+ *
+ * Description      This function saves the attribute lists [p_lists, p_end)
+ *                  of a ServiceSearchAttribute request to |bd_addr| with
+ *                  |p_db|, which took |query_us| to complete. If they differ
+ *                  from the cached result of the same request, the records
+ *                  of the device have changed and all its results are
+ *                  dropped first.
+ *
+ ******************************************************************************/
+void sdp_cache_store(const RawAddress& bd_addr, const tSDP_DISCOVERY_DB* p_db,
+                     const uint8_t* p_lists, const uint8_t* p_end,
+                     uint32_t query_us) {
+  std::lock_guard<std::mutex> lock(sdp_cache_mutex);
+  sdp_cache_stats.misses++;
+  sdp_cache_stats.miss_us += query_us;
+
+  auto device = sdp_cache_find_device(bd_addr);
+  if (device == sdp_cache.end()) {
+    sdp_cache.push_front({bd_addr, {}});
+    device = sdp_cache.begin();
+  } else {
+    sdp_cache.splice(sdp_cache.begin(), sdp_cache, device);
+  }
+
+  std::list<tSDP_CACHE_RESULT>& results = device->results;
+  for (auto it = results.begin(); it != results.end(); it++) {
+    if (!sdp_cache_same_uuids(*it, p_db) || !sdp_cache_same_attrs(*it, p_db))
+      continue;
+
+    if (it->attr_lists.size() != (size_t)(p_end - p_lists) ||
+        !std::equal(it->attr_lists.begin(), it->attr_lists.end(), p_lists)) {
+      sdp_cache_stats.changed++;
+      results.clear();
+    } else {
+      results.erase(it);
+    }
+    break;
+  }
+
+  tSDP_CACHE_RESULT result;
+  result.uuid_filters.assign(p_db->uuid_filters,
+                             p_db->uuid_filters + p_db->num_uuid_filters);
+  result.attr_filters.assign(p_db->attr_filters,
+                             p_db->attr_filters + p_db->num_attr_filters);
+  result.attr_lists.assign(p_lists, p_end);
+  result.stored_ms = time_get_os_boottime_ms();
+  result.query_us = query_us;
+  results.push_front(std::move(result));
+
+  while (results.size() > SDP_DISC_CACHE_MAX_RESULTS) results.pop_back();
+  while (sdp_cache.size() > SDP_DISC_CACHE_MAX_DEVICES) sdp_cache.pop_back();
+}
+
+/*******************************************************************************
+ *
+ * Function         sdp_cache_hit_done
+ *
+ * Description      This function records that a request answered from the
+ *                  cache completed |reply_us| after it was made.
+ *
+ ******************************************************************************/
+void sdp_cache_hit_done(uint32_t reply_us) {
+  std::lock_guard<std::mutex> lock(sdp_cache_mutex);
+  sdp_cache_stats.hits++;
+  sdp_cache_stats.hit_us += reply_us;
+}
+
+/*******************************************************************************
+ *
+ * Function         sdp_cache_free
+ *
+ * Description      This function drops all cached results when the stack
+ *                  shuts down.
+ *
+ ******************************************************************************/
+void sdp_cache_free(void) {
+  std::lock_guard<std::mutex> lock(sdp_cache_mutex);
+  sdp_cache.clear();
+  memset(&sdp_cache_stats, 0, sizeof(sdp_cache_stats));
+}
+
+/*******************************************************************************
+ *
+ * Function         SDP_InvalidateDiscoveryCache
+ *
+ * Description      This function drops the cached SDP results of a device.
+ *
+ ******************************************************************************/
+void SDP_InvalidateDiscoveryCache(const RawAddress& bd_addr) {
+  std::lock_guard<std::mutex> lock(sdp_cache_mutex);
+  auto device = sdp_cache_find_device(bd_addr);
+  if (device != sdp_cache.end()) sdp_cache.erase(device);
+}
+
+/*******************************************************************************
+ *
+ * Function         SDP_DumpDiscoveryCache
+ *
+ * Description      This function dumps the SDP discovery cache statistics to
+ *                  the |fd| file descriptor.
+ *
+ ******************************************************************************/
+void SDP_DumpDiscoveryCache(int fd) {
+  std::lock_guard<std::mutex> lock(sdp_cache_mutex);
+  uint32_t now_ms = time_get_os_boottime_ms();
+
+  dprintf(fd, "\nSDP discovery cache:\n");
+  dprintf(fd, "  Devices: %zu (max %d)  Records changed: %u\n",
+          sdp_cache.size(), SDP_DISC_CACHE_MAX_DEVICES,
+          sdp_cache_stats.changed);
+  dprintf(fd, "  Over the air: %u queries, average %llu us\n",
+          sdp_cache_stats.misses,
+          (unsigned long long)(sdp_cache_stats.misses
+                                   ? sdp_cache_stats.miss_us /
+                                         sdp_cache_stats.misses
+                                   : 0));
+  dprintf(fd, "  From cache: %u queries, average %llu us\n",
+          sdp_cache_stats.hits,
+          (unsigned long long)(sdp_cache_stats.hits ? sdp_cache_stats.hit_us /
+                                                          sdp_cache_stats.hits
+                                                    : 0));
+  for (const tSDP_CACHE_DEVICE& device : sdp_cache) {
+    dprintf(fd, "  %s\n", device.bd_addr.ToString().c_str());
+    for (const tSDP_CACHE_RESULT& result : device.results) {
+      dprintf(fd, "    %-36s %2zu attrs %4zu bytes, query %u us, age %u s\n",
+              result.uuid_filters.empty()
+                  ? "-"
+                  : result.uuid_filters[0].ToString().c_str(),
+              result.attr_filters.size(), result.attr_lists.size(),
+              result.query_us, (now_ms - result.stored_ms) / 1000);
+    }
+  }
+}
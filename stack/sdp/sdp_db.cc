@@ -72,12 +72,17 @@
 #include "sdp_api.h"
 #include "sdpint.h"
 
+using bluetooth::Uuid;
+
 #if (SDP_SERVER_ENABLED == TRUE)
 /******************************************************************************/
 /*            L O C A L    F U N C T I O N     P R O T O T Y P E S            */
 /******************************************************************************/
 static bool find_uuid_in_seq(uint8_t* p, uint32_t seq_len, uint8_t* p_his_uuid,
                              uint16_t his_len, int nest_level);
+static void build_uuid_index(tSDP_RECORD* p_rec);
+static bool record_has_uuid(tSDP_RECORD* p_rec, tUID_ENT* p_uid,
+                            uint8_t* p_uuid128);
 
 /*******************************************************************************
  *
@@ -91,10 +96,21 @@ static bool find_uuid_in_seq(uint8_t* p, uint32_t seq_len, uint8_t* p_his_uuid,
  *
  ******************************************************************************/
 tSDP_RECORD* sdp_db_service_search(tSDP_RECORD* p_rec, tSDP_UUID_SEQ* p_seq) {
-  uint16_t xx, yy;
-  tSDP_ATTRIBUTE* p_attr;
+  uint16_t yy;
+  uint8_t uuids[MAX_UUIDS_PER_SEQ][Uuid::kNumBytes128];
   tSDP_RECORD* p_end = &sdp_cb.server_db.record[sdp_cb.server_db.num_records];
 
+  /* Expand the searched UUIDs once, rather than once per attribute. A UUID
+   * of invalid length cannot match any record. */
+  for (yy = 0; yy < p_seq->num_uids; yy++) {
+    if (!sdpu_expand_uuid(p_seq->uuid_entry[yy].value,
+                          p_seq->uuid_entry[yy].len, uuids[yy])) {
+      SDP_TRACE_ERROR("%s: invalid UUID length %d", __func__,
+                      p_seq->uuid_entry[yy].len);
+      return (NULL);
+    }
+  }
+
   /* If NULL, start at the beginning, else start at the first specified record
    */
   if (!p_rec)
@@ -105,23 +121,11 @@ tSDP_RECORD* sdp_db_service_search(tSDP_RECORD* p_rec, tSDP_UUID_SEQ* p_seq) {
   /* Look through the records. The spec says that a match occurs if */
   /* the record contains all the passed UUIDs in it.                */
   for (; p_rec < p_end; p_rec++) {
+    if (!p_rec->uuid_index_valid) build_uuid_index(p_rec);
+
     for (yy = 0; yy < p_seq->num_uids; yy++) {
-      p_attr = &p_rec->attribute[0];
-      for (xx = 0; xx < p_rec->num_attributes; xx++, p_attr++) {
-        if (p_attr->type == UUID_DESC_TYPE) {
-          if (sdpu_compare_uuid_arrays(p_attr->value_ptr, p_attr->len,
-                                       &p_seq->uuid_entry[yy].value[0],
-                                       p_seq->uuid_entry[yy].len))
-            break;
-        } else if (p_attr->type == DATA_ELE_SEQ_DESC_TYPE) {
-          if (find_uuid_in_seq(p_attr->value_ptr, p_attr->len,
-                               &p_seq->uuid_entry[yy].value[0],
-                               p_seq->uuid_entry[yy].len, 0))
-            break;
-        }
-      }
       /* If any UUID was not found,  on to the next record */
-      if (xx == p_rec->num_attributes) break;
+      if (!record_has_uuid(p_rec, &p_seq->uuid_entry[yy], uuids[yy])) break;
     }
 
     /* If every UUID was found in the record, return the record */
@@ -132,6 +136,133 @@ tSDP_RECORD* sdp_db_service_search(tSDP_RECORD* p_rec, tSDP_UUID_SEQ* p_seq) {
   return (NULL);
 }
 
+/*******************************************************************************
+ *
+ * Function         add_uuid_to_index
+ *
+ * Description      This function adds a UUID to the record's UUID index,
+ *                  unless it is already there. UUIDs of invalid length are
+ *                  skipped, as they never match a search.
+ *
+ ******************************************************************************/
+static void add_uuid_to_index(tSDP_RECORD* p_rec, uint8_t* p_uuid,
+                              uint32_t uuid_len) {
+  uint8_t uuid[Uuid::kNumBytes128];
+  uint8_t xx;
+
+  if (p_rec->num_uuids > SDP_MAX_REC_UUIDS) return;
+  if (!sdpu_expand_uuid(p_uuid, uuid_len, uuid)) return;
+
+  for (xx = 0; xx < p_rec->num_uuids; xx++) {
+    if (memcmp(p_rec->uuids[xx], uuid, Uuid::kNumBytes128) == 0) return;
+  }
+
+  /* Mark the index as overflowed once it is full */
+  if (p_rec->num_uuids < SDP_MAX_REC_UUIDS)
+    memcpy(p_rec->uuids[p_rec->num_uuids], uuid, Uuid::kNumBytes128);
+  p_rec->num_uuids++;
+}
+
+/*******************************************************************************
+ *
+ * Function         add_uuids_in_seq
+ *
+ * Description      This function adds the UUIDs of a data element sequence to
+ *                  the record's UUID index. It walks the sequence the same
+ *                  way find_uuid_in_seq does.
+ *
+ ******************************************************************************/
+static void add_uuids_in_seq(tSDP_RECORD* p_rec, uint8_t* p, uint32_t seq_len,
+                             int nest_level) {
+  uint8_t* p_end = p + seq_len;
+  uint8_t type;
+  uint32_t len;
+
+  /* A little safety check to avoid excessive recursion */
+  if (nest_level > 3) return;
+
+  while (p < p_end) {
+    type = *p++;
+    p = sdpu_get_len_from_type(p, p_end, type, &len);
+    if (p == NULL || (p + len) > p_end) {
+      SDP_TRACE_WARNING("%s: bad length", __func__);
+      break;
+    }
+    type = type >> 3;
+    if (type == UUID_DESC_TYPE)
+      add_uuid_to_index(p_rec, p, len);
+    else if (type == DATA_ELE_SEQ_DESC_TYPE)
+      add_uuids_in_seq(p_rec, p, len, nest_level + 1);
+    p = p + len;
+  }
+}
+
+/*******************************************************************************
+ *
+ * Function         build_uuid_index
+ *
+ * Description      This function collects every UUID in the record, so that
+ *                  service searches do not have to parse the attributes of
+ *                  every record for every searched UUID.
+ *
+ ******************************************************************************/
+static void build_uuid_index(tSDP_RECORD* p_rec) {
+  uint16_t xx;
+  tSDP_ATTRIBUTE* p_attr = &p_rec->attribute[0];
+
+  p_rec->num_uuids = 0;
+  for (xx = 0; xx < p_rec->num_attributes; xx++, p_attr++) {
+    if (p_attr->type == UUID_DESC_TYPE)
+      add_uuid_to_index(p_rec, p_attr->value_ptr, p_attr->len);
+    else if (p_attr->type == DATA_ELE_SEQ_DESC_TYPE)
+      add_uuids_in_seq(p_rec, p_attr->value_ptr, p_attr->len, 0);
+  }
+
+  if (p_rec->num_uuids > SDP_MAX_REC_UUIDS)
+    SDP_TRACE_WARNING("%s: record 0x%08x has more than %d UUIDs", __func__,
+                      p_rec->record_handle, SDP_MAX_REC_UUIDS);
+  p_rec->uuid_index_valid = true;
+}
+
+/*******************************************************************************
+ *
+ * Function         record_has_uuid
+ *
+ * Description      This function checks whether the record contains a UUID.
+ *                  |p_uuid128| is |p_uid| expanded to 128 bits. The record's
+ *                  attributes are only parsed if its UUID index overflowed.
+ *
+ * Returns          true if found, else false
+ *
+ ******************************************************************************/
+static bool record_has_uuid(tSDP_RECORD* p_rec, tUID_ENT* p_uid,
+                            uint8_t* p_uuid128) {
+  uint16_t xx;
+  tSDP_ATTRIBUTE* p_attr;
+
+  if (p_rec->num_uuids <= SDP_MAX_REC_UUIDS) {
+    for (xx = 0; xx < p_rec->num_uuids; xx++) {
+      if (memcmp(p_rec->uuids[xx], p_uuid128, Uuid::kNumBytes128) == 0)
+        return (true);
+    }
+    return (false);
+  }
+
+  p_attr = &p_rec->attribute[0];
+  for (xx = 0; xx < p_rec->num_attributes; xx++, p_attr++) {
+    if (p_attr->type == UUID_DESC_TYPE) {
+      if (sdpu_compare_uuid_arrays(p_attr->value_ptr, p_attr->len,
+                                   &p_uid->value[0], p_uid->len))
+        return (true);
+    } else if (p_attr->type == DATA_ELE_SEQ_DESC_TYPE) {
+      if (find_uuid_in_seq(p_attr->value_ptr, p_attr->len, &p_uid->value[0],
+                           p_uid->len, 0))
+        return (true);
+    }
+  }
+  return (false);
+}
+
 /*******************************************************************************
  *
  * Function         find_uuid_in_seq
@@ -485,6 +616,8 @@ bool SDP_AddAttributeToRecord (tSDP_RECORD *p_rec, uint16_t attr_id,
     uint16_t xx, yy;
     tSDP_ATTRIBUTE* p_attr = &p_rec->attribute[0];
 
+    p_rec->uuid_index_valid = false;
+
     /* Found the record. Now, see if the attribute already exists */
     for (xx = 0; xx < p_rec->num_attributes; xx++, p_attr++) {
       /* The attribute exists. replace it */
@@ -1011,6 +1144,8 @@ bool SDP_DeleteAttributeFromRecord (tSDP_RECORD* p_rec, uint16_t attr_id)
   uint8_t *pad_ptr;
   uint32_t len;                        /* Number of bytes in the entry */
 
+  p_rec->uuid_index_valid = false;
+
   /* Found it. Now, find the attribute */
   for (xx = 0; xx < p_rec->num_attributes; xx++, p_attr++) {
     if (p_attr->id == attr_id) {
@@ -34,6 +34,7 @@
 #include "hcimsgs.h"
 #include "l2cdefs.h"
 #include "log/log.h"
+#include "osi/include/time.h"
 #include "sdp_api.h"
 #include "sdpint.h"
 
@@ -52,7 +53,6 @@ static void process_service_attr_rsp(tCONN_CB* p_ccb, uint8_t* p_reply,
                                      uint8_t* p_reply_end);
 static void process_service_search_attr_rsp(tCONN_CB* p_ccb, uint8_t* p_reply,
                                             uint8_t* p_reply_end);
-static uint8_t* save_attr_seq(tCONN_CB* p_ccb, uint8_t* p, uint8_t* p_msg_end);
 static tSDP_DISC_REC* add_record(tSDP_DISCOVERY_DB* p_db,
                                  const RawAddress& p_bda);
 static uint8_t* add_attr(uint8_t* p, uint8_t* p_end, tSDP_DISCOVERY_DB* p_db,
@@ -512,8 +512,9 @@ static void process_service_attr_rsp(tCONN_CB* p_ccb, uint8_t* p_reply,
 #endif
 
       /* Save the response in the database. Stop on any error */
-      if (!save_attr_seq(p_ccb, &p_ccb->rsp_list[0],
-                         &p_ccb->rsp_list[p_ccb->list_len])) {
+      if (!sdp_disc_save_attr_seq(p_ccb->p_db, p_ccb->device_address,
+                                  &p_ccb->rsp_list[0],
+                                  &p_ccb->rsp_list[p_ccb->list_len])) {
         sdp_disconnect(p_ccb, SDP_DB_FULL);
         return;
       }
@@ -592,7 +593,7 @@ static void process_service_attr_rsp(tCONN_CB* p_ccb, uint8_t* p_reply,
  ******************************************************************************/
 static void process_service_search_attr_rsp(tCONN_CB* p_ccb, uint8_t* p_reply,
                                             uint8_t* p_reply_end) {
-  uint8_t *p, *p_start, *p_end, *p_param_len;
+  uint8_t *p, *p_start, *p_end, *p_param_len, *p_lists;
   uint8_t type;
   uint32_t seq_len;
   uint16_t param_len, lists_byte_count = 0;
@@ -780,29 +781,37 @@ static void process_service_search_attr_rsp(tCONN_CB* p_ccb, uint8_t* p_reply,
     return;
   }
 
+  p_lists = p;
   while (p < p_end) {
-    p = save_attr_seq(p_ccb, p, &p_ccb->rsp_list[p_ccb->list_len]);
+    p = sdp_disc_save_attr_seq(p_ccb->p_db, p_ccb->device_address, p,
+                               &p_ccb->rsp_list[p_ccb->list_len]);
     if (!p) {
       sdp_disconnect(p_ccb, SDP_DB_FULL);
       return;
     }
   }
 
+  sdp_cache_store(p_ccb->device_address, p_ccb->p_db, p_lists, p_end,
+                  time_get_os_boottime_us() - p_ccb->disc_start_us);
+
   /* Since we got everything we need, disconnect the call */
   sdp_disconnect(p_ccb, SDP_SUCCESS);
 }
 
 /*******************************************************************************
  *
- * Function         save_attr_seq
+ * Function         sdp_disc_save_attr_seq
  *
  * Description      This function is called when there is a response from
- *                  the server.
+ *                  the server, or when a cached response is replayed. It
+ *                  adds one attribute list to |p_db| as a record of |bd_addr|.
  *
  * Returns          pointer to next byte or NULL if error
  *
  ******************************************************************************/
-static uint8_t* save_attr_seq(tCONN_CB* p_ccb, uint8_t* p, uint8_t* p_msg_end) {
+uint8_t* sdp_disc_save_attr_seq(tSDP_DISCOVERY_DB* p_db,
+                                const RawAddress& bd_addr, uint8_t* p,
+                                uint8_t* p_msg_end) {
   uint32_t seq_len, attr_len;
   uint16_t attr_id;
   uint8_t type, *p_seq_end;
@@ -821,7 +830,7 @@ static uint8_t* save_attr_seq(tCONN_CB* p_ccb, uint8_t* p, uint8_t* p_msg_end) {
   }
 
   /* Create a record */
-  p_rec = add_record(p_ccb->p_db, p_ccb->device_address);
+  p_rec = add_record(p_db, bd_addr);
   if (!p_rec) {
     SDP_TRACE_WARNING("SDP - DB full add_record");
     return (NULL);
@@ -845,7 +854,7 @@ static uint8_t* save_attr_seq(tCONN_CB* p_ccb, uint8_t* p, uint8_t* p_msg_end) {
     BE_STREAM_TO_UINT16(attr_id, p);
 
     /* Now, add the attribute value */
-    p = add_attr(p, p_seq_end, p_ccb->p_db, p_rec, attr_id, NULL, 0);
+    p = add_attr(p, p_seq_end, p_db, p_rec, attr_id, NULL, 0);
 
     if (!p) {
       SDP_TRACE_WARNING("SDP - DB full add_attr");
@@ -131,6 +131,8 @@ void sdp_free(void) {
     alarm_free(sdp_cb.ccb[i].sdp_conn_timer);
     sdp_cb.ccb[i].sdp_conn_timer = NULL;
   }
+  sdp_free_cached_replies();
+  sdp_cache_free();
 }
 
 #if (SDP_DEBUG == TRUE)
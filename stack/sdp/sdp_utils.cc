@@ -721,6 +721,33 @@ bool sdpu_compare_uuid_arrays(uint8_t* p_uuid1, uint32_t len1, uint8_t* p_uuid2,
   }
 }
 
+/*******************************************************************************
+ *
+ * Function         sdpu_expand_uuid
+ *
+ * Description      This function expands a 2, 4 or 16 byte BE UUID to its
+ *                  128-bit form, so that UUIDs of different sizes can be
+ *                  compared with memcmp.
+ *
+ * Returns          true if expanded, false if the length is invalid
+ *
+ ******************************************************************************/
+bool sdpu_expand_uuid(const uint8_t* p_uuid, uint32_t len, uint8_t* p_uuid128) {
+  if (len == Uuid::kNumBytes128) {
+    memcpy(p_uuid128, p_uuid, Uuid::kNumBytes128);
+    return true;
+  }
+
+  if (len != 2 && len != 4) return false;
+
+  memcpy(p_uuid128, sdp_base_uuid, Uuid::kNumBytes128);
+  if (len == 4)
+    memcpy(p_uuid128, p_uuid, len);
+  else
+    memcpy(p_uuid128 + 2, p_uuid, len);
+  return true;
+}
+
 /*******************************************************************************
  *
  * Function         sdpu_compare_uuid_with_attr
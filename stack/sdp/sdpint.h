@@ -25,6 +25,8 @@
 #ifndef SDP_INT_H
 #define SDP_INT_H
 
+#include <vector>
+
 #include "bluetooth/uuid.h"
 #include "bt_target.h"
 #include "l2c_api.h"
@@ -123,6 +125,12 @@ typedef struct {
   uint16_t num_attributes;
   tSDP_ATTRIBUTE attribute[SDP_MAX_REC_ATTR];
   uint8_t attr_pad[SDP_MAX_PAD_LEN];
+  /* UUIDs found anywhere in the record, expanded to 128 bits. Built by the
+   * first service search after the attributes change; num_uuids is greater
+   * than SDP_MAX_REC_UUIDS if the record did not fit. */
+  bool uuid_index_valid;
+  uint8_t num_uuids;
+  uint8_t uuids[SDP_MAX_REC_UUIDS][bluetooth::Uuid::kNumBytes128];
 } tSDP_RECORD;
 
 /* Define the SDP database */
@@ -200,6 +208,7 @@ typedef struct {
 
   uint8_t disc_state;
   uint8_t is_attr_search;
+  uint64_t disc_start_us; /* when the discovery was requested */
 
 #if (SDP_SERVER_ENABLED == TRUE)
   uint16_t cont_offset;     /* Continuation state data in the server response */
@@ -273,6 +282,8 @@ extern uint8_t* sdpu_get_len_from_type(uint8_t* p, uint8_t* p_end, uint8_t type,
 extern bool sdpu_is_base_uuid(uint8_t* p_uuid);
 extern bool sdpu_compare_uuid_arrays(uint8_t* p_uuid1, uint32_t len1,
                                      uint8_t* p_uuid2, uint16_t len2);
+extern bool sdpu_expand_uuid(const uint8_t* p_uuid, uint32_t len,
+                             uint8_t* p_uuid128);
 extern bool sdpu_compare_uuid_with_attr(const bluetooth::Uuid& uuid,
                                         tSDP_DISC_ATTR* p_attr);
 
@@ -319,6 +330,25 @@ extern bool sdp_dev_blacklisted_for_avrcp15 (RawAddress addr);
  */
 extern void sdp_disc_connected(tCONN_CB* p_ccb);
 extern void sdp_disc_server_rsp(tCONN_CB* p_ccb, BT_HDR* p_msg);
+extern uint8_t* sdp_disc_save_attr_seq(tSDP_DISCOVERY_DB* p_db,
+                                       const RawAddress& bd_addr, uint8_t* p,
+                                       uint8_t* p_msg_end);
+
+/* Functions provided by sdp_api.cc
+ */
+extern void sdp_free_cached_replies(void);
+
+/* Functions provided by sdp_cache.cc
+ */
+extern bool sdp_cache_find(const RawAddress& bd_addr,
+                           const tSDP_DISCOVERY_DB* p_db,
+                           std::vector<uint8_t>* p_attr_lists);
+extern void sdp_cache_store(const RawAddress& bd_addr,
+                            const tSDP_DISCOVERY_DB* p_db,
+                            const uint8_t* p_lists, const uint8_t* p_end,
+                            uint32_t query_us);
+extern void sdp_cache_hit_done(uint32_t reply_us);
+extern void sdp_cache_free(void);
 
 extern void update_pce_entry_after_cancelling_bonding(RawAddress remote_addr);
 extern void check_and_store_pce_profile_version(tSDP_DISC_REC* p_sdp_rec);
@@ -248,7 +248,6 @@ void ECC_PointMult_Bin_NAF(Point* q, Point* p, uint32_t* n,
 
 bool ECC_ValidatePoint(const Point& pt) {
   const size_t kl = KEY_LENGTH_DWORDS_P256;
-  p_256_init_curve(kl);
 
   // Ensure y^2 = x^3 + a*x + b (mod p); a = -3
 
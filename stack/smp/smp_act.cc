@@ -1547,17 +1547,26 @@ void smp_idle_terminate(tSMP_CB* p_cb, tSMP_INT_DATA* p_data) {
 /*******************************************************************************
  * Function     smp_both_have_public_keys
  * Description  The function is called when both local and peer public keys are
- *              saved.
- *              Actions:
- *              - invokes DHKey computation;
- *              - on slave side invokes sending local public key to the peer.
- *              - invokes SC phase 1 process.
+ *              saved. It invokes DHKey computation, which finishes in
+ *              smp_dhkey_computed.
  ******************************************************************************/
 void smp_both_have_public_keys(tSMP_CB* p_cb, tSMP_INT_DATA* p_data) {
   SMP_TRACE_DEBUG("%s", __func__);
 
   /* invokes DHKey computation */
   smp_compute_dhkey(p_cb);
+}
+
+/*******************************************************************************
+ * Function     smp_dhkey_computed
+ * Description  The function is called when the DHKey computation started by
+ *              smp_both_have_public_keys has finished.
+ *              Actions:
+ *              - on slave side invokes sending local public key to the peer.
+ *              - invokes SC phase 1 process.
+ ******************************************************************************/
+void smp_dhkey_computed(tSMP_CB* p_cb) {
+  SMP_TRACE_DEBUG("%s", __func__);
 
   /* on slave side invokes sending local public key to the peer */
   if (p_cb->role == HCI_ROLE_SLAVE) smp_send_pair_public_key(p_cb, NULL);
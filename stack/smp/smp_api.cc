@@ -89,6 +89,7 @@
  *
  ******************************************************************************/
 void SMP_Init(void) {
+  smp_discard_held_pdus();
   memset(&smp_cb, 0, sizeof(tSMP_CB));
   smp_cb.smp_rsp_timer_ent = alarm_new("smp.smp_rsp_timer_ent");
   smp_cb.delayed_auth_timer_ent = alarm_new("smp.delayed_auth_timer_ent");
@@ -101,8 +102,8 @@ void SMP_Init(void) {
   SMP_TRACE_EVENT("%s", __func__);
 
   smp_l2cap_if_init();
-  /* initialization of P-256 parameters */
-  p_256_init_curve(KEY_LENGTH_DWORDS_P256);
+  /* initialization of P-256 parameters and the crypto workers */
+  smp_crypto_worker_init();
 
   /* Initialize failure case for certification */
   smp_cb.cert_failure =
@@ -0,0 +1,176 @@
+/******************************************************************************
+ *
+ *  Copyright 2019 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+/******************************************************************************
+ *
+ *  This file runs the P-256 point multiplications needed for LE Secure
+ *  Connections on a small pool of worker threads, so that public key
+ *  generation and DHKey computation do not stall the BTU thread. Results are
+ *  posted back to the BTU message loop.
+ *
+ ******************************************************************************/
+
+#include <base/bind.h>
+#include <base/location.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <mutex>
+
+#include "bt_target.h"
+#include "osi/include/osi.h"
+#include "osi/include/thread.h"
+#include "p_256_ecc_pp.h"
+#include "smp_int.h"
+
+typedef struct {
+  uint32_t request_id;
+  Point point;
+  uint32_t scalar[KEY_LENGTH_DWORDS_P256];
+  Point result;
+  tSMP_ECC_CBACK* p_cback;
+} tSMP_ECC_REQ;
+
+static thread_t* smp_crypto_workers[SMP_CRYPTO_WORKERS];
+static size_t smp_crypto_next_worker;
+static uint32_t smp_crypto_next_request_id;
+
+/*******************************************************************************
+ *
+ * Function         smp_crypto_worker_init
+ *
+ * Description      Initializes the P-256 curve parameters and starts the
+ *                  crypto worker threads. The workers are kept for the
+ *                  lifetime of the process and read the curve without
+ *                  locking, so both are only set up on the first call.
+ *
+ ******************************************************************************/
+void smp_crypto_worker_init(void) {
+  static std::once_flag curve_init;
+  std::call_once(curve_init, p_256_init_curve, KEY_LENGTH_DWORDS_P256);
+
+  for (int i = 0; i < SMP_CRYPTO_WORKERS; i++) {
+    if (smp_crypto_workers[i] != NULL) continue;
+
+    char name[THREAD_NAME_MAX + 1];
+    snprintf(name, sizeof(name), "smp_crypto_%d", i);
+    smp_crypto_workers[i] = thread_new(name);
+    if (smp_crypto_workers[i] == NULL)
+      SMP_TRACE_ERROR("%s: unable to start %s, ECC will run inline", __func__,
+                      name);
+  }
+}
+
+/* Runs on the BTU thread. */
+static void smp_ecc_point_mult_complete(tSMP_ECC_REQ* p_req) {
+  tSMP_CB* p_cb = &smp_cb;
+
+  /* The PDUs held for a cancelled request were discarded with its pairing,
+   * those held now belong to the request that is still pending. */
+  if (p_cb->crypto_request_id != p_req->request_id) {
+    SMP_TRACE_WARNING("%s: dropping result of cancelled request %u", __func__,
+                      p_req->request_id);
+    return;
+  }
+
+  BT_OCTET32 x, y;
+  memcpy(x, p_req->result.x, BT_OCTET32_LEN);
+  memcpy(y, p_req->result.y, BT_OCTET32_LEN);
+
+  p_cb->crypto_request_id = 0;
+  (*p_req->p_cback)(p_cb, x, y);
+
+  /* The callback may have started another request, in which case the held
+   * PDUs stay queued until that one completes. */
+  smp_release_held_pdus();
+}
+
+/* Runs on a worker thread. */
+static void smp_ecc_point_mult_run(void* context) {
+  tSMP_ECC_REQ* p_req = (tSMP_ECC_REQ*)context;
+
+  ECC_PointMult(&p_req->result, &p_req->point, p_req->scalar,
+                KEY_LENGTH_DWORDS_P256);
+
+  base::MessageLoop* btu_message_loop = get_message_loop();
+  if (!btu_message_loop || !btu_message_loop->task_runner().get()) {
+    SMP_TRACE_WARNING("%s: BTU message loop is not running", __func__);
+    delete p_req;
+    return;
+  }
+  btu_message_loop->task_runner()->PostTask(
+      FROM_HERE,
+      task_stats_wrap(
+          get_message_loop_task_stats(), FROM_HERE,
+          base::Bind(&smp_ecc_point_mult_complete, base::Owned(p_req))));
+}
+
+/*******************************************************************************
+ *
+ * Function         smp_ecc_point_mult
+ *
+ * Description      Computes |scalar| x |p_point| (the curve base point G if
+ *                  |p_point| is NULL) on a worker thread and calls |p_cback|
+ *                  with the x and y coordinates of the result on the BTU
+ *                  thread. While the request is pending, SMP PDUs from the
+ *                  pairing peer are held back. A result that arrives after
+ *                  |p_cb| has been reset is dropped.
+ *
+ ******************************************************************************/
+void smp_ecc_point_mult(tSMP_CB* p_cb, const tSMP_PUBLIC_KEY* p_point,
+                        const BT_OCTET32 scalar, tSMP_ECC_CBACK* p_cback) {
+  tSMP_ECC_REQ* p_req = new tSMP_ECC_REQ;
+
+  if (p_point == NULL) {
+    p_req->point = curve_p256.G;
+  } else {
+    memset(&p_req->point, 0, sizeof(p_req->point));
+    memcpy(p_req->point.x, p_point->x, BT_OCTET32_LEN);
+    memcpy(p_req->point.y, p_point->y, BT_OCTET32_LEN);
+  }
+  memcpy(p_req->scalar, scalar, BT_OCTET32_LEN);
+  p_req->p_cback = p_cback;
+
+  /* 0 means "nothing pending" in the control block. */
+  if (++smp_crypto_next_request_id == 0) smp_crypto_next_request_id = 1;
+  p_req->request_id = smp_crypto_next_request_id;
+  p_cb->crypto_request_id = p_req->request_id;
+
+  thread_t* worker = smp_crypto_workers[smp_crypto_next_worker];
+  smp_crypto_next_worker = (smp_crypto_next_worker + 1) % SMP_CRYPTO_WORKERS;
+
+  if (worker == NULL) {
+    ECC_PointMult(&p_req->result, &p_req->point, p_req->scalar,
+                  KEY_LENGTH_DWORDS_P256);
+    smp_ecc_point_mult_complete(p_req);
+    delete p_req;
+    return;
+  }
+  thread_post(worker, smp_ecc_point_mult_run, p_req);
+}
+
+/*******************************************************************************
+ *
+ * Function         smp_crypto_is_pending
+ *
+ * Description      Returns true if |p_cb| is waiting for a worker result.
+ *
+ ******************************************************************************/
+bool smp_crypto_is_pending(const tSMP_CB* p_cb) {
+  return p_cb->crypto_request_id != 0;
+}
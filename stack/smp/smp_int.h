@@ -252,6 +252,11 @@ enum {
 /* check if authentication requirement need MITM protection */
 #define SMP_NO_MITM_REQUIRED(x) (((x)&SMP_AUTH_YN_BIT) == 0)
 
+/* Number of ECC worker threads. Only one pairing runs at a time, the second
+ * worker keeps a late result for a cancelled pairing from delaying the next
+ * one. */
+#define SMP_CRYPTO_WORKERS 2
+
 typedef struct {
   RawAddress bd_addr;
   BT_HDR* p_copy;
@@ -336,8 +341,13 @@ typedef struct {
   uint8_t cert_failure; /*failure case for certification */
   alarm_t* delayed_auth_timer_ent;
   uint8_t cert_disable_h7_support;
+  uint32_t crypto_request_id; /* pending worker ECC request, 0 if none */
 } tSMP_CB;
 
+/* Called on the BTU thread with the result of smp_ecc_point_mult */
+typedef void(tSMP_ECC_CBACK)(tSMP_CB* p_cb, const BT_OCTET32 x,
+                             const BT_OCTET32 y);
+
 /* Server Action functions are of this type */
 typedef void (*tSMP_ACT)(tSMP_CB* p_cb, tSMP_INT_DATA* p_data);
 
@@ -403,6 +413,7 @@ extern void smp_proc_srk_info(tSMP_CB* p_cb, tSMP_INT_DATA* p_data);
 extern void smp_generate_csrk(tSMP_CB* p_cb, tSMP_INT_DATA* p_data);
 extern void smp_key_pick_key(tSMP_CB* p_cb, tSMP_INT_DATA* p_data);
 extern void smp_both_have_public_keys(tSMP_CB* p_cb, tSMP_INT_DATA* p_data);
+extern void smp_dhkey_computed(tSMP_CB* p_cb);
 extern void smp_start_secure_connection_phase1(tSMP_CB* p_cb,
                                                tSMP_INT_DATA* p_data);
 extern void smp_process_local_nonce(tSMP_CB* p_cb, tSMP_INT_DATA* p_data);
@@ -446,6 +457,15 @@ extern void smp_br_pairing_complete(tSMP_CB* p_cb, tSMP_INT_DATA* p_data);
 /* smp_l2c */
 extern void smp_l2cap_if_init(void);
 extern void smp_data_ind(const RawAddress& bd_addr, BT_HDR* p_buf);
+extern void smp_release_held_pdus(void);
+extern void smp_discard_held_pdus(void);
+
+/* smp_crypto_worker.cc */
+extern void smp_crypto_worker_init(void);
+extern void smp_ecc_point_mult(tSMP_CB* p_cb, const tSMP_PUBLIC_KEY* p_point,
+                               const BT_OCTET32 scalar,
+                               tSMP_ECC_CBACK* p_cback);
+extern bool smp_crypto_is_pending(const tSMP_CB* p_cb);
 
 /* smp_util.cc */
 extern bool smp_send_cmd(uint8_t cmd_code, tSMP_CB* p_cb);
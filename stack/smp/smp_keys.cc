@@ -52,6 +52,10 @@ using crypto_toolbox::aes_128;
 static void smp_process_stk(tSMP_CB* p_cb, Octet16* p);
 static Octet16 smp_calculate_legacy_short_term_key(tSMP_CB* p_cb);
 static void smp_process_private_key(tSMP_CB* p_cb);
+static void smp_process_public_key(tSMP_CB* p_cb, const BT_OCTET32 x,
+                                   const BT_OCTET32 y);
+static void smp_process_dhkey(tSMP_CB* p_cb, const BT_OCTET32 x,
+                              UNUSED_ATTR const BT_OCTET32 y);
 
 #define SMP_PASSKEY_MASK 0xfff00000
 
@@ -723,24 +727,37 @@ void smp_use_oob_private_key(tSMP_CB* p_cb, tSMP_INT_DATA* p_data) {
  * Function         smp_process_private_key
  *
  * Description      This function processes private key.
- *                  It calculates public key and notifies SM that private key /
- *                  public key pair is created.
+ *                  It starts the public key calculation on a crypto worker;
+ *                  smp_process_public_key continues once it is done.
  *
  * Returns          void
  *
  ******************************************************************************/
 void smp_process_private_key(tSMP_CB* p_cb) {
-  Point public_key;
-  BT_OCTET32 private_key;
+  SMP_TRACE_DEBUG("%s", __func__);
+
+  smp_ecc_point_mult(p_cb, NULL, p_cb->private_key, smp_process_public_key);
+}
+
+/*******************************************************************************
+ *
+ * Function         smp_process_public_key
+ *
+ * Description      This function saves the public key computed from the
+ *                  private key and notifies SM that private key / public key
+ *                  pair is created.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+static void smp_process_public_key(tSMP_CB* p_cb, const BT_OCTET32 x,
+                                   const BT_OCTET32 y) {
   int generate_invalid_public_key;
 
   SMP_TRACE_DEBUG("%s", __func__);
 
-  memcpy(private_key, p_cb->private_key, BT_OCTET32_LEN);
-  ECC_PointMult(&public_key, &(curve_p256.G), (uint32_t*)private_key,
-                KEY_LENGTH_DWORDS_P256);
-  memcpy(p_cb->loc_publ_key.x, public_key.x, BT_OCTET32_LEN);
-  memcpy(p_cb->loc_publ_key.y, public_key.y, BT_OCTET32_LEN);
+  memcpy(p_cb->loc_publ_key.x, x, BT_OCTET32_LEN);
+  memcpy(p_cb->loc_publ_key.y, y, BT_OCTET32_LEN);
 
   generate_invalid_public_key =
       stack_config_get_interface()->get_pts_smp_generate_invalid_public_key();
@@ -781,29 +798,37 @@ void smp_process_private_key(tSMP_CB* p_cb) {
  *
  * Function         smp_compute_dhkey
  *
- * Description      The function:
- *                  - calculates a new public key using as input local private
- *                    key and peer public key;
- *                  - saves the new public key x-coordinate as DHKey.
+ * Description      The function starts the calculation of a new public key
+ *                  using as input local private key and peer public key on a
+ *                  crypto worker; smp_process_dhkey continues once it is done.
  *
  * Returns          void
  *
  ******************************************************************************/
 void smp_compute_dhkey(tSMP_CB* p_cb) {
-  Point peer_publ_key, new_publ_key;
-  BT_OCTET32 private_key;
-  int generate_invalid_public_key;
-
   SMP_TRACE_DEBUG("%s", __func__);
 
-  memcpy(private_key, p_cb->private_key, BT_OCTET32_LEN);
-  memcpy(peer_publ_key.x, p_cb->peer_publ_key.x, BT_OCTET32_LEN);
-  memcpy(peer_publ_key.y, p_cb->peer_publ_key.y, BT_OCTET32_LEN);
+  smp_ecc_point_mult(p_cb, &p_cb->peer_publ_key, p_cb->private_key,
+                     smp_process_dhkey);
+}
+
+/*******************************************************************************
+ *
+ * Function         smp_process_dhkey
+ *
+ * Description      The function saves the x-coordinate of the new public key
+ *                  as DHKey and lets the state machine continue.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+static void smp_process_dhkey(tSMP_CB* p_cb, const BT_OCTET32 x,
+                              UNUSED_ATTR const BT_OCTET32 y) {
+  int generate_invalid_public_key;
 
-  ECC_PointMult(&new_publ_key, &peer_publ_key, (uint32_t*)private_key,
-                KEY_LENGTH_DWORDS_P256);
+  SMP_TRACE_DEBUG("%s", __func__);
 
-  memcpy(p_cb->dhkey, new_publ_key.x, BT_OCTET32_LEN);
+  memcpy(p_cb->dhkey, x, BT_OCTET32_LEN);
 
   generate_invalid_public_key =
       stack_config_get_interface()->get_pts_smp_generate_invalid_public_key();
@@ -823,6 +848,8 @@ void smp_compute_dhkey(tSMP_CB* p_cb) {
                                       BT_OCTET32_LEN);
   smp_debug_print_nbyte_little_endian(p_cb->dhkey, "Reverted DHKey",
                                       BT_OCTET32_LEN);
+
+  smp_dhkey_computed(p_cb);
 }
 
 /** The function calculates and saves local commmitment in CB. */
@@ -28,6 +28,7 @@
 #include "log/log.h"
 
 #include <string.h>
+#include <deque>
 #include "btm_ble_api.h"
 #include "l2c_api.h"
 
@@ -47,6 +48,10 @@ static void smp_br_connect_callback(uint16_t channel, const RawAddress& bd_addr,
 static void smp_br_data_received(uint16_t channel, const RawAddress& bd_addr,
                                  BT_HDR* p_buf);
 
+/* PDUs from the pairing peer that arrived while an ECC computation was
+ * running on a crypto worker, in arrival order. */
+static std::deque<tSMP_REQ_Q_ENTRY> smp_held_pdus;
+
 /*******************************************************************************
  *
  * Function         smp_l2cap_if_init
@@ -120,6 +125,8 @@ static void smp_connect_callback(uint16_t channel, const RawAddress& bd_addr,
         smp_sm_event(p_cb, SMP_L2CAP_CONN_EVT, NULL);
       }
     } else {
+      /* PDUs held for this pairing must not be replayed into the next one */
+      smp_discard_held_pdus();
       int_data.reason = reason;
       /* Disconnected while doing security */
       smp_sm_event(p_cb, SMP_L2CAP_DISCONN_EVT, &int_data);
@@ -180,6 +187,14 @@ static void smp_data_received(uint16_t channel, const RawAddress& bd_addr,
   }
 
   if (bd_addr == p_cb->pairing_bda) {
+    /* Keep the state machine from seeing the next PDU before the ECC result
+     * it is waiting for; smp_release_held_pdus replays it. */
+    if (smp_crypto_is_pending(p_cb)) {
+      SMP_TRACE_DEBUG("%s: holding cmd=0x%x until ECC result", __func__, cmd);
+      smp_held_pdus.push_back({bd_addr, p_buf});
+      return;
+    }
+
     alarm_set_on_mloop(p_cb->smp_rsp_timer_ent, SMP_WAIT_FOR_RSP_TIMEOUT_MS,
                        smp_rsp_timeout, NULL);
 
@@ -205,6 +220,39 @@ static void smp_data_received(uint16_t channel, const RawAddress& bd_addr,
   osi_free(p_buf);
 }
 
+/*******************************************************************************
+ *
+ * Function         smp_release_held_pdus
+ *
+ * Description      Feeds PDUs held back during an ECC computation to the state
+ *                  machine, stopping if one of them starts another one.
+ *
+ ******************************************************************************/
+void smp_release_held_pdus(void) {
+  while (!smp_held_pdus.empty() && !smp_crypto_is_pending(&smp_cb)) {
+    tSMP_REQ_Q_ENTRY entry = smp_held_pdus.front();
+    smp_held_pdus.pop_front();
+    smp_data_received(L2CAP_SMP_CID, entry.bd_addr, entry.p_copy);
+  }
+}
+
+/*******************************************************************************
+ *
+ * Function         smp_discard_held_pdus
+ *
+ * Description      Frees the PDUs held back during an ECC computation, when the
+ *                  pairing they belong to ends before its result lands.
+ *
+ ******************************************************************************/
+void smp_discard_held_pdus(void) {
+  if (!smp_held_pdus.empty())
+    SMP_TRACE_DEBUG("%s: discarding %zu held PDUs", __func__,
+                    smp_held_pdus.size());
+
+  for (const tSMP_REQ_Q_ENTRY& entry : smp_held_pdus) osi_free(entry.p_copy);
+  smp_held_pdus.clear();
+}
+
 /*******************************************************************************
  *
  * Function         smp_tx_complete_callback
@@ -832,6 +832,7 @@ void smp_cb_cleanup(tSMP_CB* p_cb) {
 
   alarm_cancel(p_cb->smp_rsp_timer_ent);
   alarm_cancel(p_cb->delayed_auth_timer_ent);
+  smp_discard_held_pdus();
   memset(p_cb, 0, sizeof(tSMP_CB));
   p_cb->p_callback = p_callback;
   p_cb->trace_level = trace_level;
@@ -0,0 +1,317 @@
+/******************************************************************************
+ *
+ *  Copyright 2019 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include "btm_ble_host_filter.h"
+
+using bluetooth::Uuid;
+
+namespace {
+
+const RawAddress kAddress({0xc0, 0x01, 0x02, 0x03, 0x04, 0x05});
+const RawAddress kOtherAddress({0xc0, 0x01, 0x02, 0x03, 0x04, 0x06});
+
+// Flags, the 16 bit service UUIDs 0x180f and 0xfeaa, the name "beacon",
+// manufacturer data of company 0x00e0 and service data of UUID 0xfeaa
+const std::vector<uint8_t> kAdvData{
+    0x02, 0x01, 0x06,
+    0x05, 0x03, 0x0f, 0x18, 0xaa, 0xfe,
+    0x07, 0x09, 'b', 'e', 'a', 'c', 'o', 'n',
+    0x05, 0xff, 0xe0, 0x00, 0x12, 0x34,
+    0x05, 0x16, 0xaa, 0xfe, 0x10, 0x20};
+
+ApcfCommand Command(uint8_t type) {
+  ApcfCommand cmd = {};
+  cmd.type = type;
+  return cmd;
+}
+
+btgatt_filt_param_setup_t Params(uint16_t feat_seln, int8_t rssi = -127) {
+  btgatt_filt_param_setup_t params = {};
+  params.feat_seln = feat_seln;
+  params.rssi_high_thres = (uint8_t)rssi;
+  return params;
+}
+
+uint16_t Feature(uint8_t type) { return 1 << type; }
+
+class BleHostFilterTest : public ::testing::Test {
+ protected:
+  bool Matches(const std::vector<uint8_t>& data = kAdvData,
+               const RawAddress& bda = kAddress, int8_t rssi = -60) {
+    return filter_.Matches(bda, rssi, data.data(), data.size());
+  }
+
+  // Sets up filter |index| with the single condition |cmd|
+  void SetCondition(uint8_t index, const ApcfCommand& cmd) {
+    ASSERT_TRUE(filter_.AddConditions(index, {cmd}));
+    ASSERT_TRUE(filter_.SetFilter(index, Params(Feature(cmd.type))));
+  }
+
+  BleHostFilter filter_;
+};
+
+}  // namespace
+
+TEST_F(BleHostFilterTest, DisabledMatchesEverything) {
+  ApcfCommand cmd = Command(BTM_BLE_PF_ADDR_FILTER);
+  cmd.address = kOtherAddress;
+  SetCondition(1, cmd);
+
+  EXPECT_TRUE(Matches());
+  filter_.Enable(true);
+  EXPECT_FALSE(Matches());
+  filter_.Enable(false);
+  EXPECT_TRUE(Matches());
+}
+
+TEST_F(BleHostFilterTest, EnabledWithoutFilters) {
+  filter_.Enable(true);
+  EXPECT_FALSE(Matches());
+
+  // Conditions don't take part until their filter is set up
+  ApcfCommand cmd = Command(BTM_BLE_PF_ADDR_FILTER);
+  cmd.address = kAddress;
+  ASSERT_TRUE(filter_.AddConditions(1, {cmd}));
+  EXPECT_FALSE(Matches());
+}
+
+TEST_F(BleHostFilterTest, AllowAll) {
+  filter_.Enable(true);
+  ASSERT_TRUE(filter_.SetFilter(0, Params(0)));
+  EXPECT_TRUE(Matches());
+  EXPECT_TRUE(Matches({}));
+
+  filter_.DeleteFilter(0);
+  EXPECT_FALSE(Matches());
+}
+
+TEST_F(BleHostFilterTest, Address) {
+  filter_.Enable(true);
+  ApcfCommand cmd = Command(BTM_BLE_PF_ADDR_FILTER);
+  cmd.address = kAddress;
+  SetCondition(3, cmd);
+
+  EXPECT_TRUE(Matches());
+  EXPECT_FALSE(Matches(kAdvData, kOtherAddress));
+}
+
+TEST_F(BleHostFilterTest, ServiceUuid) {
+  filter_.Enable(true);
+  ApcfCommand cmd = Command(BTM_BLE_PF_SRVC_UUID);
+  cmd.uuid = Uuid::From16Bit(0xfeaa);
+  SetCondition(1, cmd);
+  EXPECT_TRUE(Matches());
+
+  filter_.ClearConditions(1);
+  cmd.uuid = Uuid::From16Bit(0x180d);
+  ASSERT_TRUE(filter_.AddConditions(1, {cmd}));
+  EXPECT_FALSE(Matches());
+
+  // A UUID listed in its 128 bit form matches too
+  std::vector<uint8_t> data{0x11, 0x07};
+  Uuid::UUID128Bit le = Uuid::From16Bit(0x180d).To128BitLE();
+  data.insert(data.end(), le.begin(), le.end());
+  EXPECT_TRUE(Matches(data));
+}
+
+TEST_F(BleHostFilterTest, ServiceUuidMask) {
+  filter_.Enable(true);
+  ApcfCommand cmd = Command(BTM_BLE_PF_SRVC_UUID);
+  cmd.uuid = Uuid::From16Bit(0x1800);
+  cmd.uuid_mask = Uuid::From16Bit(0xff00);
+  SetCondition(2, cmd);
+  EXPECT_TRUE(Matches());
+
+  const std::vector<uint8_t> other{0x03, 0x03, 0x0f, 0x19};
+  EXPECT_FALSE(Matches(other));
+}
+
+TEST_F(BleHostFilterTest, SolicitationUuid) {
+  filter_.Enable(true);
+  ApcfCommand cmd = Command(BTM_BLE_PF_SRVC_SOL_UUID);
+  cmd.uuid = Uuid::From16Bit(0x180f);
+  SetCondition(1, cmd);
+
+  // Listed as a service, not solicited
+  EXPECT_FALSE(Matches());
+  const std::vector<uint8_t> solicited{0x03, 0x14, 0x0f, 0x18};
+  EXPECT_TRUE(Matches(solicited));
+}
+
+TEST_F(BleHostFilterTest, LocalName) {
+  filter_.Enable(true);
+  ApcfCommand cmd = Command(BTM_BLE_PF_LOCAL_NAME);
+  cmd.name = {'b', 'e', 'a', 'c', 'o', 'n'};
+  SetCondition(1, cmd);
+  EXPECT_TRUE(Matches());
+
+  filter_.ClearConditions(1);
+  cmd.name = {'b', 'e', 'a'};
+  ASSERT_TRUE(filter_.AddConditions(1, {cmd}));
+  EXPECT_FALSE(Matches());
+}
+
+TEST_F(BleHostFilterTest, LongLocalName) {
+  filter_.Enable(true);
+  ApcfCommand cmd = Command(BTM_BLE_PF_LOCAL_NAME);
+  cmd.name.assign(BTM_BLE_PF_STR_LEN_MAX + 3, 'x');
+  SetCondition(1, cmd);
+
+  // Only the first bytes of a long name are compared
+  std::vector<uint8_t> data{BTM_BLE_PF_STR_LEN_MAX + 1, 0x08};
+  data.insert(data.end(), BTM_BLE_PF_STR_LEN_MAX, 'x');
+  EXPECT_TRUE(Matches(data));
+  data.back() = 'y';
+  EXPECT_FALSE(Matches(data));
+}
+
+TEST_F(BleHostFilterTest, ManufacturerData) {
+  filter_.Enable(true);
+  ApcfCommand cmd = Command(BTM_BLE_PF_MANU_DATA);
+  cmd.company = 0x00e0;
+  cmd.data = {0x12, 0x00};
+  cmd.data_mask = {0xff, 0x00};
+  SetCondition(1, cmd);
+  EXPECT_TRUE(Matches());
+
+  filter_.ClearConditions(1);
+  cmd.data = {0x13};
+  cmd.data_mask = {0xff};
+  ASSERT_TRUE(filter_.AddConditions(1, {cmd}));
+  EXPECT_FALSE(Matches());
+}
+
+TEST_F(BleHostFilterTest, ManufacturerCompanyOnly) {
+  filter_.Enable(true);
+  ApcfCommand cmd = Command(BTM_BLE_PF_MANU_DATA);
+  cmd.company = 0x00e0;
+  // Without a mask the data is not compared
+  cmd.data = {0x55};
+  SetCondition(1, cmd);
+  EXPECT_TRUE(Matches());
+
+  filter_.ClearConditions(1);
+  cmd.company = 0x0101;
+  cmd.company_mask = 0x00ff;
+  ASSERT_TRUE(filter_.AddConditions(1, {cmd}));
+  EXPECT_FALSE(Matches());
+  cmd.company = 0x01e0;
+  ASSERT_TRUE(filter_.AddConditions(1, {cmd}));
+  EXPECT_TRUE(Matches());
+}
+
+TEST_F(BleHostFilterTest, ServiceData) {
+  filter_.Enable(true);
+  ApcfCommand cmd = Command(BTM_BLE_PF_SRVC_DATA_PATTERN);
+  cmd.data = {0xaa, 0xfe, 0x10};
+  SetCondition(1, cmd);
+  EXPECT_TRUE(Matches());
+
+  filter_.ClearConditions(1);
+  cmd.data = {0xaa, 0xfe, 0x10, 0x20, 0x30};
+  ASSERT_TRUE(filter_.AddConditions(1, {cmd}));
+  EXPECT_FALSE(Matches());
+}
+
+TEST_F(BleHostFilterTest, FeaturesMustAllBeMet) {
+  filter_.Enable(true);
+  ApcfCommand addr = Command(BTM_BLE_PF_ADDR_FILTER);
+  addr.address = kAddress;
+  ApcfCommand uuid = Command(BTM_BLE_PF_SRVC_UUID);
+  uuid.uuid = Uuid::From16Bit(0x180d);
+  ASSERT_TRUE(filter_.AddConditions(1, {addr, uuid}));
+
+  // The UUID condition is ignored while its feature is not selected
+  ASSERT_TRUE(filter_.SetFilter(
+      1, Params(Feature(BTM_BLE_PF_ADDR_FILTER))));
+  EXPECT_TRUE(Matches());
+
+  ASSERT_TRUE(filter_.SetFilter(
+      1, Params(Feature(BTM_BLE_PF_ADDR_FILTER) |
+                Feature(BTM_BLE_PF_SRVC_UUID))));
+  EXPECT_FALSE(Matches());
+
+  // Conditions of the same feature are alternatives
+  uuid.uuid = Uuid::From16Bit(0x180f);
+  ASSERT_TRUE(filter_.AddConditions(1, {uuid}));
+  EXPECT_TRUE(Matches());
+}
+
+TEST_F(BleHostFilterTest, AnyFilterMatches) {
+  filter_.Enable(true);
+  for (uint8_t i = 0; i < BTM_BLE_HOST_FILTER_MAX; i++) {
+    ApcfCommand cmd = Command(BTM_BLE_PF_MANU_DATA);
+    cmd.company = 0x0100 + i;
+    SetCondition(i, cmd);
+  }
+  EXPECT_FALSE(Matches());
+
+  const std::vector<uint8_t> last{0x03, 0xff, 0x3f, 0x01};
+  EXPECT_TRUE(Matches(last));
+  EXPECT_EQ(0, filter_.GetAvailableSpace());
+
+  EXPECT_FALSE(filter_.AddConditions(BTM_BLE_HOST_FILTER_MAX, {}));
+  EXPECT_FALSE(filter_.SetFilter(BTM_BLE_HOST_FILTER_MAX, Params(0)));
+}
+
+TEST_F(BleHostFilterTest, RssiThreshold) {
+  filter_.Enable(true);
+  ApcfCommand cmd = Command(BTM_BLE_PF_ADDR_FILTER);
+  cmd.address = kAddress;
+  ASSERT_TRUE(filter_.AddConditions(1, {cmd}));
+  ASSERT_TRUE(
+      filter_.SetFilter(1, Params(Feature(BTM_BLE_PF_ADDR_FILTER), -70)));
+  ASSERT_TRUE(filter_.SetFilter(2, Params(0, -50)));
+
+  EXPECT_FALSE(Matches(kAdvData, kAddress, -80));
+  EXPECT_TRUE(Matches(kAdvData, kAddress, -70));
+  EXPECT_FALSE(Matches(kAdvData, kOtherAddress, -60));
+  EXPECT_TRUE(Matches(kAdvData, kOtherAddress, -50));
+}
+
+TEST_F(BleHostFilterTest, UncheckedFeaturePasses) {
+  filter_.Enable(true);
+  ASSERT_TRUE(filter_.SetFilter(1, Params(Feature(BTM_BLE_PF_TDS_DATA))));
+  EXPECT_TRUE(Matches());
+}
+
+TEST_F(BleHostFilterTest, MalformedData) {
+  filter_.Enable(true);
+  ApcfCommand cmd = Command(BTM_BLE_PF_LOCAL_NAME);
+  cmd.name = {'b', 'e', 'a', 'c', 'o', 'n'};
+  SetCondition(1, cmd);
+
+  // The name runs past the end of the data
+  std::vector<uint8_t> data(kAdvData.begin(), kAdvData.begin() + 14);
+  EXPECT_FALSE(Matches(data));
+}
+
+TEST_F(BleHostFilterTest, Reset) {
+  filter_.Enable(true);
+  ASSERT_TRUE(filter_.SetFilter(0, Params(0)));
+  filter_.Reset();
+
+  EXPECT_FALSE(filter_.IsEnabled());
+  EXPECT_EQ(BTM_BLE_HOST_FILTER_MAX, filter_.GetAvailableSpace());
+  filter_.Enable(true);
+  EXPECT_FALSE(Matches());
+}
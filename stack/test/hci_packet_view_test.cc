@@ -0,0 +1,234 @@
+/******************************************************************************
+ *
+ *  Copyright 2019 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include "hci_packet_view.h"
+
+namespace {
+
+HciPacketView View(const std::vector<uint8_t>& bytes) {
+  return HciPacketView(bytes.data(), bytes.size());
+}
+
+}  // namespace
+
+TEST(HciPacketViewTest, HasAndSlice) {
+  const std::vector<uint8_t> bytes{0x01, 0x02, 0x03};
+  HciPacketView view = View(bytes);
+
+  EXPECT_TRUE(view.Has(0, 3));
+  EXPECT_TRUE(view.Has(3, 0));
+  EXPECT_FALSE(view.Has(1, 3));
+  EXPECT_FALSE(view.Has(4, 0));
+  EXPECT_FALSE(view.Has(1, SIZE_MAX));
+
+  HciPacketView slice = view.Slice(1, 2);
+  ASSERT_EQ(2u, slice.size());
+  EXPECT_EQ(0x02, slice.data()[0]);
+  EXPECT_EQ(0u, view.Slice(2, 2).size());
+}
+
+TEST(HciPacketViewTest, AclHeader) {
+  // Handle 0x0042, start of a flushable packet, 3 bytes of payload
+  const std::vector<uint8_t> bytes{0x42, 0x20, 0x03, 0x00, 0xaa, 0xbb, 0xcc};
+  HciAclView acl(View(bytes));
+
+  ASSERT_TRUE(acl.IsValid());
+  EXPECT_EQ(0x0042, acl.GetHandle());
+  EXPECT_EQ(2, acl.GetBoundaryFlag());
+  EXPECT_EQ(0, acl.GetBroadcastFlag());
+  EXPECT_EQ(3, acl.GetLength());
+  ASSERT_EQ(3u, acl.GetPayload().size());
+  EXPECT_EQ(0xaa, acl.GetPayload().data()[0]);
+}
+
+TEST(HciPacketViewTest, AclHeaderTruncated) {
+  const std::vector<uint8_t> header{0x42, 0x20, 0x03};
+  EXPECT_FALSE(HciAclView(View(header)).IsValid());
+
+  const std::vector<uint8_t> payload{0x42, 0x20, 0x03, 0x00, 0xaa, 0xbb};
+  EXPECT_FALSE(HciAclView(View(payload)).IsValid());
+}
+
+TEST(HciPacketViewTest, AclHeaderWrite) {
+  uint8_t bytes[HciAclHeader::kSize];
+  HciAclHeader::Write(bytes, 0x1042, 0x0123);
+
+  const std::vector<uint8_t> expected{0x42, 0x10, 0x23, 0x01};
+  EXPECT_EQ(expected, std::vector<uint8_t>(bytes, bytes + sizeof(bytes)));
+}
+
+TEST(HciPacketViewTest, NumberOfCompletedPackets) {
+  const std::vector<uint8_t> bytes{0x02, 0x01, 0x20, 0x05,
+                                   0x00, 0x02, 0x00, 0x01, 0x01};
+  HciNumberOfCompletedPacketsView nocp(View(bytes));
+
+  ASSERT_TRUE(nocp.IsValid());
+  ASSERT_EQ(2, nocp.GetNumHandles());
+  // The flags are masked out of the handle
+  EXPECT_EQ(0x0001, nocp.GetHandle(0));
+  EXPECT_EQ(5, nocp.GetCompleted(0));
+  EXPECT_EQ(0x0002, nocp.GetHandle(1));
+  EXPECT_EQ(0x0101, nocp.GetCompleted(1));
+}
+
+TEST(HciPacketViewTest, NumberOfCompletedPacketsTruncated) {
+  const std::vector<uint8_t> empty;
+  EXPECT_FALSE(HciNumberOfCompletedPacketsView(View(empty)).IsValid());
+
+  const std::vector<uint8_t> bytes{0x02, 0x01, 0x00, 0x05, 0x00, 0x02};
+  EXPECT_FALSE(HciNumberOfCompletedPacketsView(View(bytes)).IsValid());
+}
+
+TEST(HciPacketViewTest, LeAdvertisingReport) {
+  const std::vector<uint8_t> bytes{
+      0x02,
+      // ADV_IND from a public address, 3 bytes of data, RSSI -60
+      0x00, 0x00, 0x06, 0x05, 0x04, 0x03, 0x02, 0x01, 0x03, 0x02, 0x01, 0x06,
+      0xc4,
+      // SCAN_RSP from a random address, no data, RSSI -70
+      0x04, 0x01, 0x16, 0x15, 0x14, 0x13, 0x12, 0xc1, 0x00, 0xba};
+  HciLeAdvertisingReportView reports(View(bytes));
+  HciAdvertisingReport report;
+
+  ASSERT_TRUE(reports.Next(&report));
+  EXPECT_EQ(0x00, report.event_type);
+  EXPECT_EQ(BLE_ADDR_PUBLIC, report.address_type);
+  EXPECT_EQ(RawAddress({0x01, 0x02, 0x03, 0x04, 0x05, 0x06}), report.address);
+  EXPECT_EQ(PHY_LE_1M, report.primary_phy);
+  EXPECT_EQ(PHY_LE_NO_PACKET, report.secondary_phy);
+  EXPECT_EQ(-60, report.rssi);
+  ASSERT_EQ(3, report.data_len);
+  EXPECT_EQ(&bytes[10], report.data);
+
+  ASSERT_TRUE(reports.Next(&report));
+  EXPECT_EQ(0x04, report.event_type);
+  EXPECT_EQ(BLE_ADDR_RANDOM, report.address_type);
+  EXPECT_EQ(0, report.data_len);
+  EXPECT_EQ(-70, report.rssi);
+
+  EXPECT_FALSE(reports.Next(&report));
+  EXPECT_FALSE(reports.IsTruncated());
+}
+
+TEST(HciPacketViewTest, LeAdvertisingReportTruncated) {
+  // Two reports announced, the data of the first one runs past the event
+  const std::vector<uint8_t> bytes{0x02, 0x00, 0x00, 0x06, 0x05, 0x04,
+                                   0x03, 0x02, 0x01, 0x1f, 0x02, 0x01};
+  HciLeAdvertisingReportView reports(View(bytes));
+  HciAdvertisingReport report;
+
+  EXPECT_FALSE(reports.Next(&report));
+  EXPECT_TRUE(reports.IsTruncated());
+  EXPECT_FALSE(reports.Next(&report));
+}
+
+TEST(HciPacketViewTest, LeExtendedAdvertisingReport) {
+  const std::vector<uint8_t> bytes{
+      0x01,
+      // Connectable, scannable legacy ADV_IND
+      0x13, 0x00,
+      // Random address
+      0x01, 0x06, 0x05, 0x04, 0x03, 0x02, 0xc1,
+      // LE 1M, no secondary PHY, SID 3, TX power 4 dBm, RSSI -50
+      0x01, 0x00, 0x03, 0x04, 0xce,
+      // Periodic advertising interval, direct address
+      0x10, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+      // 2 bytes of data
+      0x02, 0x01, 0x06};
+  HciLeExtendedAdvertisingReportView reports(View(bytes));
+  HciAdvertisingReport report;
+
+  ASSERT_TRUE(reports.Next(&report));
+  EXPECT_EQ(0x0013, report.event_type);
+  EXPECT_EQ(BLE_ADDR_RANDOM, report.address_type);
+  EXPECT_EQ(RawAddress({0xc1, 0x02, 0x03, 0x04, 0x05, 0x06}), report.address);
+  EXPECT_EQ(PHY_LE_1M, report.primary_phy);
+  EXPECT_EQ(PHY_LE_NO_PACKET, report.secondary_phy);
+  EXPECT_EQ(3, report.advertising_sid);
+  EXPECT_EQ(4, report.tx_power);
+  EXPECT_EQ(-50, report.rssi);
+  EXPECT_EQ(0x0010, report.periodic_adv_int);
+  ASSERT_EQ(2, report.data_len);
+  EXPECT_EQ(&bytes[25], report.data);
+
+  EXPECT_FALSE(reports.Next(&report));
+  EXPECT_FALSE(reports.IsTruncated());
+}
+
+TEST(HciPacketViewTest, LeExtendedAdvertisingReportTruncated) {
+  // One report announced, cut in its fixed fields
+  const std::vector<uint8_t> bytes{0x01, 0x13, 0x00, 0x01, 0x06, 0x05};
+  HciLeExtendedAdvertisingReportView reports(View(bytes));
+  HciAdvertisingReport report;
+
+  EXPECT_FALSE(reports.Next(&report));
+  EXPECT_TRUE(reports.IsTruncated());
+
+  const std::vector<uint8_t> empty;
+  EXPECT_TRUE(HciLeExtendedAdvertisingReportView(View(empty)).IsTruncated());
+}
+
+TEST(HciPacketViewTest, Builder) {
+  uint8_t bytes[12];
+  HciPacketBuilder builder(bytes, sizeof(bytes));
+  const uint8_t data[] = {0xaa, 0xbb};
+
+  builder.Append<uint8_t>(0x01)
+      .Append<uint16_t>(0x0302)
+      .AppendAddress(RawAddress({0x01, 0x02, 0x03, 0x04, 0x05, 0x06}))
+      .AppendBytes(data, sizeof(data));
+
+  EXPECT_FALSE(builder.IsOverrun());
+  ASSERT_EQ(11u, builder.size());
+  const std::vector<uint8_t> expected{0x01, 0x02, 0x03, 0x06, 0x05, 0x04,
+                                      0x03, 0x02, 0x01, 0xaa, 0xbb};
+  EXPECT_EQ(expected, std::vector<uint8_t>(bytes, bytes + builder.size()));
+}
+
+TEST(HciPacketViewTest, BuilderOverrun) {
+  uint8_t bytes[4] = {};
+  HciPacketBuilder builder(bytes, 3);
+
+  builder.Append<uint16_t>(0x0201).Append<uint16_t>(0x0403).Append<uint8_t>(5);
+
+  EXPECT_TRUE(builder.IsOverrun());
+  EXPECT_EQ(2u, builder.size());
+  // Nothing is written past the capacity, nor after the overrun
+  EXPECT_EQ(0x00, bytes[2]);
+  EXPECT_EQ(0x00, bytes[3]);
+}
+
+TEST(HciPacketViewTest, BuilderUpdatesBuffer) {
+  uint8_t storage[sizeof(BT_HDR) + 8] = {};
+  BT_HDR* p_buf = (BT_HDR*)storage;
+  p_buf->offset = 2;
+  p_buf->len = 1;
+
+  HciPacketBuilder builder(p_buf, 6);
+  builder.Append<uint32_t>(0x04030201);
+  EXPECT_EQ(5, p_buf->len);
+  EXPECT_EQ(0x01, p_buf->data[3]);
+
+  builder.Append<uint16_t>(0x0605);
+  EXPECT_TRUE(builder.IsOverrun());
+  EXPECT_EQ(5, p_buf->len);
+}
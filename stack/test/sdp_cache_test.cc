@@ -0,0 +1,224 @@
+/******************************************************************************
+ *
+ *  Copyright 2019 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <string.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "stack/sdp/sdpint.h"
+
+using bluetooth::Uuid;
+
+namespace {
+
+const RawAddress kPeer({0x11, 0x22, 0x33, 0x44, 0x55, 0x66});
+const RawAddress kOtherPeer({0x11, 0x22, 0x33, 0x44, 0x55, 0x77});
+const Uuid kAudioSink = Uuid::From16Bit(0x110b);
+const Uuid kAvrcp = Uuid::From16Bit(0x110e);
+const Uuid kL2cap = Uuid::From16Bit(0x0100);
+
+// One record with ServiceClassIDList (0x0001), ProtocolDescriptorList
+// (0x0004) and BluetoothProfileDescriptorList (0x0009).
+const std::vector<uint8_t> kServiceClass = {0x09, 0x00, 0x01, 0x35,
+                                            0x03, 0x19, 0x11, 0x0b};
+const std::vector<uint8_t> kProtocol = {0x09, 0x00, 0x04, 0x35, 0x08,
+                                        0x35, 0x06, 0x19, 0x01, 0x00,
+                                        0x09, 0x00, 0x19};
+const std::vector<uint8_t> kProfile = {0x09, 0x00, 0x09, 0x35, 0x08,
+                                       0x35, 0x06, 0x19, 0x11, 0x0d,
+                                       0x09, 0x01, 0x03};
+
+std::vector<uint8_t> AttrList(
+    const std::vector<std::vector<uint8_t>>& attributes) {
+  std::vector<uint8_t> attrs;
+  for (const std::vector<uint8_t>& attribute : attributes)
+    attrs.insert(attrs.end(), attribute.begin(), attribute.end());
+
+  std::vector<uint8_t> list = {0x36, (uint8_t)(attrs.size() >> 8),
+                               (uint8_t)attrs.size()};
+  list.insert(list.end(), attrs.begin(), attrs.end());
+  return list;
+}
+
+class SdpCacheTest : public ::testing::Test {
+ protected:
+  void SetUp() override { sdp_cache_free(); }
+  void TearDown() override { sdp_cache_free(); }
+
+  // A discovery database for |uuids| and |attrs|, sorted as
+  // SDP_InitDiscoveryDb does.
+  tSDP_DISCOVERY_DB Db(std::vector<Uuid> uuids, std::vector<uint16_t> attrs) {
+    tSDP_DISCOVERY_DB db;
+    memset(&db, 0, sizeof(db));
+    std::copy(uuids.begin(), uuids.end(), db.uuid_filters);
+    db.num_uuid_filters = uuids.size();
+    std::sort(attrs.begin(), attrs.end());
+    std::copy(attrs.begin(), attrs.end(), db.attr_filters);
+    db.num_attr_filters = attrs.size();
+    return db;
+  }
+
+  void Store(const RawAddress& bd_addr, const tSDP_DISCOVERY_DB& db,
+             const std::vector<uint8_t>& attr_lists) {
+    sdp_cache_store(bd_addr, &db, attr_lists.data(),
+                    attr_lists.data() + attr_lists.size(), 50000);
+  }
+
+  bool Find(const RawAddress& bd_addr, const tSDP_DISCOVERY_DB& db) {
+    return sdp_cache_find(bd_addr, &db, &found_);
+  }
+
+  std::vector<uint8_t> found_;
+};
+
+}  // namespace
+
+TEST_F(SdpCacheTest, serves_stored_result) {
+  tSDP_DISCOVERY_DB db = Db({kAudioSink}, {0x0001, 0x0004});
+  std::vector<uint8_t> lists = AttrList({kServiceClass, kProtocol});
+  EXPECT_FALSE(Find(kPeer, db));
+
+  Store(kPeer, db, lists);
+  ASSERT_TRUE(Find(kPeer, db));
+  EXPECT_EQ(lists, found_);
+}
+
+TEST_F(SdpCacheTest, results_are_per_device) {
+  tSDP_DISCOVERY_DB db = Db({kAudioSink}, {0x0001});
+  Store(kPeer, db, AttrList({kServiceClass}));
+
+  EXPECT_FALSE(Find(kOtherPeer, db));
+}
+
+TEST_F(SdpCacheTest, results_of_a_device_are_kept_together) {
+  tSDP_DISCOVERY_DB sink = Db({kAudioSink}, {0x0001});
+  tSDP_DISCOVERY_DB avrcp = Db({kAvrcp}, {0x0009});
+  Store(kPeer, sink, AttrList({kServiceClass}));
+  Store(kPeer, avrcp, AttrList({kProfile}));
+
+  ASSERT_TRUE(Find(kPeer, sink));
+  EXPECT_EQ(AttrList({kServiceClass}), found_);
+  ASSERT_TRUE(Find(kPeer, avrcp));
+  EXPECT_EQ(AttrList({kProfile}), found_);
+
+  SDP_InvalidateDiscoveryCache(kPeer);
+  EXPECT_FALSE(Find(kPeer, sink));
+  EXPECT_FALSE(Find(kPeer, avrcp));
+}
+
+TEST_F(SdpCacheTest, invalidate_keeps_other_devices) {
+  tSDP_DISCOVERY_DB db = Db({kAudioSink}, {0x0001});
+  Store(kPeer, db, AttrList({kServiceClass}));
+  Store(kOtherPeer, db, AttrList({kServiceClass}));
+
+  SDP_InvalidateDiscoveryCache(kPeer);
+  EXPECT_FALSE(Find(kPeer, db));
+  EXPECT_TRUE(Find(kOtherPeer, db));
+}
+
+TEST_F(SdpCacheTest, uuid_order_does_not_matter) {
+  Store(kPeer, Db({kAudioSink, kL2cap}, {0x0001}), AttrList({kServiceClass}));
+
+  EXPECT_TRUE(Find(kPeer, Db({kL2cap, kAudioSink}, {0x0001})));
+  EXPECT_FALSE(Find(kPeer, Db({kAudioSink}, {0x0001})));
+}
+
+TEST_F(SdpCacheTest, wider_result_serves_fewer_attributes) {
+  Store(kPeer, Db({kAudioSink}, {}),
+        AttrList({kServiceClass, kProtocol, kProfile}));
+
+  ASSERT_TRUE(Find(kPeer, Db({kAudioSink}, {0x0009, 0x0001})));
+  EXPECT_EQ(AttrList({kServiceClass, kProfile}), found_);
+}
+
+TEST_F(SdpCacheTest, narrower_result_does_not_serve_more_attributes) {
+  Store(kPeer, Db({kAudioSink}, {0x0001, 0x0004}),
+        AttrList({kServiceClass, kProtocol}));
+
+  EXPECT_FALSE(Find(kPeer, Db({kAudioSink}, {0x0001, 0x0009})));
+  EXPECT_FALSE(Find(kPeer, Db({kAudioSink}, {})));
+  EXPECT_TRUE(Find(kPeer, Db({kAudioSink}, {0x0004})));
+  EXPECT_EQ(AttrList({kProtocol}), found_);
+}
+
+TEST_F(SdpCacheTest, filters_every_record) {
+  std::vector<uint8_t> lists = AttrList({kServiceClass, kProtocol});
+  std::vector<uint8_t> second = AttrList({kProfile, kProtocol});
+  lists.insert(lists.end(), second.begin(), second.end());
+  Store(kPeer, Db({kL2cap}, {0x0001, 0x0004, 0x0009}), lists);
+
+  ASSERT_TRUE(Find(kPeer, Db({kL2cap}, {0x0004})));
+  std::vector<uint8_t> expected = AttrList({kProtocol});
+  std::vector<uint8_t> protocol = AttrList({kProtocol});
+  expected.insert(expected.end(), protocol.begin(), protocol.end());
+  EXPECT_EQ(expected, found_);
+}
+
+TEST_F(SdpCacheTest, changed_records_drop_the_device) {
+  tSDP_DISCOVERY_DB sink = Db({kAudioSink}, {0x0001, 0x0004});
+  tSDP_DISCOVERY_DB avrcp = Db({kAvrcp}, {0x0009});
+  Store(kPeer, avrcp, AttrList({kProfile}));
+  Store(kPeer, sink, AttrList({kServiceClass, kProtocol}));
+
+  // The same query, asked again by an app, now returns something else.
+  Store(kPeer, sink, AttrList({kServiceClass}));
+  ASSERT_TRUE(Find(kPeer, sink));
+  EXPECT_EQ(AttrList({kServiceClass}), found_);
+  EXPECT_FALSE(Find(kPeer, avrcp));
+}
+
+TEST_F(SdpCacheTest, same_records_keep_the_device) {
+  tSDP_DISCOVERY_DB sink = Db({kAudioSink}, {0x0001});
+  tSDP_DISCOVERY_DB avrcp = Db({kAvrcp}, {0x0009});
+  Store(kPeer, avrcp, AttrList({kProfile}));
+  Store(kPeer, sink, AttrList({kServiceClass}));
+
+  Store(kPeer, sink, AttrList({kServiceClass}));
+  EXPECT_TRUE(Find(kPeer, avrcp));
+}
+
+TEST_F(SdpCacheTest, malformed_result_is_dropped) {
+  tSDP_DISCOVERY_DB all = Db({kAudioSink}, {});
+  std::vector<uint8_t> lists = AttrList({kServiceClass});
+  lists[2] += 4;  // claims more bytes than there are
+  Store(kPeer, all, lists);
+
+  // Filtering finds the error and drops the result for all the queries.
+  EXPECT_FALSE(Find(kPeer, Db({kAudioSink}, {0x0001})));
+  EXPECT_FALSE(Find(kPeer, all));
+}
+
+TEST_F(SdpCacheTest, least_recently_used_device_dropped) {
+  tSDP_DISCOVERY_DB db = Db({kAudioSink}, {0x0001});
+  std::vector<RawAddress> peers;
+  for (int i = 0; i <= SDP_DISC_CACHE_MAX_DEVICES; i++) {
+    RawAddress peer = kPeer;
+    peer.address[5] = i;
+    peers.push_back(peer);
+    Store(peer, db, AttrList({kServiceClass}));
+    // Keep the first device in use.
+    EXPECT_TRUE(Find(peers[0], db));
+  }
+
+  EXPECT_TRUE(Find(peers[0], db));
+  EXPECT_FALSE(Find(peers[1], db));
+  EXPECT_TRUE(Find(peers.back(), db));
+}
@@ -0,0 +1,318 @@
+/******************************************************************************
+ *
+ *  Copyright 2019 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#include <math.h>
+
+#include <deque>
+#include <functional>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "stack/include/btm_sco_voice.h"
+
+namespace {
+
+// Speech starts after one second of silence, so that the jitter buffer has
+// settled by the time the onset is measured.
+constexpr double kOnsetSeconds = 1.0;
+constexpr int16_t kOnsetThreshold = 1000;
+
+// Delay and loss model of the link between the two pipelines. |delay_us|
+// gives the transit time of the n-th SCO packet, |lost| whether the
+// controller reports it with Packet_Status_Flag "lost".
+struct LinkModel {
+  std::function<uint64_t(size_t packet, uint64_t send_us)> delay_us;
+  std::function<bool(size_t packet)> lost;
+};
+
+struct VoiceRun {
+  std::vector<int16_t> ear;
+  tBTM_SCO_VOICE_STATS stats;
+  tBTM_SCO_VOICE_STATS stats_at_half;
+  uint32_t sample_rate;
+  double mouth_to_ear_ms;
+};
+
+struct LinkPacket {
+  uint64_t arrival_us;
+  std::vector<uint8_t> payload;
+  tBTM_SCO_DATA_FLAG status;
+};
+
+LinkModel CleanLink(uint64_t delay_us) {
+  return {[delay_us](size_t, uint64_t) { return delay_us; },
+          [](size_t) { return false; }};
+}
+
+// A voiced-like signal: a 150 Hz fundamental with a few harmonics.
+std::vector<int16_t> MakeMouth(uint32_t sample_rate, double seconds) {
+  std::vector<int16_t> mouth((size_t)(sample_rate * seconds));
+  size_t onset = (size_t)(sample_rate * kOnsetSeconds);
+  for (size_t i = onset; i < mouth.size(); i++) {
+    double t = (double)(i - onset) / sample_rate;
+    double v = 0;
+    for (int h = 1; h <= 4; h++) v += sin(2 * M_PI * 150 * h * t) / h;
+    mouth[i] = (int16_t)(5000 * v);
+  }
+  return mouth;
+}
+
+double FrameRms(const int16_t* p_pcm, size_t len) {
+  double sum = 0;
+  for (size_t i = 0; i < len; i++) sum += (double)p_pcm[i] * p_pcm[i];
+  return sqrt(sum / len);
+}
+
+// Runs |mouth| through a sending pipeline, |link| and a receiving pipeline.
+// The mouth frame that ends at t is sent at t; the ear reads a frame every
+// 7.5 ms, half a frame out of phase with the sender, and plays it at once.
+VoiceRun RunVoiceLink(tBTM_SCO_VOICE_CODEC codec,
+                      const std::vector<int16_t>& mouth,
+                      const LinkModel& link) {
+  tBTM_SCO_VOICE* p_tx = BTM_ScoVoiceNew(codec);
+  tBTM_SCO_VOICE* p_rx = BTM_ScoVoiceNew(codec);
+  EXPECT_NE(nullptr, p_tx);
+  EXPECT_NE(nullptr, p_rx);
+
+  VoiceRun run;
+  uint16_t n = BTM_ScoVoiceFrameSamples(p_tx);
+  size_t frames = mouth.size() / n;
+  run.sample_rate = n * 1000000 / BTM_SCO_VOICE_FRAME_US;
+  run.ear.resize(frames * n);
+
+  std::deque<LinkPacket> in_flight;
+  size_t packet_index = 0;
+  uint64_t last_arrival_us = 0;
+
+  for (size_t f = 0; f < frames; f++) {
+    uint64_t send_us = (f + 1) * BTM_SCO_VOICE_FRAME_US;
+    BTM_ScoVoiceWritePcm(p_tx, &mouth[f * n]);
+
+    uint8_t buf[BTM_SCO_DATA_SIZE_MAX];
+    uint16_t len;
+    while ((len = BTM_ScoVoiceGetTxPacket(p_tx, buf)) > 0) {
+      LinkPacket packet;
+      // SCO packets are delivered in order
+      packet.arrival_us = std::max(
+          last_arrival_us, send_us + link.delay_us(packet_index, send_us));
+      packet.payload.assign(buf, buf + len);
+      packet.status = BTM_SCO_DATA_CORRECT;
+      if (link.lost(packet_index)) {
+        packet.status = BTM_SCO_DATA_PAR_LOST;
+        std::fill(packet.payload.begin(), packet.payload.end(), 0);
+      }
+      last_arrival_us = packet.arrival_us;
+      in_flight.push_back(packet);
+      packet_index++;
+    }
+
+    uint64_t ear_us = send_us + BTM_SCO_VOICE_FRAME_US / 2;
+    while (!in_flight.empty() && in_flight.front().arrival_us <= ear_us) {
+      const LinkPacket& packet = in_flight.front();
+      BTM_ScoVoiceReceive(p_rx, packet.payload.data(), packet.payload.size(),
+                          packet.status, packet.arrival_us);
+      in_flight.pop_front();
+    }
+    BTM_ScoVoiceReadPcm(p_rx, &run.ear[f * n]);
+
+    if (f == frames / 2) BTM_ScoVoiceGetStats(p_rx, &run.stats_at_half);
+  }
+  BTM_ScoVoiceGetStats(p_rx, &run.stats);
+
+  // Mouth-to-ear latency of the speech onset
+  size_t mouth_onset = (size_t)(run.sample_rate * kOnsetSeconds);
+  run.mouth_to_ear_ms = -1;
+  for (size_t i = 0; i < run.ear.size(); i++) {
+    if (abs(run.ear[i]) < kOnsetThreshold) continue;
+    double ear_us = (i / n + 1) * BTM_SCO_VOICE_FRAME_US +
+                    BTM_SCO_VOICE_FRAME_US / 2 +
+                    (i % n) * 1000000.0 / run.sample_rate;
+    double mouth_us = mouth_onset * 1000000.0 / run.sample_rate;
+    run.mouth_to_ear_ms = (ear_us - mouth_us) / 1000;
+    break;
+  }
+
+  BTM_ScoVoiceFree(p_tx);
+  BTM_ScoVoiceFree(p_rx);
+  return run;
+}
+
+// Signal to noise ratio of |ear| against |mouth| delayed by |delay| samples,
+// over the samples from |from| on.
+double SnrDb(const std::vector<int16_t>& mouth, const std::vector<int16_t>& ear,
+             size_t delay, size_t from) {
+  double signal = 0, noise = 0;
+  for (size_t i = from; i < ear.size(); i++) {
+    double ref = mouth[i - delay];
+    signal += ref * ref;
+    noise += (ear[i] - ref) * (ear[i] - ref);
+  }
+  return 10 * log10(signal / std::max(noise, 1.0));
+}
+
+double BestSnrDb(const std::vector<int16_t>& mouth,
+                 const std::vector<int16_t>& ear, size_t from) {
+  double best = -100;
+  for (size_t delay = 0; delay < from; delay++)
+    best = std::max(best, SnrDb(mouth, ear, delay, from));
+  return best;
+}
+
+}  // namespace
+
+class StackScoVoiceTest : public ::testing::Test {
+ protected:
+  void RecordLatency(const VoiceRun& run) {
+    RecordProperty("mouth_to_ear_ms", (int)round(run.mouth_to_ear_ms));
+  }
+};
+
+TEST_F(StackScoVoiceTest, test_msbc_clean_link) {
+  std::vector<int16_t> mouth = MakeMouth(16000, 4.0);
+  VoiceRun run = RunVoiceLink(BTM_SCO_VOICE_CODEC_MSBC, mouth, CleanLink(2000));
+  RecordLatency(run);
+
+  EXPECT_EQ(0u, run.stats.concealed_frames);
+  EXPECT_EQ(0u, run.stats.underruns);
+  EXPECT_EQ(0u, run.stats.rx_bad_frames);
+  EXPECT_EQ(0u, run.stats.rx_missing_frames);
+  EXPECT_GT(run.mouth_to_ear_ms, 0);
+  EXPECT_LT(run.mouth_to_ear_ms, 30);
+  EXPECT_GT(BestSnrDb(mouth, run.ear, run.ear.size() - 16000), 20);
+}
+
+TEST_F(StackScoVoiceTest, test_cvsd_clean_link_is_transparent) {
+  std::vector<int16_t> mouth = MakeMouth(8000, 3.0);
+  VoiceRun run = RunVoiceLink(BTM_SCO_VOICE_CODEC_CVSD, mouth, CleanLink(2000));
+  RecordLatency(run);
+
+  EXPECT_EQ(0u, run.stats.concealed_frames);
+  EXPECT_LT(run.mouth_to_ear_ms, 30);
+  // Without a codec in the host, the ear gets the mouth samples verbatim
+  EXPECT_GE(BestSnrDb(mouth, run.ear, run.ear.size() - 8000), 90);
+}
+
+TEST_F(StackScoVoiceTest, test_msbc_flagged_packets_are_concealed) {
+  std::vector<int16_t> mouth = MakeMouth(16000, 4.0);
+  LinkModel link = CleanLink(2000);
+  size_t lost = 0;
+  link.lost = [&lost](size_t packet) {
+    bool is_lost = packet > 150 && packet < 450 && packet % 7 == 0;
+    if (is_lost) lost++;
+    return is_lost;
+  };
+  VoiceRun run = RunVoiceLink(BTM_SCO_VOICE_CODEC_MSBC, mouth, link);
+  RecordLatency(run);
+
+  EXPECT_EQ(lost, run.stats.concealed_frames);
+  EXPECT_EQ(0u, run.stats.underruns);
+
+  // Isolated losses never turn into a gap in the speech
+  size_t n = 120;
+  size_t first = (size_t)(16000 * kOnsetSeconds) / n + 10;
+  for (size_t f = first; f < run.ear.size() / n; f++)
+    EXPECT_GT(FrameRms(&run.ear[f * n], n), 1000) << "frame " << f;
+}
+
+TEST_F(StackScoVoiceTest, test_msbc_burst_loss_fades_out) {
+  std::vector<int16_t> mouth = MakeMouth(16000, 3.0);
+  LinkModel link = CleanLink(2000);
+  link.lost = [](size_t packet) { return packet >= 200 && packet < 210; };
+  VoiceRun run = RunVoiceLink(BTM_SCO_VOICE_CODEC_MSBC, mouth, link);
+
+  EXPECT_EQ(10u, run.stats.concealed_frames);
+
+  size_t n = 120;
+  size_t first = (size_t)(16000 * kOnsetSeconds) / n + 10;
+  size_t silent = 0;
+  for (size_t f = first; f < run.ear.size() / n; f++) {
+    if (FrameRms(&run.ear[f * n], n) < 100) silent++;
+  }
+  // The first frames of the burst are concealed, the rest is muted
+  EXPECT_GE(silent, 4u);
+  EXPECT_LE(silent, 7u);
+}
+
+TEST_F(StackScoVoiceTest, test_msbc_resyncs_after_dropped_packet) {
+  tBTM_SCO_VOICE* p_tx = BTM_ScoVoiceNew(BTM_SCO_VOICE_CODEC_MSBC);
+  tBTM_SCO_VOICE* p_rx = BTM_ScoVoiceNew(BTM_SCO_VOICE_CODEC_MSBC);
+  std::vector<int16_t> mouth = MakeMouth(16000, 1.5);
+
+  std::vector<uint8_t> stream;
+  for (int f = 0; f < 50; f++) {
+    BTM_ScoVoiceWritePcm(p_tx, &mouth[16000 + f * 120]);
+    uint8_t buf[BTM_SCO_DATA_SIZE_MAX];
+    uint16_t len;
+    while ((len = BTM_ScoVoiceGetTxPacket(p_tx, buf)) > 0)
+      stream.insert(stream.end(), buf, buf + len);
+  }
+
+  // Deliver the stream in 24 byte packets, as USB controllers do, and lose
+  // one of them without any status from the controller.
+  for (size_t offset = 0, i = 0; offset < stream.size(); offset += 24, i++) {
+    if (i == 20) continue;
+    BTM_ScoVoiceReceive(p_rx, &stream[offset], 24, BTM_SCO_DATA_CORRECT,
+                        offset * 125);
+  }
+
+  tBTM_SCO_VOICE_STATS stats;
+  BTM_ScoVoiceGetStats(p_rx, &stats);
+  EXPECT_EQ(50u, stats.rx_frames);
+  EXPECT_EQ(1u, stats.rx_missing_frames);
+  EXPECT_EQ(0u, stats.rx_bad_frames);
+
+  // Packets sent back are sized like the received ones
+  int16_t pcm[120] = {};
+  BTM_ScoVoiceWritePcm(p_rx, pcm);
+  uint8_t buf[BTM_SCO_DATA_SIZE_MAX];
+  EXPECT_EQ(24, BTM_ScoVoiceGetTxPacket(p_rx, buf));
+
+  BTM_ScoVoiceFree(p_tx);
+  BTM_ScoVoiceFree(p_rx);
+}
+
+TEST_F(StackScoVoiceTest, test_jitter_buffer_absorbs_bursty_link) {
+  std::vector<int16_t> mouth = MakeMouth(16000, 6.0);
+  // The link holds packets back and releases them every 30 ms
+  LinkModel link = CleanLink(0);
+  link.delay_us = [](size_t, uint64_t send_us) {
+    return 30000 - send_us % 30000 + 1000;
+  };
+  VoiceRun run = RunVoiceLink(BTM_SCO_VOICE_CODEC_MSBC, mouth, link);
+  RecordLatency(run);
+
+  EXPECT_GE(run.stats.jitter_buffer_target, 4);
+  EXPECT_EQ(run.stats_at_half.underruns, run.stats.underruns);
+  EXPECT_EQ(run.stats_at_half.concealed_frames, run.stats.concealed_frames);
+  EXPECT_LT(run.mouth_to_ear_ms, 80);
+}
+
+TEST_F(StackScoVoiceTest, test_jitter_buffer_shrinks_after_burst) {
+  std::vector<int16_t> mouth = MakeMouth(16000, 8.0);
+  LinkModel link = CleanLink(0);
+  link.delay_us = [](size_t, uint64_t send_us) -> uint64_t {
+    if (send_us > 500000) return 2000;
+    return 30000 - send_us % 30000 + 1000;
+  };
+  VoiceRun run = RunVoiceLink(BTM_SCO_VOICE_CODEC_MSBC, mouth, link);
+
+  EXPECT_LE(run.stats.jitter_buffer_target, 2);
+  EXPECT_LE(run.stats.jitter_buffer_depth, 3);
+  EXPECT_GT(run.stats.discarded_frames, 0u);
+}
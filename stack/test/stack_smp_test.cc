@@ -15,13 +15,18 @@
  *  limitations under the License.
  *
  ******************************************************************************/
+#include <base/bind.h>
+#include <base/threading/thread.h>
 #include <stdarg.h>
 
+#include <future>
+
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
 #include "bt_trace.h"
 #include "hcidefs.h"
+#include "osi/include/alarm.h"
 #include "stack/include/smp_api.h"
 #include "stack/smp/smp_int.h"
 
@@ -80,6 +85,21 @@ void LogMsg(uint32_t trace_set_mask, const char* fmt_str, ...) {
   va_end(args);
 }
 
+// smp_l2c.cc holds the PDUs received during an ECC computation. It is not
+// part of this test, count what the crypto worker asks of it instead
+static int held_pdus_released;
+static int held_pdus_discarded;
+void smp_release_held_pdus(void) { held_pdus_released++; }
+void smp_discard_held_pdus(void) { held_pdus_discarded++; }
+
+// The BTU thread ECC results are posted to. It is kept for the lifetime of the
+// test, as results of dropped requests may still land after a test ends
+static base::Thread* smp_test_btu_thread;
+base::MessageLoop* get_message_loop() {
+  return smp_test_btu_thread ? smp_test_btu_thread->message_loop() : nullptr;
+}
+task_stats_t* get_message_loop_task_stats() { return nullptr; }
+
 extern Octet16 smp_gen_p1_4_confirm(tSMP_CB* p_cb,
                                     tBLE_ADDR_TYPE remote_bd_addr_type);
 
@@ -207,4 +227,95 @@ TEST_F(SmpCalculateConfirmTest, test_smp_calculate_comfirm_as_master) {
   dump_uint128_reverse(output, confirm_str);
   ASSERT_THAT(confirm_str, StrEq(expected_confirm_str));
 }
+class SmpCryptoWorkerTest : public Test {
+ protected:
+  static void SetUpTestCase() {
+    smp_test_btu_thread = new base::Thread("smp_test_btu");
+    smp_test_btu_thread->Start();
+    smp_crypto_worker_init();
+  }
+
+  void SetUp() {
+    held_pdus_released = 0;
+    held_pdus_discarded = 0;
+    dropped_results = 0;
+    result_ = std::promise<void>();
+    RunOnBtuThread(base::Bind(&SmpCryptoWorkerTest::InitControlBlock));
+  }
+
+  void TearDown() {
+    RunOnBtuThread(base::Bind(&SmpCryptoWorkerTest::FreeAlarms));
+  }
+
+  static void InitControlBlock() {
+    memset(&smp_cb, 0, sizeof(smp_cb));
+    smp_cb.smp_rsp_timer_ent = alarm_new("smp_test.smp_rsp_timer_ent");
+    smp_cb.delayed_auth_timer_ent = alarm_new("smp_test.delayed_auth_timer_ent");
+  }
+
+  static void FreeAlarms() {
+    alarm_free(smp_cb.smp_rsp_timer_ent);
+    alarm_free(smp_cb.delayed_auth_timer_ent);
+    memset(&smp_cb, 0, sizeof(smp_cb));
+  }
+
+  // Runs |task| on the BTU thread, as SMP does, and waits for it
+  void RunOnBtuThread(base::Closure task) {
+    std::promise<void> done;
+    smp_test_btu_thread->task_runner()->PostTask(
+        FROM_HERE, base::Bind(
+                       [](base::Closure task, std::promise<void>* done) {
+                         task.Run();
+                         done->set_value();
+                       },
+                       task, &done));
+    done.get_future().wait();
+  }
+
+  static void DroppedResult(tSMP_CB* p_cb, const BT_OCTET32 x,
+                            const BT_OCTET32 y) {
+    dropped_results++;
+  }
+
+  static void Result(tSMP_CB* p_cb, const BT_OCTET32 x, const BT_OCTET32 y) {
+    result_.set_value();
+  }
+
+  static int dropped_results;
+  static std::promise<void> result_;
+};
+
+int SmpCryptoWorkerTest::dropped_results;
+std::promise<void> SmpCryptoWorkerTest::result_;
+
+// Resetting the pairing while an ECC computation runs must drop its result and
+// the PDUs held for it, rather than replay them into the next pairing
+TEST_F(SmpCryptoWorkerTest, test_reset_while_request_pending) {
+  RunOnBtuThread(base::Bind([]() {
+    BT_OCTET32 scalar;
+    memset(scalar, 0x5a, sizeof(scalar));
+
+    smp_ecc_point_mult(&smp_cb, NULL, scalar, &DroppedResult);
+    EXPECT_TRUE(smp_crypto_is_pending(&smp_cb));
+
+    smp_cb_cleanup(&smp_cb);
+    EXPECT_FALSE(smp_crypto_is_pending(&smp_cb));
+    EXPECT_EQ(1, held_pdus_discarded);
+
+    // Requests go to the workers in turn: the last one is run by the worker
+    // of the cancelled request, after it, and its result is posted after the
+    // cancelled one. The ones in between are superseded by it.
+    for (int i = 1; i < SMP_CRYPTO_WORKERS; i++)
+      smp_ecc_point_mult(&smp_cb, NULL, scalar, &DroppedResult);
+    smp_ecc_point_mult(&smp_cb, NULL, scalar, &Result);
+  }));
+
+  result_.get_future().wait();
+  // Let the task that delivered the result finish
+  RunOnBtuThread(base::Bind([]() {}));
+
+  EXPECT_EQ(0, dropped_results);
+  EXPECT_EQ(1, held_pdus_released);
+  EXPECT_FALSE(smp_crypto_is_pending(&smp_cb));
+}
 }  // namespace testing
@@ -0,0 +1,113 @@
+#!/usr/bin/env python
+"""
+Compares the Google Benchmark JSON results of test/run_benchmarks.sh with a
+baseline saved from an earlier run, and fails when a benchmark regressed by
+more than a threshold.
+
+Every metric both runs have is compared. Rates (bytes_per_second,
+items_per_second) regress when they go down, times (real_time) when they go
+up. The user counters listed in METRICS are compared the same way, in the
+direction given for each. When the results hold the aggregates of
+--benchmark_repetitions, their means are compared.
+
+Example usage:
+  $ ./test/compare_benchmarks.py --threshold 10 baseline/ results/
+"""
+
+from __future__ import print_function
+
+import argparse
+import json
+import os
+import sys
+
+# Metrics compared, and whether a higher value is better. Counters not listed
+# here, such as those describing the workload, are not compared.
+METRICS = [
+    ('bytes_per_second', True),
+    ('items_per_second', True),
+    ('real_time', False),
+    # User counters
+    ('cpu_us_per_chunk', False),
+    ('cpu_us_per_report', False),
+    ('jitter_us', False),
+    ('latency_us', False),
+]
+
+
+def load_results(path):
+  """Returns the runs of the benchmarks of a JSON file, by name."""
+  with open(path) as f:
+    benchmarks = json.load(f).get('benchmarks', [])
+
+  runs = {}
+  means = {}
+  for run in benchmarks:
+    if run.get('error_occurred'):
+      continue
+    aggregate = run.get('aggregate_name')
+    if aggregate == 'mean':
+      means[run['run_name']] = run
+    elif aggregate is None:
+      runs.setdefault(run.get('run_name', run['name']), run)
+  runs.update(means)
+  return runs
+
+
+def compare_run(name, baseline, result, threshold):
+  """Prints the change of each metric both runs have, returns whether any of
+  them regressed."""
+  regressed = False
+  for metric, higher_is_better in METRICS:
+    if metric not in baseline or metric not in result:
+      continue
+    before = float(baseline[metric])
+    after = float(result[metric])
+    if before == 0:
+      continue
+    change = (after - before) * 100 / before
+    metric_regressed = (change < -threshold) if higher_is_better else (
+        change > threshold)
+    print('%-60s %-16s %14.4g %14.4g %+8.1f%%%s' %
+          (name, metric, before, after, change,
+           '  REGRESSION' if metric_regressed else ''))
+    regressed = regressed or metric_regressed
+  return regressed
+
+
+def main():
+  parser = argparse.ArgumentParser(description=__doc__.strip().split('\n')[0])
+  parser.add_argument('--threshold', type=float, default=10.0,
+                      help='tolerated change, in percent (default: 10)')
+  parser.add_argument('baseline', help='directory of the baseline results')
+  parser.add_argument('results', help='directory of the results to check')
+  args = parser.parse_args()
+
+  regressions = []
+  for filename in sorted(os.listdir(args.results)):
+    if not filename.endswith('.json'):
+      continue
+    baseline_path = os.path.join(args.baseline, filename)
+    if not os.path.exists(baseline_path):
+      print('%s: no baseline' % filename)
+      continue
+
+    baseline = load_results(baseline_path)
+    results = load_results(os.path.join(args.results, filename))
+    for name in sorted(results):
+      if name not in baseline:
+        print('%-60s no baseline' % name)
+        continue
+      if compare_run(name, baseline[name], results[name], args.threshold):
+        regressions.append(name)
+
+  if regressions:
+    print()
+    for name in regressions:
+      print('!!! REGRESSION: %s !!!' % name)
+    return 1
+  return 0
+
+
+if __name__ == '__main__':
+  sys.exit(main())
@@ -6,17 +6,38 @@
 # Example usage:
 #   $ cd system/bt
 #   $ ./test/run_benchmarks.sh bluetooth_benchmark_example
+#
+# With -o, the results are also saved as Google Benchmark JSON, one file per
+# benchmark, and with -b compared to the ones of an earlier run:
+#   $ ./test/run_benchmarks.sh -o baseline
+#   $ ./test/run_benchmarks.sh -o results -b baseline
+#
+# bluetooth_benchmark_stack needs the simulated HCI HAL of test/rootcanal
+# running on the device.
 
 known_benchmarks=(
   bluetooth_benchmark_thread_performance
+  bluetooth_benchmark_g722_encode
+  bluetooth_benchmark_sbc_encode
+  bluetooth_benchmark_uipc_audio_path
+  bluetooth_benchmark_config
+  bluetooth_benchmark_inq_db
+  bluetooth_benchmark_hci_packet_view
+  bluetooth_benchmark_ble_host_filter
+  bluetooth_benchmark_pan_tap
+  bluetooth_benchmark_at_parser
+  bluetooth_benchmark_stack
 )
 
 usage() {
   binary="$(basename "$0")"
   echo "Usage: ${binary} --help"
-  echo "       ${binary} [-i <iterations>] [-s <specific device>] [--all] [<benchmark name>[.<filter>] ...] [--<arg> ...]"
+  echo "       ${binary} [-i <iterations>] [-s <specific device>] [-o <output dir> [-b <baseline dir>] [-t <threshold>]] [--all] [<benchmark name>[.<filter>] ...] [--<arg> ...]"
   echo
   echo "Unknown long arguments are passed to the benchmark."
+  echo "The JSON results saved with -o are those of the last iteration."
+  echo "The threshold of -t is the tolerated change against the baseline, in"
+  echo "percent (default: 10)."
   echo
   echo "Known benchmark names:"
 
@@ -28,6 +49,9 @@ usage() {
 
 iterations=1
 device=
+output_dir=
+baseline_dir=
+threshold=10
 benchmarks=()
 benchmark_args=()
 while [ $# -gt 0 ]
@@ -57,6 +81,21 @@ do
       device="$1"
       shift
       ;;
+    -o|-b|-t)
+      option="$1"
+      shift
+      if [ $# -eq 0 ]; then
+        echo "error: argument of ${option} expected" 1>&2
+        usage
+        exit 2
+      fi
+      case "${option}" in
+        -o) output_dir="$1" ;;
+        -b) baseline_dir="$1" ;;
+        -t) threshold="$1" ;;
+      esac
+      shift
+      ;;
     --all)
       benchmarks+=( "${known_benchmarks[@]}" )
       shift
@@ -76,6 +115,16 @@ if [ "${#benchmarks[@]}" -eq 0 ]; then
   benchmarks+=( "${known_benchmarks[@]}" )
 fi
 
+if [ -n "${baseline_dir}" ] && [ -z "${output_dir}" ]; then
+  echo "error: -b needs an output directory (-o)" 1>&2
+  usage
+  exit 2
+fi
+
+if [ -n "${output_dir}" ]; then
+  mkdir -p "${output_dir}"
+fi
+
 adb=( "adb" )
 if [ -n "${device}" ]; then
   adb+=( "-s" "${device}" )
@@ -101,6 +150,10 @@ do
     benchmark_command+=( "--benchmark_filter=${filter}" )
   fi
   benchmark_command+=( "${benchmark_args[@]}" )
+  device_output="/data/local/tmp/${name}.json"
+  if [ -n "${output_dir}" ]; then
+    benchmark_command+=( "--benchmark_out=${device_output}" "--benchmark_out_format=json" )
+  fi
 
   echo "--- ${name} ---"
   echo "pushing..."
@@ -115,8 +168,20 @@ do
   if [ $failed_count != 0 ]; then
     failed_benchmarks+=( "${name} ${failed_count}/${iterations}" )
   fi
+
+  if [ -n "${output_dir}" ]; then
+    "${adb[@]}" pull "${device_output}" "${output_dir}/${name}.json"
+    "${adb[@]}" shell rm -f "${device_output}"
+  fi
 done
 
+regressed=0
+if [ -n "${baseline_dir}" ]; then
+  echo "--- comparing with ${baseline_dir} ---"
+  "$(dirname "$0")/compare_benchmarks.py" --threshold "${threshold}" \
+      "${baseline_dir}" "${output_dir}" || regressed=1
+fi
+
 if [ "${#failed_benchmarks[@]}" -ne 0 ]; then
   for failed_benchmark in "${failed_benchmarks[@]}"
   do
@@ -125,4 +190,4 @@ if [ "${#failed_benchmarks[@]}" -ne 0 ]; then
   exit 1
 fi
 
-exit 0
+exit ${regressed}
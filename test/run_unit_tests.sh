@@ -9,12 +9,15 @@ known_tests=(
   net_test_bta_qti
   net_test_btif_qti
   net_test_btif_profile_queue_qti
+  net_test_btif_rc_rsp_cache_qti
   net_test_device_qti
   net_test_hci_qti
   net_test_stack_qti
   net_test_stack_multi_adv_qti
   net_test_stack_ad_parser_qti
   net_test_stack_smp_qti
+  net_test_stack_sco_voice_qti
+  net_test_stack_sdp_cache_qti
   net_test_types_qti
   net_test_btu_message_loop_qti
   net_test_osi_qti
@@ -18,6 +18,8 @@
 
 #pragma once
 
+#include <cstring>
+#include <functional>
 #include <string>
 
 /** Bluetooth Address */
@@ -60,3 +62,17 @@ inline std::ostream& operator<<(std::ostream& os, const RawAddress& a) {
   os << a.ToString();
   return os;
 }
+
+namespace std {
+template <>
+struct hash<RawAddress> {
+  std::size_t operator()(const RawAddress& val) const {
+    static_assert(sizeof(uint64_t) >= RawAddress::kLength,
+                  "Address is larger than supported size");
+    uint64_t int_addr = 0;
+    memcpy(reinterpret_cast<uint8_t*>(&int_addr), val.address,
+           RawAddress::kLength);
+    return std::hash<uint64_t>{}(int_addr);
+  }
+};
+}  // namespace std
@@ -153,3 +153,13 @@ TEST(RawAddressTest, BdAddrFromString) {
   const RawAddress result1 = {{0xab, 0x01, 0x4c, 0xd5, 0x21, 0x9f}};
   EXPECT_EQ(0, memcmp(&addr, &result1, sizeof(addr)));
 }
+
+TEST(RawAddressTest, HashDistinguishesAddresses) {
+  const RawAddress bdaddr1 = {{0x11, 0x22, 0x33, 0x44, 0x55, 0x66}};
+  const RawAddress bdaddr2 = {{0x11, 0x22, 0x33, 0x44, 0x55, 0x66}};
+  const RawAddress bdaddr3 = {{0x11, 0x22, 0x33, 0x44, 0x55, 0x67}};
+
+  std::hash<RawAddress> hasher;
+  EXPECT_EQ(hasher(bdaddr1), hasher(bdaddr2));
+  EXPECT_NE(hasher(bdaddr1), hasher(bdaddr3));
+}
@@ -0,0 +1,157 @@
+/*
+ * Copyright 2019 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Latency and CPU cost of the A2DP software encoding PCM path. Both endpoints
+// run in this process: a thread writes PCM on the data socket the way the
+// audio HAL does, and the benchmark thread reads it with UIPC_Read() the way
+// the A2DP source media task does.
+
+#include <benchmark/benchmark.h>
+#include <stdarg.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "bt_common.h"
+#include "bt_utils.h"
+#include "osi/include/osi.h"
+#include "osi/include/semaphore.h"
+#include "osi/include/socket_utils/sockets.h"
+#include "osi/include/time.h"
+#include "uipc.h"
+
+using ::benchmark::State;
+
+#define BENCHMARK_DATA_PATH "/data/local/tmp/.uipc_benchmark_data"
+#define BENCHMARK_READ_POLL_MS 10
+
+#if defined(OFF_TARGET_TEST_ENABLED)
+#define BENCHMARK_SOCKET_NAMESPACE ANDROID_SOCKET_NAMESPACE_ABSTRACT
+#else
+#define BENCHMARK_SOCKET_NAMESPACE ANDROID_SOCKET_NAMESPACE_FILESYSTEM
+#endif
+
+uint8_t btif_trace_level = BT_TRACE_LEVEL_WARNING;
+
+// Require bte_logmsg.cc to run, here is just to fake it as we don't care about
+// trace in benchmark
+void LogMsg(UNUSED_ATTR uint32_t trace_set_mask,
+            UNUSED_ATTR const char* fmt_str, ...) {}
+void vnd_LogMsg(UNUSED_ATTR uint32_t trace_set_mask,
+                UNUSED_ATTR const char* fmt_str, ...) {}
+
+// The media task priority is not what is measured here
+void raise_priority_a2dp(UNUSED_ATTR tHIGH_PRIORITY_TASK high_task) {}
+
+// CPU time used by all the threads of the process: the writer, the reader and
+// the UIPC read task.
+static double process_cpu_seconds() {
+  struct timespec ts;
+  clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static semaphore_t* channel_open;
+
+static void data_cb(UNUSED_ATTR tUIPC_CH_ID ch_id, tUIPC_EVENT event) {
+  if (event != UIPC_OPEN_EVT) return;
+
+  // Same setup as btif_a2dp_data_cb(): the media task reads directly
+  UIPC_Ioctl(UIPC_CH_ID_AV_AUDIO, UIPC_REG_REMOVE_ACTIVE_READSET, NULL);
+  UIPC_Ioctl(UIPC_CH_ID_AV_AUDIO, UIPC_SET_READ_POLL_TMO,
+             reinterpret_cast<void*>(BENCHMARK_READ_POLL_MS));
+  semaphore_post(channel_open);
+}
+
+// One iteration is one chunk of PCM, from the moment the writer is asked for
+// it to the moment the reader has all of it. latency_us is the part of it
+// from the write to the end of the read.
+static void BM_UipcAudioPath(State& state) {
+  const size_t chunk_size = state.range(0);
+
+  channel_open = semaphore_new(0);
+  UIPC_Init(NULL);
+  UIPC_Open(UIPC_CH_ID_AV_AUDIO, data_cb, BENCHMARK_DATA_PATH);
+  int hal_fd = osi_socket_local_client(BENCHMARK_DATA_PATH,
+                                       BENCHMARK_SOCKET_NAMESPACE, SOCK_STREAM);
+  if (hal_fd < 0) {
+    state.SkipWithError("cannot connect to the UIPC data socket");
+    UIPC_Close(UIPC_CH_ID_ALL);
+    semaphore_free(channel_open);
+    return;
+  }
+  semaphore_wait(channel_open);
+
+  semaphore_t* write_request = semaphore_new(0);
+  std::atomic<bool> running(true);
+  std::thread hal([&]() {
+    std::vector<uint8_t> pcm(chunk_size);
+    while (true) {
+      semaphore_wait(write_request);
+      if (!running) break;
+      uint64_t written_us = time_get_os_boottime_us();
+      memcpy(pcm.data(), &written_us, sizeof(written_us));
+      size_t count = 0;
+      while (count < chunk_size) {
+        ssize_t sent;
+        OSI_NO_INTR(sent = send(hal_fd, pcm.data() + count, chunk_size - count,
+                                MSG_NOSIGNAL));
+        if (sent <= 0) break;
+        count += sent;
+      }
+    }
+  });
+
+  std::vector<uint8_t> pcm(chunk_size);
+  uint64_t latency_us = 0;
+  double cpu_start = process_cpu_seconds();
+  for (auto _ : state) {
+    semaphore_post(write_request);
+    if (UIPC_Read(UIPC_CH_ID_AV_AUDIO, NULL, pcm.data(), chunk_size) !=
+        chunk_size) {
+      state.SkipWithError("short read");
+      break;
+    }
+    uint64_t written_us;
+    memcpy(&written_us, pcm.data(), sizeof(written_us));
+    latency_us += time_get_os_boottime_us() - written_us;
+  }
+  double cpu_seconds = process_cpu_seconds() - cpu_start;
+
+  running = false;
+  semaphore_post(write_request);
+  hal.join();
+  close(hal_fd);
+  UIPC_Close(UIPC_CH_ID_ALL);
+  semaphore_free(write_request);
+  semaphore_free(channel_open);
+
+  state.SetBytesProcessed(state.iterations() * chunk_size);
+  if (state.iterations() != 0) {
+    state.counters["latency_us"] = (double)latency_us / state.iterations();
+    state.counters["cpu_us_per_chunk"] =
+        cpu_seconds * 1e6 / state.iterations();
+  }
+}
+// One SBC frame of 16 bit stereo PCM, and a 20 ms HAL write at 44.1 kHz
+BENCHMARK(BM_UipcAudioPath)->Arg(512)->Arg(3528);
+
+BENCHMARK_MAIN();
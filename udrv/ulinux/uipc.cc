@@ -691,37 +691,46 @@ uint32_t UIPC_Read(tUIPC_CH_ID ch_id, UNUSED_ATTR uint16_t* p_msg_evt,
   }
 
   while (n_read < (int)len) {
-    pfd.fd = fd;
-    pfd.events = POLLIN | POLLHUP;
+    ssize_t n;
 
-    /* make sure there is data prior to attempting read to avoid blocking
-       a read for more than poll timeout */
+    /* The media task reads at the pace the audio HAL writes, so data is
+       usually already queued. Try to read it first and only poll when the
+       socket is empty, saving a system call per read. */
+    OSI_NO_INTR(n = recv(fd, p_buf + n_read, len - n_read, MSG_DONTWAIT));
+
+    if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+      pfd.fd = fd;
+      pfd.events = POLLIN | POLLHUP;
+
+      /* make sure there is data prior to attempting read to avoid blocking
+         a read for more than poll timeout */
+
+      int poll_ret;
+      OSI_NO_INTR(poll_ret =
+                      poll(&pfd, 1, uipc_main.ch[ch_id].read_poll_tmo_ms));
+      if (poll_ret == 0) {
+        BTIF_TRACE_WARNING("poll timeout (%d ms)",
+                           uipc_main.ch[ch_id].read_poll_tmo_ms);
+        break;
+      }
+      if (poll_ret < 0) {
+        BTIF_TRACE_ERROR("%s(): poll() failed: return %d errno %d (%s)",
+                         __func__, poll_ret, errno, strerror(errno));
+        break;
+      }
 
-    int poll_ret;
-    OSI_NO_INTR(poll_ret = poll(&pfd, 1, uipc_main.ch[ch_id].read_poll_tmo_ms));
-    if (poll_ret == 0) {
-      BTIF_TRACE_WARNING("poll timeout (%d ms)",
-                         uipc_main.ch[ch_id].read_poll_tmo_ms);
-      break;
-    }
-    if (poll_ret < 0) {
-      BTIF_TRACE_ERROR("%s(): poll() failed: return %d errno %d (%s)", __func__,
-                       poll_ret, errno, strerror(errno));
-      break;
-    }
+      // BTIF_TRACE_EVENT("poll revents %x", pfd.revents);
 
-    // BTIF_TRACE_EVENT("poll revents %x", pfd.revents);
+      if (pfd.revents & (POLLHUP | POLLNVAL)) {
+        BTIF_TRACE_WARNING("poll : channel detached remotely");
+        std::lock_guard<std::recursive_mutex> lock(uipc_main.mutex);
+        uipc_close_locked(ch_id);
+        return 0;
+      }
 
-    if (pfd.revents & (POLLHUP | POLLNVAL)) {
-      BTIF_TRACE_WARNING("poll : channel detached remotely");
-      std::lock_guard<std::recursive_mutex> lock(uipc_main.mutex);
-      uipc_close_locked(ch_id);
-      return 0;
+      OSI_NO_INTR(n = recv(fd, p_buf + n_read, len - n_read, 0));
     }
 
-    ssize_t n;
-    OSI_NO_INTR(n = recv(fd, p_buf + n_read, len - n_read, 0));
-
     // BTIF_TRACE_EVENT("read %d bytes", n);
 
     if (n == 0) {
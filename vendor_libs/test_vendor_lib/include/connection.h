@@ -31,8 +31,12 @@ namespace test_vendor_lib {
 // Model the connection of a device to the controller.
 class Connection {
  public:
-  Connection(std::shared_ptr<Device> dev, uint16_t handle)
-      : dev_(dev), handle_(handle), connected_(true), encrypted_(false) {}
+  Connection(std::shared_ptr<Device> dev, uint16_t handle, bool le = true)
+      : dev_(dev),
+        handle_(handle),
+        le_(le),
+        connected_(true),
+        encrypted_(false) {}
 
   virtual ~Connection() = default;
 
@@ -52,6 +56,12 @@ class Connection {
     return (handle_ != handle) || !connected_;
   }
 
+  // Return the connection handle.
+  uint16_t GetHandle() const { return handle_; }
+
+  // Return true for an LE link, false for a BR/EDR ACL link.
+  bool IsLe() const { return le_; }
+
   void Disconnect() { connected_ = false; };
   bool Connected() { return connected_; };
 
@@ -71,6 +81,11 @@ class Connection {
   // Receive data from the device to simulate packet exchange.
   bool ReceiveFromDevice(std::vector<uint8_t>& data);
 
+  // Add an ACL fragment from the host, starting a new L2CAP frame if |start|.
+  // Return true and set |frame| once the frame is complete.
+  bool ReassembleFromHost(bool start, const std::vector<uint8_t>& fragment,
+                          std::vector<uint8_t>& frame);
+
  private:
   // A shared pointer to the connected device
   std::shared_ptr<Device> dev_;
@@ -78,6 +93,9 @@ class Connection {
   // The connection handle
   uint16_t handle_;
 
+  // The transport of the link
+  bool le_;
+
   // State variables
   bool connected_;
   bool encrypted_;
@@ -87,6 +105,9 @@ class Connection {
 
   // Messages from the device for the next packet exchange.
   std::queue<std::vector<uint8_t>> messages_;
+
+  // The L2CAP frame from the host being reassembled.
+  std::vector<uint8_t> host_frame_;
 };
 
 }  // namespace test_vendor_lib
@@ -24,6 +24,7 @@
 #include "bt_address.h"
 
 #include "hci/include/hci_hal.h"
+#include "osi/include/osi.h"
 #include "stack/include/btm_ble_api.h"
 
 namespace test_vendor_lib {
@@ -115,6 +116,15 @@ class Device {
   // Let the device know that time has passed.
   virtual void TimerTick() {}
 
+  // Take the next L2CAP frame the device sends over its connection, if any.
+  // Return false when the device has nothing more to send for now.
+  virtual bool ReadTraffic(UNUSED_ATTR std::vector<uint8_t>& frame) {
+    return false;
+  }
+
+  // Hand the device an L2CAP frame the host sent over its connection.
+  virtual void WriteTraffic(UNUSED_ATTR const std::vector<uint8_t>& frame) {}
+
  protected:
   BtAddress address_;
 
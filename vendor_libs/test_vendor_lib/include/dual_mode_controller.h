@@ -17,6 +17,7 @@
 #pragma once
 
 #include <cstdint>
+#include <map>
 #include <memory>
 #include <string>
 #include <unordered_map>
@@ -350,6 +351,21 @@ class DualModeController {
   // Bluetooth Core Specification Version 4.2 Volume 2 Part E 7.1.19
   void HciRemoteNameRequest(const std::vector<uint8_t>& args);
 
+  // OGF: 0x0001
+  // OCF: 0x0006
+  // Bluetooth Core Specification Version 4.2 Volume 2 Part E 7.1.6
+  void HciDisconnect(const std::vector<uint8_t>& args);
+
+  // OGF: 0x0001
+  // OCF: 0x0009
+  // Bluetooth Core Specification Version 4.2 Volume 2 Part E 7.1.8
+  void HciAcceptConnectionRequest(const std::vector<uint8_t>& args);
+
+  // OGF: 0x0001
+  // OCF: 0x000A
+  // Bluetooth Core Specification Version 4.2 Volume 2 Part E 7.1.9
+  void HciRejectConnectionRequest(const std::vector<uint8_t>& args);
+
   // Test Commands
 
   // Bluetooth Core Specification Version 4.2 Volume 2 Part E 7.7.1
@@ -475,8 +491,33 @@ class DualModeController {
   // List the devices that the controller knows about
   void TestChannelList(const std::vector<std::string>& args) const;
 
+  // Connect a device, by address, to the host: "connect <address> [le|br]". LE
+  // devices connect as masters, BR/EDR devices page the host which has to
+  // accept the connection.
+  void TestChannelConnect(const std::vector<std::string>& args);
+
+  // Set how many ACL packets from the host the controller completes per tick:
+  // "credits <packets_per_tick>". With 0, the default, every packet is
+  // completed as soon as it is received.
+  void TestChannelCredits(const std::vector<std::string>& args);
+
+  // Remove every device, so that a test starts from an empty environment.
+  // Open connections stay up until the host disconnects them.
+  void TestChannelClear(const std::vector<std::string>& args);
+
+  // Set the period of the timer which drives the devices: "timer <ms>".
+  void TestChannelTimer(const std::vector<std::string>& args);
+
   void Connections();
 
+  // Send the frames the device of |connection| has ready to the host.
+  void SendDeviceTraffic(Connection& connection);
+
+  // Return the credits of the ACL packets the host sent, up to the number the
+  // controller transmits per tick, in a single Number Of Completed Packets
+  // event.
+  void CompleteAclPackets();
+
   void LeScan();
 
   void PageScan();
@@ -587,6 +628,15 @@ class DualModeController {
 
   std::vector<std::shared_ptr<Connection>> connections_;
 
+  // Devices paging the host, until it accepts or rejects the connection.
+  std::vector<std::shared_ptr<Device>> connection_requests_;
+
+  // ACL packets from the host not completed yet, by connection handle.
+  std::map<uint16_t, uint16_t> acl_packets_in_flight_;
+  size_t acl_packets_buffered_ = 0;
+  uint16_t acl_packets_per_tick_ = 0;
+  uint16_t acl_next_handle_ = 0;
+
   AsyncTaskId timer_tick_task_;
   std::chrono::milliseconds timer_period_ = std::chrono::milliseconds(100);
 
@@ -123,6 +123,14 @@ class EventPacket : public Packet {
       uint8_t status, uint16_t handle, const BtAddress& address,
       uint8_t link_type, bool encryption_enabled);
 
+  // Bluetooth Core Specification Version 4.2, Volume 2, Part E, Section 7.7.4
+  static std::unique_ptr<EventPacket> CreateConnectionRequestEvent(
+      const BtAddress& address, uint32_t class_of_device, uint8_t link_type);
+
+  // Bluetooth Core Specification Version 4.2, Volume 2, Part E, Section 7.7.5
+  static std::unique_ptr<EventPacket> CreateDisconnectionCompleteEvent(
+      uint8_t status, uint16_t handle, uint8_t reason);
+
   // Bluetooth Core Specification Version 4.2, Volume 2, Part E, Section 7.7.25
   static std::unique_ptr<EventPacket> CreateLoopbackCommandEvent(
       uint16_t opcode, const std::vector<uint8_t>& payload);
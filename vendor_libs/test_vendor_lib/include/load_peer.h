@@ -0,0 +1,91 @@
+//
+// Copyright 2019 The Android Open Source Project
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#pragma once
+
+#include <cstdint>
+#include <queue>
+#include <vector>
+
+#include "device.h"
+
+namespace test_vendor_lib {
+
+// A connectable peer which keeps the link busy once connected, so that the
+// host stack can be run against many loaded connections at once. The traffic
+// is made of L2CAP frames shaped like:
+//  - gatt:   a flood of ATT Handle Value Notifications,
+//  - a2dp:   bursts of RTP media packets carrying SBC frames,
+//  - rfcomm: bulk UIH frames on a data DLCI.
+// The peer also runs a minimal ATT server with a single service, so that the
+// host can discover it and register for the notifications:
+//  0x0028 Primary Service 0xfff0
+//  0x0029 Characteristic 0xfff1 (write without response, notify)
+//  0x002a Characteristic Value
+//  0x002b Client Characteristic Configuration
+class LoadPeer : public Device {
+ public:
+  enum TrafficKind { kGatt, kA2dp, kRfcomm };
+
+  LoadPeer();
+  virtual ~LoadPeer() = default;
+
+  // Initialize from "load_peer <address> <le|br> <gatt|a2dp|rfcomm>
+  // [<frame_bytes> [<frames_per_burst> [<burst_period_ticks>]]]".
+  virtual void Initialize(const std::vector<std::string>& args) override;
+
+  // Return a string representation of the type of device.
+  virtual std::string GetTypeString() const override { return "load_peer"; }
+
+  virtual bool LeConnect() override { return le_; }
+
+  virtual bool IsPageScanAvailable() const override { return !le_; }
+
+  // Return true if the peer connects over LE.
+  bool IsLe() const { return le_; }
+
+  // Start the burst due this tick. Frames of the previous burst which weren't
+  // read yet are dropped, as a stalled link would.
+  virtual void TimerTick() override;
+
+  // Take the responses to the requests of the host first, then the frames of
+  // the burst.
+  virtual bool ReadTraffic(std::vector<uint8_t>& frame) override;
+
+  // Answer the ATT requests of the host.
+  virtual void WriteTraffic(const std::vector<uint8_t>& frame) override;
+
+  // Return the response of the ATT server to |request|, empty if none is due.
+  static std::vector<uint8_t> AttResponse(const std::vector<uint8_t>& request);
+
+  // Return the L2CAP frame number |seq| of a |kind| stream, with
+  // |payload_bytes| bytes of payload after the protocol headers.
+  static std::vector<uint8_t> BuildFrame(TrafficKind kind, uint16_t seq,
+                                         size_t payload_bytes);
+
+ private:
+  bool le_ = true;
+  TrafficKind kind_ = kGatt;
+  size_t frame_bytes_ = 20;
+  size_t frames_per_burst_ = 1;
+  size_t burst_period_ticks_ = 1;
+  size_t ticks_ = 0;
+  size_t frames_left_ = 0;
+  uint16_t seq_ = 0;
+  std::queue<std::vector<uint8_t>> responses_;
+};
+
+}  // namespace test_vendor_lib
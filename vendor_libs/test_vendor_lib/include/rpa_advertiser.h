@@ -0,0 +1,68 @@
+//
+// Copyright 2019 The Android Open Source Project
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+#include "bt_address.h"
+#include "device.h"
+
+namespace test_vendor_lib {
+
+// An LE advertiser using a resolvable private address, which it changes
+// periodically like a privacy enabled phone or tag would. Addresses are
+// derived from a seed, so that a scenario can spawn thousands of distinct
+// advertisers and replay them identically. The hash part of the addresses is
+// not computed from an IRK, the host has no bond with these devices.
+class RpaAdvertiser : public Device {
+ public:
+  RpaAdvertiser();
+  virtual ~RpaAdvertiser() = default;
+
+  // Initialize from "rpa_advertiser <seed> [<interval_ms> [<rotation_ms>
+  // [connectable]]]".
+  virtual void Initialize(const std::vector<std::string>& args) override;
+
+  // Return a string representation of the type of device.
+  virtual std::string GetTypeString() const override {
+    return "rpa_advertiser";
+  }
+
+  virtual bool LeConnect() override { return connectable_; }
+
+  // LE only.
+  virtual bool IsPageScanAvailable() const override { return false; }
+
+  // Change the address once the rotation period is over.
+  virtual void TimerTick() override;
+
+  // Set |address| to the address used in rotation period |rotation| by the
+  // advertiser with |seed|.
+  static void GetRpa(uint32_t seed, uint32_t rotation, BtAddress& address);
+
+ private:
+  uint32_t seed_ = 0;
+  uint32_t rotation_ = 0;
+  bool connectable_ = false;
+  std::chrono::milliseconds rotation_period_ms_ =
+      std::chrono::milliseconds(15 * 60 * 1000);
+  std::chrono::steady_clock::time_point rotation_time_;
+};
+
+}  // namespace test_vendor_lib
@@ -0,0 +1,108 @@
+#
+# Copyright 2019 The Android Open Source Project
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+#
+
+"""Script for loading the test vendor controller with many virtual devices.
+
+This script replays a scenario file over the test channel, to put the host
+stack under the load of a crowded environment: thousands of advertisers using
+resolvable private addresses, and many connections busy with A2DP-like media
+bursts, GATT notification floods or RFCOMM bulk transfers.
+
+Scenario files hold one command per line, '#' starts a comment:
+  advertisers <count> <interval_ms> [<rotation_ms> [connectable]]
+  peers <count> <le|br> <gatt|a2dp|rfcomm> [<frame_bytes> [<frames_per_burst>
+      [<burst_period_ticks>]]]
+  credits <packets_per_tick>
+  wait <seconds>
+
+Peers are connected to the host as soon as they are added. A tick is a period
+of the controller timer, 100ms by default.
+
+Usage:
+  python load_scenario.py [port] [scenario_file]
+  The root canal HAL (test/rootcanal) listens on port 6111; forward it with
+  'adb forward tcp:6111 tcp:6111' first. data/crowded.scenario is an example.
+"""
+
+#!/usr/bin/env python
+
+import sys
+import time
+
+from test_channel import TestChannel
+
+class LoadScenario(object):
+  """Sends the commands of a scenario file to the controller.
+
+  Attributes:
+    test_channel: The communication channel to send data to the controller.
+  """
+
+  def __init__(self, test_channel):
+    self._test_channel = test_channel
+    self._advertisers = 0
+    self._peers = 0
+
+  def run(self, lines):
+    for number, line in enumerate(lines, 1):
+      words = line.split('#', 1)[0].split()
+      if not words:
+        continue
+      handler = getattr(self, '_do_' + words[0], None)
+      if handler is None:
+        raise ValueError('line %d: unknown command %s' % (number, words[0]))
+      handler(words[1:])
+
+  def _do_advertisers(self, args):
+    count = int(args[0])
+    for _ in range(count):
+      self._test_channel.send_command(
+          'add', ['rpa_advertiser', str(self._advertisers)] + args[1:])
+      self._advertisers += 1
+
+  def _do_peers(self, args):
+    count = int(args[0])
+    for _ in range(count):
+      address = self._peer_address(self._peers)
+      self._test_channel.send_command('add', ['load_peer', address] + args[1:])
+      self._test_channel.send_command('connect', [address, args[1]])
+      self._peers += 1
+
+  def _do_credits(self, args):
+    self._test_channel.send_command('credits', args[:1])
+
+  def _do_wait(self, args):
+    time.sleep(float(args[0]))
+
+  @staticmethod
+  def _peer_address(index):
+    return '10:ad:%02x:%02x:%02x:%02x' % ((index >> 24) & 0xff,
+                                          (index >> 16) & 0xff,
+                                          (index >> 8) & 0xff, index & 0xff)
+
+def main(argv):
+  if len(argv) != 3:
+    print('Usage: python load_scenario.py [port] [scenario_file]')
+    return
+  test_channel = TestChannel(int(argv[1]))
+  try:
+    with open(argv[2]) as scenario:
+      LoadScenario(test_channel).run(scenario.readlines())
+  finally:
+    test_channel.close()
+
+if __name__ == '__main__':
+  main(sys.argv)
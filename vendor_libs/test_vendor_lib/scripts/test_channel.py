@@ -182,6 +182,34 @@ class TestChannelShell(cmd.Cmd):
     """
     self._test_channel.send_command('del', args.split())
 
+  def do_connect(self, args):
+    """
+    Arguments: address [le|br]
+    Connect the device with the specified address to the host.
+    """
+    self._test_channel.send_command('connect', args.split())
+
+  def do_credits(self, args):
+    """
+    Arguments: packets_per_tick
+    Limit the ACL packets the controller completes per tick, 0 for no limit.
+    """
+    self._test_channel.send_command('credits', args.split())
+
+  def do_clear(self, args):
+    """
+    Arguments: None.
+    Remove every device.
+    """
+    self._test_channel.send_command('clear', [])
+
+  def do_timer(self, args):
+    """
+    Arguments: period_ms
+    Set the period of the timer which drives the devices.
+    """
+    self._test_channel.send_command('timer', args.split())
+
   def do_get(self, args):
     """
     Arguments: dev_num attr_str
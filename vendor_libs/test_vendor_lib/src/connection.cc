@@ -54,6 +54,23 @@ bool Connection::ReceiveFromDevice(vector<uint8_t>& data) {
   return false;
 }
 
+bool Connection::ReassembleFromHost(bool start, const vector<uint8_t>& fragment,
+                                    vector<uint8_t>& frame) {
+  if (start)
+    host_frame_ = fragment;
+  else if (!host_frame_.empty())
+    host_frame_.insert(host_frame_.end(), fragment.begin(), fragment.end());
+
+  // Basic L2CAP header: length of the information payload and channel id.
+  if (host_frame_.size() < 4) return false;
+  size_t length = host_frame_[0] | (host_frame_[1] << 8);
+  if (host_frame_.size() < 4 + length) return false;
+
+  frame.swap(host_frame_);
+  host_frame_.clear();
+  return true;
+}
+
 const std::string Connection::ToString() {
   return "connection " + std::to_string(handle_) + " to " + dev_->ToString();
 }
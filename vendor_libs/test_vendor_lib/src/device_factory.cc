@@ -23,6 +23,8 @@
 #include "classic.h"
 #include "device.h"
 #include "keyboard.h"
+#include "load_peer.h"
+#include "rpa_advertiser.h"
 
 #include "base/logging.h"
 
@@ -40,6 +42,9 @@ std::shared_ptr<Device> DeviceFactory::Create(const vector<std::string>& args) {
   if (args[0] == "broken_adv") new_device = std::make_shared<BrokenAdv>();
   if (args[0] == "classic") new_device = std::make_shared<Classic>();
   if (args[0] == "keyboard") new_device = std::make_shared<Keyboard>();
+  if (args[0] == "load_peer") new_device = std::make_shared<LoadPeer>();
+  if (args[0] == "rpa_advertiser")
+    new_device = std::make_shared<RpaAdvertiser>();
 
   if (new_device != nullptr) new_device->Initialize(args);
 
@@ -19,6 +19,11 @@
 #include "dual_mode_controller.h"
 #include "device_factory.h"
 
+#include <errno.h>
+#include <stdlib.h>
+
+#include <algorithm>
+#include <limits>
 #include <memory>
 
 #include <base/logging.h>
@@ -60,6 +65,20 @@ bool ParseUint16t(base::StringPiece value, uint16_t* field) {
   return true;
 }
 
+// Reads the decimal test channel argument |arg| into |value|. Returns false,
+// leaving |value| unchanged, if |arg| is not a number in [min, max].
+bool ParseTestChannelArg(const std::string& arg, long min, long max,
+                         long* value) {
+  char* end = nullptr;
+  errno = 0;
+  long parsed = strtol(arg.c_str(), &end, 10);
+  if (arg.empty() || *end != '\0' || errno == ERANGE || parsed < min ||
+      parsed > max)
+    return false;
+  *value = parsed;
+  return true;
+}
+
 }  // namespace
 
 namespace test_vendor_lib {
@@ -156,6 +175,9 @@ DualModeController::DualModeController()
   SET_HANDLER(HCI_INQUIRY_CANCEL, HciInquiryCancel);
   SET_HANDLER(HCI_DELETE_STORED_LINK_KEY, HciDeleteStoredLinkKey);
   SET_HANDLER(HCI_RMT_NAME_REQUEST, HciRemoteNameRequest);
+  SET_HANDLER(HCI_DISCONNECT, HciDisconnect);
+  SET_HANDLER(HCI_ACCEPT_CONNECTION_REQUEST, HciAcceptConnectionRequest);
+  SET_HANDLER(HCI_REJECT_CONNECTION_REQUEST, HciRejectConnectionRequest);
   SET_HANDLER(HCI_BLE_SET_EVENT_MASK, HciLeSetEventMask);
   SET_HANDLER(HCI_BLE_READ_BUFFER_SIZE, HciLeReadBufferSize);
   SET_HANDLER(HCI_BLE_READ_LOCAL_SPT_FEAT, HciLeReadLocalSupportedFeatures);
@@ -187,6 +209,10 @@ DualModeController::DualModeController()
   SET_TEST_HANDLER("add", TestChannelAdd);
   SET_TEST_HANDLER("del", TestChannelDel);
   SET_TEST_HANDLER("list", TestChannelList);
+  SET_TEST_HANDLER("connect", TestChannelConnect);
+  SET_TEST_HANDLER("credits", TestChannelCredits);
+  SET_TEST_HANDLER("clear", TestChannelClear);
+  SET_TEST_HANDLER("timer", TestChannelTimer);
 #undef SET_TEST_HANDLER
 }
 
@@ -221,6 +247,37 @@ void DualModeController::HandleAcl(std::unique_ptr<AclPacket> acl_packet) {
     send_event_(EventPacket::CreateNumberOfCompletedPacketsEvent(channel, 1));
     return;
   }
+
+  uint16_t handle = acl_packet->GetChannel();
+  if (acl_packets_per_tick_ == 0) {
+    send_event_(EventPacket::CreateNumberOfCompletedPacketsEvent(handle, 1));
+  } else if (acl_packets_buffered_ >=
+             static_cast<size_t>(properties_.GetTotalNumAclDataPackets() +
+                                 properties_.GetTotalNumLeDataPackets())) {
+    // A host sharing the ACL buffers for LE may use both pools, only going
+    // beyond their sum is certainly a flow control bug.
+    LOG_WARN(LOG_TAG, "Dropping ACL packet for handle 0x%04x: no buffer left",
+             handle);
+    return;
+  } else {
+    acl_packets_in_flight_[handle]++;
+    acl_packets_buffered_++;
+  }
+
+  // Hand the L2CAP frames to the device, and its answers straight back, so
+  // that request/response exchanges don't wait for the timer.
+  for (size_t i = 0; i < connections_.size(); i++) {
+    if (!(*connections_[i] == handle) || !connections_[i]->Connected())
+      continue;
+    const vector<uint8_t>& packet = acl_packet->GetPacket();
+    vector<uint8_t> frame;
+    if (connections_[i]->ReassembleFromHost(
+            acl_packet->GetPacketBoundaryFlags() != AclPacket::Continuing,
+            vector<uint8_t>(packet.begin() + 4, packet.end()), frame)) {
+      connections_[i]->GetDevice()->WriteTraffic(frame);
+      SendDeviceTraffic(*connections_[i]);
+    }
+  }
 }
 
 void DualModeController::HandleSco(std::unique_ptr<ScoPacket> sco_packet) {
@@ -290,9 +347,10 @@ static uint8_t GetRssi(size_t dev) {
   return -((dev * 16) % 127);
 }
 
-static uint8_t LeGetHandle() {
-  static int handle = 0;
-  return handle++;
+static uint16_t GetConnectionHandle() {
+  static uint16_t handle = 0;
+  handle = (handle + 1) % 0x0f00;  // 0x0F00 - 0x0FFF are reserved
+  return handle;
 }
 
 static uint8_t LeGetConnInterval() { return 1; }
@@ -302,16 +360,80 @@ static uint8_t LeGetConnLatency() { return 2; }
 static uint8_t LeGetSupervisionTimeout() { return 3; }
 
 void DualModeController::Connections() {
+  if (acl_packets_per_tick_ != 0) CompleteAclPackets();
+
   for (size_t i = 0; i < connections_.size(); i++) {
     if (connections_[i]->Connected()) {
       connections_[i]->SendToDevice();
-      vector<uint8_t> data;
-      connections_[i]->ReceiveFromDevice(data);
-      // HandleConnectionData(data);
+      SendDeviceTraffic(*connections_[i]);
     }
   }
 }
 
+void DualModeController::SendDeviceTraffic(Connection& connection) {
+  vector<uint8_t> data;
+  while (connection.GetDevice()->ReadTraffic(data)) connection.AddMessage(data);
+
+  // Fragment the frames of the device to the buffer size of the link.
+  size_t mtu = properties_.GetAclDataPacketSize();
+  if (connection.IsLe() && properties_.GetLeDataPacketLength() != 0)
+    mtu = properties_.GetLeDataPacketLength();
+  uint16_t handle = connection.GetHandle();
+  while (connection.ReceiveFromDevice(data)) {
+    for (size_t offset = 0; offset < data.size(); offset += mtu) {
+      size_t octets = std::min(mtu, data.size() - offset);
+      std::unique_ptr<AclPacket> acl = std::make_unique<AclPacket>(
+          handle,
+          offset == 0 ? AclPacket::FirstAutomaticallyFlushable
+                      : AclPacket::Continuing,
+          AclPacket::PointToPoint);
+      acl->AddPayloadOctets(octets,
+                            vector<uint8_t>(data.begin() + offset,
+                                            data.begin() + offset + octets));
+      send_acl_(std::move(acl));
+    }
+  }
+}
+
+void DualModeController::CompleteAclPackets() {
+  // Handles which fit in the 255 bytes of the event parameters.
+  static const size_t kMaxHandlesPerEvent = 63;
+
+  std::unique_ptr<EventPacket> event;
+  size_t handles = 0;
+  uint16_t credits = acl_packets_per_tick_;
+
+  // Start after the last handle served, so that a busy connection doesn't
+  // get all the credits.
+  auto it = acl_packets_in_flight_.lower_bound(acl_next_handle_);
+  size_t entries = acl_packets_in_flight_.size();
+  for (size_t visited = 0;
+       visited < entries && credits > 0 && handles < kMaxHandlesPerEvent;
+       visited++) {
+    if (it == acl_packets_in_flight_.end())
+      it = acl_packets_in_flight_.begin();
+
+    uint16_t completed = std::min(it->second, credits);
+    if (event == nullptr)
+      event =
+          EventPacket::CreateNumberOfCompletedPacketsEvent(it->first, completed);
+    else
+      event->AddCompletedPackets(it->first, completed);
+    handles++;
+    credits -= completed;
+    acl_packets_buffered_ -= completed;
+    acl_next_handle_ = it->first + 1;
+
+    it->second -= completed;
+    if (it->second == 0)
+      it = acl_packets_in_flight_.erase(it);
+    else
+      it++;
+  }
+
+  if (event != nullptr) send_event_(std::move(event));
+}
+
 void DualModeController::LeScan() {
   std::unique_ptr<EventPacket> le_adverts =
       EventPacket::CreateLeAdvertisingReportEvent();
@@ -341,7 +463,7 @@ void DualModeController::LeScan() {
         LOG_INFO(LOG_TAG, "Connecting to device %d", static_cast<int>(dev));
         if (peer_address_ == addr && peer_address_type_ == addr_type &&
             devices_[dev]->LeConnect()) {
-          uint16_t handle = LeGetHandle();
+          uint16_t handle = GetConnectionHandle();
           std::unique_ptr<EventPacket> event =
               EventPacket::CreateLeConnectionCompleteEvent(
                   kSuccessStatus, handle, HCI_ROLE_MASTER, addr_type, addr,
@@ -477,6 +599,85 @@ void DualModeController::TestChannelList(
   }
 }
 
+void DualModeController::TestChannelConnect(const vector<std::string>& args) {
+  LogCommand("TestChannel 'connect'");
+
+  BtAddress addr;
+  if (args.empty() || !addr.FromString(args[0])) {
+    LOG_INFO(LOG_TAG, "TestChannel 'connect': bad address!");
+    return;
+  }
+
+  auto device = std::find_if(devices_.begin(), devices_.end(),
+                             [&addr](const std::shared_ptr<Device>& d) {
+                               return addr == d->GetBtAddress();
+                             });
+  if (device == devices_.end()) {
+    LOG_INFO(LOG_TAG, "TestChannel 'connect': no device %s!",
+             args[0].c_str());
+    return;
+  }
+
+  std::shared_ptr<Device> dev = *device;
+  bool le = args.size() < 2 || args[1] != "br";
+  if (le) {
+    uint16_t handle = GetConnectionHandle();
+    send_event_(EventPacket::CreateLeConnectionCompleteEvent(
+        kSuccessStatus, handle, HCI_ROLE_SLAVE, dev->GetAddressType(),
+        dev->GetBtAddress(), LeGetConnInterval(), LeGetConnLatency(),
+        LeGetSupervisionTimeout()));
+    connections_.push_back(std::make_shared<Connection>(dev, handle));
+  } else {
+    connection_requests_.push_back(dev);
+    send_event_(EventPacket::CreateConnectionRequestEvent(
+        dev->GetBtAddress(), dev->GetDeviceClass(), HCI_LINK_TYPE_ACL));
+  }
+}
+
+void DualModeController::TestChannelCredits(const vector<std::string>& args) {
+  LogCommand("TestChannel 'credits'");
+
+  long packets_per_tick;
+  if (args.empty() ||
+      !ParseTestChannelArg(args[0], 0, std::numeric_limits<uint16_t>::max(),
+                           &packets_per_tick)) {
+    LOG_INFO(LOG_TAG, "TestChannel 'credits': bad packets per tick '%s'!",
+             args.empty() ? "" : args[0].c_str());
+    return;
+  }
+  acl_packets_per_tick_ = packets_per_tick;
+  if (acl_packets_per_tick_ != 0) return;
+
+  // Complete what was held back.
+  for (const auto& in_flight : acl_packets_in_flight_)
+    send_event_(EventPacket::CreateNumberOfCompletedPacketsEvent(
+        in_flight.first, in_flight.second));
+  acl_packets_in_flight_.clear();
+  acl_packets_buffered_ = 0;
+}
+
+void DualModeController::TestChannelClear(
+    UNUSED_ATTR const vector<std::string>& args) {
+  LogCommand("TestChannel 'clear'");
+
+  devices_.clear();
+  connection_requests_.clear();
+}
+
+void DualModeController::TestChannelTimer(const vector<std::string>& args) {
+  LogCommand("TestChannel 'timer'");
+
+  long period_ms;
+  if (args.empty() ||
+      !ParseTestChannelArg(args[0], 1, std::numeric_limits<int32_t>::max(),
+                           &period_ms)) {
+    LOG_INFO(LOG_TAG, "TestChannel 'timer': bad period '%s'!",
+             args.empty() ? "" : args[0].c_str());
+    return;
+  }
+  SetTimerPeriod(std::chrono::milliseconds(period_ms));
+}
+
 void DualModeController::HciReset(const vector<uint8_t>& args) {
   LogCommand("Reset");
   CHECK(args[0] == 0);  // No arguments
@@ -721,6 +922,92 @@ void DualModeController::HciRemoteNameRequest(
   SendCommandStatusSuccess(HCI_RMT_NAME_REQUEST);
 }
 
+void DualModeController::HciDisconnect(const vector<uint8_t>& args) {
+  LogCommand("Disconnect");
+  CHECK(args.size() == 4);
+
+  uint16_t handle = (args[1] | (args[2] << 8)) & 0x0fff;
+
+  auto connection = std::find_if(
+      connections_.begin(), connections_.end(),
+      [handle](const std::shared_ptr<Connection>& c) { return *c == handle; });
+  if (connection == connections_.end()) {
+    SendCommandStatus(HCI_ERR_NO_CONNECTION, HCI_DISCONNECT);
+    return;
+  }
+
+  SendCommandStatusSuccess(HCI_DISCONNECT);
+  connections_.erase(connection);
+
+  // Packets still buffered for the link are flushed, the host resets its
+  // credits for them on the Disconnection Complete event.
+  auto in_flight = acl_packets_in_flight_.find(handle);
+  if (in_flight != acl_packets_in_flight_.end()) {
+    acl_packets_buffered_ -= in_flight->second;
+    acl_packets_in_flight_.erase(in_flight);
+  }
+
+  send_event_(EventPacket::CreateDisconnectionCompleteEvent(
+      kSuccessStatus, handle, HCI_ERR_CONN_CAUSE_LOCAL_HOST));
+}
+
+void DualModeController::HciAcceptConnectionRequest(
+    const vector<uint8_t>& args) {
+  LogCommand("Accept Connection Request");
+  CHECK(args.size() == 8);
+
+  BtAddress addr;
+  vector<uint8_t> peer_addr = {args[1], args[2], args[3],
+                               args[4], args[5], args[6]};
+  addr.FromVector(peer_addr);
+
+  auto request = std::find_if(
+      connection_requests_.begin(), connection_requests_.end(),
+      [&addr](const std::shared_ptr<Device>& d) {
+        return addr == d->GetBtAddress();
+      });
+  if (request == connection_requests_.end()) {
+    SendCommandStatus(HCI_ERR_NO_CONNECTION, HCI_ACCEPT_CONNECTION_REQUEST);
+    return;
+  }
+
+  SendCommandStatusSuccess(HCI_ACCEPT_CONNECTION_REQUEST);
+
+  // The requested role is ignored, the host stays slave.
+  uint16_t handle = GetConnectionHandle();
+  send_event_(EventPacket::CreateConnectionCompleteEvent(
+      kSuccessStatus, handle, addr, HCI_LINK_TYPE_ACL, false));
+  connections_.push_back(std::make_shared<Connection>(*request, handle, false));
+  connection_requests_.erase(request);
+}
+
+void DualModeController::HciRejectConnectionRequest(
+    const vector<uint8_t>& args) {
+  LogCommand("Reject Connection Request");
+  CHECK(args.size() == 8);
+
+  BtAddress addr;
+  vector<uint8_t> peer_addr = {args[1], args[2], args[3],
+                               args[4], args[5], args[6]};
+  addr.FromVector(peer_addr);
+  uint8_t reason = args[7];
+
+  auto request = std::find_if(
+      connection_requests_.begin(), connection_requests_.end(),
+      [&addr](const std::shared_ptr<Device>& d) {
+        return addr == d->GetBtAddress();
+      });
+  if (request == connection_requests_.end()) {
+    SendCommandStatus(HCI_ERR_NO_CONNECTION, HCI_REJECT_CONNECTION_REQUEST);
+    return;
+  }
+
+  SendCommandStatusSuccess(HCI_REJECT_CONNECTION_REQUEST);
+  send_event_(EventPacket::CreateConnectionCompleteEvent(
+      reason, 0, addr, HCI_LINK_TYPE_ACL, false));
+  connection_requests_.erase(request);
+}
+
 void DualModeController::HciLeSetEventMask(const vector<uint8_t>& args) {
   LogCommand("LE SetEventMask");
   le_event_mask_ = args;
@@ -0,0 +1,319 @@
+//
+// Copyright 2019 The Android Open Source Project
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#define LOG_TAG "load_peer"
+
+#include "load_peer.h"
+
+#include <algorithm>
+
+#include "base/logging.h"
+
+#include "stack/include/hcidefs.h"
+
+using std::vector;
+
+namespace {
+
+// Fixed channels and the first dynamic channels a host allocates, on which
+// the frames are sent.
+const uint16_t kAttCid = 0x0004;
+const uint16_t kRfcommCid = 0x0040;
+const uint16_t kAvdtpMediaCid = 0x0041;
+
+// Bluetooth Core Specification Version 4.2, Volume 3, Part F, Section 3.4
+const uint8_t kAttErrorRsp = 0x01;
+const uint8_t kAttExchangeMtuReq = 0x02;
+const uint8_t kAttFindInformationReq = 0x04;
+const uint8_t kAttReadByTypeReq = 0x08;
+const uint8_t kAttReadReq = 0x0a;
+const uint8_t kAttReadByGroupTypeReq = 0x10;
+const uint8_t kAttWriteReq = 0x12;
+const uint8_t kAttHandleValueNotification = 0x1b;
+const uint8_t kAttHandleValueIndication = 0x1d;
+const uint8_t kAttHandleValueConfirmation = 0x1e;
+const uint8_t kAttCommandFlag = 0x40;
+
+const uint8_t kAttInvalidHandle = 0x01;
+const uint8_t kAttInvalidPdu = 0x04;
+const uint8_t kAttRequestNotSupported = 0x06;
+const uint8_t kAttAttributeNotFound = 0x0a;
+
+const uint16_t kAttMtu = 247;
+
+// The attributes of the single service of the server.
+const uint16_t kAttServiceHandle = 0x0028;
+const uint16_t kAttCharacteristicHandle = 0x0029;
+const uint16_t kAttValueHandle = 0x002a;
+const uint16_t kAttCccdHandle = 0x002b;
+
+const uint16_t kPrimaryServiceUuid = 0x2800;
+const uint16_t kCharacteristicUuid = 0x2803;
+const uint16_t kCccdUuid = 0x2902;
+const uint16_t kLoadServiceUuid = 0xfff0;
+const uint16_t kLoadCharacteristicUuid = 0xfff1;
+const uint8_t kWriteWithoutResponseNotify = 0x14;
+
+const size_t kRtpHeaderSize = 12;
+const uint8_t kRtpVersion2 = 0x80;
+const uint8_t kRtpPayloadTypeSbc = 0x60;
+const size_t kSbcFrameSize = 119;  // 44.1kHz joint stereo, bitpool 53
+
+const uint8_t kRfcommDlci = 0x02;  // Server channel 1
+const uint8_t kRfcommUih = 0xef;
+
+// Bluetooth RFCOMM specification, TS 07.10 Section 5.2.1.6: reversed CRC-8
+// with polynomial x^8 + x^2 + x + 1.
+uint8_t RfcommFcs(const uint8_t* p, size_t len) {
+  uint8_t fcs = 0xff;
+  while (len--) {
+    fcs ^= *p++;
+    for (int i = 0; i < 8; i++) fcs = (fcs & 1) ? (fcs >> 1) ^ 0xe0 : fcs >> 1;
+  }
+  return 0xff - fcs;
+}
+
+void AddOctets2(vector<uint8_t>& v, uint16_t value) {
+  v.push_back(value & 0xff);
+  v.push_back(value >> 8);
+}
+
+uint16_t GetOctets2(const vector<uint8_t>& v, size_t offset) {
+  return v[offset] | (v[offset + 1] << 8);
+}
+
+vector<uint8_t> AttError(uint8_t request, uint16_t handle, uint8_t error) {
+  vector<uint8_t> pdu = {kAttErrorRsp, request};
+  AddOctets2(pdu, handle);
+  pdu.push_back(error);
+  return pdu;
+}
+
+vector<uint8_t> L2capFrame(uint16_t cid, const vector<uint8_t>& sdu) {
+  vector<uint8_t> frame;
+  AddOctets2(frame, sdu.size());
+  AddOctets2(frame, cid);
+  frame.insert(frame.end(), sdu.begin(), sdu.end());
+  return frame;
+}
+
+}  // namespace
+
+namespace test_vendor_lib {
+
+LoadPeer::LoadPeer() {
+  address_type_ = kBtAddressTypePublic;
+  advertising_interval_ms_ = std::chrono::milliseconds(100);
+  advertising_type_ = BTM_BLE_CONNECT_EVT;
+  adv_data_ = {0x05,  // Length
+               BTM_BLE_AD_TYPE_NAME_CMPL,
+               'l',
+               'o',
+               'a',
+               'd'};
+  device_class_ = 0x240404;  // Audio, wearable headset
+  page_scan_repetition_mode_ = 0;
+  clock_offset_ = 0;
+}
+
+void LoadPeer::Initialize(const vector<std::string>& args) {
+  if (args.size() < 2) return;
+
+  BtAddress addr;
+  if (addr.FromString(args[1])) SetBtAddress(addr);
+
+  if (args.size() < 3) return;
+
+  le_ = args[2] != "br";
+
+  if (args.size() < 4) return;
+
+  if (args[3] == "a2dp")
+    kind_ = kA2dp;
+  else if (args[3] == "rfcomm")
+    kind_ = kRfcomm;
+  else
+    kind_ = kGatt;
+
+  if (args.size() < 5) return;
+
+  frame_bytes_ = std::stoul(args[4]);
+
+  if (args.size() < 6) return;
+
+  frames_per_burst_ = std::stoul(args[5]);
+
+  if (args.size() < 7) return;
+
+  burst_period_ticks_ = std::max<size_t>(1, std::stoul(args[6]));
+}
+
+void LoadPeer::TimerTick() {
+  if (ticks_++ % burst_period_ticks_ == 0) frames_left_ = frames_per_burst_;
+}
+
+bool LoadPeer::ReadTraffic(vector<uint8_t>& frame) {
+  if (!responses_.empty()) {
+    frame = responses_.front();
+    responses_.pop();
+    return true;
+  }
+
+  if (frames_left_ == 0) return false;
+  frames_left_--;
+  frame = BuildFrame(kind_, seq_++, frame_bytes_);
+  return true;
+}
+
+void LoadPeer::WriteTraffic(const vector<uint8_t>& frame) {
+  if (frame.size() < 5 || GetOctets2(frame, 2) != kAttCid) return;
+
+  vector<uint8_t> response =
+      AttResponse(vector<uint8_t>(frame.begin() + 4, frame.end()));
+  if (!response.empty()) responses_.push(L2capFrame(kAttCid, response));
+}
+
+vector<uint8_t> LoadPeer::AttResponse(const vector<uint8_t>& request) {
+  uint8_t opcode = request[0];
+
+  // Indications have an odd opcode, like responses, so they are checked first.
+  if (opcode == kAttHandleValueIndication) return {kAttHandleValueConfirmation};
+
+  // Responses, notifications and commands, such as the writes without
+  // response of a throughput test, get no answer.
+  if ((opcode & 1) || opcode == kAttHandleValueNotification ||
+      (opcode & kAttCommandFlag))
+    return {};
+
+  switch (opcode) {
+    case kAttExchangeMtuReq: {
+      vector<uint8_t> pdu = {kAttExchangeMtuReq + 1};
+      AddOctets2(pdu, kAttMtu);
+      return pdu;
+    }
+
+    case kAttFindInformationReq: {
+      if (request.size() != 5)
+        return AttError(opcode, 0, kAttInvalidPdu);
+      uint16_t start = GetOctets2(request, 1);
+      uint16_t end = GetOctets2(request, 3);
+      if (start > kAttCccdHandle || end < kAttCccdHandle)
+        return AttError(opcode, start, kAttAttributeNotFound);
+      vector<uint8_t> pdu = {kAttFindInformationReq + 1, 0x01};  // 16-bit
+      AddOctets2(pdu, kAttCccdHandle);
+      AddOctets2(pdu, kCccdUuid);
+      return pdu;
+    }
+
+    case kAttReadByTypeReq: {
+      if (request.size() != 7 && request.size() != 21)
+        return AttError(opcode, 0, kAttInvalidPdu);
+      uint16_t start = GetOctets2(request, 1);
+      uint16_t end = GetOctets2(request, 3);
+      if (request.size() != 7 ||
+          GetOctets2(request, 5) != kCharacteristicUuid ||
+          start > kAttCharacteristicHandle || end < kAttCharacteristicHandle)
+        return AttError(opcode, start, kAttAttributeNotFound);
+      vector<uint8_t> pdu = {kAttReadByTypeReq + 1, 7};
+      AddOctets2(pdu, kAttCharacteristicHandle);
+      pdu.push_back(kWriteWithoutResponseNotify);
+      AddOctets2(pdu, kAttValueHandle);
+      AddOctets2(pdu, kLoadCharacteristicUuid);
+      return pdu;
+    }
+
+    case kAttReadReq: {
+      if (request.size() != 3) return AttError(opcode, 0, kAttInvalidPdu);
+      uint16_t handle = GetOctets2(request, 1);
+      if (handle < kAttServiceHandle || handle > kAttCccdHandle)
+        return AttError(opcode, handle, kAttInvalidHandle);
+      return {kAttReadReq + 1, 0x00, 0x00};
+    }
+
+    case kAttReadByGroupTypeReq: {
+      if (request.size() != 7 && request.size() != 21)
+        return AttError(opcode, 0, kAttInvalidPdu);
+      uint16_t start = GetOctets2(request, 1);
+      uint16_t end = GetOctets2(request, 3);
+      if (request.size() != 7 ||
+          GetOctets2(request, 5) != kPrimaryServiceUuid ||
+          start > kAttServiceHandle || end < kAttServiceHandle)
+        return AttError(opcode, start, kAttAttributeNotFound);
+      vector<uint8_t> pdu = {kAttReadByGroupTypeReq + 1, 6};
+      AddOctets2(pdu, kAttServiceHandle);
+      AddOctets2(pdu, kAttCccdHandle);
+      AddOctets2(pdu, kLoadServiceUuid);
+      return pdu;
+    }
+
+    case kAttWriteReq:
+      return {kAttWriteReq + 1};
+
+    default:
+      return AttError(opcode, 0, kAttRequestNotSupported);
+  }
+}
+
+vector<uint8_t> LoadPeer::BuildFrame(TrafficKind kind, uint16_t seq,
+                                     size_t payload_bytes) {
+  vector<uint8_t> sdu;
+  uint16_t cid;
+
+  switch (kind) {
+    case kGatt:
+      cid = kAttCid;
+      sdu.push_back(kAttHandleValueNotification);
+      AddOctets2(sdu, kAttValueHandle);
+      break;
+
+    case kA2dp: {
+      cid = kAvdtpMediaCid;
+      uint32_t timestamp = seq * 128u;  // 128 samples per SBC frame
+      sdu.push_back(kRtpVersion2);
+      sdu.push_back(kRtpPayloadTypeSbc);
+      sdu.push_back(seq >> 8);
+      sdu.push_back(seq & 0xff);
+      for (int shift = 24; shift >= 0; shift -= 8)
+        sdu.push_back((timestamp >> shift) & 0xff);
+      for (int i = 0; i < 4; i++) sdu.push_back(0);  // SSRC
+      CHECK(sdu.size() == kRtpHeaderSize);
+      // SBC media payload header: number of frames in the packet.
+      sdu.push_back(std::max<size_t>(1, payload_bytes / kSbcFrameSize) & 0x0f);
+    } break;
+
+    case kRfcomm: {
+      cid = kRfcommCid;
+      sdu.push_back((kRfcommDlci << 2) | 0x03);  // C/R and EA set
+      sdu.push_back(kRfcommUih);
+      if (payload_bytes > 127) {
+        sdu.push_back((payload_bytes << 1) & 0xfe);
+        sdu.push_back(payload_bytes >> 7);
+      } else {
+        sdu.push_back((payload_bytes << 1) | 0x01);
+      }
+    } break;
+  }
+
+  for (size_t i = 0; i < payload_bytes; i++)
+    sdu.push_back(static_cast<uint8_t>(seq + i));
+
+  // The FCS of UIH frames only covers the address and control fields.
+  if (kind == kRfcomm) sdu.push_back(RfcommFcs(sdu.data(), 2));
+
+  return L2capFrame(cid, sdu);
+}
+
+}  // namespace test_vendor_lib
@@ -0,0 +1,111 @@
+//
+// Copyright 2019 The Android Open Source Project
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#define LOG_TAG "rpa_advertiser"
+
+#include "rpa_advertiser.h"
+#include "stack/include/hcidefs.h"
+
+using std::vector;
+
+namespace {
+
+// Mixes the bits of |x|, so that consecutive seeds give unrelated addresses.
+uint32_t Mix(uint32_t x) {
+  x ^= x >> 16;
+  x *= 0x7feb352d;
+  x ^= x >> 15;
+  x *= 0x846ca68b;
+  x ^= x >> 16;
+  return x;
+}
+
+}  // namespace
+
+namespace test_vendor_lib {
+
+RpaAdvertiser::RpaAdvertiser() {
+  address_type_ = kBtAddressTypeRandom;
+  advertising_interval_ms_ = std::chrono::milliseconds(1000);
+  advertising_type_ = BTM_BLE_NON_CONNECT_EVT;
+  rotation_time_ = std::chrono::steady_clock::now();
+  GetRpa(seed_, rotation_, address_);
+}
+
+void RpaAdvertiser::Initialize(const vector<std::string>& args) {
+  if (args.size() < 2) return;
+
+  seed_ = std::stoul(args[1]);
+  GetRpa(seed_, rotation_, address_);
+
+  // Manufacturer specific data changing with the seed, as the payload of
+  // real advertisers does.
+  adv_data_ = {0x02,  // Length
+               BTM_BLE_AD_TYPE_FLAG,
+               BTM_BLE_BREDR_NOT_SPT | BTM_BLE_GEN_DISC_FLAG,
+               0x07,  // Length
+               HCI_EIR_MANUFACTURER_SPECIFIC_TYPE,
+               0xe0,
+               0x00,
+               static_cast<uint8_t>(seed_),
+               static_cast<uint8_t>(seed_ >> 8),
+               static_cast<uint8_t>(seed_ >> 16),
+               static_cast<uint8_t>(seed_ >> 24)};
+
+  if (args.size() < 3) return;
+
+  SetAdvertisementInterval(std::chrono::milliseconds(std::stoi(args[2])));
+
+  if (args.size() < 4) return;
+
+  rotation_period_ms_ = std::chrono::milliseconds(std::stoi(args[3]));
+
+  if (args.size() < 5) return;
+
+  connectable_ = args[4] == "connectable";
+  advertising_type_ =
+      connectable_ ? BTM_BLE_CONNECT_EVT : BTM_BLE_NON_CONNECT_EVT;
+}
+
+void RpaAdvertiser::TimerTick() {
+  std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+  if (rotation_period_ms_ == std::chrono::milliseconds(0) ||
+      now - rotation_time_ < rotation_period_ms_)
+    return;
+
+  rotation_time_ = now;
+  rotation_++;
+  GetRpa(seed_, rotation_, address_);
+}
+
+void RpaAdvertiser::GetRpa(uint32_t seed, uint32_t rotation,
+                           BtAddress& address) {
+  uint32_t prand = Mix(seed * 0x9e3779b9 + rotation);
+  uint32_t hash = Mix(prand ^ seed);
+
+  // Bluetooth Core Specification Version 4.2, Volume 6, Part B, Section
+  // 1.3.2.2: hash in the 24 least significant bits, prand in the 24 most
+  // significant ones, with its two most significant bits set to 0b01.
+  vector<uint8_t> octets = {static_cast<uint8_t>(hash),
+                            static_cast<uint8_t>(hash >> 8),
+                            static_cast<uint8_t>(hash >> 16),
+                            static_cast<uint8_t>(prand),
+                            static_cast<uint8_t>(prand >> 8),
+                            static_cast<uint8_t>(((prand >> 16) & 0x3f) | 0x40)};
+  address.FromVector(octets);
+}
+
+}  // namespace test_vendor_lib
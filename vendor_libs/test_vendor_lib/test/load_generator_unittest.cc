@@ -0,0 +1,148 @@
+/******************************************************************************
+ *
+ *  Copyright 2019 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#include <gtest/gtest.h>
+#include <set>
+#include <string>
+#include <vector>
+using std::vector;
+
+#include "load_peer.h"
+#include "rpa_advertiser.h"
+
+namespace test_vendor_lib {
+
+class LoadGeneratorTest : public ::testing::Test {
+ public:
+  LoadGeneratorTest() {}
+  ~LoadGeneratorTest() {}
+};
+
+TEST_F(LoadGeneratorTest, RpaFormat) {
+  std::set<std::string> addresses;
+  for (uint32_t seed = 0; seed < 1000; seed++) {
+    BtAddress address;
+    RpaAdvertiser::GetRpa(seed, 0, address);
+    vector<uint8_t> octets;
+    address.ToVector(octets);
+    ASSERT_EQ(6u, octets.size());
+    EXPECT_EQ(0x40, octets[5] & 0xc0);
+    addresses.insert(address.ToString());
+  }
+  EXPECT_EQ(1000u, addresses.size());
+}
+
+TEST_F(LoadGeneratorTest, RpaRotates) {
+  BtAddress first, again, rotated;
+  RpaAdvertiser::GetRpa(7, 3, first);
+  RpaAdvertiser::GetRpa(7, 3, again);
+  RpaAdvertiser::GetRpa(7, 4, rotated);
+  EXPECT_EQ(first.ToString(), again.ToString());
+  EXPECT_NE(first.ToString(), rotated.ToString());
+}
+
+TEST_F(LoadGeneratorTest, GattNotification) {
+  vector<uint8_t> frame = LoadPeer::BuildFrame(LoadPeer::kGatt, 0, 20);
+  ASSERT_EQ(4u + 3u + 20u, frame.size());
+  EXPECT_EQ(23, frame[0] | (frame[1] << 8));  // L2CAP length
+  EXPECT_EQ(0x0004, frame[2] | (frame[3] << 8));  // ATT
+  EXPECT_EQ(0x1b, frame[4]);  // Handle Value Notification
+}
+
+TEST_F(LoadGeneratorTest, A2dpMediaPacket) {
+  vector<uint8_t> frame = LoadPeer::BuildFrame(LoadPeer::kA2dp, 0x0102, 595);
+  ASSERT_EQ(4u + 12u + 1u + 595u, frame.size());
+  EXPECT_EQ(0x80, frame[4]);  // RTP version 2
+  EXPECT_EQ(0x01, frame[6]);  // Sequence number
+  EXPECT_EQ(0x02, frame[7]);
+  EXPECT_EQ(5, frame[16]);  // SBC frames
+}
+
+TEST_F(LoadGeneratorTest, RfcommUih) {
+  vector<uint8_t> frame = LoadPeer::BuildFrame(LoadPeer::kRfcomm, 0, 200);
+  ASSERT_EQ(4u + 4u + 200u + 1u, frame.size());
+  EXPECT_EQ(0x0b, frame[4]);  // DLCI 2, C/R, EA
+  EXPECT_EQ(0xef, frame[5]);  // UIH
+  EXPECT_EQ(200, (frame[6] >> 1) | (frame[7] << 7));  // Two byte length
+  EXPECT_EQ(0x9a, frame.back());  // FCS of the address and control fields
+}
+
+TEST_F(LoadGeneratorTest, BurstPeriod) {
+  LoadPeer peer;
+  peer.Initialize({"load_peer", "10:00:00:00:00:01", "le", "gatt", "20", "3",
+                   "2"});
+  vector<uint8_t> frame;
+  size_t frames[4] = {};
+  for (size_t tick = 0; tick < 4; tick++) {
+    peer.TimerTick();
+    while (peer.ReadTraffic(frame)) frames[tick]++;
+  }
+  EXPECT_EQ(3u, frames[0]);
+  EXPECT_EQ(0u, frames[1]);
+  EXPECT_EQ(3u, frames[2]);
+  EXPECT_EQ(0u, frames[3]);
+}
+
+TEST_F(LoadGeneratorTest, AttDiscovery) {
+  // Read By Group Type Request for the primary services.
+  vector<uint8_t> response =
+      LoadPeer::AttResponse({0x10, 0x01, 0x00, 0xff, 0xff, 0x00, 0x28});
+  EXPECT_EQ(vector<uint8_t>({0x11, 6, 0x28, 0x00, 0x2b, 0x00, 0xf0, 0xff}),
+            response);
+
+  // Read By Type Request for the characteristics.
+  response = LoadPeer::AttResponse({0x08, 0x28, 0x00, 0x2b, 0x00, 0x03, 0x28});
+  EXPECT_EQ(vector<uint8_t>({0x09, 7, 0x29, 0x00, 0x14, 0x2a, 0x00, 0xf1, 0xff}),
+            response);
+
+  // Past the end of the database.
+  response = LoadPeer::AttResponse({0x08, 0x2c, 0x00, 0xff, 0xff, 0x03, 0x28});
+  EXPECT_EQ(vector<uint8_t>({0x01, 0x08, 0x2c, 0x00, 0x0a}), response);
+}
+
+TEST_F(LoadGeneratorTest, AttWrites) {
+  // Enabling the notifications is acknowledged.
+  EXPECT_EQ(vector<uint8_t>({0x13}),
+            LoadPeer::AttResponse({0x12, 0x2b, 0x00, 0x01, 0x00}));
+  // Write Commands get no response.
+  EXPECT_TRUE(LoadPeer::AttResponse({0x52, 0x2a, 0x00, 0x55}).empty());
+}
+
+TEST_F(LoadGeneratorTest, AttIndications) {
+  // Indications are confirmed.
+  EXPECT_EQ(vector<uint8_t>({0x1e}),
+            LoadPeer::AttResponse({0x1d, 0x2a, 0x00, 0x55}));
+  // Notifications and responses are not.
+  EXPECT_TRUE(LoadPeer::AttResponse({0x1b, 0x2a, 0x00, 0x55}).empty());
+  EXPECT_TRUE(LoadPeer::AttResponse({0x0b, 0x55}).empty());
+}
+
+TEST_F(LoadGeneratorTest, ResponsesFirst) {
+  LoadPeer peer;
+  peer.Initialize({"load_peer", "10:00:00:00:00:01", "le", "gatt", "20", "3"});
+  peer.TimerTick();
+  peer.WriteTraffic({0x03, 0x00, 0x04, 0x00, 0x02, 0x00, 0x02});
+
+  vector<uint8_t> frame;
+  ASSERT_TRUE(peer.ReadTraffic(frame));
+  EXPECT_EQ(vector<uint8_t>({0x03, 0x00, 0x04, 0x00, 0x03, 0xf7, 0x00}), frame);
+  ASSERT_TRUE(peer.ReadTraffic(frame));
+  EXPECT_EQ(0x1b, frame[4]);
+}
+
+}  // namespace test_vendor_lib